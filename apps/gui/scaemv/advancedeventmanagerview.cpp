@@ -45,6 +45,7 @@
 #include <seiscomp3/datamodel/magnitude.h>
 #include <seiscomp3/seismology/regions.h>
 
+#include <ipgp/core/datamodel/inventorysnapshot.h>
 #include <ipgp/core/math/math.h>
 #include <ipgp/core/geo/geo.h>
 #include <ipgp/core/string/string.h>
@@ -52,6 +53,7 @@
 #include <ipgp/gui/datamodel/progressindicator/progressindicator.h>
 #include <ipgp/gui/datamodel/originplot/originplot.h>
 #include <ipgp/gui/datamodel/gutenbergrichter/gutenbergrichterwidget.h>
+#include <ipgp/gui/datamodel/bvaluevariance/bvaluevariancewidget.h>
 #include <ipgp/gui/datamodel/hypocentersdrift/hypocentersdriftwidget.h>
 #include <ipgp/gui/datamodel/uncertainty/uncertaintywidget.h>
 #include <ipgp/gui/datamodel/crosssection/crosssection.h>
@@ -118,6 +120,7 @@ AdvancedEventManagerView(int& argc, char** argv) :
 
 	setLoadInventoryEnabled(true);
 	setLoadStationsEnabled(true);
+	setLoadCitiesEnabled(true);
 
 	messageSubscription("LOCATION");
 	messageSubscription("CONFIG");
@@ -244,6 +247,7 @@ void AdvancedEventManagerView::setupApplicationMenus() {
 	    this, SLOT(log(const int&, const QString&, const QString&)));
 
 	connect(_ui->actionGutenbergRichterRelation, SIGNAL(triggered()), this, SLOT(showGutenbergRichterGraph()));
+	connect(_ui->actionBValueVariation, SIGNAL(triggered()), this, SLOT(showBValueVariationGraph()));
 	connect(_ui->actionDrifttoHypocenters, SIGNAL(triggered()), this, SLOT(showHypocenterDriftGraph()));
 	connect(_ui->actionEventsMap, SIGNAL(triggered()), this, SLOT(showGlobalMap()));
 	connect(_ui->actionEventsTopoMap, SIGNAL(triggered()), this, SLOT(showTopographyMap()));
@@ -964,6 +968,7 @@ void AdvancedEventManagerView::showGlobalMap() {
 	NULL, mapDescriptor().defaultLongitude(), mapDescriptor().defaultLatitude(),
 	    mapDescriptor().tilePattern());
 	_globalMap->setScheme(scheme());
+	_globalMap->foregroundCanvas().addCities(cities());
 	_globalMap->setObjectName("EventsMap");
 
 	connect(_globalMap, SIGNAL(nullifyQObject(QObject*)), this, SLOT(nullifyQObject(QObject*)));
@@ -1020,7 +1025,7 @@ void AdvancedEventManagerView::showTopographyMap() {
 	}
 
 	_topoMap = new TopographyMap(mainWindow());
-	_topoMap->setDatabase(query());
+	_topoMap->setDatabase(query(), _db);
 	_topoMap->renderer()->setAvailableSettings(_topoSettings);
 	_topoMap->renderer()->setActiveSettings(_topoSettings.begin().value());
 
@@ -1073,6 +1078,19 @@ void AdvancedEventManagerView::showGutenbergRichterGraph() {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void AdvancedEventManagerView::showBValueVariationGraph() {
+
+	BValueVarianceWidget* object = getPlottingWidget<BValueVarianceWidget>();
+	if ( object ) return;
+
+	initPlottingWidget<BValueVarianceWidget>("b-value Variation");
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void AdvancedEventManagerView::showHypocenterDriftGraph() {
 
@@ -1722,6 +1740,12 @@ bool AdvancedEventManagerView::initConfiguration() {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void AdvancedEventManagerView::databaseMessage(const QString& oldDB,
                                                const QString& newDB) {
+
+	//! Station coordinates are loaded again out of the new database
+	IPGP::Core::InventorySnapshot::Reset();
+	if ( _topoMap )
+	    _topoMap->setDatabase(query(), _db);
+
 	_eventListWidget->setDatabase(query());
 	_eventListWidget->startBlinking();
 }
@@ -160,6 +160,7 @@ class AdvancedEventManagerView : public IPGP::Gui::Client::Application {
 		void showResidualAzimuthGraph();
 		void showResidualTakeOffGraph();
 		void showGutenbergRichterGraph();
+		void showBValueVariationGraph();
 		void showMagnigtudeVarationGraph();
 		void showEventTypeVarationGraph();
 		void showHypocenterDriftGraph();
@@ -0,0 +1,374 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include "bulletinexportengine.h"
+
+#include <seiscomp3/datamodel/publicobject.h>
+#include <seiscomp3/io/database.h>
+#include <seiscomp3/logging/log.h>
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+
+using namespace Seiscomp;
+using namespace Seiscomp::DataModel;
+
+
+
+/**
+ * @class   BulletinExportWorker
+ * @brief   Pool worker: opens its own database connection and processes
+ *          jobs until the engine runs dry or is canceled.
+ */
+class BulletinExportWorker : public QRunnable {
+
+	public:
+		explicit BulletinExportWorker(BulletinExportEngine* engine) :
+				_engine(engine) {}
+
+		void run() {
+
+			//! Objects read by this thread are detached copies, the registry
+			//! and its instances belong to the GUI thread
+			PublicObject::SetRegistrationEnabled(false);
+
+			IO::DatabaseInterfacePtr db = IO::DatabaseInterface::Open(_engine->_databaseURI.c_str());
+			if ( !db ) {
+				_engine->abort(QString("Export worker failed to connect to database %1")
+				        .arg(_engine->_databaseURI.c_str()));
+				_engine->workerDone();
+				return;
+			}
+
+			DatabaseQueryPtr query = new DatabaseQuery(db.get());
+
+			int first, count;
+			while ( (first = _engine->takeJobs(count)) != -1 ) {
+
+				//! One set-based load for the whole chunk
+				IPGP::Core::BulletinLoader loader(query.get());
+				for (int i = first; i < first + count; ++i)
+					loader.addEvent(_engine->_jobs.at(i).event.get());
+				loader.load();
+
+				for (int index = first; index < first + count; ++index) {
+
+					BulletinExportEngine::Fragment fragment;
+					try {
+						fragment.valid = _engine->_formatter->format(query.get(),
+						    loader, _engine->_jobs.at(index), index, fragment);
+					} catch ( std::exception& e ) {
+						SEISCOMP_ERROR("Failed to export event %s: %s",
+						    _engine->_jobs.at(index).event->publicID().c_str(), e.what());
+						fragment.valid = false;
+					} catch ( ... ) {
+						fragment.valid = false;
+					}
+
+					_engine->storeFragment(index, fragment);
+				}
+			}
+
+			db->disconnect();
+			_engine->workerDone();
+		}
+
+	private:
+		BulletinExportEngine* _engine;
+};
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BulletinExportEngine::BulletinExportEngine(Formatter* formatter,
+                                           const std::string& databaseURI,
+                                           QObject* parent) :
+		QThread(parent), _formatter(formatter), _databaseURI(databaseURI),
+		_workerCount(QThread::idealThreadCount()), _activeWorkers(0),
+		_nextJob(0), _written(0), _window(0), _chunkSize(16), _exportedCount(0),
+		_pickCount(0), _canceled(false) {
+
+	if ( _workerCount < 1 )
+	    _workerCount = 1;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BulletinExportEngine::~BulletinExportEngine() {
+	cancel();
+	wait();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::setJobs(const QVector<Job>& jobs) {
+	_jobs = jobs;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::setOutputFile(const QString& file) {
+	_outputFile = file;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::setCatalogFile(const QString& file) {
+	_catalogFile = file;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::setWorkerCount(const int& count) {
+	_workerCount = (count > 0) ? count : 1;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::cancel() {
+
+	QMutexLocker locker(&_mutex);
+	_canceled = true;
+	_fragmentStored.wakeAll();
+	_fragmentWritten.wakeAll();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BulletinExportEngine::isCanceled() {
+	QMutexLocker locker(&_mutex);
+	return _canceled;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::run() {
+
+	{
+		QMutexLocker locker(&_mutex);
+
+		_error.clear();
+		_exportedCount = 0;
+		_pickCount = 0;
+		_nextJob = 0;
+		_written = 0;
+		_canceled = false;
+
+		_fragments.fill(Fragment(), _jobs.size());
+		_ready.fill(false, _jobs.size());
+
+		//! Bounds the number of fragments held in memory when the writer
+		//! falls behind (e.g. a slow event blocking the catalogue order)
+		_window = _workerCount * _chunkSize * 4;
+	}
+
+	QFile output(_outputFile);
+	if ( !output.open(QIODevice::WriteOnly) ) {
+		_error = QString("Couldn't open file %1").arg(_outputFile);
+		return;
+	}
+
+	QFile catalog(_catalogFile);
+	if ( !_catalogFile.isEmpty() && !catalog.open(QIODevice::WriteOnly) ) {
+		_error = QString("Couldn't open file %1").arg(_catalogFile);
+		return;
+	}
+
+	const std::string header = _formatter->header();
+	if ( output.write(header.c_str(), header.size()) != static_cast<qint64>(header.size()) )
+	    abort(QString("Couldn't write into file %1").arg(_outputFile));
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(_workerCount);
+	_activeWorkers = isCanceled() ? 0 : qMin(_workerCount, _jobs.size());
+	for (int i = 0; i < _activeWorkers; ++i)
+		pool.start(new BulletinExportWorker(this));
+
+	int written = 0;
+	for (int i = 0; i < _jobs.size() && !isCanceled(); ++i) {
+
+		Fragment fragment;
+		{
+			QMutexLocker locker(&_mutex);
+			while ( !_ready.at(i) && !_canceled && _activeWorkers > 0 )
+				_fragmentStored.wait(&_mutex);
+
+			if ( !_ready.at(i) )
+			    break;
+
+			fragment = _fragments.at(i);
+			_fragments[i] = Fragment();
+			_written = i + 1;
+			_fragmentWritten.wakeAll();
+		}
+
+		if ( fragment.valid ) {
+
+			if ( output.write(fragment.bulletin.c_str(), fragment.bulletin.size())
+			        != static_cast<qint64>(fragment.bulletin.size()) ) {
+				abort(QString("Couldn't write into file %1").arg(_outputFile));
+				break;
+			}
+
+			if ( catalog.isOpen()
+			        && catalog.write(fragment.catalog.c_str(), fragment.catalog.size())
+			            != static_cast<qint64>(fragment.catalog.size()) ) {
+				abort(QString("Couldn't write into file %1").arg(_catalogFile));
+				break;
+			}
+
+			_exportedCount++;
+			_pickCount += fragment.pickCount;
+		}
+
+		written = i + 1;
+		emit jobDone(i, fragment.valid);
+		emit progress(i + 1, _jobs.size());
+	}
+
+	pool.waitForDone();
+
+	//! Workers may all have stopped without an error being reported
+	if ( written < _jobs.size() && !isCanceled() )
+	    abort(QString("Export stopped after %1/%2 event(s)").arg(written).arg(_jobs.size()));
+
+	if ( !isCanceled() ) {
+		const std::string footer = _formatter->footer();
+		if ( output.write(footer.c_str(), footer.size()) != static_cast<qint64>(footer.size())
+		        || !output.flush() )
+		    abort(QString("Couldn't write into file %1").arg(_outputFile));
+	}
+
+	output.close();
+	if ( catalog.isOpen() )
+	    catalog.close();
+
+	//! A bulletin without its footer would pass for a complete one
+	if ( isCanceled() ) {
+		output.remove();
+		if ( !_catalogFile.isEmpty() )
+		    catalog.remove();
+		SEISCOMP_WARNING("Bulletin export engine stopped, removed incomplete file %s",
+		    _outputFile.toStdString().c_str());
+		return;
+	}
+
+	SEISCOMP_DEBUG("Bulletin export engine wrote %d/%d event(s) into %s",
+	    _exportedCount, _jobs.size(), _outputFile.toStdString().c_str());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int BulletinExportEngine::takeJobs(int& count) {
+
+	QMutexLocker locker(&_mutex);
+
+	while ( !_canceled && _nextJob < _jobs.size()
+	        && _nextJob >= _written + _window )
+		_fragmentWritten.wait(&_mutex);
+
+	if ( _canceled || _nextJob >= _jobs.size() )
+	    return -1;
+
+	// Smaller chunks at the tail keep every worker busy until the end
+	const int left = _jobs.size() - _nextJob;
+	count = qMax(1, qMin(_chunkSize, left / _workerCount));
+
+	const int first = _nextJob;
+	_nextJob += count;
+
+	return first;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::storeFragment(const int& index,
+                                         const Fragment& fragment) {
+
+	QMutexLocker locker(&_mutex);
+	_fragments[index] = fragment;
+	_ready[index] = true;
+	_fragmentStored.wakeAll();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::abort(const QString& error) {
+
+	SEISCOMP_ERROR("%s", error.toStdString().c_str());
+
+	QMutexLocker locker(&_mutex);
+	if ( _error.isEmpty() )
+	    _error = error;
+	_canceled = true;
+	_fragmentStored.wakeAll();
+	_fragmentWritten.wakeAll();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExportEngine::workerDone() {
+
+	QMutexLocker locker(&_mutex);
+	_activeWorkers--;
+	_fragmentStored.wakeAll();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
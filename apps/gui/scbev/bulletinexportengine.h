@@ -0,0 +1,201 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef __IPGP_APPLICATION_BULLETINEXPORTENGINE_H__
+#define __IPGP_APPLICATION_BULLETINEXPORTENGINE_H__
+
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <QVector>
+
+#include <seiscomp3/datamodel/databasequery.h>
+#include <seiscomp3/datamodel/event.h>
+#include <seiscomp3/datamodel/origin.h>
+#include <ipgp/core/bulletin/bulletinloader.h>
+
+#include <string>
+
+
+/**
+ * @class   BulletinExportEngine
+ * @brief   Parallel bulletin export engine.
+ *
+ * The engine fans the creation of per-event bulletin fragments out over a
+ * pool of workers. Each worker owns its own database connection (opened
+ * from the given URI), so that the round-trips of different events run
+ * concurrently. Fragments are written down in catalogue order as soon as
+ * they are available: the output file is streamed and only a small window
+ * of fragments is kept in memory at a time. When the export is canceled
+ * or fails (e.g. a write error), the footer is not written and the output
+ * and catalog files are removed.
+ *
+ * The engine is a QThread: start() it, then listen to progress() and
+ * jobDone() (emitted from the engine thread, use queued connections) and
+ * to finished().
+ */
+class BulletinExportEngine : public QThread {
+
+	Q_OBJECT
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		struct Job {
+				//! Detached copy of the event, owned by the job
+				Seiscomp::DataModel::EventPtr event;
+				//! Registered instance, GUI thread only (never read by workers)
+				Seiscomp::DataModel::OriginPtr origin;
+				//! Resolved in the GUI thread, workers mustn't touch widgets
+				std::string seismicCode;
+		};
+
+		struct Fragment {
+				Fragment() :
+						pickCount(0), valid(false) {}
+				std::string bulletin;
+				std::string catalog;
+				int pickCount;
+				bool valid;
+		};
+
+		/**
+		 * @brief Fragments producer interface.
+		 * @note  format() is called concurrently from every worker thread
+		 *        and must therefore only rely on its arguments and on
+		 *        read-only state.
+		 */
+		class Formatter {
+			public:
+				virtual ~Formatter() {}
+				virtual std::string header() {
+					return std::string();
+				}
+				virtual std::string footer() {
+					return std::string();
+				}
+				virtual bool format(Seiscomp::DataModel::DatabaseQuery*,
+				                    const IPGP::Core::BulletinLoader&,
+				                    const Job&, const int& index,
+				                    Fragment&) = 0;
+		};
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		explicit BulletinExportEngine(Formatter*, const std::string& databaseURI,
+		                              QObject* parent = NULL);
+		~BulletinExportEngine();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		void setJobs(const QVector<Job>&);
+		const QVector<Job>& jobs() const {
+			return _jobs;
+		}
+
+		void setOutputFile(const QString&);
+		//! Catalog parts of the fragments are streamed into this file
+		void setCatalogFile(const QString&);
+
+		//! Defaults to QThread::idealThreadCount()
+		void setWorkerCount(const int&);
+
+		//! Thread safe, may be called from the GUI thread at any time
+		void cancel();
+		bool isCanceled();
+
+		const QString& error() const {
+			return _error;
+		}
+		const int& exportedCount() const {
+			return _exportedCount;
+		}
+		const int& pickCount() const {
+			return _pickCount;
+		}
+
+	Q_SIGNALS:
+		// ------------------------------------------------------------------
+		//  Qt signals
+		// ------------------------------------------------------------------
+		void progress(const int& written, const int& total);
+		void jobDone(const int& index, const bool& valid);
+
+	protected:
+		// ------------------------------------------------------------------
+		//  Protected interface
+		// ------------------------------------------------------------------
+		void run();
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		friend class BulletinExportWorker;
+
+		/**
+		 * @brief  Reserves the next chunk of jobs to process.
+		 * @param  count the number of reserved jobs
+		 * @return the first job index, -1 when there is none left
+		 */
+		int takeJobs(int& count);
+		void storeFragment(const int& index, const Fragment&);
+		void abort(const QString& error);
+		void workerDone();
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		Formatter* _formatter;
+		std::string _databaseURI;
+		QString _outputFile;
+		QString _catalogFile;
+		QString _error;
+
+		QVector<Job> _jobs;
+		QVector<Fragment> _fragments;
+		QVector<bool> _ready;
+
+		QMutex _mutex;
+		QWaitCondition _fragmentStored;
+		QWaitCondition _fragmentWritten;
+
+		int _workerCount;
+		int _activeWorkers;
+		int _nextJob;
+		int _written;
+		int _window;
+		int _chunkSize;
+		int _exportedCount;
+		int _pickCount;
+		bool _canceled;
+};
+
+
+#endif
@@ -54,6 +54,7 @@
 #include <ipgp/gui/3rd-party/qprogressindicator/qprogressindicator.h>
 
 #include <ipgp/core/bulletin/bulletin.h>
+#include <ipgp/core/bulletin/bulletinloader.h>
 #include <ipgp/core/datamodel/objectcache.h>
 #include <ipgp/core/math/math.h>
 #include <ipgp/core/misc/misc.h>
@@ -63,6 +64,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <QFile>
+#include <QProgressDialog>
 #include <QTextStream>
 
 
@@ -84,6 +86,35 @@ using namespace IPGP::Gui::Client;
 using namespace IPGP::Gui::Misc;
 
 
+namespace {
+
+
+//! Maximum number of notifiers sent in a single message
+const int NotifierBatchSize = 100;
+
+
+/**
+ * @brief Copies the attributes of a registered event into an instance that
+ *        the export workers can own (children aren't needed by bulletins).
+ */
+EventPtr detachedEvent(Event* event) {
+
+	const bool registration = PublicObject::IsRegistrationEnabled();
+	PublicObject::SetRegistrationEnabled(false);
+
+	EventPtr copy = Event::Create(event->publicID());
+	if ( copy )
+	    *copy = *event;
+
+	PublicObject::SetRegistrationEnabled(registration);
+
+	return copy;
+}
+
+
+}
+
+
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 BulletinExporterView::BulletinExporterView(int& argc, char** argv) :
@@ -106,6 +137,8 @@ BulletinExporterView::BulletinExporterView(int& argc, char** argv) :
 	_manualCheck = NULL;
 	_noneCheck = NULL;
 	_allCheck = NULL;
+	_exportEngine = NULL;
+	_exportProgress = NULL;
 
 	_originCount = 0;
 	_eventCount = 0;
@@ -119,6 +152,8 @@ BulletinExporterView::BulletinExporterView(int& argc, char** argv) :
 	_useOneFilePerBulletin = false;
 	_hasQuakeMLSchema = false;
 	_setEventAsFinal = false;
+	_exportType = eGSE;
+	_exportWorkers = 0;
 
 	setLoadStationsEnabled(true);
 	setMasterMessagingGroup("LOCATION");
@@ -135,6 +170,14 @@ BulletinExporterView::BulletinExporterView(int& argc, char** argv) :
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 BulletinExporterView::~BulletinExporterView() {
 
+	// Workers use this instance as formatter, stop them before members die
+	if ( _exportEngine ) {
+		_exportEngine->cancel();
+		_exportEngine->wait();
+		delete _exportEngine;
+	}
+	_exportEngine = NULL;
+
 	if ( _map )
 	    delete _map;
 	_map = NULL;
@@ -227,6 +270,9 @@ bool BulletinExporterView::initConfiguration() {
 	try {
 		_useOneFilePerBulletin = configGetBool("bev.export.useOneFilePerBulletin");
 	} catch ( ... ) {}
+	try {
+		_exportWorkers = configGetInt("bev.export.workers");
+	} catch ( ... ) {}
 	try {
 		_showNotExistingOrigins = configGetBool("bev.showNotExistingOrigins");
 	} catch ( ... ) {}
@@ -453,10 +499,12 @@ void BulletinExporterView::setupApplicationMenus() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void BulletinExporterView::writeHypoCatalog(EventPtr event,
+void BulletinExporterView::writeHypoCatalog(std::string* catalog,
+                                            EventPtr event,
                                             OriginPtr origin,
                                             MagnitudePtr mag,
-                                            const std::string& id) {
+                                            const std::string& id,
+                                            const std::string& seismicCode) {
 
 	std::string date = origin->time().value().toString("%Y%m%d");
 	std::string hour = origin->time().value().toString("%H%M");
@@ -513,8 +561,7 @@ void BulletinExporterView::writeHypoCatalog(EventPtr event,
 		quality = origin->quality().groundTruthLevel();
 	} catch ( ... ) {}
 
-	std::string scode;
-	scode = _eventListWidget->getSeismicCode(event->publicID().c_str()).toStdString();
+	const std::string scode = seismicCode;
 
 	std::string azigap;
 	try {
@@ -522,75 +569,75 @@ void BulletinExporterView::writeHypoCatalog(EventPtr event,
 	} catch ( ... ) {}
 
 	// Date YYYYMMDD col 1-9
-	_hypoCatalog.append(date);
+	catalog->append(date);
 
 	// Hour Minute col 10-14
-	_hypoCatalog.append(addWhiteSpace(hour, 5, 0));
+	catalog->append(addWhiteSpace(hour, 5, 0));
 
 	// Seconds col 14-20 F6.2
-	_hypoCatalog.append(addWhiteSpace(sec, 6, 0));
+	catalog->append(addWhiteSpace(sec, 6, 0));
 
 	// Latitude col 20-29
-	_hypoCatalog.append(addWhiteSpace(lat, 9, 0));
+	catalog->append(addWhiteSpace(lat, 9, 0));
 
 	// Longitude col 30-39
-	_hypoCatalog.append(addWhiteSpace(lon, 10, 0));
+	catalog->append(addWhiteSpace(lon, 10, 0));
 
 	// Depth col 39-46
-	_hypoCatalog.append(addWhiteSpace(depth, 7, 0));
+	catalog->append(addWhiteSpace(depth, 7, 0));
 
 	// Blank col 46-47
-	_hypoCatalog.append(addWhiteSpace("", 1, 0));
+	catalog->append(addWhiteSpace("", 1, 0));
 
 	// Magnitude code col 47-48
 	if ( mag ) {
 		if ( mag->type().length() > 1 ) {
 			std::string magLetter = mag->type().substr(1, 1);
 			boost::to_upper(magLetter);
-			_hypoCatalog.append(addWhiteSpace(magLetter, 1, 0));
+			catalog->append(addWhiteSpace(magLetter, 1, 0));
 		}
 	}
 	else {
-		_hypoCatalog.append(addWhiteSpace("", 1, 0));
+		catalog->append(addWhiteSpace("", 1, 0));
 	}
 
 	// Magnitude col 48-53
-	_hypoCatalog.append(addWhiteSpace(magnitude, 5, 0));
+	catalog->append(addWhiteSpace(magnitude, 5, 0));
 
 	// Number of P & S times with weights greater than 0.1.
 	// becomes here the number of phases col 53-56
-	_hypoCatalog.append(addWhiteSpace(toString(origin->arrivalCount()), 3, 0));
+	catalog->append(addWhiteSpace(toString(origin->arrivalCount()), 3, 0));
 
 	// Azimuthal gap col 56-60
-	_hypoCatalog.append(addWhiteSpace(stripWhiteSpace(azigap), 4, 0));
+	catalog->append(addWhiteSpace(stripWhiteSpace(azigap), 4, 0));
 
 	// Distance to nearest station col 60-65
-	_hypoCatalog.append(addWhiteSpace(stripWhiteSpace(dMin), 5, 0));
+	catalog->append(addWhiteSpace(stripWhiteSpace(dMin), 5, 0));
 
 	// RMS travel time residual col 65-70
-	_hypoCatalog.append(addWhiteSpace(stripWhiteSpace(rms), 5, 0));
+	catalog->append(addWhiteSpace(stripWhiteSpace(rms), 5, 0));
 
 	// Horizontal error (km) col 70-75
-	_hypoCatalog.append(addWhiteSpace(stripWhiteSpace(erh), 5, 0));
+	catalog->append(addWhiteSpace(stripWhiteSpace(erh), 5, 0));
 
 	// Vertical error (km) col 75-80
-	_hypoCatalog.append(addWhiteSpace(stripWhiteSpace(erz), 5, 0));
+	catalog->append(addWhiteSpace(stripWhiteSpace(erz), 5, 0));
 
 	// Remark assigned by analyst (i.e. Q for quarry blast)
-	_hypoCatalog.append(addWhiteSpace("", 1, 0));
+	catalog->append(addWhiteSpace("", 1, 0));
 
 	// Quality code A-D
-	_hypoCatalog.append(addWhiteSpace(quality, 1, 0));
+	catalog->append(addWhiteSpace(quality, 1, 0));
 
 	// Most common data source (i.e. W= earthworm)
-	_hypoCatalog.append(addWhiteSpace("", 1, 0));
+	catalog->append(addWhiteSpace("", 1, 0));
 
 	// Auxiliary remark from program (i.e. “-“ for depth fixed, etc.)
-	_hypoCatalog.append(addWhiteSpace("", 1, 0));
+	catalog->append(addWhiteSpace("", 1, 0));
 
-	_hypoCatalog.append(addWhiteSpace(scode, 6, 1));
-	_hypoCatalog.append(id);
-	_hypoCatalog.append("\n");
+	catalog->append(addWhiteSpace(scode, 6, 1));
+	catalog->append(id);
+	catalog->append("\n");
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -598,15 +645,17 @@ void BulletinExporterView::writeHypoCatalog(EventPtr event,
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void BulletinExporterView::writeHypoBulletin(std::string* str,
-                                             EventPtr event, OriginPtr origin) {
+void BulletinExporterView::writeHypoBulletin(const BulletinLoader::Objects& objects,
+                                             std::string* str,
+                                             std::string* catalog,
+                                             int* pickCount, EventPtr event,
+                                             OriginPtr origin,
+                                             const std::string& seismicCode) {
 
 	PickList picks;
 	int errors = 0;
 
-	std::string scode = "";
-	scode = _eventListWidget->getSeismicCode(event->publicID().c_str()).toStdString();
-	scode = stripWhiteSpace(scode);
+	std::string scode = stripWhiteSpace(seismicCode);
 
 	std::string id = "";
 	if ( _instituteTag == "%originID%" )
@@ -618,13 +667,10 @@ void BulletinExporterView::writeHypoBulletin(std::string* str,
 //		id = origin->time().value().toString("%Y%m%d") + "_"
 //		        + origin->time().value().toString("%H%M") + _instituteTag;
 
-	if ( origin->arrivalCount() == 0 )
-	    query()->loadArrivals(origin.get());
-
+	// Arrivals, picks and preferred magnitude come from the bulk loader
 	for (size_t i = 0; i < origin->arrivalCount(); ++i) {
 
-		PickPtr pick = Pick::Cast(PublicObjectPtr(query()->getObject(
-		    Pick::TypeInfo(), origin->arrival(i)->pickID())));
+		PickPtr pick = IPGP::Core::Misc::getPick(origin->arrival(i)->pickID(), objects.picks);
 
 		if ( pick )
 			picks.push_back(pick);
@@ -634,9 +680,15 @@ void BulletinExporterView::writeHypoBulletin(std::string* str,
 		}
 	}
 
+	// Amplitudes indexed by pick, looked up with the phase as type
+	typedef std::multimap<std::string, AmplitudePtr> AmplitudeIndex;
+	AmplitudeIndex amplitudes;
+	for (size_t i = 0; i < objects.amplitudes.size(); ++i)
+		amplitudes.insert(std::make_pair(objects.amplitudes.at(i)->pickID(),
+		    objects.amplitudes.at(i)));
+
 	std::string magnitude;
-	MagnitudePtr mag = Magnitude::Cast(PublicObjectPtr(query()->getObject(
-	    Magnitude::TypeInfo(), event->preferredMagnitudeID())));
+	MagnitudePtr mag = objects.magnitude;
 	if ( mag )
 	    try {
 		    magnitude = "M=" + stringify("%3.1f", mag->magnitude().value());
@@ -644,7 +696,7 @@ void BulletinExporterView::writeHypoBulletin(std::string* str,
 
 
 	// Adding line to catalog content
-	writeHypoCatalog(event, origin, mag, id);
+	writeHypoCatalog(catalog, event, origin, mag, id, seismicCode);
 
 	bool isPPhase = false;
 	bool isSPhase = false;
@@ -771,7 +823,13 @@ void BulletinExporterView::writeHypoBulletin(std::string* str,
 
 			if ( isIntegrated == false ) {
 
-				AmplitudePtr amp = query()->getAmplitude(pick->publicID(), pick->phaseHint().code());
+				AmplitudePtr amp;
+				std::pair<AmplitudeIndex::const_iterator, AmplitudeIndex::const_iterator>
+				        range = amplitudes.equal_range(pick->publicID());
+				for (AmplitudeIndex::const_iterator it = range.first;
+				        it != range.second && !amp; ++it)
+					if ( it->second->type() == pick->phaseHint().code() )
+					    amp = it->second;
 				if ( amp )
 				    try {
 					    if ( amp->period().value() != .0 )
@@ -825,7 +883,7 @@ void BulletinExporterView::writeHypoBulletin(std::string* str,
 		//! writing down P-phase with S-phase
 		if ( isPPhase == true && isSPhase == true ) {
 
-			_pickCount += 2;
+			*pickCount += 2;
 
 			//! station name //! alphanumeric 4
 			*str += addWhiteSpace(stationCode, 4, 1);
@@ -930,7 +988,7 @@ void BulletinExporterView::writeHypoBulletin(std::string* str,
 		// writing down P-phase without S-phase
 		if ( isPPhase == true && isSPhase == false ) {
 
-			_pickCount++;
+			(*pickCount)++;
 
 			//! station name //! alphanumeric 4
 			//<< Hypo71::addWhiteSpace(toString(pick->waveformID().stationCode()), 4, 1)
@@ -1044,56 +1102,257 @@ void BulletinExporterView::writeHypoBulletin(std::string* str,
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-bool BulletinExporterView::writeBulletinToFile(const std::string& str,
-                                               const EXPORT_TYPE& type) {
+bool BulletinExporterView::startExport(const EXPORT_TYPE& type) {
 
-	bool retCode = false;
+	if ( _exportEngine ) {
+		QMessageBox::warning(mainWindow(), tr("Export"),
+		    tr("An export is already running, please wait for it to finish."));
+		return false;
+	}
 
-	if ( str.compare("") == 0 )
-		QMessageBox::critical(mainWindow(), tr("Error"),
-		    QString("No data have been generated by export module."));
-	else {
+	if ( !getOutputFile() ) return false;
 
-		if ( type == eHYPO71 ) {
-			QString outCat = _outputFile + QString(".CATALOG.TXT");
-			QFile catfile(outCat);
-			if ( !catfile.open(QIODevice::WriteOnly) ) {
-				return false;
-			}
-			else {
-				catfile.write(_hypoCatalog.c_str());
-				catfile.close();
-			}
-			_outputFile.append(".TXT");
+	// objects counters
+	_eventCount = 0;
+	_originCount = 0;
+	_pickCount = 0;
+	_magnitudeCount = 0;
+	_exportedJobs.clear();
+
+	if ( _exportDialog ) {
+		_exportDialog->hide();
+		delete _exportDialog;
+		_exportDialog = NULL;
+	}
+
+	if ( type == eQML ) {
+		if ( _quakemlSchemaFile == "" ) {
+			QMessageBox::warning(mainWindow(), tr("Erreur"),
+			    tr("No QuakeML schema file defined in configuration.\n"
+				    "Please specify one."));
+			return false;
 		}
-		else if ( type == eGSE )
-			_outputFile.append(".gse");
-		else if ( type == eIMS )
-			_outputFile.append(".ims");
-		else if ( type == eQML || type == eSC3ML )
-		    _outputFile.append(".xml");
-
-		QFile file(_outputFile);
-		if ( !file.open(QIODevice::WriteOnly) ) {
-			QMessageBox::critical(mainWindow(), tr("Error"),
-			    QString("Couldn't open file %1.\n"
-				    "Please make sure the storage unit is writable.").arg(_outputFile));
+		if ( !Util::fileExists(_quakemlSchemaFile) ) {
+			log(LM_ERROR, __func__, QString("QuakeML schema file %1 not found")
+			        .arg(_quakemlSchemaFile.c_str()));
+			QMessageBox::warning(mainWindow(), tr("Error"),
+			    QString::fromUtf8("File %1 seems to be missing.\n"
+				    "Please ensure it is present and conform.")
+			            .arg(_quakemlSchemaFile.c_str()));
 			return false;
 		}
-		else {
-			file.write(str.c_str());
-			file.close();
+	}
+
+	showOriginWarning();
+
+	QVector<QPair<QString, bool> > list = _eventListWidget->eventsCheckStateVector();
+
+	// Jobs are built in catalogue order, everything a worker needs from the
+	// event list widget (objects, seismic code) is resolved here
+	QVector<BulletinExportEngine::Job> jobs;
+	for (int i = 0; i < list.size(); ++i) {
+
+		if ( !list.at(i).second ) continue;
+
+		EventPtr event = _eventListWidget->getEvent(list.at(i).first.toStdString());
+
+		if ( !event ) {
+			SEISCOMP_DEBUG("Skipped event %s because it has not been found",
+			    list.at(i).first.toStdString().c_str());
+			continue;
 		}
 
-		retCode = true;
+		OriginPtr origin = _eventListWidget->getOrigin(event->preferredOriginID());
+
+		if ( !origin ) {
+			SEISCOMP_DEBUG("Skipped event %s, not origin found", event->publicID().c_str());
+			continue;
+		}
+
+		BulletinExportEngine::Job job;
+		job.event = detachedEvent(event.get());
+		job.origin = origin;
+		if ( type == eHYPO71 )
+		    job.seismicCode = _eventListWidget->getSeismicCode(event->publicID().c_str()).toStdString();
+		jobs.append(job);
+	}
+
+	if ( jobs.isEmpty() ) {
+		SEISCOMP_ERROR("There is no events checked to export");
+		QMessageBox::critical(mainWindow(), tr("Error"),
+		    QString("No data have been generated by export module."));
+		return false;
+	}
+
+	_exportType = type;
+	_exportMessageID = Time::GMT().toString("%Y/%m/%d_%H%M%S") + " " + _author;
+
+	QString catalogFile;
+	if ( type == eHYPO71 ) {
+		catalogFile = _outputFile + QString(".CATALOG.TXT");
+		_outputFile.append(".TXT");
+	}
+	else if ( type == eGSE )
+		_outputFile.append(".gse");
+	else if ( type == eIMS )
+		_outputFile.append(".ims");
+	else if ( type == eQML || type == eSC3ML )
+	    _outputFile.append(".xml");
+
+	_exportEngine = new BulletinExportEngine(this, _db, this);
+	_exportEngine->setJobs(jobs);
+	_exportEngine->setOutputFile(_outputFile);
+	_exportEngine->setCatalogFile(catalogFile);
+	if ( _exportWorkers > 0 )
+	    _exportEngine->setWorkerCount(_exportWorkers);
+
+	connect(_exportEngine, SIGNAL(progress(const int&, const int&)),
+	    this, SLOT(exportProgress(const int&, const int&)), Qt::QueuedConnection);
+	connect(_exportEngine, SIGNAL(jobDone(const int&, const bool&)),
+	    this, SLOT(exportJobDone(const int&, const bool&)), Qt::QueuedConnection);
+	connect(_exportEngine, SIGNAL(finished()), this, SLOT(exportFinished()),
+	    Qt::QueuedConnection);
+
+	_exportProgress = new QProgressDialog(tr("Exporting bulletin..."),
+	    tr("Cancel"), 0, jobs.size(), mainWindow());
+	_exportProgress->setWindowModality(Qt::ApplicationModal);
+	_exportProgress->setMinimumDuration(0);
+	_exportProgress->setAutoClose(false);
+	_exportProgress->setAutoReset(false);
+	connect(_exportProgress, SIGNAL(canceled()), this, SLOT(cancelExport()));
+	_exportProgress->show();
+
+	log(LM_OK, __func__, QString("Exporting %1 event(s) into %2")
+	        .arg(jobs.size()).arg(_outputFile));
+
+	_exportEngine->start();
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+std::string BulletinExporterView::header() {
+
+	std::string str;
+
+	if ( _exportType == eGSE ) {
+		str += "BEGIN GSE2.0\n";
+		str += "MSG_TYPE DATA\n";
+		str += "MSG_ID " + _exportMessageID + "\n";
+		str += "DATA_TYPE BULLETIN GSE2.0\n";
+	}
+	else if ( _exportType == eIMS ) {
+		str += "BEGIN IMS1.0\n";
+		str += "MSG_TYPE DATA\n";
+		str += "MSG_ID " + _exportMessageID + "\n";
+		str += "BULLETIN (IMS1.0:SHORT FORMAT)\n";
+		str += "DATA_TYPE BULLETIN IMS1.0:short\n";
+	}
+
+	return str;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+std::string BulletinExporterView::footer() {
+
+	if ( _exportType == eGSE || _exportType == eIMS )
+	    return "STOP\n";
+
+	return std::string();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
 
-		QMessageBox::information(mainWindow(), tr("Successful export"),
-		    QString::fromUtf8("<p>Exported %1 event(s) containing :<br/>"
-			    "  * %2 origin(s)<br/> * %3 pick(s)<br/> * %4 magnitude(s)</p>").arg(_eventCount)
-		            .arg(_originCount).arg(_pickCount).arg(_magnitudeCount));
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BulletinExporterView::format(DatabaseQuery* query,
+                                  const BulletinLoader& loader,
+                                  const BulletinExportEngine::Job& job,
+                                  const int& index,
+                                  BulletinExportEngine::Fragment& fragment) {
+
+	const BulletinLoader::Objects* objects = loader.objects(job.event.get());
+	if ( !objects ) {
+		SEISCOMP_ERROR("Can't get objects to create bulletin of event %s",
+		    job.event->publicID().c_str());
+		return false;
+	}
+
+	if ( _exportType == eHYPO71 ) {
+		//! The loaded instance holds the arrivals
+		writeHypoBulletin(*objects, &fragment.bulletin, &fragment.catalog,
+		    &fragment.pickCount, job.event, objects->origin, job.seismicCode);
+		return true;
+	}
+
+	Bulletin bul(job.event.get(), query);
+
+	if ( !bul.getObjects(loader) ) {
+		SEISCOMP_ERROR("Can't get objects to create bulletin of event %s",
+		    job.event->publicID().c_str());
+		return false;
 	}
 
-	return retCode;
+	if ( _exportType == eGSE ) {
+		fragment.bulletin = bul.getBulletin(IPGP::Core::Bulletin::GSE2_0);
+		return true;
+	}
+
+	if ( _exportType == eIMS ) {
+		fragment.bulletin = bul.getBulletin(IPGP::Core::Bulletin::IMS1_0);
+		return true;
+	}
+
+	if ( _exportType != eQML )
+	    return false;
+
+	// Exporting event as SC3ML in temp file, one per job since workers
+	// run the converter concurrently
+	const std::string outFile = _tempFolder + "event-sc3ml-" + toString(index) + ".xml";
+	const std::string inFile = _tempFolder + "event-quakeml-" + toString(index) + ".xml";
+
+	std::ofstream out(outFile.c_str());
+	out << bul.getBulletin(IPGP::Core::Bulletin::QUAKEML) << std::endl;
+	out.close();
+
+	QString cmd = QString("xalan -in %1 -xsl %2 -out %3 -html -indent 4")
+	        .arg(outFile.c_str()).arg(_quakemlSchemaFile.c_str())
+	        .arg(inFile.c_str());
+
+	QProcess process;
+	process.start(cmd);
+
+	if ( !process.waitForStarted() ) {
+		SEISCOMP_ERROR("QuakeML converter process couldn't start");
+		return false;
+	}
+
+	if ( !process.waitForFinished() ) {
+		SEISCOMP_ERROR("QuakeML converter process couldn't finish");
+		return false;
+	}
+
+	std::ifstream file(inFile.c_str());
+	std::string line;
+	while ( file.good() ) {
+		getline(file, line);
+		fragment.bulletin += line + "\n";
+	}
+	file.close();
+
+	QFile::remove(outFile.c_str());
+	QFile::remove(inFile.c_str());
+
+	return true;
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1496,100 +1755,15 @@ void BulletinExporterView::showOriginWarning() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-bool BulletinExporterView::exportAsGSE() {
-
-	if ( !getOutputFile() ) return false;
-
-	// objects counters
-	_eventCount = 0;
-	_originCount = 0;
-	_pickCount = 0;
-	_magnitudeCount = 0;
-
-	if ( _exportDialog ) {
-		_exportDialog->hide();
-		delete _exportDialog;
-		_exportDialog = NULL;
-	}
-
-	showOriginWarning();
-
-	Time now = Time::GMT();
-	std::string outputString;
-	outputString += "BEGIN GSE2.0\n";
-	outputString += "MSG_TYPE DATA\n";
-	outputString += "MSG_ID " + now.toString("%Y/%m/%d_%H%M%S") + " " + _author + "\n";
-	outputString += "DATA_TYPE BULLETIN GSE2.0\n";
-
-
-	QVector<QPair<QString, bool> > list = _eventListWidget->eventsCheckStateVector();
-
-	if ( list.size() == 0 ) {
-		SEISCOMP_ERROR("There is no events checked to export");
-		return false;
-	}
-
-	loadingPercentage(0, applicationName(), "Creating GSE bulletin");
-
-	for (int i = 0; i < list.size(); ++i) {
-
-		QString publicID = list.at(i).first;
-		const bool checked = list.at(i).second;
-
-		if ( !checked ) continue;
-
-		EventPtr event = _eventListWidget->getEvent(publicID.toStdString());
-
-		if ( !event ) {
-			SEISCOMP_DEBUG("Skipped event %s because it has not been found", event.get()->publicID().c_str());
-			continue;
-		}
-
-		OriginPtr origin = _eventListWidget->getOrigin(event->preferredOriginID());
-
-		if ( !origin ) {
-			SEISCOMP_DEBUG("Skipped event %s, not origin found", event.get()->publicID().c_str());
-			continue;
-		}
-
-		Bulletin bul(event.get(), query());
-
-		if ( !bul.getObjects() ) {
-			log(LM_ERROR, __func__, "Can't get objects to create GSE 2.0 bulletin");
-			SEISCOMP_ERROR("Can't get objects to create bulletin");
-			return false;
-		}
-
-		outputString += bul.getBulletin(IPGP::Core::Bulletin::GSE2_0);
-
-		_eventCount++;
-		_originCount++;
-
-		if ( _setEventAsFinal ) {
-
-			Notifier::SetEnabled(true);
-
-			origin->setEvaluationStatus(EvaluationStatus(FINAL));
-
-			NotifierPtr n = new Notifier("EventParameters", OP_UPDATE, origin.get());
-			NotifierMessagePtr m = new NotifierMessage;
-			m->attach(n.get());
-			connection()->send(m.get());
-
-			Notifier::SetEnabled(false);
-		}
-
-		try {
-			loadingPercentage(percentageOfSomething<int>(list.size(), i),
-			    applicationName(), "Writing down GSE bulletin");
-		} catch ( ... ) {}
-	}
-
-	loadingPercentage(-1, applicationName(), "");
+void BulletinExporterView::exportProgress(const int& written,
+                                          const int& total) {
 
-	outputString += "STOP\n";
+	if ( !_exportProgress ) return;
 
-	return writeBulletinToFile(outputString, eGSE);
+	_exportProgress->setMaximum(total);
+	_exportProgress->setValue(written);
+	_exportProgress->setLabelText(QString("Exported %1 / %2 event(s)")
+	        .arg(written).arg(total));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1597,102 +1771,95 @@ bool BulletinExporterView::exportAsGSE() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-bool BulletinExporterView::exportAsIMS() {
+void BulletinExporterView::exportJobDone(const int& index, const bool& valid) {
 
-	if ( !getOutputFile() )
-	    return false;
+	if ( !valid || !_exportEngine ) return;
 
-	// objects counters
-	_eventCount = 0;
-	_originCount = 0;
-	_pickCount = 0;
-	_magnitudeCount = 0;
+	_eventCount++;
+	_originCount++;
+	_exportedJobs.append(index);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	if ( _exportDialog ) {
-		_exportDialog->hide();
-		delete _exportDialog;
-		_exportDialog = NULL;
-	}
 
-	showOriginWarning();
 
-	Time now = Time::GMT();
-	std::string outputString;
-	outputString += "BEGIN IMS1.0\n";
-	outputString += "MSG_TYPE DATA\n";
-	outputString += "MSG_ID " + now.toString("%Y/%m/%d_%H%M%S") + " " + _author + "\n";
-	outputString += "BULLETIN (IMS1.0:SHORT FORMAT)\n";
-	outputString += "DATA_TYPE BULLETIN IMS1.0:short\n";
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinExporterView::exportFinished() {
 
-	QVector<QPair<QString, bool> > list = _eventListWidget->eventsCheckStateVector();
+	if ( !_exportEngine ) return;
 
-	if ( list.size() == 0 ) {
-		SEISCOMP_ERROR("There is no events checked to export");
-		return false;
+	if ( _exportProgress ) {
+		_exportProgress->hide();
+		_exportProgress->deleteLater();
+		_exportProgress = NULL;
 	}
 
-	loadingPercentage(0, applicationName(), "Creating IMS bulletin");
+	_pickCount = _exportEngine->pickCount();
 
-	for (int i = 0; i < list.size(); ++i) {
+	const QString error = _exportEngine->error();
+	const bool canceled = _exportEngine->isCanceled();
 
-		QString publicID = list.at(i).first;
-		const bool checked = list.at(i).second;
+	// Workers are done, the registered origins of the exported events can
+	// now be updated and sent from the GUI thread. Nothing is flagged when
+	// the incomplete bulletin has been removed.
+	if ( _setEventAsFinal && error.isEmpty() && !canceled && !_exportedJobs.isEmpty() ) {
 
-		if ( !checked ) continue;
+		Notifier::SetEnabled(true);
 
-		EventPtr event = _eventListWidget->getEvent(publicID.toStdString());
+		// Large exports are split so no message exceeds the broker limits
+		int failed = 0;
+		NotifierMessagePtr m = new NotifierMessage;
+		for (int i = 0; i < _exportedJobs.size(); ++i) {
 
-		if ( !event ) {
-			SEISCOMP_DEBUG("Skipped event %s because it has not been found", event.get()->publicID().c_str());
-			continue;
-		}
-
-		OriginPtr origin = _eventListWidget->getOrigin(event->preferredOriginID());
-
-		if ( !origin ) {
-			SEISCOMP_DEBUG("Skipped event %s, not origin found", event.get()->publicID().c_str());
-			continue;
-		}
+			OriginPtr origin = _exportEngine->jobs().at(_exportedJobs.at(i)).origin;
+			origin->setEvaluationStatus(EvaluationStatus(FINAL));
+			m->attach(new Notifier("EventParameters", OP_UPDATE, origin.get()));
 
-		Bulletin bul(event.get(), query());
+			if ( static_cast<int>(m->size()) < NotifierBatchSize
+			        && i < _exportedJobs.size() - 1 )
+				continue;
 
-		if ( !bul.getObjects() ) {
-			log(LM_ERROR, __func__, "Can't get objects to create IMS 1.0 bulletin");
-			SEISCOMP_ERROR("Can't get objects to create bulletin");
-			return false;
+			if ( !connection() || !connection()->send(m.get()) )
+				failed += m->size();
+			m = new NotifierMessage;
 		}
 
-		outputString += bul.getBulletin(IPGP::Core::Bulletin::IMS1_0);
-
-		_eventCount++;
-		_originCount++;
-
-		if ( _setEventAsFinal ) {
+		Notifier::SetEnabled(false);
 
-			Notifier::SetEnabled(true);
-
-			origin->setEvaluationStatus(EvaluationStatus(FINAL));
-
-			NotifierPtr n = new Notifier("EventParameters", OP_UPDATE, origin.get());
-			NotifierMessagePtr m = new NotifierMessage;
-			m->attach(n.get());
-			connection()->send(m.get());
+		if ( failed > 0 )
+			log(LM_ERROR, __func__, QString("Failed to send the final status of %1 origin(s)")
+			        .arg(failed));
+	}
+	_exportedJobs.clear();
 
-			Notifier::SetEnabled(false);
-		}
+	_exportEngine->deleteLater();
+	_exportEngine = NULL;
 
-		try {
-			loadingPercentage(percentageOfSomething<int>(list.size(), i),
-			    applicationName(), "Writing down IMS bulletin");
-		} catch ( ... ) {}
+	if ( !error.isEmpty() ) {
+		log(LM_ERROR, __func__, error);
+		QMessageBox::critical(mainWindow(), tr("Error"),
+		    QString("%1.\nPlease make sure the storage unit is writable "
+			    "and the database reachable.").arg(error));
+		return;
 	}
 
-	loadingPercentage(-1, applicationName(), "");
+	if ( canceled ) {
+		log(LM_WARNING, __func__, QString("Export canceled after %1 event(s), incomplete file %2 removed")
+		        .arg(_eventCount).arg(_outputFile));
+		return;
+	}
 
-	outputString += "STOP\n";
+	if ( _eventCount == 0 ) {
+		QMessageBox::critical(mainWindow(), tr("Error"),
+		    QString("No data have been generated by export module."));
+		return;
+	}
 
-	return writeBulletinToFile(outputString, eIMS);
+	QMessageBox::information(mainWindow(), tr("Successful export"),
+	    QString::fromUtf8("<p>Exported %1 event(s) containing :<br/>"
+		    "  * %2 origin(s)<br/> * %3 pick(s)<br/> * %4 magnitude(s)</p>").arg(_eventCount)
+	            .arg(_originCount).arg(_pickCount).arg(_magnitudeCount));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1700,85 +1867,36 @@ bool BulletinExporterView::exportAsIMS() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-bool BulletinExporterView::exportAsHYPO71() {
-
-	if ( !getOutputFile() ) return false;
-
-	// objects counters
-	_eventCount = 0;
-	_originCount = 0;
-	_pickCount = 0;
-	_magnitudeCount = 0;
-
-	if ( _exportDialog ) {
-		_exportDialog->hide();
-		delete _exportDialog;
-		_exportDialog = NULL;
-	}
-
-	showOriginWarning();
-
-	_hypoCatalog.clear();
-	std::string outputString;
-
-	QVector<QPair<QString, bool> > list = _eventListWidget->eventsCheckStateVector();
-
-	if ( list.size() == 0 ) {
-		SEISCOMP_ERROR("There is no events checked to export");
-		return false;
-	}
-
-	loadingPercentage(0, applicationName(), "Creating HYPO71 bulletin");
-
-	for (int i = 0; i < list.size(); ++i) {
-
-		QString publicID = list.at(i).first;
-		const bool checked = list.at(i).second;
-
-		if ( !checked ) continue;
-
-		EventPtr event = _eventListWidget->getEvent(publicID.toStdString());
-
-		if ( !event ) {
-			SEISCOMP_DEBUG("Skipped event %s because it has not been found", event.get()->publicID().c_str());
-			continue;
-		}
+void BulletinExporterView::cancelExport() {
+	if ( _exportEngine )
+	    _exportEngine->cancel();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-		OriginPtr origin = _eventListWidget->getOrigin(event->preferredOriginID());
 
-		if ( !origin ) {
-			SEISCOMP_DEBUG("Skipped event %s, not origin found", event.get()->publicID().c_str());
-			continue;
-		}
 
-		writeHypoBulletin(&outputString, event, origin);
 
-		_eventCount++;
-		_originCount++;
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BulletinExporterView::exportAsGSE() {
+	return startExport(eGSE);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-		if ( _setEventAsFinal ) {
 
-			Notifier::SetEnabled(true);
 
-			origin->setEvaluationStatus(EvaluationStatus(FINAL));
 
-			NotifierPtr n = new Notifier("EventParameters", DataModel::OP_UPDATE, origin.get());
-			NotifierMessagePtr m = new NotifierMessage;
-			m->attach(n.get());
-			connection()->send(m.get());
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BulletinExporterView::exportAsIMS() {
+	return startExport(eIMS);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-			Notifier::SetEnabled(false);
-		}
 
-		try {
-			loadingPercentage(percentageOfSomething<int>(list.size(), i),
-			    applicationName(), "Writing down HYPO71 bulletin");
-		} catch ( ... ) {}
-	}
 
-	loadingPercentage(-1, applicationName(), "");
 
-	return writeBulletinToFile(outputString, eHYPO71);
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BulletinExporterView::exportAsHYPO71() {
+	return startExport(eHYPO71);
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1918,144 +2036,7 @@ const double BulletinExporterView::getTimeValue(const PickList& picks,
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 bool BulletinExporterView::exportAsQUAKEML() {
-
-	if ( !getOutputFile() ) return false;
-
-	// objects counters
-	_eventCount = 0;
-	_originCount = 0;
-	_pickCount = 0;
-	_magnitudeCount = 0;
-
-
-	if ( _exportDialog ) {
-		_exportDialog->hide();
-		delete _exportDialog;
-		_exportDialog = NULL;
-	}
-
-	showOriginWarning();
-
-	std::string outputString;
-
-	EventParametersPtr ep = new EventParameters;
-
-	QVector<QPair<QString, bool> > list = _eventListWidget->eventsCheckStateVector();
-
-	if ( list.size() == 0 ) {
-		SEISCOMP_ERROR("There is no events checked to export");
-		return false;
-	}
-
-	loadingPercentage(0, applicationName(), "Creating QuakeML bulletin");
-
-	QString content;
-	for (int i = 0; i < list.size(); ++i) {
-
-		QString publicID = list.at(i).first;
-		const bool checked = list.at(i).second;
-
-		if ( !checked ) continue;
-
-		EventPtr event = _eventListWidget->getEvent(publicID.toStdString());
-
-		if ( !event ) {
-			SEISCOMP_DEBUG("Skipped event %s because it has not been found", event.get()->publicID().c_str());
-			continue;
-		}
-
-		OriginPtr origin = _eventListWidget->getOrigin(event->preferredOriginID());
-
-		if ( !origin ) {
-			SEISCOMP_DEBUG("Skipped event %s, not origin found", event.get()->publicID().c_str());
-			continue;
-		}
-
-		if ( _quakemlSchemaFile != "" ) {
-			if ( !Util::fileExists(_quakemlSchemaFile) ) {
-				log(LM_ERROR, __func__, QString("QuakeML schema file %1 not found")
-				        .arg(_quakemlSchemaFile.c_str()));
-				QMessageBox::warning(mainWindow(), tr("Error"),
-				    QString::fromUtf8("File %1 seems to be missing.\n"
-					    "Please ensure it is present and conform.")
-				            .arg(_quakemlSchemaFile.c_str()));
-				break;
-			}
-		}
-		else {
-			QMessageBox::warning(mainWindow(), tr("Erreur"),
-			    tr("No QuakeML schema file defined in configuration.\n"
-				    "Please specify one."));
-			break;
-		}
-
-		Bulletin bul(event.get(), query());
-
-		if ( !bul.getObjects() ) {
-			SEISCOMP_ERROR("Can't get objects to create bulletin");
-			return false;
-		}
-
-		// Exporting event as SC3ML in temp file
-		std::string outFile = _tempFolder + "event-sc3ml.xml";
-		std::ofstream out(outFile.c_str());
-		out << bul.getBulletin(IPGP::Core::Bulletin::QUAKEML) << std::endl;
-		out.close();
-
-		QString cmd = QString("xalan -in %1 -xsl %2 -out %3event-quakeml.xml -html -indent 4")
-		        .arg(outFile.c_str()).arg(_quakemlSchemaFile.c_str())
-		        .arg(_tempFolder.c_str());
-
-		QProcess process;
-		process.start(cmd);
-
-		log(LM_OK, __func__, "Waiting for converter to produce QuakeML file");
-
-		if ( !process.waitForStarted() ) {
-			log(LM_ERROR, __func__, "QuakeML converter process couldn't start");
-			return false;
-		}
-
-		if ( !process.waitForFinished() ) {
-			log(LM_ERROR, __func__, "QuakeML converter process couldn't finish");
-			return false;
-		}
-
-		std::string inFile = _tempFolder + "event-quakeml.xml";
-		std::ifstream file(inFile.c_str());
-		std::string line;
-		while ( file.good() ) {
-			getline(file, line);
-			content.append(QString("%1\n").arg(line.c_str()));
-		}
-
-		log(LM_OK, __func__, "Read back converted QuakeML file");
-
-		_eventCount++;
-		_originCount++;
-
-		if ( _setEventAsFinal ) {
-
-			Notifier::SetEnabled(true);
-
-			origin->setEvaluationStatus(EvaluationStatus(FINAL));
-
-			NotifierPtr n = new Notifier("EventParameters", OP_UPDATE, origin.get());
-			NotifierMessagePtr m = new NotifierMessage;
-			m->attach(n.get());
-			connection()->send(m.get());
-
-			Notifier::SetEnabled(false);
-		}
-
-		try {
-			loadingPercentage(percentageOfSomething<int>(list.size(), i),
-			    applicationName(), "Writing down QuakeML bulletin");
-		} catch ( ... ) {}
-	}
-	loadingPercentage(-1, applicationName(), "");
-
-	return writeBulletinToFile(content.toStdString(), eQML);
+	return startExport(eQML);
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -27,6 +27,8 @@
 
 #include <QObject>
 
+#include "bulletinexportengine.h"
+
 #include <ipgp/core/datamodel/types.h>
 #include <ipgp/gui/client/application.h>
 #include <ipgp/gui/datamodel/eventlist/eventlistwidget.h>
@@ -45,6 +47,7 @@
 QT_FORWARD_DECLARE_CLASS(QLabel);
 QT_FORWARD_DECLARE_CLASS(QStandardItemModel);
 QT_FORWARD_DECLARE_CLASS(QRadioButton);
+QT_FORWARD_DECLARE_CLASS(QProgressDialog);
 
 class QProgressIndicator;
 
@@ -63,7 +66,8 @@ DEFINE_IPGP_SMARTPOINTER(ProgressIndicator);
 }
 }
 
-class BulletinExporterView : public IPGP::Gui::Client::Application {
+class BulletinExporterView : public IPGP::Gui::Client::Application,
+        public BulletinExportEngine::Formatter {
 
 	Q_OBJECT
 
@@ -105,35 +109,56 @@ class BulletinExporterView : public IPGP::Gui::Client::Application {
 		//  Protected interface
 		// ------------------------------------------------------------------
 		/**
-		 * @brief Writes an Hypo2000 origins catalog.
+		 * @brief Writes an Hypo2000 origins catalog line.
+		 * @param catalog The container
 		 * @param event The event object pointer
 		 * @param origin The origin object pointer
 		 * @param mag The magnitude object pointer
 		 * @param id The ID that links an entry to its phases
+		 * @param seismicCode The event seismic code
 		 */
-		void writeHypoCatalog(Seiscomp::DataModel::EventPtr,
+		void writeHypoCatalog(std::string* catalog,
+		                      Seiscomp::DataModel::EventPtr,
 		                      Seiscomp::DataModel::OriginPtr,
 		                      Seiscomp::DataModel::MagnitudePtr,
-		                      const std::string& id);
+		                      const std::string& id,
+		                      const std::string& seismicCode);
 
-		//! Writes a bulletin in Hypo2000 format
 		/**
 		 * @brief Writes a phase bulletin in Hypo2000 format.
+		 * @param objects The event objects fetched by a BulletinLoader
 		 * @param str The container
+		 * @param catalog The catalog container
+		 * @param pickCount The exported picks counter
 		 * @param event The event object pointer
 		 * @param origin The origin object pointer
+		 * @param seismicCode The event seismic code
+		 * @note  Called from export workers: only relies on its arguments
+		 *        and on configuration values.
 		 */
-		void writeHypoBulletin(std::string* str, Seiscomp::DataModel::EventPtr,
-		                       Seiscomp::DataModel::OriginPtr);
+		void writeHypoBulletin(const IPGP::Core::BulletinLoader::Objects& objects,
+		                       std::string* str, std::string* catalog,
+		                       int* pickCount, Seiscomp::DataModel::EventPtr,
+		                       Seiscomp::DataModel::OriginPtr,
+		                       const std::string& seismicCode);
 
 		/**
-		 * @brief  Writes a bulletin from temporary file to physical file.
-		 * @param  file The file full path
+		 * @brief  Collects checked events and starts the export engine.
 		 * @param  type The bulletin export type
 		 * @see    enum EXPORT_TYPE to have a list of available formats
-		 * @return true on success, false otherwise
+		 * @return true if the export has been started, false otherwise
 		 */
-		bool writeBulletinToFile(const std::string&, const EXPORT_TYPE&);
+		bool startExport(const EXPORT_TYPE&);
+
+		// ------------------------------------------------------------------
+		//  BulletinExportEngine::Formatter interface
+		// ------------------------------------------------------------------
+		std::string header();
+		std::string footer();
+		bool format(Seiscomp::DataModel::DatabaseQuery*,
+		            const IPGP::Core::BulletinLoader&,
+		            const BulletinExportEngine::Job&, const int& index,
+		            BulletinExportEngine::Fragment&);
 
 	private:
 		// ------------------------------------------------------------------
@@ -177,6 +202,11 @@ class BulletinExporterView : public IPGP::Gui::Client::Application {
 		bool exportAsHYPO71();
 		bool exportAsQUAKEML();
 
+		void exportProgress(const int& written, const int& total);
+		void exportJobDone(const int& index, const bool& valid);
+		void exportFinished();
+		void cancelExport();
+
 		bool getOutputFile();
 		void showOriginWarning();
 		void updateMapItems();
@@ -202,6 +232,8 @@ class BulletinExporterView : public IPGP::Gui::Client::Application {
 		QLabel* _databaseLabel;
 
 		IPGP::Gui::ProgressIndicator* _progressIndicator;
+		QProgressDialog* _exportProgress;
+		BulletinExportEngine* _exportEngine;
 		QProgressIndicator* _pi;
 
 		QRadioButton* _allCheck;
@@ -219,10 +251,12 @@ class BulletinExporterView : public IPGP::Gui::Client::Application {
 		int _originCount;
 		int _pickCount;
 		int _magnitudeCount;
+		int _exportWorkers;
+		EXPORT_TYPE _exportType;
 
 		std::string _author;
 		std::string _institute;
-		std::string _hypoCatalog;
+		std::string _exportMessageID;
 		std::string _quakemlSchemaFile;
 		std::string _tempFolder;
 		std::string _instituteTag;
@@ -230,6 +264,9 @@ class BulletinExporterView : public IPGP::Gui::Client::Application {
 		std::vector<IPGP::Core::Locators> _locators;
 
 		bool _setEventAsFinal;
+		//! Jobs whose fragment has been written, their origins are set
+		//! FINAL once the engine has finished
+		QList<int> _exportedJobs;
 		bool _showNotLocatableOrigins;
 		bool _showOutOfNetworkOrigins;
 		bool _showOriginsWithNotType;
@@ -0,0 +1,87 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+
+#include <ipgp/gui/map/tilearchive.h>
+#include <QCoreApplication>
+#include <QStringList>
+#include <iostream>
+
+
+using namespace IPGP::Gui::Map;
+
+
+void usage() {
+	std::cerr << "Usage: sctilepack [--pattern pattern] [--min-zoom level] "
+	          "[--max-zoom level] [--no-downsampling] tile-directory archive-file"
+	          << std::endl;
+}
+
+
+int main(int argc, char** argv) {
+
+	QCoreApplication app(argc, argv);
+
+	QString pattern = DEFAULT_TILE_PATTERN.c_str();
+	int minZoom = MIN_ZOOM;
+	int maxZoom = MAX_ZOOM;
+	bool downsampling = true;
+	QStringList files;
+
+	QStringList args = app.arguments();
+	for (int i = 1; i < args.size(); ++i) {
+
+		const QString& arg = args.at(i);
+		if ( arg == "--pattern" && i + 1 < args.size() )
+			pattern = args.at(++i);
+		else if ( arg == "--min-zoom" && i + 1 < args.size() )
+			minZoom = args.at(++i).toInt();
+		else if ( arg == "--max-zoom" && i + 1 < args.size() )
+			maxZoom = args.at(++i).toInt();
+		else if ( arg == "--no-downsampling" )
+			downsampling = false;
+		else if ( arg == "-h" || arg == "--help" ) {
+			usage();
+			return 0;
+		}
+		else
+			files << arg;
+	}
+
+	if ( files.size() != 2 || minZoom > maxZoom ) {
+		usage();
+		return 1;
+	}
+
+	QString error;
+	const int count = TileArchive::pack(files.at(0), pattern, files.at(1),
+	    qMax(minZoom, 0), qMin(maxZoom, MAX_ZOOM), downsampling, &error);
+
+	if ( count < 0 ) {
+		std::cerr << error.toStdString() << std::endl;
+		return 1;
+	}
+
+	std::cout << "Packed " << count << " tiles into "
+	          << files.at(1).toStdString() << std::endl;
+
+	return 0;
+}
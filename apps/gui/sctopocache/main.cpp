@@ -0,0 +1,96 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+
+#include <ipgp/gui/opengl/topographycache.h>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QStringList>
+#include <iostream>
+
+
+using namespace IPGP::Gui::OpenGL;
+
+
+void usage() {
+	std::cerr << "Usage: sctopocache [--type stl|xyz] [--force] topography-file"
+	          << std::endl;
+}
+
+
+int main(int argc, char** argv) {
+
+	QCoreApplication app(argc, argv);
+
+	QString type;
+	bool force = false;
+	QStringList files;
+
+	QStringList args = app.arguments();
+	for (int i = 1; i < args.size(); ++i) {
+
+		const QString& arg = args.at(i);
+		if ( arg == "--type" && i + 1 < args.size() )
+			type = args.at(++i).toLower();
+		else if ( arg == "--force" )
+			force = true;
+		else if ( arg == "-h" || arg == "--help" ) {
+			usage();
+			return 0;
+		}
+		else
+			files << arg;
+	}
+
+	if ( files.size() != 1
+	        || (!type.isEmpty() && type != "stl" && type != "xyz") ) {
+		usage();
+		return 1;
+	}
+
+	//! The viewers only look for the cache next to the source file
+	const QString source = files.at(0);
+	const QString cache = TopographyCache::fileName(source);
+
+	if ( type.isEmpty() )
+		type = (QFileInfo(source).suffix().toLower() == "stl") ? "stl" : "xyz";
+	const TopographyFile::Type sourceType = (type == "stl") ?
+	        TopographyFile::STL : TopographyFile::XYZ;
+
+	if ( !force ) {
+		TopographyCache existing;
+		if ( existing.open(cache, sourceType) && existing.isUpToDate(source) ) {
+			std::cout << cache.toStdString() << " is up to date" << std::endl;
+			return 0;
+		}
+	}
+
+	QString error;
+	if ( !TopographyCache::build(source, sourceType, cache, &error) ) {
+		std::cerr << error.toStdString() << std::endl;
+		return 1;
+	}
+
+	std::cout << "Cached " << source.toStdString() << " into "
+	          << cache.toStdString() << std::endl;
+
+	return 0;
+}
@@ -67,6 +67,8 @@ using namespace IPGP::Gui::Misc;
 WorldEarthquakeView::WorldEarthquakeView(int& argc, char** argv) :
 		IPGP::Gui::Client::Application(argc, argv) {
 
+	setLoadCitiesEnabled(true);
+
 	_map = NULL;
 	_databaseLabel = NULL;
 	_configDialog = NULL;
@@ -1230,6 +1232,7 @@ void WorldEarthquakeView::setupGraphicalInterface() {
 	_map = new MapWidget(mapDescriptor().names(), mapDescriptor().paths(),
 	    mainWindow(), mapDescriptor().defaultLongitude(),
 	    mapDescriptor().defaultLatitude(), mapDescriptor().tilePattern());
+	_map->foregroundCanvas().addCities(cities());
 
 	QBoxLayout* lm = new QVBoxLayout(_ui->frameMap);
 	_ui->frameMap->setLayout(lm);
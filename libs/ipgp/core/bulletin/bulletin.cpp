@@ -21,6 +21,7 @@
 #define SEISCOMP_COMPONENT IPGPBULLETIN
 
 #include <ipgp/core/bulletin/bulletin.h>
+#include <ipgp/core/bulletin/bulletinloader.h>
 #include <ipgp/core/bulletin/isf.h>
 #include <ipgp/core/string/string.h>
 #include <ipgp/core/misc/misc.h>
@@ -76,59 +77,50 @@ bool Bulletin::getObjects() {
 
 	if ( !_query || !_event ) return false;
 
-	// Clear objects collections first
-	_arrivalList.clear();
-	_pickList.clear();
-	_amplitudeList.clear();
-	_stationMagnitudeList.clear();
-	_commentList.clear();
+	BulletinLoader loader(_query.get());
+	loader.addEvent(_event.get());
+	loader.load();
 
-	// Preferred magnitude
-	PublicObjectPtr obj = _query->getObject(Magnitude::TypeInfo(), _event->preferredMagnitudeID());
-	_magnitude = Magnitude::Cast(obj);
+	return getObjects(loader);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	// Preferred origin
-	obj = _query->getObject(Origin::TypeInfo(), _event->preferredOriginID());
-	_origin = Origin::Cast(obj);
 
-	if ( _origin ) {
 
-		if ( _origin->arrivalCount() == 0 )
-		    _query->loadArrivals(_origin.get());
 
-		if ( _origin->stationMagnitudeCount() == 0 )
-		    _query->loadStationMagnitudes(_origin.get());
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool Bulletin::getObjects(const BulletinLoader& loader) {
 
-		if ( _origin->magnitudeCount() == 0 )
-		    _query->loadMagnitudes(_origin.get());
+	// Clear objects collections first
+	_arrivalList.clear();
+	_pickList.clear();
+	_amplitudeList.clear();
+	_stationMagnitudeList.clear();
+	_amplitudeIndex.clear();
+	_stationMagnitudeIndex.clear();
+	_commentList.clear();
+	_origin = NULL;
+	_magnitude = NULL;
 
-		// Origin picks
-		DatabaseIterator di = _query->getPicks(_origin->publicID());
-		for (; *di; ++di) {
-			PickPtr pick = Pick::Cast(*di);
-			if ( pick )
-			    _pickList.push_back(pick);
-		}
+	const BulletinLoader::Objects* objects = loader.objects(_event.get());
+	if ( !objects )
+	    return false;
 
-		// Origin amplitudes
-		di = _query->getAmplitudesForOrigin(_origin->publicID());
-		for (; *di; ++di) {
-			AmplitudePtr amplitude = Amplitude::Cast(*di);
-			if ( amplitude )
-			    _amplitudeList.push_back(amplitude);
-		}
+	_origin = objects->origin;
+	_magnitude = objects->magnitude;
+	_pickList = objects->picks;
+	_amplitudeList = objects->amplitudes;
+	_stationMagnitudeList = objects->stationMagnitudes;
 
-		// Origin station magnitude
-		for (size_t j = 0; j < _origin->stationMagnitudeCount(); ++j) {
-			StationMagnitude* sta = _origin->stationMagnitude(j);
-			if ( sta )
-			    _stationMagnitudeList.push_back(sta);
-		}
+	_amplitudeIndex.clear();
+	for (size_t i = 0; i < _amplitudeList.size(); ++i)
+		_amplitudeIndex[_amplitudeList[i]->publicID()] = _amplitudeList[i].get();
 
-		return true;
-	}
+	_stationMagnitudeIndex.clear();
+	for (size_t i = 0; i < _stationMagnitudeList.size(); ++i)
+		_stationMagnitudeIndex[_stationMagnitudeList[i]->publicID()] = _stationMagnitudeList[i].get();
 
-	return false;
+	return true;
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -916,8 +908,7 @@ std::string Bulletin::getSC3MLBulletin() {
 
 		// Adding picks
 		for (size_t a = 0; a < _origin->arrivalCount(); ++a) {
-			PickPtr pick = Pick::Cast(PublicObjectPtr(
-			    _query->getObject(Pick::TypeInfo(), _origin->arrival(a)->pickID())));
+			PickPtr pick = Misc::getPick(_origin->arrival(a)->pickID(), _pickList);
 			if ( !pick ) {
 				SEISCOMP_WARNING("Pick with id '%s' not found",
 				    _origin->arrival(a)->pickID().c_str());
@@ -935,7 +926,7 @@ std::string Bulletin::getSC3MLBulletin() {
 			for (size_t s = 0; s < netmag->stationMagnitudeContributionCount();
 			        ++s) {
 
-				StationMagnitudePtr stamag = StationMagnitude::Find(
+				StationMagnitudePtr stamag = findStationMagnitude(
 				    netmag->stationMagnitudeContribution(s)->stationMagnitudeID());
 				if ( !stamag ) {
 					SEISCOMP_WARNING("StationMagnitude with id '%s' not found",
@@ -943,8 +934,7 @@ std::string Bulletin::getSC3MLBulletin() {
 					continue;
 				}
 
-				AmplitudePtr staamp = Amplitude::Cast(PublicObjectPtr(
-				    _query->getObject(Amplitude::TypeInfo(), stamag->amplitudeID())));
+				AmplitudePtr staamp = findAmplitude(stamag->amplitudeID());
 				if ( !staamp ) {
 					SEISCOMP_WARNING("Amplitude with id '%s' not found", stamag->amplitudeID().c_str());
 					continue;
@@ -973,6 +963,31 @@ std::string Bulletin::getSC3MLBulletin() {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+StationMagnitude* Bulletin::findStationMagnitude(const std::string& publicID) const {
+
+	std::map<std::string, StationMagnitude*>::const_iterator it =
+	    _stationMagnitudeIndex.find(publicID);
+
+	return (it != _stationMagnitudeIndex.end()) ? it->second : NULL;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+Amplitude* Bulletin::findAmplitude(const std::string& publicID) const {
+
+	std::map<std::string, Amplitude*>::const_iterator it = _amplitudeIndex.find(publicID);
+
+	return (it != _amplitudeIndex.end()) ? it->second : NULL;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 const std::string Bulletin::getBulletin(const Type& type) {
 
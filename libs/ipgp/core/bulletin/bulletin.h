@@ -34,6 +34,7 @@
 #include <seiscomp3/datamodel/stationmagnitude.h>
 #include <seiscomp3/datamodel/databasequery.h>
 #include <seiscomp3/datamodel/types.h>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -42,6 +43,7 @@
 namespace IPGP {
 namespace Core {
 
+class BulletinLoader;
 
 /**
  * @class   Bulletin
@@ -107,6 +109,14 @@ class SC_IPGP_CORE_API Bulletin {
 		 */
 		bool getObjects();
 
+		/**
+		 * @brief  Takes objects attached to current event from a loader
+		 *         which already fetched them, no query is performed.
+		 * @return True on success, false if the loader doesn't know the
+		 *         event's preferred origin.
+		 */
+		bool getObjects(const BulletinLoader&);
+
 		/**
 		 * @brief  Bulletin instance log file.
 		 * @return A list of log entries added by methods while commputing.
@@ -142,6 +152,11 @@ class SC_IPGP_CORE_API Bulletin {
 		std::string getIMSBulletin();
 		const std::string getEventType(Seiscomp::DataModel::EventType) const;
 
+		Seiscomp::DataModel::StationMagnitude*
+		findStationMagnitude(const std::string& publicID) const;
+		Seiscomp::DataModel::Amplitude*
+		findAmplitude(const std::string& publicID) const;
+
 		//! Not implemented yet!
 		std::string getHypo2000Bulletin();
 		std::string getHypo71Bulletin();
@@ -154,6 +169,9 @@ class SC_IPGP_CORE_API Bulletin {
 		std::vector<Seiscomp::DataModel::PickPtr> _pickList;
 		std::vector<Seiscomp::DataModel::AmplitudePtr> _amplitudeList;
 		std::vector<Seiscomp::DataModel::StationMagnitudePtr> _stationMagnitudeList;
+		//! publicID -> object, lookups of the lists above
+		std::map<std::string, Seiscomp::DataModel::Amplitude*> _amplitudeIndex;
+		std::map<std::string, Seiscomp::DataModel::StationMagnitude*> _stationMagnitudeIndex;
 		std::vector<Seiscomp::DataModel::CommentPtr> _commentList;
 		Seiscomp::DataModel::EventPtr _event;
 		Seiscomp::DataModel::DatabaseQueryPtr _query;
@@ -0,0 +1,435 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#define SEISCOMP_COMPONENT IPGPBULLETIN
+
+#include <ipgp/core/bulletin/bulletinloader.h>
+#include <seiscomp3/datamodel/arrival.h>
+#include <seiscomp3/datamodel/publicobject.h>
+#include <seiscomp3/datamodel/stationmagnitudecontribution.h>
+#include <seiscomp3/io/database.h>
+#include <seiscomp3/logging/log.h>
+#include <algorithm>
+#include <set>
+
+
+using namespace Seiscomp;
+using namespace Seiscomp::DataModel;
+
+
+namespace {
+
+
+typedef std::map<unsigned long, OriginPtr> OriginOIDs;
+typedef std::map<unsigned long, MagnitudePtr> MagnitudeOIDs;
+
+
+/**
+ * @brief Builds the content of an SQL IN (...) clause, the identifiers are
+ *        escaped by the database driver (quoting rules are backend specific).
+ */
+std::string inClause(IO::DatabaseInterface* db,
+                     std::vector<std::string>::const_iterator begin,
+                     std::vector<std::string>::const_iterator end) {
+
+	std::string str;
+	std::string escaped;
+	for (std::vector<std::string>::const_iterator it = begin; it != end; ++it) {
+
+		if ( !str.empty() )
+		    str += ",";
+
+		escaped.resize(it->size() * 2 + 1);
+		const size_t length = db->escape(&escaped[0], it->c_str(), it->size());
+
+		str += "'";
+		str.append(escaped, 0, length);
+		str += "'";
+	}
+
+	return str;
+}
+
+
+/**
+ * @brief Returns the object itself, or a detached copy of it when the
+ *        calling thread has disabled the registration and the object
+ *        belongs to the registry (i.e. it is shared with another thread).
+ */
+template <typename T>
+T* detached(T* object) {
+
+	if ( !object || PublicObject::IsRegistrationEnabled() || !object->registered() )
+	    return object;
+
+	T* copy = T::Create(object->publicID());
+	if ( copy )
+	    *copy = *object;
+
+	return copy;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Core {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BulletinLoader::BulletinLoader(DatabaseQuery* query) :
+		_query(query), _queryCount(0) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BulletinLoader::~BulletinLoader() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinLoader::addEvent(Event* event) {
+
+	if ( !event ) return;
+
+	_events[event->publicID()] = PreferredIDs(event->preferredOriginID(),
+	    event->preferredMagnitudeID());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinLoader::clear() {
+	_events.clear();
+	_origins.clear();
+	_objects.clear();
+	_magnitudes.clear();
+	_queryCount = 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BulletinLoader::load() {
+
+	if ( !_query ) return false;
+
+	std::vector<std::string> originIDs;
+	for (std::map<std::string, PreferredIDs>::const_iterator it = _events.begin();
+	        it != _events.end(); ++it)
+		if ( !it->second.first.empty() && _origins.find(it->second.first) == _origins.end() )
+		    originIDs.push_back(it->second.first);
+
+	std::sort(originIDs.begin(), originIDs.end());
+	originIDs.erase(std::unique(originIDs.begin(), originIDs.end()), originIDs.end());
+
+	bool retCode = true;
+	for (size_t i = 0; i < originIDs.size(); i += BatchSize) {
+		std::vector<std::string> batch(originIDs.begin() + i,
+		    originIDs.begin() + std::min(i + BatchSize, originIDs.size()));
+		retCode = loadBatch(batch) && retCode;
+	}
+
+	// Preferred magnitudes are most of the time network magnitudes of the
+	// preferred origin, only fetch the remaining ones
+	std::vector<std::string> magnitudeIDs;
+	for (std::map<std::string, PreferredIDs>::const_iterator it = _events.begin();
+	        it != _events.end(); ++it)
+		if ( !it->second.second.empty() && _magnitudes.find(it->second.second) == _magnitudes.end() )
+		    magnitudeIDs.push_back(it->second.second);
+
+	std::sort(magnitudeIDs.begin(), magnitudeIDs.end());
+	magnitudeIDs.erase(std::unique(magnitudeIDs.begin(), magnitudeIDs.end()), magnitudeIDs.end());
+
+	for (size_t i = 0; i < magnitudeIDs.size(); i += BatchSize) {
+		std::vector<std::string> batch(magnitudeIDs.begin() + i,
+		    magnitudeIDs.begin() + std::min(i + BatchSize, magnitudeIDs.size()));
+		retCode = loadMagnitudes(batch) && retCode;
+	}
+
+	assemble();
+
+	SEISCOMP_DEBUG("Loaded objects of %d event(s) using %d queries",
+	    (int) _events.size(), (int) _queryCount);
+
+	return retCode;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const BulletinLoader::Objects*
+BulletinLoader::objects(const Event* event) const {
+
+	if ( !event ) return NULL;
+
+	ObjectsMap::const_iterator it = _objects.find(event->publicID());
+	if ( it == _objects.end() || !it->second.origin )
+	    return NULL;
+
+	return &it->second;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BulletinLoader::loadBatch(const std::vector<std::string>& originIDs) {
+
+	const std::string ids = inClause(_query->driver(), originIDs.begin(), originIDs.end());
+	const std::string byOrigin = " AND POrigin.publicID IN (" + ids + ")";
+
+	OriginOIDs origins;
+	std::set<unsigned long> needArrivals, needMagnitudes, needStationMagnitudes;
+	MagnitudeOIDs needContributions;
+
+	// Origins
+	DatabaseIterator it = run("SELECT POrigin.publicID,Origin.* FROM Origin,"
+		"PublicObject AS POrigin WHERE Origin._oid=POrigin._oid" + byOrigin,
+	    Origin::TypeInfo());
+	for (; *it; ++it) {
+		OriginPtr origin = detached(Origin::Cast(*it));
+		if ( !origin ) continue;
+
+		origins[it.oid()] = origin;
+		_origins[origin->publicID()].origin = origin;
+
+		//! Cached instances may already hold their children
+		if ( origin->arrivalCount() == 0 )
+		    needArrivals.insert(it.oid());
+		if ( origin->magnitudeCount() == 0 )
+		    needMagnitudes.insert(it.oid());
+		if ( origin->stationMagnitudeCount() == 0 )
+		    needStationMagnitudes.insert(it.oid());
+	}
+
+	if ( origins.empty() )
+	    return true;
+
+	// Arrivals
+	it = run("SELECT Arrival.* FROM Arrival,PublicObject AS POrigin "
+		"WHERE Arrival._parent_oid=POrigin._oid" + byOrigin,
+	    Arrival::TypeInfo());
+	for (; *it; ++it) {
+		ArrivalPtr arrival = Arrival::Cast(*it);
+		if ( arrival && needArrivals.count(it.parentOid()) )
+		    origins[it.parentOid()]->add(arrival.get());
+	}
+
+	// Network magnitudes
+	it = run("SELECT PMagnitude.publicID,Magnitude.* FROM Magnitude,"
+		"PublicObject AS PMagnitude,PublicObject AS POrigin "
+		"WHERE Magnitude._oid=PMagnitude._oid "
+		"AND Magnitude._parent_oid=POrigin._oid" + byOrigin,
+	    Magnitude::TypeInfo());
+	for (; *it; ++it) {
+		MagnitudePtr magnitude = detached(Magnitude::Cast(*it));
+		if ( !magnitude ) continue;
+
+		_magnitudes[magnitude->publicID()] = magnitude;
+
+		if ( needMagnitudes.count(it.parentOid()) )
+		    origins[it.parentOid()]->add(magnitude.get());
+		if ( magnitude->stationMagnitudeContributionCount() == 0 )
+		    needContributions[it.oid()] = magnitude;
+	}
+
+	// Station magnitude contributions
+	if ( !needContributions.empty() ) {
+		it = run("SELECT StationMagnitudeContribution.* FROM "
+			"StationMagnitudeContribution,Magnitude,PublicObject AS POrigin "
+			"WHERE StationMagnitudeContribution._parent_oid=Magnitude._oid "
+			"AND Magnitude._parent_oid=POrigin._oid" + byOrigin,
+		    StationMagnitudeContribution::TypeInfo());
+		for (; *it; ++it) {
+			StationMagnitudeContributionPtr contribution = StationMagnitudeContribution::Cast(*it);
+			MagnitudeOIDs::iterator mag = needContributions.find(it.parentOid());
+			if ( contribution && mag != needContributions.end() )
+			    mag->second->add(contribution.get());
+		}
+	}
+
+	// Station magnitudes
+	it = run("SELECT PStationMagnitude.publicID,StationMagnitude.* FROM "
+		"StationMagnitude,PublicObject AS PStationMagnitude,"
+		"PublicObject AS POrigin "
+		"WHERE StationMagnitude._oid=PStationMagnitude._oid "
+		"AND StationMagnitude._parent_oid=POrigin._oid" + byOrigin,
+	    StationMagnitude::TypeInfo());
+	for (; *it; ++it) {
+		StationMagnitudePtr sta = detached(StationMagnitude::Cast(*it));
+		if ( sta && needStationMagnitudes.count(it.parentOid()) )
+		    origins[it.parentOid()]->add(sta.get());
+	}
+
+	// Picks referenced by arrivals
+	std::map<std::string, PickPtr> picks;
+	it = run("SELECT DISTINCT PPick.publicID,Pick.* FROM Arrival,"
+		"PublicObject AS POrigin,Pick,PublicObject AS PPick "
+		"WHERE Arrival._parent_oid=POrigin._oid" + byOrigin +
+		" AND PPick.publicID=Arrival.pickID AND Pick._oid=PPick._oid",
+	    Pick::TypeInfo());
+	for (; *it; ++it) {
+		PickPtr pick = detached(Pick::Cast(*it));
+		if ( pick )
+		    picks[pick->publicID()] = pick;
+	}
+
+	// Amplitudes referencing those picks
+	std::multimap<std::string, AmplitudePtr> amplitudes;
+	std::set<std::string> amplitudeIDs;
+	it = run("SELECT DISTINCT PAmplitude.publicID,Amplitude.* FROM Arrival,"
+		"PublicObject AS POrigin,Amplitude,PublicObject AS PAmplitude "
+		"WHERE Arrival._parent_oid=POrigin._oid" + byOrigin +
+		" AND Amplitude.pickID=Arrival.pickID AND Amplitude._oid=PAmplitude._oid",
+	    Amplitude::TypeInfo());
+	for (; *it; ++it) {
+		AmplitudePtr amplitude = detached(Amplitude::Cast(*it));
+		if ( amplitude && amplitudeIDs.insert(amplitude->publicID()).second )
+		    amplitudes.insert(std::make_pair(amplitude->pickID(), amplitude));
+	}
+
+	// Amplitudes referenced by station magnitudes, which aren't necessarily
+	// measured on an associated pick
+	std::map<std::string, AmplitudePtr> stationAmplitudes;
+	it = run("SELECT DISTINCT PAmplitude.publicID,Amplitude.* FROM StationMagnitude,"
+		"PublicObject AS POrigin,Amplitude,PublicObject AS PAmplitude "
+		"WHERE StationMagnitude._parent_oid=POrigin._oid" + byOrigin +
+		" AND PAmplitude.publicID=StationMagnitude.amplitudeID"
+		" AND Amplitude._oid=PAmplitude._oid",
+	    Amplitude::TypeInfo());
+	for (; *it; ++it) {
+		AmplitudePtr amplitude = detached(Amplitude::Cast(*it));
+		if ( amplitude )
+		    stationAmplitudes[amplitude->publicID()] = amplitude;
+	}
+
+	// Dispatch objects to their origin
+	for (OriginOIDs::iterator o = origins.begin(); o != origins.end(); ++o) {
+
+		OriginPtr origin = o->second;
+		Objects& objects = _origins[origin->publicID()];
+
+		std::set<std::string> seen, seenAmplitudes;
+		for (size_t i = 0; i < origin->arrivalCount(); ++i) {
+
+			const std::string& pickID = origin->arrival(i)->pickID();
+			if ( !seen.insert(pickID).second ) continue;
+
+			std::map<std::string, PickPtr>::iterator p = picks.find(pickID);
+			if ( p != picks.end() )
+			    objects.picks.push_back(p->second);
+
+			typedef std::multimap<std::string, AmplitudePtr>::iterator AmpIt;
+			std::pair<AmpIt, AmpIt> range = amplitudes.equal_range(pickID);
+			for (AmpIt a = range.first; a != range.second; ++a)
+				if ( seenAmplitudes.insert(a->second->publicID()).second )
+				    objects.amplitudes.push_back(a->second);
+		}
+
+		for (size_t i = 0; i < origin->stationMagnitudeCount(); ++i) {
+
+			StationMagnitude* sta = origin->stationMagnitude(i);
+			objects.stationMagnitudes.push_back(sta);
+
+			std::map<std::string, AmplitudePtr>::iterator a =
+			    stationAmplitudes.find(sta->amplitudeID());
+			if ( a != stationAmplitudes.end()
+			        && seenAmplitudes.insert(a->first).second )
+			    objects.amplitudes.push_back(a->second);
+		}
+	}
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BulletinLoader::loadMagnitudes(const std::vector<std::string>& magnitudeIDs) {
+
+	DatabaseIterator it = run("SELECT PMagnitude.publicID,Magnitude.* FROM "
+		"Magnitude,PublicObject AS PMagnitude WHERE Magnitude._oid=PMagnitude._oid "
+		"AND PMagnitude.publicID IN (" + inClause(_query->driver(),
+		magnitudeIDs.begin(), magnitudeIDs.end()) + ")", Magnitude::TypeInfo());
+	for (; *it; ++it) {
+		MagnitudePtr magnitude = detached(Magnitude::Cast(*it));
+		if ( magnitude )
+		    _magnitudes[magnitude->publicID()] = magnitude;
+	}
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BulletinLoader::assemble() {
+
+	_objects.clear();
+
+	for (std::map<std::string, PreferredIDs>::const_iterator it = _events.begin();
+	        it != _events.end(); ++it) {
+
+		ObjectsMap::const_iterator o = _origins.find(it->second.first);
+		if ( o == _origins.end() ) continue;
+
+		Objects& objects = _objects[it->first];
+		objects = o->second;
+
+		std::map<std::string, MagnitudePtr>::const_iterator m = _magnitudes.find(it->second.second);
+		if ( m != _magnitudes.end() )
+		    objects.magnitude = m->second;
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+DatabaseIterator BulletinLoader::run(const std::string& query,
+                                     const Seiscomp::Core::RTTI& type) {
+	_queryCount++;
+	return _query->getObjectIterator(query, type);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+} // namespace Core
+} // namespace IPGP
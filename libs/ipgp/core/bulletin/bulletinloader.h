@@ -0,0 +1,141 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef __IPGP_CORE_BULLETINLOADER_H__
+#define __IPGP_CORE_BULLETINLOADER_H__
+
+#include <ipgp/core/api.h>
+#include <seiscomp3/datamodel/event.h>
+#include <seiscomp3/datamodel/origin.h>
+#include <seiscomp3/datamodel/amplitude.h>
+#include <seiscomp3/datamodel/magnitude.h>
+#include <seiscomp3/datamodel/pick.h>
+#include <seiscomp3/datamodel/stationmagnitude.h>
+#include <seiscomp3/datamodel/databasequery.h>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace IPGP {
+namespace Core {
+
+
+/**
+ * @class   BulletinLoader
+ * @package IPGP::Core::Bulletin
+ * @brief   Set-based loader of the objects a bulletin is made of.
+ *
+ * Events are queued with addEvent() and load() then fetches the preferred
+ * origins of all of them, their arrivals, magnitudes (and contributions),
+ * station magnitudes, picks and amplitudes, plus the preferred magnitudes,
+ * in a fixed number of queries per batch of origins. One loader can be
+ * shared by many Bulletin instances (see Bulletin::getObjects(const
+ * BulletinLoader&)), none of which has to query the database anymore.
+ * @note  Children are only attached to origins/magnitudes which don't
+ *        already have any, like DatabaseQuery::load* calls used to.
+ *        A thread which disabled the PublicObject registration gets
+ *        detached copies of registry-cached objects instead, so that the
+ *        instances shared with the GUI thread are never modified.
+ */
+class SC_IPGP_CORE_API BulletinLoader {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		struct Objects {
+				Seiscomp::DataModel::OriginPtr origin;
+				Seiscomp::DataModel::MagnitudePtr magnitude;
+				std::vector<Seiscomp::DataModel::PickPtr> picks;
+				std::vector<Seiscomp::DataModel::AmplitudePtr> amplitudes;
+				std::vector<Seiscomp::DataModel::StationMagnitudePtr> stationMagnitudes;
+		};
+
+		//! Maximum number of publicIDs per IN (...) clause
+		static const size_t BatchSize = 500;
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		explicit BulletinLoader(Seiscomp::DataModel::DatabaseQuery*);
+		~BulletinLoader();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! Queues the event's preferred origin and magnitude
+		void addEvent(Seiscomp::DataModel::Event*);
+
+		/**
+		 * @brief  Loads every queued event's objects.
+		 * @return true if no query failed, false otherwise
+		 */
+		bool load();
+
+		/**
+		 * @brief  Fetches the objects of an event.
+		 * @return the objects or NULL if the event's preferred origin hasn't
+		 *         been loaded
+		 */
+		const Objects* objects(const Seiscomp::DataModel::Event*) const;
+
+		void clear();
+
+		const size_t queryCount() const {
+			return _queryCount;
+		}
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		bool loadBatch(const std::vector<std::string>& originIDs);
+		bool loadMagnitudes(const std::vector<std::string>& magnitudeIDs);
+		void assemble();
+		Seiscomp::DataModel::DatabaseIterator run(const std::string& query,
+		                                          const Seiscomp::Core::RTTI&);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		typedef std::map<std::string, Objects> ObjectsMap;
+		typedef std::pair<std::string, std::string> PreferredIDs;
+
+		Seiscomp::DataModel::DatabaseQueryPtr _query;
+		//! eventID -> (preferred originID, preferred magnitudeID)
+		std::map<std::string, PreferredIDs> _events;
+		//! originID -> origin subtree (no preferred magnitude)
+		ObjectsMap _origins;
+		//! eventID -> bulletin objects
+		ObjectsMap _objects;
+		std::map<std::string, Seiscomp::DataModel::MagnitudePtr> _magnitudes;
+		size_t _queryCount;
+};
+
+
+} // namespace Core
+} // namespace IPGP
+
+#endif
@@ -0,0 +1,211 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#define SEISCOMP_COMPONENT IPGP_INVENTORYSNAPSHOT
+
+#include <ipgp/core/datamodel/inventorysnapshot.h>
+#include <seiscomp3/datamodel/network.h>
+#include <seiscomp3/datamodel/station.h>
+#include <seiscomp3/logging/log.h>
+#include <seiscomp3/utils/timer.h>
+#include <algorithm>
+
+
+using namespace Seiscomp;
+using namespace Seiscomp::DataModel;
+
+
+namespace {
+
+
+bool byStart(const IPGP::Core::InventorySnapshot::Station& a,
+             const IPGP::Core::InventorySnapshot::Station& b) {
+	return a.start < b.start;
+}
+
+
+typedef std::map<std::string, IPGP::Core::InventorySnapshot> SnapshotMap;
+
+//! Snapshots only hold plain data, nothing outlives the database drivers
+SnapshotMap& sharedSnapshots() {
+	static SnapshotMap snapshots;
+	return snapshots;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Core {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool InventorySnapshot::Station::isActive(const Seiscomp::Core::Time& time) const {
+	return start <= time && (!end.valid() || time < end);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+InventorySnapshot::InventorySnapshot() :
+		_loaded(false) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+InventorySnapshot::~InventorySnapshot() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+InventorySnapshot* InventorySnapshot::Shared(const std::string& databaseURI,
+                                             DatabaseQuery* query) {
+
+	if ( !query ) return NULL;
+
+	InventorySnapshot& snapshot = sharedSnapshots()[databaseURI];
+	if ( !snapshot.isLoaded() )
+	    snapshot.load(query);
+
+	return &snapshot;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void InventorySnapshot::Reset() {
+	sharedSnapshots().clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool InventorySnapshot::load(DatabaseQuery* query) {
+
+	clear();
+
+	if ( !query ) return false;
+
+	Util::StopWatch sw;
+
+	std::map<unsigned long, std::string> networks;
+	DatabaseIterator it = query->getObjectIterator("SELECT PNetwork.publicID,"
+		"Network.* FROM Network,PublicObject AS PNetwork "
+		"WHERE Network._oid=PNetwork._oid", Network::TypeInfo());
+	if ( !it.valid() ) {
+		SEISCOMP_ERROR("Failed to fetch the inventory networks");
+		return false;
+	}
+	for (; *it; ++it) {
+		NetworkPtr network = Network::Cast(*it);
+		if ( network )
+		    networks[it.oid()] = network->code();
+	}
+
+	it = query->getObjectIterator("SELECT PStation.publicID,Station.* FROM "
+		"Station,PublicObject AS PStation WHERE Station._oid=PStation._oid",
+	    DataModel::Station::TypeInfo());
+	if ( !it.valid() ) {
+		SEISCOMP_ERROR("Failed to fetch the inventory stations");
+		return false;
+	}
+	for (; *it; ++it) {
+
+		StationPtr object = DataModel::Station::Cast(*it);
+		if ( !object ) continue;
+
+		std::map<unsigned long, std::string>::const_iterator network = networks.find(it.parentOid());
+		if ( network == networks.end() ) continue;
+
+		Station station;
+		station.networkCode = network->second;
+		station.code = object->code();
+		station.latitude = object->latitude();
+		station.longitude = object->longitude();
+		station.elevation = object->elevation();
+		station.start = object->start();
+		try {
+			station.end = object->end();
+		} catch ( ... ) {}
+
+		_stations[key(station.networkCode, station.code)].push_back(station);
+	}
+
+	for (StationMap::iterator s = _stations.begin(); s != _stations.end(); ++s)
+		std::sort(s->second.begin(), s->second.end(), byStart);
+
+	_loaded = true;
+
+	SEISCOMP_DEBUG("Inventory snapshot of %ld networks and %ld stations loaded in %s",
+	    networks.size(), _stations.size(), Seiscomp::Core::Time(sw.elapsed()).toString("%T.%f").c_str());
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void InventorySnapshot::clear() {
+	_stations.clear();
+	_loaded = false;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const InventorySnapshot::Station*
+InventorySnapshot::station(const std::string& networkCode,
+                           const std::string& code,
+                           const Seiscomp::Core::Time& time) const {
+
+	StationMap::const_iterator it = _stations.find(key(networkCode, code));
+	if ( it == _stations.end() || it->second.empty() )
+	    return NULL;
+
+	if ( time.valid() )
+		for (Epochs::const_reverse_iterator e = it->second.rbegin();
+		        e != it->second.rend(); ++e)
+			if ( e->isActive(time) )
+			    return &(*e);
+
+	return &it->second.back();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+} // namespace Core
+} // namespace IPGP
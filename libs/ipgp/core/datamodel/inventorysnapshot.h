@@ -0,0 +1,149 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_CORE_DATAMODEL_INVENTORYSNAPSHOT_H__
+#define __IPGP_CORE_DATAMODEL_INVENTORYSNAPSHOT_H__
+
+#include <ipgp/core/api.h>
+#include <seiscomp3/core/datetime.h>
+#include <seiscomp3/datamodel/databasequery.h>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace IPGP {
+namespace Core {
+
+
+/**
+ * @class   InventorySnapshot
+ * @package IPGP::Core::DataModel
+ * @brief   Station coordinates of the whole inventory.
+ *
+ * The networks and stations epochs are fetched in two queries and indexed
+ * by network and station code, so that resolving a station's coordinates
+ * doesn't cost a database round trip anymore. Snapshots returned by
+ * Shared() are keyed by database URI, loaded the first time a database is
+ * asked for and kept until Reset() drops them.
+ * @note  Shared snapshots are meant to be used from the GUI thread.
+ */
+class SC_IPGP_CORE_API InventorySnapshot {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		struct Station {
+				std::string networkCode;
+				std::string code;
+				double latitude;
+				double longitude;
+				double elevation;
+				Seiscomp::Core::Time start;
+				//! Invalid (default) time if the epoch is still open
+				Seiscomp::Core::Time end;
+
+				bool isActive(const Seiscomp::Core::Time&) const;
+		};
+		//! Epochs of a station, sorted by start time
+		typedef std::vector<Station> Epochs;
+		typedef std::map<std::string, Epochs> StationMap;
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		InventorySnapshot();
+		~InventorySnapshot();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief  Fetches the snapshot of a database, loading it first if
+		 *         needed.
+		 * @param  databaseURI the database connection URI, the key of the
+		 *         snapshot
+		 * @param  query the query to load the snapshot with, not kept
+		 * @return the snapshot shared by every user of the same database,
+		 *         NULL without query
+		 */
+		static InventorySnapshot* Shared(const std::string& databaseURI,
+		                                 Seiscomp::DataModel::DatabaseQuery* query);
+
+		/**
+		 * @brief Drops every shared snapshot (e.g. when the database is
+		 *        changed or the inventory updated), they are loaded again
+		 *        the next time they're asked for.
+		 * @note  Pointers returned by Shared() are invalidated.
+		 */
+		static void Reset();
+
+		/**
+		 * @brief  Replaces the content with the inventory of a database.
+		 * @return true if both queries succeeded, false otherwise
+		 */
+		bool load(Seiscomp::DataModel::DatabaseQuery*);
+		void clear();
+
+		bool isLoaded() const {
+			return _loaded;
+		}
+
+		/**
+		 * @brief  Looks a station up.
+		 * @param  time the epoch to consider, an invalid time selects the
+		 *         latest one
+		 * @return the station's epoch active at the time, or the latest
+		 *         one if none is, NULL if the station is unknown
+		 */
+		const Station* station(const std::string& networkCode,
+		                       const std::string& code,
+		                       const Seiscomp::Core::Time& time = Seiscomp::Core::Time()) const;
+
+		//! Every station, keyed by "NET.STA"
+		const StationMap& stations() const {
+			return _stations;
+		}
+
+		size_t size() const {
+			return _stations.size();
+		}
+
+		static std::string key(const std::string& networkCode,
+		                       const std::string& code) {
+			return networkCode + "." + code;
+		}
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		StationMap _stations;
+		bool _loaded;
+};
+
+
+} // namespace Core
+} // namespace IPGP
+
+#endif
@@ -0,0 +1,350 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/core/math/bvalueseries.h>
+#include <algorithm>
+#include <math.h>
+
+
+namespace {
+
+
+typedef std::pair<double, double> Event;
+
+
+inline bool isNan(const double& x) {
+	return x != x;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Core {
+namespace Math {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BValueSeries::Sample::Sample() :
+		start(.0), end(.0), count(0), rate(.0), fitLevel(-1.) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BValueSeries::BValueSeries() :
+		_windowType(EventWindow), _length(200.), _step(20.), _binWidth(.1),
+		_completeness(MaximumCurvature), _completenessValue(.0),
+		_minimumCount(50), _origin(.0), _windowCount(0) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BValueSeries::~BValueSeries() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueSeries::setWindow(const WindowType& type, const double& length,
+                             const double& step) {
+	_windowType = type;
+	_length = length;
+	_step = step;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueSeries::setBinWidth(const double& width) {
+	_binWidth = width;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueSeries::setCompleteness(const Completeness& completeness,
+                                   const double& value) {
+	_completeness = completeness;
+	_completenessValue = value;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueSeries::setMinimumCount(const size_t& count) {
+	_minimumCount = count;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const BValueSeries::Samples&
+BValueSeries::compute(const std::vector<double>& times,
+                      const std::vector<double>& magnitudes) {
+
+	_samples.clear();
+	_times.clear();
+	_magnitudes.clear();
+	_bins.clear();
+	_counts.clear();
+	_sums.clear();
+	_squares.clear();
+	_windowCount = 0;
+
+	if ( _binWidth <= .0 || _length <= .0 || _step <= .0 )
+		return _samples;
+
+	std::vector<Event> events;
+	events.reserve(std::min(times.size(), magnitudes.size()));
+	for (size_t i = 0; i < times.size() && i < magnitudes.size(); ++i)
+		if ( !isNan(magnitudes[i]) )
+			events.push_back(Event(times[i], magnitudes[i]));
+
+	if ( events.empty() )
+		return _samples;
+
+	std::sort(events.begin(), events.end());
+
+	const size_t n = events.size();
+	_times.resize(n);
+	_magnitudes.resize(n);
+	double minimum = events.front().second, maximum = minimum;
+	for (size_t i = 0; i < n; ++i) {
+		_times[i] = events[i].first;
+		_magnitudes[i] = events[i].second;
+		minimum = std::min(minimum, _magnitudes[i]);
+		maximum = std::max(maximum, _magnitudes[i]);
+	}
+
+	const double tolerance = FrequencyMagnitudeDistribution::Tolerance;
+	_origin = floor(minimum / _binWidth + tolerance) * _binWidth;
+	const size_t bins = (size_t) floor((maximum - _origin) / _binWidth + tolerance) + 1;
+
+	_bins.resize(n);
+	for (size_t i = 0; i < n; ++i)
+		_bins[i] = std::min(bins - 1, (size_t) std::max(.0,
+		    floor((_magnitudes[i] - _origin) / _binWidth + tolerance)));
+
+	_counts.resize(bins, 0);
+	_sums.resize(bins, .0);
+	_squares.resize(bins, .0);
+
+	//! Earthquakes are added as the window end reaches them, then removed
+	//! as its start leaves them behind: each one is visited twice
+	size_t head = 0, tail = 0;
+
+	if ( _windowType == EventWindow ) {
+
+		const size_t length = std::max((size_t) 2, (size_t) _length);
+		const size_t step = std::max((size_t) 1, (size_t) _step);
+
+		for (size_t first = 0; first + length <= n; first += step) {
+			while ( head < first + length )
+				add(head++);
+			while ( tail < first )
+				remove(tail++);
+			_samples.push_back(sample(_times[first], _times[first + length - 1]));
+		}
+	}
+	else {
+
+		//! Windows end from one length after the first earthquake, up to
+		//! the first one past the last earthquake
+		for (size_t k = 0;; ++k) {
+			const double end = _times.front() + _length + k * _step;
+			const double start = end - _length;
+			while ( head < n && _times[head] < end )
+				add(head++);
+			while ( tail < head && _times[tail] < start )
+				remove(tail++);
+			_samples.push_back(sample(start, end));
+			if ( end > _times.back() ) break;
+		}
+	}
+
+	return _samples;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueSeries::add(const size_t& event) {
+
+	const size_t bin = _bins[event];
+	const double m = _magnitudes[event] - _origin;
+
+	++_counts[bin];
+	_sums[bin] += m;
+	_squares[bin] += m * m;
+	++_windowCount;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueSeries::remove(const size_t& event) {
+
+	const size_t bin = _bins[event];
+	const double m = _magnitudes[event] - _origin;
+
+	--_windowCount;
+
+	//! Emptied bins are reset, so that rounding errors don't pile up
+	if ( --_counts[bin] == 0 ) {
+		_sums[bin] = .0;
+		_squares[bin] = .0;
+		return;
+	}
+
+	_sums[bin] -= m;
+	_squares[bin] -= m * m;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BValueSeries::Sample BValueSeries::sample(const double& start,
+                                          const double& end) const {
+
+	Sample s;
+	s.start = start;
+	s.end = end;
+	s.count = _windowCount;
+	if ( end > start )
+		s.rate = _windowCount / (end - start);
+
+	const size_t bins = _counts.size();
+	const double tolerance = FrequencyMagnitudeDistribution::Tolerance;
+
+	//! Sums of the earthquakes above each bin lower bound
+	std::vector<size_t> counts(bins + 1, 0);
+	std::vector<double> sums(bins + 1, .0);
+	std::vector<double> squares(bins + 1, .0);
+	for (size_t i = bins; i > 0; --i) {
+		counts[i - 1] = counts[i] + _counts[i - 1];
+		sums[i - 1] = sums[i] + _sums[i - 1];
+		squares[i - 1] = squares[i] + _squares[i - 1];
+	}
+
+	size_t bin = bins;
+	switch ( _completeness ) {
+
+		case FixedCompleteness: {
+			const double k = ceil((_completenessValue - _origin) / _binWidth - tolerance);
+			bin = (k <= .0) ? 0 : std::min(bins, (size_t) k);
+		}
+		break;
+
+		case MaximumCurvature:
+			for (size_t i = 0; i < bins; ++i)
+				if ( _counts[i] > 0 && (bin == bins || _counts[i] > _counts[bin]) )
+					bin = i;
+		break;
+
+		case GoodnessOfFit: {
+			bool found = false;
+			for (size_t i = 0; i < bins; ++i) {
+
+				if ( counts[i] < FrequencyMagnitudeDistribution::GoodnessOfFitMinimumCount )
+					break;
+
+				const FrequencyMagnitudeDistribution::BValue bv =
+				        estimate(i, counts, sums, squares);
+				if ( !bv.valid ) continue;
+
+				//! Same residual as FrequencyMagnitudeDistribution, over
+				//! the bins of the window
+				double misfit = .0;
+				for (size_t j = i; j < bins; ++j) {
+					const double low = _origin + j * _binWidth;
+					const double predicted = pow(10., bv.a - bv.b * low)
+					        - pow(10., bv.a - bv.b * (low + _binWidth));
+					misfit += fabs(_counts[j] - predicted);
+				}
+
+				const double fit = 100. - 100. * misfit / counts[i];
+				if ( !found || fit > s.fitLevel || fit >= _completenessValue ) {
+					found = true;
+					s.fitLevel = fit;
+					bin = i;
+				}
+
+				if ( fit >= _completenessValue ) break;
+			}
+		}
+		break;
+	}
+
+	if ( bin == bins )
+		return s;
+
+	s.bValue = estimate(bin, counts, sums, squares);
+	if ( s.bValue.count < _minimumCount )
+		s.bValue.valid = false;
+
+	return s;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+FrequencyMagnitudeDistribution::BValue
+BValueSeries::estimate(const size_t& bin, const std::vector<size_t>& counts,
+                       const std::vector<double>& sums,
+                       const std::vector<double>& squares) const {
+
+	const double mc = _origin + bin * _binWidth;
+	const size_t n = counts[bin];
+	if ( n == 0 )
+		return FrequencyMagnitudeDistribution::maximumLikelihood(mc, _binWidth, 0, .0, .0);
+
+	const double mean = sums[bin] / n;
+
+	return FrequencyMagnitudeDistribution::maximumLikelihood(mc, _binWidth, n,
+	    _origin + mean, squares[bin] - n * mean * mean);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace Math
+} // namespace Core
+} // namespace IPGP
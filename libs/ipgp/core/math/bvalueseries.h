@@ -0,0 +1,187 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_CORE_MATH_BVALUESERIES_H__
+#define __IPGP_CORE_MATH_BVALUESERIES_H__
+
+
+#include <ipgp/core/api.h>
+#include <ipgp/core/math/gutenbergrichter.h>
+#include <stddef.h>
+#include <vector>
+
+
+namespace IPGP {
+namespace Core {
+namespace Math {
+
+
+/**
+ * @class   BValueSeries
+ * @package IPGP::Core::Math
+ * @brief   Completeness magnitude, b-value and rate of earthquakes over
+ *          sliding windows
+ *
+ * Windows hold a given number of earthquakes or span a given duration, and
+ * advance by a step of the same kind. The earthquakes of the window are
+ * binned by magnitude, each bin keeping its count and the sums of its
+ * magnitudes and of their squares: advancing the window only adds the
+ * earthquakes it reaches and removes the ones it leaves, and each window
+ * costs one pass over the bins (or one per completeness candidate with
+ * the goodness of fit) whatever its number of earthquakes.
+ * Times are given in any unit, rates are expressed in the same one.
+ */
+class SC_IPGP_CORE_API BValueSeries {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		enum WindowType {
+			EventWindow,
+			TimeWindow
+		};
+
+		enum Completeness {
+			//! The given magnitude, rounded up to the bins
+			FixedCompleteness,
+			MaximumCurvature,
+			//! Goodness of fit at the given level, in percent
+			GoodnessOfFit
+		};
+
+		struct SC_IPGP_CORE_API Sample {
+				Sample();
+				//! Time of the first earthquake, or window start
+				double start;
+				//! Time of the last earthquake, or window end
+				double end;
+				size_t count;
+				//! Number of earthquakes per time unit
+				double rate;
+				//! Invalid if fewer than minimumCount() earthquakes are
+				//! above the completeness magnitude
+				FrequencyMagnitudeDistribution::BValue bValue;
+				//! Goodness of fit level reached, negative unless estimated
+				//! by goodness of fit
+				double fitLevel;
+		};
+		typedef std::vector<Sample> Samples;
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		BValueSeries();
+		~BValueSeries();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief Sets the windows.
+		 * @param type whether length and step are numbers of earthquakes
+		 *        or durations
+		 * @param length the window length
+		 * @param step the distance between consecutive windows
+		 */
+		void setWindow(const WindowType& type, const double& length,
+		               const double& step);
+		//! Sets the magnitudes binning width, bins being multiples of it
+		void setBinWidth(const double&);
+		/**
+		 * @brief Sets how the completeness magnitude of each window is
+		 *        found.
+		 * @param value the completeness magnitude, or the fit level
+		 */
+		void setCompleteness(const Completeness&, const double& value = .0);
+		//! Sets the least number of earthquakes above the completeness
+		//! magnitude a window needs for its b-value
+		void setMinimumCount(const size_t&);
+
+		const WindowType& windowType() const {
+			return _windowType;
+		}
+		size_t minimumCount() const {
+			return _minimumCount;
+		}
+
+		/**
+		 * @brief  Computes the series.
+		 * @param  times the earthquakes times, in any order
+		 * @param  magnitudes the earthquakes magnitudes, NaN values being
+		 *         dropped
+		 * @return the samples, in time order
+		 */
+		const Samples& compute(const std::vector<double>& times,
+		                       const std::vector<double>& magnitudes);
+
+		const Samples& samples() const {
+			return _samples;
+		}
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		void add(const size_t& event);
+		void remove(const size_t& event);
+		Sample sample(const double& start, const double& end) const;
+		//! Estimation above a bin, out of the sums of the earthquakes
+		//! above each bin
+		FrequencyMagnitudeDistribution::BValue
+		estimate(const size_t& bin, const std::vector<size_t>& counts,
+		         const std::vector<double>& sums,
+		         const std::vector<double>& squares) const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		WindowType _windowType;
+		double _length;
+		double _step;
+		double _binWidth;
+		Completeness _completeness;
+		double _completenessValue;
+		size_t _minimumCount;
+
+		//! Earthquakes in time order, and the bin of each
+		std::vector<double> _times;
+		std::vector<double> _magnitudes;
+		std::vector<size_t> _bins;
+
+		//! Lower bound of the first bin, sums being taken relative to it
+		double _origin;
+		std::vector<size_t> _counts;
+		std::vector<double> _sums;
+		std::vector<double> _squares;
+		size_t _windowCount;
+
+		Samples _samples;
+};
+
+
+} // namespace Math
+} // namespace Core
+} // namespace IPGP
+
+#endif
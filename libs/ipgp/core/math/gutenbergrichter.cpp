@@ -0,0 +1,390 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/core/math/gutenbergrichter.h>
+#include <algorithm>
+#include <math.h>
+
+
+namespace {
+
+
+//! Marsaglia's xorshift, each bootstrap owning its state
+inline unsigned int xorshift(unsigned int& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+
+inline bool isNan(const double& x) {
+	return x != x;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Core {
+namespace Math {
+
+
+const double FrequencyMagnitudeDistribution::Tolerance = 1e-6;
+const size_t FrequencyMagnitudeDistribution::GoodnessOfFitMinimumCount = 50;
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+FrequencyMagnitudeDistribution::BValue::BValue() :
+		mc(.0), count(0), a(.0), b(.0), error(.0), bootstrapError(-1.),
+		valid(false) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+FrequencyMagnitudeDistribution::FrequencyMagnitudeDistribution() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+FrequencyMagnitudeDistribution::
+FrequencyMagnitudeDistribution(const std::vector<double>& magnitudes) {
+	setMagnitudes(magnitudes);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+FrequencyMagnitudeDistribution::~FrequencyMagnitudeDistribution() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void FrequencyMagnitudeDistribution::
+setMagnitudes(const std::vector<double>& magnitudes) {
+
+	clear();
+
+	_magnitudes.reserve(magnitudes.size());
+	for (size_t i = 0; i < magnitudes.size(); ++i)
+		if ( !isNan(magnitudes[i]) )
+			_magnitudes.push_back(magnitudes[i]);
+
+	std::sort(_magnitudes.begin(), _magnitudes.end());
+
+	//! Sums are taken relative to the smallest magnitude, which keeps the
+	//! variances computed out of them accurate
+	const size_t count = _magnitudes.size();
+	_sums.resize(count + 1, .0);
+	_squares.resize(count + 1, .0);
+	for (size_t i = count; i > 0; --i) {
+		const double m = _magnitudes[i - 1] - _magnitudes.front();
+		_sums[i - 1] = _sums[i] + m;
+		_squares[i - 1] = _squares[i] + m * m;
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void FrequencyMagnitudeDistribution::clear() {
+	_magnitudes.clear();
+	_sums.clear();
+	_squares.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+double FrequencyMagnitudeDistribution::minimum() const {
+	return _magnitudes.empty() ? .0 : _magnitudes.front();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+double FrequencyMagnitudeDistribution::maximum() const {
+	return _magnitudes.empty() ? .0 : _magnitudes.back();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+size_t FrequencyMagnitudeDistribution::lowerIndex(const double& m) const {
+	return std::lower_bound(_magnitudes.begin(), _magnitudes.end(),
+	    m - Tolerance) - _magnitudes.begin();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+size_t FrequencyMagnitudeDistribution::countAbove(const double& m) const {
+	return _magnitudes.size() - lowerIndex(m);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+size_t FrequencyMagnitudeDistribution::countBetween(const double& low,
+                                                    const double& high) const {
+	const size_t first = lowerIndex(low);
+	const size_t last = lowerIndex(high);
+	return (last > first) ? last - first : 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+size_t FrequencyMagnitudeDistribution::
+histogram(const double& start, const double& width,
+          std::vector<double>& centers, std::vector<double>& incremental,
+          std::vector<double>& cumulative) const {
+
+	centers.clear();
+	incremental.clear();
+	cumulative.clear();
+
+	if ( _magnitudes.empty() || width <= .0 || start > maximum() + Tolerance )
+		return 0;
+
+	const size_t bins = (size_t) floor((maximum() - start) / width + Tolerance) + 1;
+	centers.resize(bins);
+	incremental.resize(bins);
+	cumulative.resize(bins);
+
+	//! Bounds are computed from the start, not accumulated, so that they
+	//! don't drift over many bins
+	size_t above = countAbove(start);
+	for (size_t i = 0; i < bins; ++i) {
+		const double low = start + i * width;
+		const size_t next = countAbove(low + width);
+		centers[i] = low + width / 2.;
+		cumulative[i] = above;
+		incremental[i] = above - next;
+		above = next;
+	}
+
+	return bins;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+FrequencyMagnitudeDistribution::BValue
+FrequencyMagnitudeDistribution::maximumLikelihood(const double& mc,
+                                                  const double& width) const {
+
+	const size_t first = lowerIndex(mc);
+	const size_t n = _magnitudes.size() - first;
+	if ( n == 0 )
+		return maximumLikelihood(mc, width, 0, .0, .0);
+
+	const double mean = _sums[first] / n;
+
+	return maximumLikelihood(mc, width, n, mean + _magnitudes.front(),
+	    _squares[first] - n * mean * mean);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+FrequencyMagnitudeDistribution::BValue
+FrequencyMagnitudeDistribution::maximumLikelihood(const double& mc,
+                                                  const double& width,
+                                                  const size_t& count,
+                                                  const double& mean,
+                                                  const double& deviations) {
+
+	BValue result;
+	result.mc = mc;
+	result.count = count;
+	if ( count < 2 )
+		return result;
+
+	const double delta = mean - (mc - width / 2.);
+	if ( delta <= .0 )
+		return result;
+
+	const double n = count;
+	result.b = M_LOG10E / delta;
+	result.a = log10(n) + result.b * mc;
+	result.error = 2.3 * result.b * result.b
+	        * sqrt(std::max(.0, deviations) / (n * (n - 1.)));
+	result.valid = true;
+
+	return result;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+double FrequencyMagnitudeDistribution::bootstrap(const double& mc,
+                                                 const double& width,
+                                                 const size_t& samples,
+                                                 const unsigned int& seed) const {
+
+	const size_t first = lowerIndex(mc);
+	const size_t n = _magnitudes.size() - first;
+	if ( n < 2 || samples < 2 )
+		return -1.;
+
+	const double* tail = &_magnitudes[first];
+	const double lower = mc - width / 2.;
+
+	//! xorshift never leaves a null state
+	unsigned int state = (seed == 0) ? 1 : seed;
+
+	double sum = .0, square = .0;
+	size_t valid = 0;
+	for (size_t s = 0; s < samples; ++s) {
+
+		double mean = .0;
+		for (size_t i = 0; i < n; ++i)
+			mean += tail[xorshift(state) % n];
+		mean /= n;
+
+		if ( mean - lower <= .0 ) continue;
+
+		const double b = M_LOG10E / (mean - lower);
+		sum += b;
+		square += b * b;
+		++valid;
+	}
+
+	if ( valid < 2 )
+		return -1.;
+
+	const double mean = sum / valid;
+	return sqrt(std::max(.0, (square - valid * mean * mean) / (valid - 1.)));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool FrequencyMagnitudeDistribution::maximumCurvature(const double& start,
+                                                      const double& width,
+                                                      double& mc) const {
+
+	std::vector<double> centers, incremental, cumulative;
+	const size_t bins = histogram(start, width, centers, incremental, cumulative);
+
+	size_t best = bins;
+	for (size_t i = 0; i < bins; ++i)
+		if ( incremental[i] > .0 && (best == bins || incremental[i] > incremental[best]) )
+			best = i;
+
+	if ( best == bins )
+		return false;
+
+	mc = start + best * width;
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool FrequencyMagnitudeDistribution::goodnessOfFit(const double& start,
+                                                   const double& width,
+                                                   const double& level,
+                                                   double& mc,
+                                                   double* residual) const {
+
+	std::vector<double> centers, incremental, cumulative;
+	const size_t bins = histogram(start, width, centers, incremental, cumulative);
+
+	bool found = false;
+	double bestFit = .0;
+	for (size_t i = 0; i < bins; ++i) {
+
+		if ( cumulative[i] < GoodnessOfFitMinimumCount ) break;
+
+		const double candidate = start + i * width;
+		const BValue bv = maximumLikelihood(candidate, width);
+		if ( !bv.valid ) continue;
+
+		//! R = 100 - 100 * sum(|observed - predicted|) / sum(observed),
+		//! over the bins above the candidate
+		double misfit = .0;
+		for (size_t j = i; j < bins; ++j) {
+			const double low = start + j * width;
+			const double predicted = pow(10., bv.a - bv.b * low)
+			        - pow(10., bv.a - bv.b * (low + width));
+			misfit += fabs(incremental[j] - predicted);
+		}
+
+		const double fit = 100. - 100. * misfit / cumulative[i];
+		if ( !found || fit > bestFit ) {
+			found = true;
+			bestFit = fit;
+			mc = candidate;
+		}
+
+		if ( fit >= level ) {
+			bestFit = fit;
+			mc = candidate;
+			break;
+		}
+	}
+
+	if ( found && residual )
+		*residual = bestFit;
+
+	return found;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace Math
+} // namespace Core
+} // namespace IPGP
@@ -0,0 +1,206 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_CORE_MATH_GUTENBERGRICHTER_H__
+#define __IPGP_CORE_MATH_GUTENBERGRICHTER_H__
+
+
+#include <ipgp/core/api.h>
+#include <stddef.h>
+#include <vector>
+
+
+namespace IPGP {
+namespace Core {
+namespace Math {
+
+
+/**
+ * @class   FrequencyMagnitudeDistribution
+ * @package IPGP::Core::Math
+ * @brief   Gutenberg-Richter statistics of a set of magnitudes
+ *
+ * Magnitudes are sorted once, along with the sums of the magnitudes and of
+ * their squares above each of them: the number of earthquakes above a
+ * magnitude then costs a binary search, a histogram bin two of them, and
+ * the maximum likelihood b-value of the earthquakes above a completeness
+ * magnitude the same whatever their number.
+ * Magnitudes closer than Tolerance to a bound are considered on it, so that
+ * rounded magnitudes fall in their bins.
+ * @note  Const methods are thread safe.
+ */
+class SC_IPGP_CORE_API FrequencyMagnitudeDistribution {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		/**
+		 * @brief log10(N(M >= m)) = a - b.m, fitted over the earthquakes
+		 *        above the completeness magnitude mc.
+		 */
+		struct SC_IPGP_CORE_API BValue {
+				BValue();
+				double mc;
+				size_t count;
+				double a;
+				double b;
+				//! Shi & Bolt (1982) standard deviation of b
+				double error;
+				//! Standard deviation of the bootstrapped b-values, negative
+				//! unless computed
+				double bootstrapError;
+				bool valid;
+		};
+
+		static const double Tolerance;
+		//! Least number of earthquakes a goodness of fit candidate needs
+		static const size_t GoodnessOfFitMinimumCount;
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		FrequencyMagnitudeDistribution();
+		explicit FrequencyMagnitudeDistribution(const std::vector<double>& magnitudes);
+		~FrequencyMagnitudeDistribution();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! Sorts the magnitudes, NaN values are dropped
+		void setMagnitudes(const std::vector<double>&);
+		void clear();
+
+		//! Magnitudes in ascending order
+		const std::vector<double>& magnitudes() const {
+			return _magnitudes;
+		}
+		size_t size() const {
+			return _magnitudes.size();
+		}
+		bool empty() const {
+			return _magnitudes.empty();
+		}
+		double minimum() const;
+		double maximum() const;
+
+		//! @return the number of magnitudes >= m
+		size_t countAbove(const double& m) const;
+		//! @return the number of magnitudes in [low, high[
+		size_t countBetween(const double& low, const double& high) const;
+
+		/**
+		 * @brief  Bins the magnitudes from start up to the largest one.
+		 * @param  start the lower bound of the first bin
+		 * @param  width the bins width
+		 * @param  centers the bins centers output
+		 * @param  incremental the number of magnitudes of each bin
+		 * @param  cumulative the number of magnitudes above each bin lower
+		 *         bound
+		 * @return the number of bins
+		 */
+		size_t histogram(const double& start, const double& width,
+		                 std::vector<double>& centers,
+		                 std::vector<double>& incremental,
+		                 std::vector<double>& cumulative) const;
+
+		/**
+		 * @brief  Maximum likelihood b-value (Aki, 1965; Utsu, 1966):
+		 *         b = log10(e) / (mean(M) - (mc - width / 2)).
+		 * @param  mc the completeness magnitude
+		 * @param  width the magnitudes binning width, 0 if continuous
+		 * @return the estimation, invalid below two earthquakes or without
+		 *         spread
+		 */
+		BValue maximumLikelihood(const double& mc, const double& width) const;
+
+		/**
+		 * @brief  Maximum likelihood b-value out of the moments of the
+		 *         earthquakes above mc, for callers keeping their own sums.
+		 * @param  count the number of earthquakes above mc
+		 * @param  mean their mean magnitude
+		 * @param  deviations the sum of their squared deviations from the
+		 *         mean
+		 */
+		static BValue maximumLikelihood(const double& mc, const double& width,
+		                                const size_t& count, const double& mean,
+		                                const double& deviations);
+
+		/**
+		 * @brief  Standard deviation of the maximum likelihood b-values of
+		 *         samples drawn with replacement out of the earthquakes above
+		 *         mc.
+		 * @param  samples the number of samples
+		 * @param  seed the seed of the pseudo-random draws, the same seed
+		 *         giving the same result
+		 * @return the standard deviation, negative if it can't be computed
+		 */
+		double bootstrap(const double& mc, const double& width,
+		                 const size_t& samples,
+		                 const unsigned int& seed = 1) const;
+
+		/**
+		 * @brief  Completeness magnitude by maximum curvature: the lower
+		 *         bound of the most populated bin.
+		 * @return false without magnitude above start
+		 */
+		bool maximumCurvature(const double& start, const double& width,
+		                      double& mc) const;
+
+		/**
+		 * @brief  Completeness magnitude by goodness of fit (Wiemer & Wyss,
+		 *         2000): the lowest bin lower bound above which the
+		 *         distribution predicted by the maximum likelihood a and b
+		 *         values explains the observed one at the given level, or
+		 *         the best explained one if no bound reaches it.
+		 * @param  level the fit level, in percent (e.g. 90 or 95)
+		 * @param  mc the completeness magnitude output
+		 * @param  residual optional output of the fit level reached
+		 * @return false if no bin holds enough earthquakes above it
+		 */
+		bool goodnessOfFit(const double& start, const double& width,
+		                   const double& level, double& mc,
+		                   double* residual = NULL) const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		//! @return the index of the first magnitude >= m
+		size_t lowerIndex(const double& m) const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		std::vector<double> _magnitudes;
+		//! Sums of the magnitudes from the i-th one to the largest one
+		std::vector<double> _sums;
+		std::vector<double> _squares;
+};
+
+
+} // namespace Math
+} // namespace Core
+} // namespace IPGP
+
+#endif
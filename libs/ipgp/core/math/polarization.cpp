@@ -0,0 +1,284 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/core/math/polarization.h>
+#include <math.h>
+#include <algorithm>
+
+
+namespace {
+
+
+const double RadToDeg = 180. / (4. * atan(1.));
+
+
+inline bool isMissing(const double& v) {
+	return v != v;
+}
+
+
+/**
+ * @brief Derives the polarization attributes of a covariance matrix.
+ * @return false if the motion is null
+ */
+bool analyze(const double covariance[3][3], IPGP::Core::Math::Polarization& p) {
+
+	IPGP::Core::Math::symmetricEigenDecomposition(covariance, p.eigenvalues, p.eigenvectors);
+
+	const double l1 = p.eigenvalues[0];
+	const double l2 = std::max(p.eigenvalues[1], .0);
+	const double l3 = std::max(p.eigenvalues[2], .0);
+
+	if ( !(l1 > .0) )
+	    return false;
+
+	//! Orient the principal axis upward
+	double* u = p.eigenvectors[0];
+	if ( u[0] < .0 )
+	    u[0] = -u[0], u[1] = -u[1], u[2] = -u[2];
+
+	p.rectilinearity = 1. - (l2 + l3) / (2. * l1);
+	p.planarity = 1. - 2. * l3 / (l1 + l2);
+	p.azimuth = atan2(u[2], u[1]) * RadToDeg;
+	if ( p.azimuth < .0 )
+	    p.azimuth += 360.;
+	p.incidence = acos(std::min(u[0], 1.)) * RadToDeg;
+
+	return true;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Core {
+namespace Math {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+Polarization::Polarization() :
+		first(0), count(0), rectilinearity(.0), planarity(.0), azimuth(.0),
+		incidence(.0) {
+
+	for (int i = 0; i < 3; ++i) {
+		eigenvalues[i] = .0;
+		for (int j = 0; j < 3; ++j)
+			eigenvectors[i][j] = (i == j) ? 1. : .0;
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+double Polarization::backAzimuth() const {
+	return fmod(azimuth + 180., 360.);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void symmetricEigenDecomposition(const double matrix[3][3],
+                                 double eigenvalues[3],
+                                 double eigenvectors[3][3]) {
+
+	double a[3][3], v[3][3];
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j) {
+			a[i][j] = matrix[i][j];
+			v[i][j] = (i == j) ? 1. : .0;
+		}
+
+	for (int sweep = 0; sweep < 50; ++sweep) {
+
+		const double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+		const double diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+		if ( off <= 1e-30 * diag || off == .0 )
+		    break;
+
+		for (int p = 0; p < 2; ++p) {
+			for (int q = p + 1; q < 3; ++q) {
+
+				if ( a[p][q] == .0 ) continue;
+
+				//! Rotation zeroing a[p][q]
+				const double theta = (a[q][q] - a[p][p]) / (2. * a[p][q]);
+				const double t = ((theta >= .0) ? 1. : -1.)
+				        / (fabs(theta) + sqrt(theta * theta + 1.));
+				const double c = 1. / sqrt(t * t + 1.);
+				const double s = t * c;
+
+				for (int k = 0; k < 3; ++k) {
+					const double akp = a[k][p];
+					const double akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < 3; ++k) {
+					const double apk = a[p][k];
+					const double aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for (int k = 0; k < 3; ++k) {
+					const double vkp = v[k][p];
+					const double vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	//! Sort by descending eigenvalue, columns of v being the eigenvectors
+	int order[3] = { 0, 1, 2 };
+	for (int i = 0; i < 2; ++i)
+		for (int j = i + 1; j < 3; ++j)
+			if ( a[order[j]][order[j]] > a[order[i]][order[i]] )
+			    std::swap(order[i], order[j]);
+
+	for (int i = 0; i < 3; ++i) {
+		eigenvalues[i] = a[order[i]][order[i]];
+		for (int k = 0; k < 3; ++k)
+			eigenvectors[i][k] = v[k][order[i]];
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool polarization(const double* z, const double* n, const double* e,
+                  const size_t& count, Polarization& result) {
+
+	PolarizationList list;
+	if ( polarization(z, n, e, count, count, count, list) == 0 )
+	    return false;
+
+	result = list.front();
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+size_t polarization(const double* z, const double* n, const double* e,
+                    const size_t& count, const size_t& window,
+                    const size_t& step, PolarizationList& results) {
+
+	if ( !z || !n || !e || window < 2 || step == 0 || count < window )
+	    return 0;
+
+	const double* c[3] = { z, n, e };
+
+	//! Offsets by the mean of the present samples, so that cumulated
+	//! products don't lose the small fluctuations
+	double mean[3] = { .0, .0, .0 };
+	size_t present = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if ( isMissing(z[i]) || isMissing(n[i]) || isMissing(e[i]) )
+		    continue;
+		for (int k = 0; k < 3; ++k)
+			mean[k] += c[k][i];
+		++present;
+	}
+	if ( present == 0 )
+	    return 0;
+	for (int k = 0; k < 3; ++k)
+		mean[k] /= present;
+
+	//! Cumulated sums, sample i being accounted in entry i + 1: the three
+	//! components, their six products, and the missing samples
+	enum { Sums = 10, Missing = 9 };
+	std::vector<double> sums((count + 1) * Sums, .0);
+	for (size_t i = 0; i < count; ++i) {
+
+		const double* prev = &sums[i * Sums];
+		double* cur = &sums[(i + 1) * Sums];
+
+		if ( isMissing(z[i]) || isMissing(n[i]) || isMissing(e[i]) ) {
+			std::copy(prev, prev + Sums, cur);
+			cur[Missing] += 1.;
+			continue;
+		}
+
+		const double x[3] = { z[i] - mean[0], n[i] - mean[1], e[i] - mean[2] };
+		cur[0] = prev[0] + x[0];
+		cur[1] = prev[1] + x[1];
+		cur[2] = prev[2] + x[2];
+		cur[3] = prev[3] + x[0] * x[0];
+		cur[4] = prev[4] + x[0] * x[1];
+		cur[5] = prev[5] + x[0] * x[2];
+		cur[6] = prev[6] + x[1] * x[1];
+		cur[7] = prev[7] + x[1] * x[2];
+		cur[8] = prev[8] + x[2] * x[2];
+		cur[Missing] = prev[Missing];
+	}
+
+	const size_t before = results.size();
+	const double w = (double) window;
+
+	for (size_t first = 0; first + window <= count; first += step) {
+
+		const double* a = &sums[first * Sums];
+		const double* b = &sums[(first + window) * Sums];
+
+		if ( b[Missing] != a[Missing] ) continue;
+
+		double s[Sums];
+		for (int k = 0; k < Sums; ++k)
+			s[k] = b[k] - a[k];
+
+		double covariance[3][3];
+		covariance[0][0] = (s[3] - s[0] * s[0] / w) / w;
+		covariance[0][1] = (s[4] - s[0] * s[1] / w) / w;
+		covariance[0][2] = (s[5] - s[0] * s[2] / w) / w;
+		covariance[1][1] = (s[6] - s[1] * s[1] / w) / w;
+		covariance[1][2] = (s[7] - s[1] * s[2] / w) / w;
+		covariance[2][2] = (s[8] - s[2] * s[2] / w) / w;
+		covariance[1][0] = covariance[0][1];
+		covariance[2][0] = covariance[0][2];
+		covariance[2][1] = covariance[1][2];
+
+		Polarization p;
+		p.first = first;
+		p.count = window;
+		if ( analyze(covariance, p) )
+		    results.push_back(p);
+	}
+
+	return results.size() - before;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+} // namespace Math
+} // namespace Core
+} // namespace IPGP
@@ -0,0 +1,118 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_CORE_MATH_POLARIZATION_H__
+#define __IPGP_CORE_MATH_POLARIZATION_H__
+
+
+#include <ipgp/core/api.h>
+#include <stddef.h>
+#include <vector>
+
+
+namespace IPGP {
+namespace Core {
+namespace Math {
+
+
+/**
+ * @brief Polarization of three-component ground motion over a window,
+ *        derived from the eigen-decomposition of its covariance matrix
+ *        (Jurkevics, 1988). Components are ordered (Z, N, E).
+ */
+struct SC_IPGP_CORE_API Polarization {
+
+		Polarization();
+
+		//! First sample of the window and its number of samples
+		size_t first;
+		size_t count;
+
+		//! Covariance eigenvalues, in descending order
+		double eigenvalues[3];
+		//! eigenvectors[i] is the (Z, N, E) unit vector of eigenvalues[i],
+		//! the principal one pointing upward
+		double eigenvectors[3][3];
+
+		//! 1 - (l2 + l3) / 2l1: 1 for linear, 0 for isotropic motion
+		double rectilinearity;
+		//! 1 - 2l3 / (l1 + l2): 1 for planar motion
+		double planarity;
+		//! Azimuth of the principal axis, clockwise from north (degrees)
+		double azimuth;
+		//! Angle between the principal axis and the vertical (degrees)
+		double incidence;
+
+		/**
+		 * @brief  The direction the wave comes from, assuming it is a P
+		 *         wave: its upward motion points away from the source.
+		 * @return the back-azimuth in degrees, in [0, 360[
+		 */
+		double backAzimuth() const;
+};
+typedef std::vector<Polarization> PolarizationList;
+
+
+/**
+ * @brief Diagonalizes a symmetric 3x3 matrix (cyclic Jacobi rotations).
+ * @param matrix the symmetric matrix
+ * @param eigenvalues the eigenvalues output, in descending order
+ * @param eigenvectors the unit eigenvectors output, eigenvectors[i]
+ *        belonging to eigenvalues[i]
+ */
+void SC_IPGP_CORE_API
+symmetricEigenDecomposition(const double matrix[3][3], double eigenvalues[3],
+                            double eigenvectors[3][3]);
+
+/**
+ * @brief  Analyzes the polarization of a whole window.
+ * @param  z,n,e the components samples, NaN if missing
+ * @param  count the number of samples
+ * @param  result the polarization output
+ * @return false if a sample is missing or the motion is null
+ */
+bool SC_IPGP_CORE_API
+polarization(const double* z, const double* n, const double* e,
+             const size_t& count, Polarization& result);
+
+/**
+ * @brief  Analyzes the polarization over sliding windows. Covariances are
+ *         computed out of cumulated sums, so that each window costs the
+ *         same whatever its length. Windows holding a missing (NaN) sample
+ *         or null motion are skipped.
+ * @param  z,n,e the components samples, NaN if missing
+ * @param  count the number of samples
+ * @param  window the number of samples per window
+ * @param  step the number of samples between two windows starts
+ * @param  results the analyzed windows, appended
+ * @return the number of windows appended
+ * @note   Thread safe, meant to be run over many stations in parallel.
+ */
+size_t SC_IPGP_CORE_API
+polarization(const double* z, const double* n, const double* e,
+             const size_t& count, const size_t& window, const size_t& step,
+             PolarizationList& results);
+
+
+} // namespace Math
+} // namespace Core
+} // namespace IPGP
+
+#endif
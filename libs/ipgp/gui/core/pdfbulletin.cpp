@@ -25,7 +25,18 @@
 #include <seiscomp3/core/system.h>
 #include <seiscomp3/math/geo.h>
 #include <seiscomp3/datamodel/stationmagnitude.h>
-#include <ipgp/gui/map/widgets/originwidget.h>
+#include <ipgp/gui/map/snapshotrenderer.h>
+#include <ipgp/gui/map/tilearchive.h>
+#include <ipgp/gui/map/drawables/epicenter.h>
+#include <ipgp/gui/map/drawables/arrival.h>
+#include <ipgp/gui/map/drawables/station.h>
+#include <ipgp/gui/misc/misc.h>
+#include <seiscomp3/datamodel/station.h>
+#include <QDir>
+#include <QFontDatabase>
+#include <QMap>
+#include <QSet>
+#include <QThreadPool>
 
 #include <fstream>
 
@@ -272,22 +283,93 @@ void PDFBulletin::publishBulletin(Seiscomp::DataModel::OriginPtr origin,
 	log(true, QString("stored tmp html file in folder %1").arg(_tmpFolder.c_str()));
 	emit logMessage(0x01, __func__, QString("stored tmp html file in folder %1").arg(_tmpFolder.c_str()));
 
-	OriginWidgetPtr pdfmap = OriginWidgetPtr(new OriginWidget(mapsNames, mapsPaths,
-	    origin->longitude().value(), origin->latitude().value()));
-	pdfmap->centerOn(origin->latitude().value(), origin->longitude().value());
-	pdfmap->setDatabase(_query);
-	pdfmap->setOrigin(origin.get());
-	pdfmap->setGeometry(0, 0, 400, 540);
-	pdfmap->setZoomLevel(6);
-	pdfmap->takeSnapshot(QString("%1/bigmap.png").arg(_tmpFolder.c_str()));
-	log(true, QString("stored bigmap.png in folder %1").arg(_tmpFolder.c_str()));
-	emit logMessage(0x01, __func__, QString("stored bigmap.png in folder %1").arg(_tmpFolder.c_str()));
-
-	pdfmap->setGeometry(0, 0, 390, 270);
-	pdfmap->setZoomLevel(8);
-	pdfmap->takeSnapshot(QString("%1/smallmap.png").arg(_tmpFolder.c_str()));
-	log(true, QString("stored smallmap.png in folder %1").arg(_tmpFolder.c_str()));
-	emit logMessage(0x01, __func__, QString("stored smallmap.png in folder %1").arg(_tmpFolder.c_str()));
+	//! Maps are painted off-screen, no widget has to be created (nor shown)
+	Map::MapSettings settings;
+	for (size_t i = 0; i < mapsPaths.size(); ++i) {
+
+		QString path = mapsPaths.at(i).c_str();
+		const QString name = (i < mapsNames.size()) ?
+		        QString(mapsNames.at(i).c_str()) : path;
+
+		if ( path.isEmpty() )
+		    continue;
+
+		//! Tile archives are plain files, only directories get the slash
+		QString archive = path;
+		while ( archive.endsWith('/') )
+			archive.chop(1);
+
+		if ( Map::TileArchive::isArchive(archive) )
+			path = archive;
+		else {
+
+			if ( !path.endsWith('/') )
+			    path += '/';
+
+			if ( !QDir(path).exists() ) {
+				log(false, QString("map %1 skipped, no tiles in %2").arg(name).arg(path));
+				emit logMessage(0x02, __func__, QString("map %1 skipped, no tiles in %2").arg(name).arg(path));
+				continue;
+			}
+		}
+
+		settings.tilePath = path;
+		log(true, QString("using map %1 from %2").arg(name).arg(path));
+		emit logMessage(0x01, __func__, QString("using map %1 from %2").arg(name).arg(path));
+		break;
+	}
+
+	if ( settings.tilePath.isEmpty() ) {
+		log(false, QString("no usable map among %1 configured, drawing on plain background")
+		        .arg(mapsPaths.size()));
+		emit logMessage(0x02, __func__, QString("no usable map among %1 configured, drawing on plain background")
+		        .arg(mapsPaths.size()));
+	}
+	settings.tilePattern = Map::DEFAULT_TILE_PATTERN.c_str();
+	settings.defaultBackground = Qt::white;
+
+	const QPointF center(origin->longitude().value(), origin->latitude().value());
+	const QString bigmap = QString("%1/bigmap.png").arg(_tmpFolder.c_str());
+	const QString smallmap = QString("%1/smallmap.png").arg(_tmpFolder.c_str());
+
+	//! Both maps are rendered at the same time, each task owns its geometries
+	Map::SnapshotTask bigmapTask(settings, center, 6, QSize(400, 540), bigmap);
+	Map::SnapshotTask smallmapTask(settings, center, 8, QSize(390, 270), smallmap);
+	bigmapTask.setAutoDelete(false);
+	smallmapTask.setAutoDelete(false);
+	addOriginGeometries(bigmapTask, origin);
+	addOriginGeometries(smallmapTask, origin);
+
+	//! Labels are painted too, fall back on this thread when the font
+	//! engine can't be shared with workers
+	if ( QFontDatabase::supportsThreadedFontRendering() ) {
+		QThreadPool pool;
+		pool.start(&bigmapTask);
+		pool.start(&smallmapTask);
+		pool.waitForDone();
+	}
+	else {
+		bigmapTask.run();
+		smallmapTask.run();
+	}
+
+	if ( bigmapTask.isRendered() ) {
+		log(true, QString("stored bigmap.png in folder %1").arg(_tmpFolder.c_str()));
+		emit logMessage(0x01, __func__, QString("stored bigmap.png in folder %1").arg(_tmpFolder.c_str()));
+	}
+	else {
+		log(false, QString("failed to store bigmap.png in folder %1").arg(_tmpFolder.c_str()));
+		emit logMessage(0x04, __func__, QString("failed to store bigmap.png in folder %1").arg(_tmpFolder.c_str()));
+	}
+
+	if ( smallmapTask.isRendered() ) {
+		log(true, QString("stored smallmap.png in folder %1").arg(_tmpFolder.c_str()));
+		emit logMessage(0x01, __func__, QString("stored smallmap.png in folder %1").arg(_tmpFolder.c_str()));
+	}
+	else {
+		log(false, QString("failed to store smallmap.png in folder %1").arg(_tmpFolder.c_str()));
+		emit logMessage(0x04, __func__, QString("failed to store smallmap.png in folder %1").arg(_tmpFolder.c_str()));
+	}
 
 	QString cmd = QString("%1 %2 %3").arg(_pdfConverter)
 	        .arg(QString("%1%2").arg(_tmpFolder.c_str()).arg("tmp.html"))
@@ -375,6 +457,91 @@ ArrivalPtr PDFBulletin::getArrival(Seiscomp::DataModel::OriginPtr origin,
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void PDFBulletin::addOriginGeometries(Map::SnapshotTask& task,
+                                      OriginPtr origin) {
+
+	double depth = .0;
+	bool hasDepth = false;
+	try {
+		depth = origin->depth().value();
+		hasDepth = true;
+	} catch ( ... ) {}
+
+	Map::Epicenter* epicenter = new Map::Epicenter;
+	epicenter->setName(origin->publicID().c_str());
+	epicenter->setGeoPosition(QPointF(origin->longitude().value(), origin->latitude().value()));
+	epicenter->setAntialiased(true);
+	epicenter->setSize(EpicenterDefaultSize);
+	epicenter->pen().setColor(hasDepth ? Misc::getDepthColoration(depth) : QColor(Qt::black));
+	epicenter->pen().setWidthF(EpicenterDefaultPenWidth);
+	task.addGeometry(epicenter);
+
+	QMap<QString, Map::Station*> stations;
+	QList<Map::Arrival*> arrivals;
+	QSet<QString> phases;
+
+	for (size_t i = 0; i < origin->arrivalCount(); ++i) {
+
+		ArrivalPtr ar = origin->arrival(i);
+		if ( !ar ) continue;
+
+		PickPtr pick = getPick(ar->pickID());
+		if ( !pick ) continue;
+
+		const QString key = QString("%1.%2")
+		        .arg(pick->waveformID().networkCode().c_str())
+		        .arg(pick->waveformID().stationCode().c_str());
+
+		Map::Station* stationGeometry = stations.value(key, NULL);
+		if ( !stationGeometry ) {
+
+			StationPtr station = _query->getStation(pick->waveformID().networkCode(),
+			    pick->waveformID().stationCode(), Time::GMT());
+			if ( !station ) continue;
+
+			stationGeometry = new Map::Station();
+			stationGeometry->setName(station->code().c_str());
+			stationGeometry->setNetwork(pick->waveformID().networkCode().c_str());
+			stationGeometry->setGeoPosition(QPointF(station->longitude(), station->latitude()));
+			stationGeometry->pen().setColor(Qt::white);
+			stationGeometry->setSize(StationCircleDefaultSize);
+			stations.insert(key, stationGeometry);
+		}
+
+		if ( phases.contains(key + ar->phase().code().c_str()) )
+			continue;
+		phases.insert(key + ar->phase().code().c_str());
+
+		double residual = .0;
+		try {
+			residual = ar->timeResidual();
+		} catch ( ... ) {}
+
+		Map::Arrival* arrival = new Map::Arrival();
+		arrival->setName(ar->pickID().c_str());
+		arrival->setEpicenter(epicenter);
+		arrival->setStation(stationGeometry);
+		arrival->setPhaseCode(ar->phase().code().c_str());
+		arrival->pen().setColor(Qt::white);
+		arrival->setOpacity(.3);
+		arrival->setResiduals(residual);
+		arrivals.append(arrival);
+	}
+
+	//! Same painting order as OriginWidget: arrivals below stations
+	for (int i = 0; i < arrivals.size(); ++i)
+		task.addGeometry(arrivals.at(i));
+
+	for (QMap<QString, Map::Station*>::const_iterator it = stations.constBegin();
+	        it != stations.constEnd(); ++it)
+		task.addGeometry(it.value());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void PDFBulletin::log(bool status, const QString& msg) {
 
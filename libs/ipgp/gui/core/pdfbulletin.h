@@ -42,6 +42,9 @@ class DatabaseQuery;
 namespace IPGP {
 namespace Gui {
 
+namespace Map {
+class SnapshotTask;
+}
 
 /**
  * @class   PDFBulletin
@@ -113,6 +116,8 @@ class SC_IPGP_GUI_API PDFBulletin : public QObject {
 		                                     const std::string& phase);
 		Seiscomp::DataModel::ArrivalPtr getArrival(Seiscomp::DataModel::OriginPtr,
 		                                           const std::string pickID);
+		void addOriginGeometries(Map::SnapshotTask&,
+		                         Seiscomp::DataModel::OriginPtr);
 		void log(bool, const QString&);
 
 	Q_SIGNALS:
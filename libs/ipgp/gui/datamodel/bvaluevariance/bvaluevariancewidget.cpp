@@ -0,0 +1,487 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/datamodel/bvaluevariance/bvaluevariancewidget.h>
+#include <ipgp/gui/datamodel/bvaluevariance/ui_bvaluevariancewidget.h>
+#include <ipgp/gui/3rd-party/qcustomplot/qcustomplot.h>
+#include <ipgp/core/math/math.h>
+#include <QtGui>
+
+
+
+
+using namespace Seiscomp;
+using namespace Seiscomp::DataModel;
+
+using namespace IPGP::Core;
+using namespace IPGP::Core::Math;
+
+
+namespace {
+
+const double SecondsPerDay = 86400.;
+const double SecondsPerYear = 365.25 * SecondsPerDay;
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BValueVarianceWidget::
+BValueVarianceWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
+		PlottingWidget(query, parent, f), _ui(new Ui::BValueVarianceWidget) {
+
+	_ui->setupUi(this);
+
+	setObjectName("BValueVariance");
+
+	_showLegend = true;
+	_ui->checkBox_legend->setChecked(_showLegend);
+	_ui->checkBoxShowCompleteness->setChecked(true);
+	_ui->checkBoxShowRate->setChecked(true);
+
+	_ui->doubleSpinBoxInterval->setRange(.01, 1.);
+	_ui->doubleSpinBoxInterval->setSingleStep(.1);
+	_ui->doubleSpinBoxInterval->setValue(.1);
+
+	_ui->comboBoxCompleteness->setCurrentIndex(1);
+	_ui->doubleSpinBoxCompleteness->setRange(-5., 11.);
+	_ui->doubleSpinBoxCompleteness->setSingleStep(.1);
+	_ui->doubleSpinBoxCompleteness->setValue(1.);
+	_ui->doubleSpinBoxCompleteness->setEnabled(false);
+
+	_ui->spinBoxMinimumCount->setRange(2, 100000);
+	_ui->spinBoxMinimumCount->setValue(50);
+
+	windowTypeChanged(_ui->comboBoxWindow->currentIndex());
+
+	_plot = new QCustomPlot(this);
+	_plot->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+	_plot->setBackground(Qt::transparent);
+	_plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+
+	_plot->axisRect()->setBackground(Qt::white);
+	_plot->axisRect()->setRangeDrag(Qt::Horizontal);
+	_plot->axisRect()->setRangeZoom(Qt::Horizontal);
+	_plot->xAxis->setDateTimeSpec(Qt::UTC);
+	_plot->xAxis->setTickLabelType(QCPAxis::ltDateTime);
+	_plot->xAxis2->setVisible(true);
+	_plot->xAxis2->setTicks(false);
+	_plot->xAxis2->setTickLabels(false);
+	_plot->yAxis->setLabel("b-value");
+	_plot->yAxis->grid()->setSubGridVisible(false);
+	_plot->yAxis2->setVisible(true);
+	_plot->yAxis2->setLabel("Completeness magnitude");
+
+	_rateRect = new QCPAxisRect(_plot);
+	_rateRect->setBackground(Qt::white);
+	_rateRect->setRangeDrag(Qt::Horizontal);
+	_rateRect->setRangeZoom(Qt::Horizontal);
+	_rateRect->setupFullAxesBox();
+	_rateRect->axis(QCPAxis::atBottom)->setDateTimeSpec(Qt::UTC);
+	_rateRect->axis(QCPAxis::atBottom)->setTickLabelType(QCPAxis::ltDateTime);
+	_rateRect->axis(QCPAxis::atLeft)->setLabel("Events per day");
+	_rateRect->axis(QCPAxis::atTop)->setTicks(false);
+	_rateRect->axis(QCPAxis::atTop)->setTickLabels(false);
+	_rateRect->axis(QCPAxis::atRight)->setTicks(false);
+	_rateRect->axis(QCPAxis::atRight)->setTickLabels(false);
+	_plot->plotLayout()->addElement(1, 0, _rateRect);
+
+	//! Both axes rects follow the same time range
+	connect(_plot->xAxis, SIGNAL(rangeChanged(QCPRange)),
+	    _rateRect->axis(QCPAxis::atBottom), SLOT(setRange(QCPRange)));
+	connect(_rateRect->axis(QCPAxis::atBottom), SIGNAL(rangeChanged(QCPRange)),
+	    _plot->xAxis, SLOT(setRange(QCPRange)));
+
+#ifndef __APPLE__
+	_plot->xAxis->setTickLabelFont(QFont(QFont().family(), 8));
+	_plot->yAxis->setTickLabelFont(QFont(QFont().family(), 8));
+	_plot->yAxis2->setTickLabelFont(QFont(QFont().family(), 8));
+	_rateRect->axis(QCPAxis::atBottom)->setTickLabelFont(QFont(QFont().family(), 8));
+	_rateRect->axis(QCPAxis::atLeft)->setTickLabelFont(QFont(QFont().family(), 8));
+#endif
+
+	QFont legendFont = font();
+	legendFont.setPointSize(10);
+
+	_plot->legend->setFont(legendFont);
+	_plot->legend->setSelectedFont(legendFont);
+
+	_plot->setWindowTitle("b-value variation");
+
+	QBoxLayout* l = new QVBoxLayout(_ui->framePlot);
+	_ui->framePlot->setLayout(l);
+	l->addWidget(_plot);
+	l->setMargin(0);
+
+	QBoxLayout* l2 = new QVBoxLayout(_ui->frameToolBox);
+	_ui->frameToolBox->setLayout(l2);
+	l2->addWidget(_toolBox);
+	l2->setMargin(0);
+	_toolBox->show();
+
+	_ui->listWidgetAvailable->setSelectionMode(QAbstractItemView::MultiSelection);
+	_ui->listWidgetSelected->setSelectionMode(QAbstractItemView::MultiSelection);
+
+	connect(_ui->checkBox_legend, SIGNAL(clicked(bool)), this, SLOT(showLegend(bool)));
+	connect(_ui->toolButtonAddMag, SIGNAL(clicked()), this, SLOT(addMagnitude()));
+	connect(_ui->toolButtonRemoveMag, SIGNAL(clicked()), this, SLOT(removeMagnitude()));
+	connect(_ui->comboBoxWindow, SIGNAL(currentIndexChanged(int)), this, SLOT(windowTypeChanged(int)));
+	connect(_ui->comboBoxCompleteness, SIGNAL(currentIndexChanged(int)), this, SLOT(completenessChanged(int)));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BValueVarianceWidget::~BValueVarianceWidget() {
+	delete _ui, _ui = NULL;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::showLegend(bool clicked) {
+	_showLegend = clicked;
+	replot();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::windowTypeChanged(int idx) {
+
+	if ( idx == BValueSeries::EventWindow ) {
+		_ui->doubleSpinBoxLength->setDecimals(0);
+		_ui->doubleSpinBoxLength->setRange(10., 100000.);
+		_ui->doubleSpinBoxLength->setSingleStep(10.);
+		_ui->doubleSpinBoxLength->setValue(200.);
+		_ui->doubleSpinBoxStep->setDecimals(0);
+		_ui->doubleSpinBoxStep->setRange(1., 100000.);
+		_ui->doubleSpinBoxStep->setSingleStep(10.);
+		_ui->doubleSpinBoxStep->setValue(20.);
+	}
+	else {
+		_ui->doubleSpinBoxLength->setDecimals(1);
+		_ui->doubleSpinBoxLength->setRange(.1, 36525.);
+		_ui->doubleSpinBoxLength->setSingleStep(1.);
+		_ui->doubleSpinBoxLength->setValue(30.);
+		_ui->doubleSpinBoxStep->setDecimals(1);
+		_ui->doubleSpinBoxStep->setRange(.1, 36525.);
+		_ui->doubleSpinBoxStep->setSingleStep(1.);
+		_ui->doubleSpinBoxStep->setValue(1.);
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::completenessChanged(int idx) {
+	_ui->doubleSpinBoxCompleteness->setEnabled(idx == 0);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::
+setMagnitudeTypes(const Core::MagnitudeTypes& magnitudes) {
+
+	_magnitudes = magnitudes;
+
+	_ui->listWidgetAvailable->clear();
+	_ui->listWidgetSelected->clear();
+
+	for (size_t i = 0; i < magnitudes.size(); ++i)
+		_ui->listWidgetSelected->addItem(magnitudes.at(i).c_str());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::addMagnitude() {
+	for (int i = _ui->listWidgetAvailable->count() - 1; i > -1; --i)
+		if ( _ui->listWidgetAvailable->item(i)->isSelected() )
+		    _ui->listWidgetSelected->addItem(_ui->listWidgetAvailable->takeItem(i));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::removeMagnitude() {
+	for (int i = _ui->listWidgetSelected->count() - 1; i > -1; --i)
+		if ( _ui->listWidgetSelected->item(i)->isSelected() )
+		    _ui->listWidgetAvailable->addItem(_ui->listWidgetSelected->takeItem(i));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::print(const ToolBox::ExportConfig& ec) {
+
+	QString outputFile = QFileDialog::getSaveFileName(this, tr("Save b-value variation graphic"),
+	    QDir::currentPath(), tr("%1 (*.%1)").arg(ec.format.toString()), 0,
+	    QFileDialog::DontUseNativeDialog);
+
+	if ( outputFile.isEmpty() )
+	    return;
+
+	if ( (outputFile.right(4) != QString(".%1").arg(ec.format.toString())) )
+	    outputFile.append(QString(".%1").arg(ec.format.toString()).toLower());
+
+	if ( ec.format == IPGP::Gui::PDF )
+		_plot->savePdf(outputFile, 0, ec.printSize.width(), ec.printSize.height());
+	else if ( ec.format == IPGP::Gui::PNG )
+		_plot->savePng(outputFile, ec.printSize.width(), ec.printSize.height(), 1, -1);
+	else if ( ec.format == IPGP::Gui::JPG )
+		_plot->saveJpg(outputFile, ec.printSize.width(), ec.printSize.height(), 1, -1);
+	else if ( ec.format == IPGP::Gui::BMP )
+		_plot->saveBmp(outputFile, ec.printSize.width(), ec.printSize.height(), 1);
+	else if ( ec.format == IPGP::Gui::PS )
+	    _plot->saveRastered(outputFile, ec.printSize.width(), ec.printSize.height(), 1., "PS", 100);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const bool BValueVarianceWidget::
+checkMagnitude(const std::string& magtype) {
+
+	for (int i = 0; i < _ui->listWidgetSelected->count(); ++i)
+		if ( _ui->listWidgetSelected->item(i)->text() == magtype.c_str() )
+		    return true;
+
+	return false;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::showRateAxisRect(const bool& show) {
+
+	const bool shown = _rateRect->layout() != NULL;
+	if ( show == shown )
+		return;
+
+	//! Taken out of the layout, the axes rect stays a child of the plot
+	if ( show )
+		_plot->plotLayout()->addElement(1, 0, _rateRect);
+	else {
+		_plot->plotLayout()->take(_rateRect);
+		_plot->plotLayout()->simplify();
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::replot() {
+
+	if ( _events->size() == 0 ) {
+		emit plottingError("the event list is empty");
+		return;
+	}
+
+	if ( _ui->listWidgetSelected->count() == 0 ) {
+		emit plottingError("no magnitude(s) selected, nothing plotted");
+		return;
+	}
+
+	emit working();
+
+	if ( _timer )
+	    stopBlinking();
+
+	const CatalogueSnapshot& cat = *_catalogue;
+
+	std::vector<double> times, magnitudes;
+	times.reserve(cat.size());
+	magnitudes.reserve(cat.size());
+	for (size_t j = 0; j < cat.size(); ++j) {
+		if ( !cat.hasMagnitude(j) ) continue;
+		if ( !checkMagnitude(cat.magnitudeTypes()[j]) ) continue;
+		times.push_back((double) cat.times()[j]);
+		magnitudes.push_back(cat.magnitudes()[j]);
+	}
+
+	const BValueSeries::WindowType type =
+	        static_cast<BValueSeries::WindowType>(_ui->comboBoxWindow->currentIndex());
+	const double scale = (type == BValueSeries::TimeWindow) ? SecondsPerDay : 1.;
+	_series.setWindow(type, _ui->doubleSpinBoxLength->value() * scale,
+	    _ui->doubleSpinBoxStep->value() * scale);
+	_series.setBinWidth(_ui->doubleSpinBoxInterval->value());
+	_series.setMinimumCount(_ui->spinBoxMinimumCount->value());
+
+	switch ( _ui->comboBoxCompleteness->currentIndex() ) {
+		case 0:
+			_series.setCompleteness(BValueSeries::FixedCompleteness,
+			    _ui->doubleSpinBoxCompleteness->value());
+		break;
+		case 2:
+			_series.setCompleteness(BValueSeries::GoodnessOfFit, 90.);
+		break;
+		case 3:
+			_series.setCompleteness(BValueSeries::GoodnessOfFit, 95.);
+		break;
+		default:
+			_series.setCompleteness(BValueSeries::MaximumCurvature);
+		break;
+	}
+
+	const BValueSeries::Samples& samples = _series.compute(times, magnitudes);
+
+	QVector<double> bKeys, bValues, bErrors, mcKeys, mcValues, rateKeys, rates;
+	for (size_t i = 0; i < samples.size(); ++i) {
+
+		const BValueSeries::Sample& s = samples[i];
+
+		rateKeys.append(s.end);
+		rates.append(s.rate * SecondsPerDay);
+
+		if ( s.bValue.count > 0 ) {
+			mcKeys.append(s.end);
+			mcValues.append(s.bValue.mc);
+		}
+
+		if ( !s.bValue.valid ) continue;
+
+		bKeys.append(s.end);
+		bValues.append(s.bValue.b);
+		bErrors.append(s.bValue.error);
+	}
+
+	_plot->clearPlottables();
+
+	QPen pen;
+	pen.setWidth(2.);
+
+	pen.setColor(Qt::black);
+	QCPGraph* bGraph = _plot->addGraph(_plot->xAxis, _plot->yAxis);
+	bGraph->setPen(pen);
+	bGraph->setName("b-value");
+	bGraph->setErrorType(QCPGraph::etValue);
+	bGraph->setErrorPen(QPen(Qt::gray));
+	bGraph->setDataValueError(bKeys, bValues, bErrors);
+	bGraph->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssDisc, 4));
+
+	if ( _ui->checkBoxShowCompleteness->isChecked() ) {
+		pen.setColor(QColor(255, 76, 76));
+		QCPGraph* mcGraph = _plot->addGraph(_plot->xAxis, _plot->yAxis2);
+		mcGraph->setPen(pen);
+		mcGraph->setName("Completeness magnitude");
+		mcGraph->setLineStyle(QCPGraph::lsStepLeft);
+		mcGraph->setData(mcKeys, mcValues);
+		mcGraph->rescaleValueAxis();
+	}
+	_plot->yAxis2->setTicks(_ui->checkBoxShowCompleteness->isChecked());
+	_plot->yAxis2->setTickLabels(_ui->checkBoxShowCompleteness->isChecked());
+
+	showRateAxisRect(_ui->checkBoxShowRate->isChecked());
+	if ( _ui->checkBoxShowRate->isChecked() ) {
+		pen.setColor(QColor(86, 124, 181));
+		QCPGraph* rateGraph = _plot->addGraph(_rateRect->axis(QCPAxis::atBottom),
+		    _rateRect->axis(QCPAxis::atLeft));
+		rateGraph->setPen(pen);
+		rateGraph->setName("Seismicity rate");
+		rateGraph->setBrush(QColor(86, 124, 181, 60));
+		rateGraph->setData(rateKeys, rates);
+		rateGraph->rescaleValueAxis();
+		_rateRect->axis(QCPAxis::atLeft)->setRangeLower(.0);
+	}
+
+	bGraph->rescaleAxes();
+	_plot->yAxis->scaleRange(1.2, _plot->yAxis->range().center());
+	if ( !rateKeys.isEmpty() )
+		_plot->xAxis->setRange(rateKeys.first(), rateKeys.last());
+
+	_plot->legend->setVisible(_showLegend);
+	_plot->replot();
+
+	updateTrend();
+
+	emit idling();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BValueVarianceWidget::updateTrend() {
+
+	const BValueSeries::Samples& samples = _series.samples();
+
+	std::vector<double> years, bValues;
+	const BValueSeries::Sample* last = NULL;
+	for (size_t i = 0; i < samples.size(); ++i) {
+		if ( !samples[i].bValue.valid ) continue;
+		years.push_back(samples[i].end / SecondsPerYear);
+		bValues.push_back(samples[i].bValue.b);
+		last = &samples[i];
+	}
+
+	if ( !last ) {
+		_ui->labelTrend->setText(QString("No window holds %1 events above its "
+			"completeness magnitude").arg(_series.minimumCount()));
+		return;
+	}
+
+	QString text = QString("Last window: b = %1 +/- %2, Mc = %3")
+	        .arg(last->bValue.b, 0, 'f', 3).arg(last->bValue.error, 0, 'f', 3)
+	        .arg(last->bValue.mc, 0, 'f', 2);
+
+	//! The b-value trend over the windows, which matters more than any
+	//! single estimation when monitoring unrest
+	try {
+		const LinearRegression regression = leastMeanSquareRegression(years, bValues);
+		text.append(QString("\nb-value trend: %1 per year over %2 windows")
+		        .arg(regression.slope, 0, 'f', 3).arg(years.size()));
+	} catch ( ... ) {}
+
+	_ui->labelTrend->setText(text);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+} // namespace Gui
+} // namespace IPGP
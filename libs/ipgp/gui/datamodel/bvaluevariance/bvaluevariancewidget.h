@@ -0,0 +1,116 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_GUI_BVALUEVARIANCEWIDGET_H__
+#define __IPGP_GUI_BVALUEVARIANCEWIDGET_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/datamodel/plottingwidget.h>
+#include <ipgp/core/math/bvalueseries.h>
+
+
+class QCustomPlot;
+class QCPAxisRect;
+
+namespace Ui {
+class BValueVarianceWidget;
+}
+
+
+namespace IPGP {
+namespace Gui {
+
+/**
+ * @class   BValueVarianceWidget
+ * @package IPGP::Gui::Widgets
+ * @brief   A b-value, completeness magnitude and seismicity rate variation
+ *          plotter
+ *
+ * Estimations are made over windows sliding through the catalogue, each
+ * one plotted at the time of its end.
+ */
+class SC_IPGP_GUI_API BValueVarianceWidget : public PlottingWidget {
+
+	Q_OBJECT
+
+	Q_CLASSINFO( "Author", "IPGP" )
+	Q_CLASSINFO( "Version", "1.0.0" )
+	Q_CLASSINFO( "URL", "www.ipgp.fr" )
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		explicit BValueVarianceWidget(Seiscomp::DataModel::DatabaseQuery*,
+		                              QWidget* parent = NULL,
+		                              Qt::WFlags = 0);
+		~BValueVarianceWidget();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		QCustomPlot* plot() const {
+			return _plot;
+		}
+		void setMagnitudeTypes(const Core::MagnitudeTypes&);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		const bool checkMagnitude(const std::string&);
+		void showRateAxisRect(const bool&);
+		void updateTrend();
+
+	public Q_SLOTS:
+		// ------------------------------------------------------------------
+		//  Public Qt interface
+		// ------------------------------------------------------------------
+		void replot();
+		void print(const ToolBox::ExportConfig& ec);
+
+	private Q_SLOTS:
+		// ------------------------------------------------------------------
+		//  Private Qt interface
+		// ------------------------------------------------------------------
+		void showLegend(bool);
+		void windowTypeChanged(int);
+		void completenessChanged(int);
+
+		void addMagnitude();
+		void removeMagnitude();
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		Ui::BValueVarianceWidget* _ui;
+		QCustomPlot* _plot;
+		//! Seismicity rate axes, below the b-value ones
+		QCPAxisRect* _rateRect;
+		bool _showLegend;
+		Core::Math::BValueSeries _series;
+};
+
+} // namespace Gui
+} // namespace IPGP
+
+#endif
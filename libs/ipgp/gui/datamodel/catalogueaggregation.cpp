@@ -0,0 +1,345 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/datamodel/catalogueaggregation.h>
+#include <math.h>
+#include <set>
+
+
+namespace {
+
+using namespace IPGP::Gui;
+
+const qint64 SecondsPerDay = 86400;
+
+
+qint64 floorDivide(const qint64& a, const qint64& b) {
+	qint64 q = a / b;
+	if ( (a % b != 0) && ((a < 0) != (b < 0)) )
+		--q;
+	return q;
+}
+
+
+//! Days since 1970-01-01 of a proleptic Gregorian date
+qint64 daysFromCivil(qint64 y, const int& m, const int& d) {
+
+	y -= (m <= 2);
+	const qint64 era = ((y >= 0) ? y : y - 399) / 400;
+	const qint64 yoe = y - era * 400;
+	const qint64 doy = (153 * (m + ((m > 2) ? -3 : 9)) + 2) / 5 + d - 1;
+	const qint64 doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return era * 146097 + doe - 719468;
+}
+
+
+//! Year and month of a number of days since 1970-01-01
+void civilFromDays(qint64 z, qint64& y, int& m) {
+
+	z += 719468;
+	const qint64 era = ((z >= 0) ? z : z - 146096) / 146097;
+	const qint64 doe = z - era * 146097;
+	const qint64 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const qint64 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const qint64 mp = (5 * doy + 2) / 153;
+
+	m = mp + ((mp < 10) ? 3 : -9);
+	y = yoe + era * 400 + (m <= 2);
+}
+
+
+//! Bucket starts of a time, by granularity
+void bucketStarts(const double& time, qint64 starts[CatalogueAggregation::GranularityCount]) {
+
+	const qint64 days = floorDivide((qint64) floor(time), SecondsPerDay);
+
+	qint64 y;
+	int m;
+	civilFromDays(days, y, m);
+
+	starts[CatalogueAggregation::Day] = days * SecondsPerDay;
+	starts[CatalogueAggregation::Month] = daysFromCivil(y, m, 1) * SecondsPerDay;
+	starts[CatalogueAggregation::Year] = daysFromCivil(y, 1, 1) * SecondsPerDay;
+}
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+CatalogueAggregation::Bucket::Bucket() :
+		count(0), energy(.0) {
+	for (int r = 0; r < RangeCount; ++r)
+		ranges[r] = 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+CatalogueAggregation::CatalogueAggregation() :
+		_generation(0) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+CatalogueAggregation::~CatalogueAggregation() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CatalogueAggregation::insert(const QString& id, const double& time,
+                                  const double& magnitude) {
+
+	QHash<QString, Entry>::iterator it = _entries.find(id);
+	if ( it == _entries.end() ) {
+		Entry e;
+		e.time = time;
+		e.magnitude = magnitude;
+		e.generation = _generation;
+		_entries.insert(id, e);
+		add(time, magnitude, 1);
+		return;
+	}
+
+	it->generation = _generation;
+	if ( it->time == time && it->magnitude == magnitude )
+		return;
+
+	add(it->time, it->magnitude, -1);
+	it->time = time;
+	it->magnitude = magnitude;
+	add(time, magnitude, 1);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool CatalogueAggregation::erase(const QString& id) {
+
+	QHash<QString, Entry>::iterator it = _entries.find(id);
+	if ( it == _entries.end() )
+		return false;
+
+	add(it->time, it->magnitude, -1);
+	_entries.erase(it);
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CatalogueAggregation::clear() {
+
+	_entries.clear();
+	for (int g = 0; g < GranularityCount; ++g)
+		_buckets[g].clear();
+
+	_catalogue.clear();
+	_magnitudeTypes.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool CatalogueAggregation::
+synchronize(const CatalogueSnapshotCPtr& catalogue,
+            const QStringList& magnitudeTypes) {
+
+	QStringList types = magnitudeTypes;
+	types.sort();
+
+	if ( catalogue == _catalogue && types == _magnitudeTypes )
+		return false;
+
+	if ( !catalogue ) {
+		clear();
+		return true;
+	}
+
+	std::set<std::string> selected;
+	for (int i = 0; i < types.size(); ++i)
+		selected.insert(types.at(i).toStdString());
+
+	//! Events seen in the snapshot are stamped with a new generation,
+	//! the ones left with an older stamp are gone
+	++_generation;
+
+	const CatalogueSnapshot& cat = *catalogue;
+	for (size_t j = 0; j < cat.size(); ++j) {
+
+		if ( !cat.hasMagnitude(j) ) continue;
+		if ( selected.find(cat.magnitudeTypes()[j]) == selected.end() ) continue;
+
+		insert(QString::fromStdString(cat.publicIDs()[j]),
+		    (double) cat.times()[j], cat.magnitudes()[j]);
+	}
+
+	QHash<QString, Entry>::iterator it = _entries.begin();
+	while ( it != _entries.end() ) {
+		if ( it->generation != _generation ) {
+			add(it->time, it->magnitude, -1);
+			it = _entries.erase(it);
+		}
+		else
+			++it;
+	}
+
+	_catalogue = catalogue;
+	_magnitudeTypes = types;
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+CatalogueAggregation::Series
+CatalogueAggregation::series(const Granularity& g) const {
+
+	const Buckets& buckets = _buckets[g];
+
+	Series s;
+	s.keys.reserve(buckets.size());
+	s.counts.reserve(buckets.size());
+	s.energies.reserve(buckets.size());
+	for (int r = 0; r < RangeCount; ++r)
+		s.ranges[r].reserve(buckets.size());
+
+	for (Buckets::const_iterator it = buckets.constBegin();
+	        it != buckets.constEnd(); ++it) {
+		s.keys.append(it.key());
+		s.counts.append(it.value().count);
+		s.energies.append(it.value().energy);
+		for (int r = 0; r < RangeCount; ++r)
+			s.ranges[r].append(it.value().ranges[r]);
+	}
+
+	return s;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int CatalogueAggregation::range(const double& magnitude) {
+
+	//! Null and negative magnitudes are placeholders of missing values
+	if ( !(magnitude > .0) )
+		return -1;
+
+	return (magnitude >= RangeCount - 1) ? RangeCount - 1 : (int) magnitude;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+double CatalogueAggregation::energy(const double& magnitude) {
+	// Gutenberg-Richter formula
+	//! TODO Make this configurable?!
+	return pow(10, 2.9 + 1.92 * magnitude - .024 * magnitude * magnitude);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+qint64 CatalogueAggregation::bucketStart(const double& time,
+                                         const Granularity& g) {
+	qint64 starts[GranularityCount];
+	bucketStarts(time, starts);
+	return starts[g];
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+double CatalogueAggregation::bucketLength(const Granularity& g) {
+
+	switch ( g ) {
+		case Month:
+			return 30. * SecondsPerDay;
+		case Year:
+			return 365. * SecondsPerDay;
+		default:
+			return SecondsPerDay;
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CatalogueAggregation::add(const double& time, const double& magnitude,
+                               const int& sign) {
+
+	qint64 starts[GranularityCount];
+	bucketStarts(time, starts);
+
+	const int r = range(magnitude);
+	const double e = energy(magnitude);
+
+	for (int g = 0; g < GranularityCount; ++g) {
+
+		Buckets::iterator it = _buckets[g].find(starts[g]);
+		if ( it == _buckets[g].end() )
+			it = _buckets[g].insert(starts[g], Bucket());
+
+		Bucket& b = it.value();
+		b.count += sign;
+		if ( r >= 0 )
+			b.ranges[r] += sign;
+		b.energy += sign * e;
+
+		//! Emptied buckets are dropped with their rounding residue
+		if ( b.count <= 0 )
+			_buckets[g].erase(it);
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace Gui
+} // namespace IPGP
@@ -0,0 +1,169 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_GUI_DATAMODEL_CATALOGUEAGGREGATION_H__
+#define __IPGP_GUI_DATAMODEL_CATALOGUEAGGREGATION_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/datamodel/cataloguesnapshot.h>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+namespace IPGP {
+namespace Gui {
+
+
+/**
+ * @class   CatalogueAggregation
+ * @package IPGP::Gui::DataModel
+ * @brief   Per day, month and year counts of a catalogue
+ *
+ * Keeps, for every day, month and year holding at least one event, the
+ * number of events, their number by magnitude range and the energy they
+ * released. The three granularities are maintained together: switching
+ * from one to another, or from a cumulative to an incremental view, only
+ * reads the buckets back.
+ * Events are identified by their publicID. insert() and erase() update
+ * the buckets of a single event, synchronize() applies the differences
+ * between the events aggregated and the ones of a catalogue snapshot.
+ * Buckets are bounded by UTC calendar days, months and years.
+ */
+class SC_IPGP_GUI_API CatalogueAggregation {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		enum Granularity {
+			Day,
+			Month,
+			Year
+		};
+		static const int GranularityCount = 3;
+
+		//! Magnitude ranges ]0,1[, [1,2[, [2,3[, [3,4[, [4,5[ and [5,+inf[
+		static const int RangeCount = 6;
+
+		struct Bucket {
+				Bucket();
+				int count;
+				int ranges[RangeCount];
+				double energy;
+		};
+		//! Buckets by start time, in epoch seconds
+		typedef QMap<qint64, Bucket> Buckets;
+
+		//! Columns of the buckets of a granularity, by start time
+		struct Series {
+				QVector<double> keys;
+				QVector<double> counts;
+				QVector<double> ranges[RangeCount];
+				QVector<double> energies;
+		};
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		CatalogueAggregation();
+		~CatalogueAggregation();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief Adds an event, or moves it if its time or magnitude
+		 *        changed.
+		 * @param id the event identifier, e.g. the origin publicID
+		 * @param time the origin time, in epoch seconds
+		 * @param magnitude the event magnitude
+		 */
+		void insert(const QString& id, const double& time,
+		            const double& magnitude);
+		//! @return false if the event isn't aggregated
+		bool erase(const QString& id);
+		void clear();
+
+		/**
+		 * @brief  Aggregates the events of a snapshot whose preferred
+		 *         magnitude has one of the given types: events which left
+		 *         the snapshot are erased, new or changed ones inserted.
+		 * @param  catalogue the snapshot, NULL empties the aggregation
+		 * @param  magnitudeTypes the magnitude types to aggregate
+		 * @return false if the aggregation already described this snapshot
+		 *         and these types, nothing being done
+		 */
+		bool synchronize(const CatalogueSnapshotCPtr& catalogue,
+		                 const QStringList& magnitudeTypes);
+
+		int count() const {
+			return _entries.size();
+		}
+		const Buckets& buckets(const Granularity& g) const {
+			return _buckets[g];
+		}
+		//! Reads the non empty buckets of a granularity into columns
+		Series series(const Granularity& g) const;
+
+		//! @return the index of the range of a magnitude, -1 if none
+		static int range(const double& magnitude);
+		//! @return the energy released by an event, in joules
+		static double energy(const double& magnitude);
+		//! @return the start time of the bucket of a time, in epoch seconds
+		static qint64 bucketStart(const double& time, const Granularity&);
+		//! @return the nominal length of a granularity buckets, in seconds
+		static double bucketLength(const Granularity&);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		void add(const double& time, const double& magnitude, const int& sign);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		struct Entry {
+				double time;
+				double magnitude;
+				quint32 generation;
+		};
+
+		QHash<QString, Entry> _entries;
+		Buckets _buckets[GranularityCount];
+		quint32 _generation;
+
+		//! What the last synchronization was made of
+		CatalogueSnapshotCPtr _catalogue;
+		QStringList _magnitudeTypes;
+};
+
+
+} // namespace Gui
+} // namespace IPGP
+
+#endif
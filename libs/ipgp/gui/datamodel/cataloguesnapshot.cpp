@@ -0,0 +1,233 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#define SEISCOMP_COMPONENT IPGP_CATALOGUESNAPSHOT
+
+#include <ipgp/gui/datamodel/cataloguesnapshot.h>
+#include <seiscomp3/datamodel/event.h>
+#include <seiscomp3/datamodel/magnitude.h>
+#include <seiscomp3/datamodel/origin.h>
+#include <seiscomp3/logging/log.h>
+#include <seiscomp3/utils/timer.h>
+#include <QWeakPointer>
+
+
+using namespace Seiscomp;
+using namespace Seiscomp::DataModel;
+
+
+namespace IPGP {
+namespace Gui {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+CatalogueSnapshot::CatalogueSnapshot() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+CatalogueSnapshot::~CatalogueSnapshot() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+CatalogueSnapshotCPtr CatalogueSnapshot::Shared(const Core::OriginList* list) {
+
+	//! Only the last snapshot is kept, and only while a widget holds it
+	static QWeakPointer<const CatalogueSnapshot> last;
+
+	if ( !list ) return CatalogueSnapshotCPtr();
+
+	CatalogueSnapshotCPtr snapshot = last.toStrongRef();
+	if ( snapshot && snapshot->isSnapshotOf(*list) )
+		return snapshot;
+
+	CatalogueSnapshotPtr fresh(new CatalogueSnapshot);
+	fresh->build(*list);
+
+	snapshot = fresh;
+	last = snapshot;
+
+	return snapshot;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CatalogueSnapshot::build(const Core::OriginList& list) {
+
+	Util::StopWatch sw;
+
+	clear();
+
+	const size_t count = list.size();
+	_publicIDs.resize(count);
+	_times.resize(count);
+	_latitudes.resize(count, .0);
+	_longitudes.resize(count, .0);
+	_depths.resize(count, .0);
+	_magnitudes.resize(count, .0);
+	_magnitudeTypes.resize(count);
+	_eventTypes.resize(count);
+	_flags.resize(count, 0);
+	_origins.resize(count, NULL);
+	_events.resize(count, NULL);
+	_preferredMagnitudeIDs.resize(count);
+
+	for (size_t i = 0; i < count; ++i) {
+
+		Origin* org = list[i].first.get();
+		Event* evt = list[i].second.get();
+
+		_origins[i] = org;
+		_events[i] = evt;
+
+		if ( org ) {
+
+			_publicIDs[i] = org->publicID();
+			_times[i] = org->time().value();
+			_latitudes[i] = org->latitude().value();
+			_longitudes[i] = org->longitude().value();
+
+			try {
+				_depths[i] = org->depth().value();
+				_flags[i] |= HasDepth;
+			} catch ( ... ) {}
+
+			try {
+				if ( org->evaluationMode() == AUTOMATIC )
+					_flags[i] |= Automatic;
+				_flags[i] |= HasEvaluationMode;
+			} catch ( ... ) {}
+		}
+
+		if ( !evt ) continue;
+
+		_preferredMagnitudeIDs[i] = evt->preferredMagnitudeID();
+
+		try {
+			_eventTypes[i] = evt->type().toString();
+			_flags[i] |= HasEventType;
+		} catch ( ... ) {}
+
+		Magnitude* mag = Magnitude::Find(evt->preferredMagnitudeID());
+		if ( !mag ) continue;
+
+		_magnitudeTypes[i] = mag->type();
+		try {
+			_magnitudes[i] = mag->magnitude().value();
+			_flags[i] |= HasMagnitude;
+		} catch ( ... ) {}
+	}
+
+	SEISCOMP_DEBUG("Catalogue snapshot of %ld events built in %s", count,
+	    Seiscomp::Core::Time(sw.elapsed()).toString("%T.%f").c_str());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool CatalogueSnapshot::isSnapshotOf(const Core::OriginList& list) const {
+
+	if ( list.size() != _origins.size() )
+		return false;
+
+	//! Addresses may be reused by new objects, their identifiers and the
+	//! plotted event attributes are compared as well
+	for (size_t i = 0; i < list.size(); ++i) {
+
+		const Origin* org = list[i].first.get();
+		const Event* evt = list[i].second.get();
+
+		if ( org != _origins[i] || evt != _events[i] )
+			return false;
+		if ( org && org->publicID() != _publicIDs[i] )
+			return false;
+		if ( !evt ) continue;
+
+		if ( evt->preferredMagnitudeID() != _preferredMagnitudeIDs[i] )
+			return false;
+
+		//! Types and magnitudes may be updated in place by messages
+		std::string type;
+		bool hasType = false;
+		try {
+			type = evt->type().toString();
+			hasType = true;
+		} catch ( ... ) {}
+		if ( hasType != hasEventType(i) || type != _eventTypes[i] )
+			return false;
+
+		const Magnitude* mag = Magnitude::Find(evt->preferredMagnitudeID());
+		if ( !mag ) {
+			if ( hasMagnitude(i) || !_magnitudeTypes[i].empty() )
+			    return false;
+			continue;
+		}
+
+		if ( mag->type() != _magnitudeTypes[i] )
+			return false;
+
+		double value = .0;
+		bool hasValue = false;
+		try {
+			value = mag->magnitude().value();
+			hasValue = true;
+		} catch ( ... ) {}
+		if ( hasValue != hasMagnitude(i) || value != _magnitudes[i] )
+			return false;
+	}
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CatalogueSnapshot::clear() {
+
+	_publicIDs.clear();
+	_times.clear();
+	_latitudes.clear();
+	_longitudes.clear();
+	_depths.clear();
+	_magnitudes.clear();
+	_magnitudeTypes.clear();
+	_eventTypes.clear();
+	_flags.clear();
+	_origins.clear();
+	_events.clear();
+	_preferredMagnitudeIDs.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace Gui
+} // namespace IPGP
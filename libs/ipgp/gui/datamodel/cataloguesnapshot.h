@@ -0,0 +1,161 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_GUI_DATAMODEL_CATALOGUESNAPSHOT_H__
+#define __IPGP_GUI_DATAMODEL_CATALOGUESNAPSHOT_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/core/datamodel/types.h>
+#include <seiscomp3/core/datetime.h>
+#include <string>
+#include <vector>
+
+
+namespace IPGP {
+namespace Gui {
+
+
+DEFINE_IPGP_SMARTPOINTER(CatalogueSnapshot);
+/**
+ * @class   CatalogueSnapshot
+ * @package IPGP::Gui::DataModel
+ * @brief   Columnar copy of the fields plotted out of an event list
+ *
+ * Plotting widgets used to walk the origin list on every replot, looking
+ * the preferred magnitude of each event up and catching the exceptions of
+ * every optional attribute. The snapshot does it once per list: the i-th
+ * entry of each column describes the i-th origin of the list, optional
+ * attributes being flagged.
+ * Snapshots returned by Shared() are reused as long as the list holds the
+ * same origins and events with the same types and preferred magnitudes
+ * (identifiers, types and values), so that the widgets of a same view
+ * share the work.
+ */
+class SC_IPGP_GUI_API CatalogueSnapshot {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		enum Flag {
+			HasDepth = 0x01,
+			HasMagnitude = 0x02,
+			HasEvaluationMode = 0x04,
+			Automatic = 0x08,
+			HasEventType = 0x10
+		};
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		CatalogueSnapshot();
+		~CatalogueSnapshot();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief  Fetches the snapshot of a list, building it first if the
+		 *         last one shared doesn't describe it.
+		 * @return the snapshot, NULL without list
+		 */
+		static CatalogueSnapshotCPtr Shared(const Core::OriginList*);
+
+		void build(const Core::OriginList&);
+		//! @return true if the snapshot has been built out of these objects
+		bool isSnapshotOf(const Core::OriginList&) const;
+		void clear();
+
+		size_t size() const {
+			return _publicIDs.size();
+		}
+
+		bool hasDepth(const size_t& i) const {
+			return _flags[i] & HasDepth;
+		}
+		bool hasMagnitude(const size_t& i) const {
+			return _flags[i] & HasMagnitude;
+		}
+		bool hasEvaluationMode(const size_t& i) const {
+			return _flags[i] & HasEvaluationMode;
+		}
+		bool isAutomatic(const size_t& i) const {
+			return _flags[i] & Automatic;
+		}
+		bool hasEventType(const size_t& i) const {
+			return _flags[i] & HasEventType;
+		}
+
+		//! Origins publicIDs
+		const std::vector<std::string>& publicIDs() const {
+			return _publicIDs;
+		}
+		const std::vector<Seiscomp::Core::Time>& times() const {
+			return _times;
+		}
+		const std::vector<double>& latitudes() const {
+			return _latitudes;
+		}
+		const std::vector<double>& longitudes() const {
+			return _longitudes;
+		}
+		const std::vector<double>& depths() const {
+			return _depths;
+		}
+		//! Preferred magnitudes values and types
+		const std::vector<double>& magnitudes() const {
+			return _magnitudes;
+		}
+		const std::vector<std::string>& magnitudeTypes() const {
+			return _magnitudeTypes;
+		}
+		//! Events types, as strings
+		const std::vector<std::string>& eventTypes() const {
+			return _eventTypes;
+		}
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		std::vector<std::string> _publicIDs;
+		std::vector<Seiscomp::Core::Time> _times;
+		std::vector<double> _latitudes;
+		std::vector<double> _longitudes;
+		std::vector<double> _depths;
+		std::vector<double> _magnitudes;
+		std::vector<std::string> _magnitudeTypes;
+		std::vector<std::string> _eventTypes;
+		std::vector<unsigned char> _flags;
+
+		//! What the snapshot has been built out of
+		std::vector<const void*> _origins;
+		std::vector<const void*> _events;
+		std::vector<std::string> _preferredMagnitudeIDs;
+};
+
+
+} // namespace Gui
+} // namespace IPGP
+
+#endif
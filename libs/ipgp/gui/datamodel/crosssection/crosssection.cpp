@@ -22,7 +22,7 @@
 #include <ipgp/gui/datamodel/crosssection/ui_crosssection.h>
 #include <ipgp/gui/client/application.h>
 #include <ipgp/gui/datamodel/squarrezoomplot.h>
-#include <seiscomp3/datamodel/magnitude.h>
+#include <ipgp/gui/datamodel/scatterplottable.h>
 #include <seiscomp3/datamodel/types.h>
 #include <seiscomp3/math/polygon.h>
 #include <seiscomp3/math/geo.h>
@@ -355,8 +355,8 @@ void CrossSection::replot() {
 
 	if ( _timer ) stopBlinking();
 
-	_horizontalProjection->clearGraphs();
-	_verticalProjection->clearGraphs();
+	_horizontalProjection->clearPlottables();
+	_verticalProjection->clearPlottables();
 
 	emit enableCrossSection(QPointF(_ui->longitudeA->value(), _ui->latitudeA->value()),
 	    QPointF(_ui->longitudeB->value(), _ui->latitudeB->value()),
@@ -374,67 +374,53 @@ void CrossSection::replot() {
 	poly.addVertex(latBMin, _ui->longitudeB->value());
 	poly.addVertex(latAMin, _ui->longitudeA->value());
 
+	const CatalogueSnapshot& cat = *_catalogue;
+
 	MagnitudeList list;
 	QStringList objects;
 	size_t idx = 0;
-	for (OriginList::const_iterator i = _events->begin();
-	        i != _events->end(); ++i, ++idx) {
+	for (; idx < cat.size(); ++idx) {
+
+		emit loadingPercentage(percentageOfSomething<int>(cat.size(), idx),
+		    objectName(), "Sorting events");
+
+		//! Ignore object without depth, it will misrepresent the cross section
+		if ( !cat.hasDepth(idx) ) continue;
 
-		OriginPtr org = i->first;
+		const double depth = cat.depths()[idx];
+		if ( !poly.pointInPolygon(cat.latitudes()[idx], cat.longitudes()[idx])
+		        || depth <= _ui->depth_min->value()
+		        || depth >= _ui->depth_max->value() )
+			continue;
 
 		EventMagnitude e;
-		e.publicID = org->publicID();
-		e.time = org->time().value();
+		e.publicID = cat.publicIDs()[idx];
+		e.time = cat.times()[idx];
+		e.depth = depth;
+		e.hasDepth = true;
+		e.isAuto = cat.isAutomatic(idx);
 
 		if ( AppInstance->scheme().distanceInKM() ) {
-			e.latitude = org->latitude();
-			e.longitude = org->longitude();
+			e.latitude = cat.latitudes()[idx];
+			e.longitude = cat.longitudes()[idx];
 		}
 		else {
-			e.latitude = Seiscomp::Math::Geo::km2deg(org->latitude());
-			e.longitude = Seiscomp::Math::Geo::km2deg(org->longitude());
+			e.latitude = Seiscomp::Math::Geo::km2deg(cat.latitudes()[idx]);
+			e.longitude = Seiscomp::Math::Geo::km2deg(cat.longitudes()[idx]);
 		}
 
-		MagnitudePtr mag = Magnitude::Find(i->second->preferredMagnitudeID());
-		if ( mag ) {
-			try {
-				e.magnitude = mag->magnitude().value();
-				e.magnitudeSize = (4.9 * (mag->magnitude().value() - 1.2)) / 2.;
-				e.hasMagnitude = true;
-			} catch ( ... ) {
-				e.hasMagnitude = false;
-			}
+		e.magnitudeSize = 2.;
+		e.hasMagnitude = cat.hasMagnitude(idx);
+		if ( e.hasMagnitude ) {
+			e.magnitude = cat.magnitudes()[idx];
+			e.magnitudeSize = (4.9 * (e.magnitude - 1.2)) / 2.;
 		}
 
 		if ( e.magnitudeSize < 2. )
 		    e.magnitudeSize = 2.;
 
-		try {
-			e.depth = org->depth().value();
-			e.hasDepth = true;
-		} catch ( ... ) {
-			e.hasDepth = false;
-		}
-
-		try {
-			if ( org->evaluationMode() == AUTOMATIC )
-				e.isAuto = true;
-			else if ( org->evaluationMode() == MANUAL )
-			    e.isAuto = false;
-		} catch ( ... ) {}
-
-		//! Ignore object without depth, it will misrepresent the cross section
-		if ( !e.hasDepth ) continue;
-
-		if ( poly.pointInPolygon(org->latitude().value(), org->longitude().value())
-		        && e.depth > _ui->depth_min->value()
-		        && e.depth < _ui->depth_max->value() ) {
-			list << e;
-			objects << org->publicID().c_str();
-		}
-
-		emit loadingPercentage(percentageOfSomething<int>(_events->size(), idx),
-		    objectName(), "Sorting events");
+		list << e;
+		objects << e.publicID.c_str();
 	}
 
 	// Inform parent of objects to be highlighted
@@ -442,43 +428,24 @@ void CrossSection::replot() {
 
 	// Pen offset
 	double offset = 2.;
-	idx = 0;
-
-	// Draw objects shapes
-	for (MagnitudeList::const_iterator it = list.constBegin();
-	        it != list.constEnd(); ++it, ++idx) {
 
-		QCPGraph* hg = _horizontalProjection->addGraph();
-		hg->setName((*it).publicID.c_str());
-		hg->addData((*it).longitude, (*it).depth);
-		hg->setLineStyle(QCPGraph::lsNone);
-		hg->setPen(QPen());
-		hg->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssCircle, (*it).magnitudeSize + offset));
-		hg->setTooltip(QString("%1\n%2")
-		        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
-		        .arg((*it).publicID.c_str()));
-		_horizontalProjection->legend->removeItem(_horizontalProjection->legend->itemCount() - 1);
-
-
-		QCPGraph* vg = _verticalProjection->addGraph();
-		vg->setName((*it).publicID.c_str());
-		vg->addData((*it).latitude, (*it).depth);
-		vg->setLineStyle(QCPGraph::lsNone);
-		vg->setPen(QPen());
-		vg->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssCircle, (*it).magnitudeSize + offset));
-		vg->setTooltip(QString("%1\n%2")
-		        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
-		        .arg((*it).publicID.c_str()));
-		_verticalProjection->legend->removeItem(_verticalProjection->legend->itemCount() - 1);
-
-		emit loadingPercentage(percentageOfSomething<int>(list.size(), idx),
-		    objectName(), "First painting");
-	}
+	//! Each projection draws all its objects from one plottable, their
+	//! outlines first and then their colored shapes
+	ScatterPlottable* hs = new ScatterPlottable(_horizontalProjection->xAxis,
+	    _horizontalProjection->yAxis);
+	_horizontalProjection->addPlottable(hs);
+	hs->removeFromLegend();
+	hs->setOutline(QPen(), offset);
+	hs->reserve(list.size());
+
+	ScatterPlottable* vs = new ScatterPlottable(_verticalProjection->xAxis,
+	    _verticalProjection->yAxis);
+	_verticalProjection->addPlottable(vs);
+	vs->removeFromLegend();
+	vs->setOutline(QPen(), offset);
+	vs->reserve(list.size());
 
 	idx = 0;
-	// Fill up shapes with colors
 	for (MagnitudeList::const_iterator it = list.constBegin();
 	        it != list.constEnd(); ++it, ++idx) {
 
@@ -488,33 +455,20 @@ void CrossSection::replot() {
 		else
 			c = QColor(0, 0, 0, 150);
 
-		QCPGraph* hg = _horizontalProjection->addGraph();
-		hg->setName((*it).publicID.c_str());
-		hg->addData((*it).longitude, (*it).depth);
-		hg->setLineStyle(QCPGraph::lsNone);
-		hg->setPen(c);
-		hg->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssDisc, c, (*it).magnitudeSize));
-		hg->setTooltip(QString("%1\n%2")
-		        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
-		        .arg((*it).publicID.c_str()));
-		_horizontalProjection->legend->removeItem(_horizontalProjection->legend->itemCount() - 1);
-
-
-		QCPGraph* vg = _verticalProjection->addGraph();
-		vg->setName((*it).publicID.c_str());
-		vg->addData((*it).latitude, (*it).depth);
-		vg->setLineStyle(QCPGraph::lsNone);
-		vg->setPen(c);
-		vg->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-		        QCPScatterStyle::ssFilledSquare : QCPScatterStyle::ssDisc, c, (*it).magnitudeSize));
-		vg->setTooltip(QString("%1\n%2")
+		const QString name = (*it).publicID.c_str();
+		const QString tooltip = QString("%1\n%2")
 		        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
-		        .arg((*it).publicID.c_str()));
-		_verticalProjection->legend->removeItem(_verticalProjection->legend->itemCount() - 1);
+		        .arg(name);
+
+		hs->addPoint((*it).longitude, (*it).depth, (*it).magnitudeSize,
+		    ((*it).isAuto) ? QCPScatterStyle::ssSquare : QCPScatterStyle::ssDisc,
+		    c, name, tooltip);
+		vs->addPoint((*it).latitude, (*it).depth, (*it).magnitudeSize,
+		    ((*it).isAuto) ? QCPScatterStyle::ssFilledSquare : QCPScatterStyle::ssDisc,
+		    c, name, tooltip);
 
 		emit loadingPercentage(percentageOfSomething<int>(list.size(), idx),
-		    objectName(), "Second painting");
+		    objectName(), "Painting");
 	}
 
 	_horizontalProjection->rescaleAxes();
@@ -560,8 +514,16 @@ void CrossSection::updateCurrentProfile(const int& idx) {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void CrossSection::plottableClicked(QCPAbstractPlottable* plottable,
                                     QMouseEvent* event) {
-	Q_UNUSED(event);
-	emit elementClicked(plottable->name());
+
+	ScatterPlottable* scatter = qobject_cast<ScatterPlottable*>(plottable);
+	if ( !scatter ) {
+		emit elementClicked(plottable->name());
+		return;
+	}
+
+	const int index = scatter->pointAt(event->pos());
+	if ( index >= 0 )
+		emit elementClicked(scatter->pointName(index));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
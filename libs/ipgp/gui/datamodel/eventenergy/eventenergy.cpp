@@ -24,10 +24,11 @@
 #include <ipgp/gui/datamodel/eventenergy/eventenergy.h>
 #include <ipgp/gui/datamodel/eventenergy/ui_eventenergy.h>
 #include <ipgp/gui/datamodel/squarrezoomplot.h>
+#include <ipgp/gui/datamodel/scatterplottable.h>
 #include <ipgp/gui/misc/misc.h>
 #include <ipgp/core/math/math.h>
-#include <seiscomp3/datamodel/magnitude.h>
 #include <QtGui>
+#include <set>
 
 
 using namespace Seiscomp;
@@ -37,13 +38,25 @@ using namespace IPGP::Core::Math;
 
 
 
+namespace {
+
+using namespace IPGP::Gui;
+
+//! comboBoxGranularity entries, the first one plotting events one by one
+const int Events = 0;
+const CatalogueAggregation::Granularity Granularities[] = {
+	CatalogueAggregation::Day, // unused
+	CatalogueAggregation::Day,
+	CatalogueAggregation::Month,
+	CatalogueAggregation::Year
+};
+
+}
+
+
 namespace IPGP {
 namespace Gui {
 
-typedef QPair<double, double> MagMo;
-//	typedef QPair<Time, MagMo> TimedMo;
-typedef QMap<double, MagMo> MagMap;
-
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 EventEnergy::EventEnergy(Seiscomp::DataModel::DatabaseQuery* query,
@@ -112,9 +125,12 @@ EventEnergy::EventEnergy(Seiscomp::DataModel::DatabaseQuery* query,
 
 	connect(_ui->toolButtonAdd, SIGNAL(clicked()), this, SLOT(addMagnitude()));
 	connect(_ui->toolButtonRemove, SIGNAL(clicked()), this, SLOT(removeMagnitude()));
-	connect(_ui->checkBoxPlotBaseTen, SIGNAL(clicked()), this, SLOT(replot()));
-	connect(_ui->checkBoxShowCumulativeValues, SIGNAL(clicked()), this, SLOT(replot()));
-	connect(_ui->checkBoxShowIncrementalValues, SIGNAL(clicked()), this, SLOT(replot()));
+	connect(_ui->checkBoxPlotBaseTen, SIGNAL(clicked()), this, SLOT(render()));
+	connect(_ui->checkBoxShowCumulativeValues, SIGNAL(clicked()), this, SLOT(render()));
+	connect(_ui->checkBoxShowIncrementalValues, SIGNAL(clicked()), this, SLOT(render()));
+	connect(_ui->checkBoxShowIncrementalRegression, SIGNAL(clicked()), this, SLOT(render()));
+	connect(_ui->checkBoxShowCumulativeRegression, SIGNAL(clicked()), this, SLOT(render()));
+	connect(_ui->comboBoxGranularity, SIGNAL(currentIndexChanged(int)), this, SLOT(render()));
 	connect(_ui->checkBoxShowLegend, SIGNAL(clicked()), this, SLOT(showHideLegend()));
 	connect(_plot, SIGNAL(plottableClick(QCPAbstractPlottable*, QMouseEvent*)),
 	    this, SLOT(plottableClicked(QCPAbstractPlottable*, QMouseEvent*)));
@@ -179,20 +195,6 @@ void EventEnergy::setMagnitudeTypes(const Core::MagnitudeTypes& magnitudes) {
 
 
 
-// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-const bool EventEnergy::checkMagnitude(const std::string& magtype) {
-
-	for (int i = 0; i < _ui->listWidgetSelected->count(); ++i)
-		if ( _ui->listWidgetSelected->item(i)->text() == magtype.c_str() )
-		    return true;
-
-	return false;
-}
-// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
-
-
-
-
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void EventEnergy::addMagnitude() {
 	for (int i = _ui->listWidgetAvailable->count() - 1; i > -1; --i)
@@ -218,8 +220,16 @@ void EventEnergy::removeMagnitude() {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void EventEnergy::plottableClicked(QCPAbstractPlottable* plottable,
                                    QMouseEvent* event) {
-	Q_UNUSED(event);
-	emit elementClicked(plottable->name());
+
+	ScatterPlottable* scatter = qobject_cast<ScatterPlottable*>(plottable);
+	if ( !scatter ) {
+		emit elementClicked(plottable->name());
+		return;
+	}
+
+	const int index = scatter->pointAt(event->pos());
+	if ( index >= 0 )
+		emit elementClicked(scatter->pointName(index));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -256,75 +266,93 @@ void EventEnergy::replot() {
 
 	emit working();
 
-	// Ordered map
-	MagMap map;
-	// Un-ordered list
-	MagnitudeList m;
+	QStringList types;
+	for (int i = 0; i < _ui->listWidgetSelected->count(); ++i)
+		types << _ui->listWidgetSelected->item(i)->text();
 
-	//! Store all valid magnitude values and origins time, calculate mo (in joule)
-	for (OriginList::const_iterator j = _events->begin();
-	        j != _events->end(); ++j) {
+	//! Events are only listed again when the aggregation changed
+	if ( _aggregation.synchronize(_catalogue, types) ) {
 
-		MagnitudePtr mag = Magnitude::Find(j->second->preferredMagnitudeID());
+		_items.clear();
 
-		if ( !mag ) continue;
+		const CatalogueSnapshot& cat = *_catalogue;
+		std::set<std::string> selected;
+		for (int i = 0; i < types.size(); ++i)
+			selected.insert(types.at(i).toStdString());
 
-		if ( !checkMagnitude(mag->type()) ) continue;
+		for (size_t j = 0; j < cat.size(); ++j) {
 
-		double magnitude;
-		try {
-			magnitude = mag->magnitude().value();
-		} catch ( ... ) {
 			//! Ignore event without magnitude!!
-			continue;
-		}
+			if ( !cat.hasMagnitude(j) ) continue;
+			if ( selected.find(cat.magnitudeTypes()[j]) == selected.end() ) continue;
 
-		// Gutenber-Richter formula...
-		//! TODO Make this configurable?!
-		double mo = pow(10, 2.9 + 1.92 * magnitude - .024 * pow(magnitude, 2));
-		map.insert((double) j->first->time().value(), MagMo(magnitude, mo));
+			const double magnitude = cat.magnitudes()[j];
 
-		EventMagnitude e;
-		e.time = j->first->time().value();
-		e.publicID = j->first->publicID();
-		e.magnitude = magnitude;
-		e.magnitudeEnergy = mo;
-		e.magnitudeSize = (4.9 * (magnitude - 1.2)) / 2.;
-		if ( e.magnitudeSize < 2. )
-		    e.magnitudeSize = 2.;
+			EventMagnitude e;
+			e.time = cat.times()[j];
+			e.publicID = cat.publicIDs()[j];
+			e.magnitude = magnitude;
+			e.magnitudeEnergy = CatalogueAggregation::energy(magnitude);
+			e.magnitudeSize = (4.9 * (magnitude - 1.2)) / 2.;
+			if ( e.magnitudeSize < 2. )
+			    e.magnitudeSize = 2.;
 
-		try {
-			if ( j->first->evaluationMode() == AUTOMATIC )
-				e.isAuto = true;
-			else if ( j->first->evaluationMode() == MANUAL )
-			    e.isAuto = false;
-		} catch ( ... ) {
-			e.isAuto = false;
-		}
+			e.isAuto = cat.isAutomatic(j);
+			e.hasDepth = cat.hasDepth(j);
+			e.depth = cat.depths()[j];
 
-		try {
-			e.depth = j->first->depth().value();
-			e.hasDepth = true;
-		} catch ( ... ) {
-			e.hasDepth = false;
+			_items.append(e);
 		}
 
-		m.append(e);
+		qStableSort(_items.begin(), _items.end());
 	}
 
-	//! Determine cumulative values of magnitudes values and mo values
-	QVector<double> moCum(map.size());
-	QVector<double> times(map.size());
-	QVector<double> moInc(map.size());
+	render();
+
+	emit idling();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
 
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void EventEnergy::render() {
+
+	//! Curves of the previous list mustn't stay on screen
+	if ( _aggregation.count() == 0 ) {
+		_plot->clearPlottables();
+		_plot->replot();
+		emit plottingError("No event with the selected magnitude(s), nothing plotted");
+		return;
+	}
+
+	const int granularity = _ui->comboBoxGranularity->currentIndex();
+
+	//! Energy released by each event or bucket, and its cumulated value
+	QVector<double> times;
+	QVector<double> moInc;
+	if ( granularity == ::Events ) {
+		times.reserve(_items.size());
+		moInc.reserve(_items.size());
+		for (MagnitudeList::const_iterator it = _items.constBegin();
+		        it != _items.constEnd(); ++it) {
+			times << (double) (*it).time;
+			moInc << (*it).magnitudeEnergy;
+		}
+	}
+	else {
+		const CatalogueAggregation::Series series =
+		    _aggregation.series(::Granularities[granularity]);
+		times = series.keys;
+		moInc = series.energies;
+	}
+
+	QVector<double> moCum(times.size());
 	double lastMo = .0;
-	int i = 0;
-	for (MagMap::const_iterator it = map.constBegin();
-	        it != map.constEnd(); ++it, ++i) {
-		moCum[i] = it.value().second + lastMo;
-		times[i] = it.key();
-		moInc[i] = it.value().second;
-		lastMo += it.value().second;
+	for (int i = 0; i < times.size(); ++i) {
+		lastMo += moInc.at(i);
+		moCum[i] = lastMo;
 	}
 
 	_plot->clearPlottables();
@@ -351,46 +379,35 @@ void EventEnergy::replot() {
 	// Draw the incremental values
 	if ( _ui->checkBoxShowIncrementalValues->isChecked() ) {
 
-		// Pen offset
-		double offset = 2.;
-
-		// Draw empty shapes first
-		for (MagnitudeList::const_iterator it = m.constBegin();
-		        it != m.constEnd(); ++it) {
-
-			QCPGraph* b = _plot->addGraph();
-			b->addData((double) (*it).time, (*it).magnitudeEnergy);
-			b->setName((*it).publicID.c_str());
-			b->setLineStyle(QCPGraph::lsNone);
-			b->setPen(QPen());
-			b->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-			    QCPScatterStyle::ssSquare : QCPScatterStyle::ssCircle,
-			    (*it).magnitudeSize + offset));
-			b->setTooltip(QString("%1\n%2")
-			    .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
-			    .arg((*it).publicID.c_str()));
-
-			_plot->legend->removeItem(_plot->legend->itemCount() - 1);
+		if ( granularity == ::Events ) {
+
+			// Pen offset
+			double offset = 2.;
+
+			//! Every event is drawn from one plottable, outlines first
+			ScatterPlottable* scatter = new ScatterPlottable(_plot->xAxis, _plot->yAxis);
+			_plot->addPlottable(scatter);
+			scatter->removeFromLegend();
+			scatter->setOutline(QPen(), offset);
+			scatter->reserve(_items.size());
+
+			for (MagnitudeList::const_iterator it = _items.constBegin();
+			        it != _items.constEnd(); ++it)
+				scatter->addPoint((double) (*it).time, (*it).magnitudeEnergy,
+				    (*it).magnitudeSize, ((*it).isAuto) ?
+				            QCPScatterStyle::ssFilledSquare : QCPScatterStyle::ssDisc,
+				    Misc::getDepthColoration((*it).depth), (*it).publicID.c_str(),
+				    QString("%1\n%2")
+				        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
+				        .arg((*it).publicID.c_str()));
 		}
-
-		// Fill up shapes with colors
-		for (MagnitudeList::const_iterator it = m.constBegin();
-		        it != m.constEnd(); ++it) {
-
-			QColor c = Misc::getDepthColoration((*it).depth);
-
+		else {
 			QCPGraph* b = _plot->addGraph();
-			b->addData((double) (*it).time, (*it).magnitudeEnergy);
-			b->setName((*it).publicID.c_str());
+			b->setData(times, moInc);
+			b->setPen(QPen(QColor(86, 124, 181)));
+			b->setName(QString("Released energy"));
 			b->setLineStyle(QCPGraph::lsNone);
-			b->setPen(c);
-			b->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-			    QCPScatterStyle::ssFilledSquare : QCPScatterStyle::ssDisc, c, (*it).magnitudeSize));
-			b->setTooltip(QString("%1\n%2")
-			    .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
-			    .arg((*it).publicID.c_str()));
-
-			_plot->legend->removeItem(_plot->legend->itemCount() - 1);
+			b->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssDisc, 6));
 		}
 	}
 
@@ -27,6 +27,7 @@
 #include <ipgp/gui/api.h>
 #include <ipgp/gui/defs.h>
 #include <ipgp/gui/datamodel/plottingwidget.h>
+#include <ipgp/gui/datamodel/catalogueaggregation.h>
 
 
 
@@ -42,6 +43,16 @@ namespace Gui {
 
 DEFINE_IPGP_SMARTPOINTER(SquarreZoomPlot);
 
+/**
+ * @class   EventEnergy
+ * @package IPGP::Gui::DataModel
+ * @brief   Released energy plotter
+ *
+ * Energies are plotted by event, or summed by day, month or year through a
+ * CatalogueAggregation. Events and buckets are only updated when the
+ * catalogue or the selected magnitude types change, the display options
+ * redraw them.
+ */
 class SC_IPGP_GUI_API EventEnergy : public PlottingWidget {
 
 	Q_OBJECT
@@ -64,12 +75,6 @@ class SC_IPGP_GUI_API EventEnergy : public PlottingWidget {
 		// ------------------------------------------------------------------
 		void setMagnitudeTypes(const Core::MagnitudeTypes&);
 
-	private:
-		// ------------------------------------------------------------------
-		//  Private interface
-		// ------------------------------------------------------------------
-		const bool checkMagnitude(const std::string&);
-
 	public Q_SLOTS:
 		// ------------------------------------------------------------------
 		//  Public virtual Qt interface
@@ -86,6 +91,8 @@ class SC_IPGP_GUI_API EventEnergy : public PlottingWidget {
 
 		void plottableClicked(QCPAbstractPlottable*, QMouseEvent*);
 		void showHideLegend();
+		//! Draws the events or the aggregated buckets with the current options
+		void render();
 
 	private:
 		// ------------------------------------------------------------------
@@ -103,8 +110,15 @@ class SC_IPGP_GUI_API EventEnergy : public PlottingWidget {
 				std::string publicID;
 				bool isAuto;
 				bool hasDepth;
+				bool operator<(const EventMagnitude& other) const {
+					return time < other.time;
+				}
 		};
 		typedef QList<EventMagnitude> MagnitudeList;
+
+		//! Events of the aggregation, by origin time
+		MagnitudeList _items;
+		CatalogueAggregation _aggregation;
 };
 
 } // namespace Gui
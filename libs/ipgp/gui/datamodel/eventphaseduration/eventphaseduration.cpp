@@ -28,7 +28,6 @@
 #include <ipgp/core/math/math.h>
 #include <seiscomp3/datamodel/arrival.h>
 #include <seiscomp3/datamodel/databasequery.h>
-#include <seiscomp3/datamodel/magnitude.h>
 #include <QtGui>
 
 
@@ -230,26 +229,17 @@ void EventPhaseDuration::replot() {
 
 	emit working();
 
+	const CatalogueSnapshot& cat = *_catalogue;
+
 	StationList stations;
 	Core::Math::Numbers<double> mags;
+	size_t index = 0;
 	for (OriginList::const_iterator i = _events->begin();
-	        i != _events->end(); ++i) {
+	        i != _events->end(); ++i, ++index) {
 
 		OriginPtr org = i->first;
-		MagnitudePtr mag = Magnitude::Find(i->second->preferredMagnitudeID());
-
-		bool hasMag = true;
-
-		if ( !mag )
-		    hasMag = false;
-
-		double magnitude;
-		if ( hasMag )
-		    try {
-			    magnitude = mag->magnitude().value();
-		    } catch ( ... ) {
-			//				continue;
-		}
+		const bool hasMag = cat.hasMagnitude(index);
+		const double magnitude = cat.magnitudes()[index];
 
 		//! At this point, picks have been fetched and stored in the local
 		//! pick list, which makes them immediately available, but we can use
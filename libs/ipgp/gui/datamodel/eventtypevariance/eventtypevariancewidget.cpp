@@ -322,9 +322,12 @@ void EventTypeVarianceWidget::prepareData(TimedOccurrence& count) {
 
 	_data.clear();
 
-	for (OriginList::iterator j = _events->begin(); j != _events->end(); ++j) {
+	const CatalogueSnapshot& cat = *_catalogue;
+
+	size_t index = 0;
+	for (OriginList::iterator j = _events->begin(); j != _events->end();
+	        ++j, ++index) {
 
-		OriginPtr org = j->first;
 		EventPtr event = j->second;
 
 		QString type;
@@ -346,23 +349,20 @@ void EventTypeVarianceWidget::prepareData(TimedOccurrence& count) {
 				}
 			}
 		}
-		else {
-			try {
-				type = j->second->type().toString();
-			} catch ( ... ) {}
-		}
+		else if ( cat.hasEventType(index) )
+			type = cat.eventTypes()[index].c_str();
 
 		if ( !checkType(type) )
 		    continue;
 
 		Time t;
 		if ( _ui->comboBox_sensibility->currentText().contains("Months") )
-			t.set(stringToInt(org->time().value().toString("%Y")),
-			    stringToInt(org->time().value().toString("%m")), 1, 0, 0, 0, 0);
+			t.set(stringToInt(cat.times()[index].toString("%Y")),
+			    stringToInt(cat.times()[index].toString("%m")), 1, 0, 0, 0, 0);
 		else if ( _ui->comboBox_sensibility->currentText().contains("Days") )
-		    t.set(stringToInt(org->time().value().toString("%Y")),
-		        stringToInt(org->time().value().toString("%m")),
-		        stringToInt(org->time().value().toString("%d")), 0, 0, 0, 0);
+		    t.set(stringToInt(cat.times()[index].toString("%Y")),
+		        stringToInt(cat.times()[index].toString("%m")),
+		        stringToInt(cat.times()[index].toString("%d")), 0, 0, 0, 0);
 
 		if ( count[t] )
 			count[t] += 1.;
@@ -0,0 +1,164 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/datamodel/gutenbergrichter/gutenbergrichterestimation.h>
+#include <math.h>
+
+
+using namespace IPGP::Core::Math;
+
+
+namespace {
+
+
+//! @return the index of the bin holding m, bins if none does
+int binOf(const double& m, const double& start, const double& width,
+          const int& bins) {
+
+	if ( m < start )
+		return 0;
+
+	const int bin = (int) floor((m - start) / width
+	        + FrequencyMagnitudeDistribution::Tolerance);
+
+	return (bin < bins) ? bin : bins;
+}
+
+
+/**
+ * @brief Fits log10 of the non empty bins of [first, last[ and evaluates
+ *        the fit at their centers.
+ */
+LinearRegression fit(const QVector<double>& centers,
+                     const QVector<double>& values, const int& first,
+                     const int& last, QVector<double>& fitted) {
+
+	std::vector<double> xs, ys;
+	for (int i = first; i < last; ++i) {
+		if ( values.at(i) <= .0 ) continue;
+		xs.push_back(centers.at(i));
+		ys.push_back(log10(values.at(i)));
+	}
+
+	LinearRegression regression;
+	try {
+		regression = leastMeanSquareRegression(xs, ys);
+	} catch ( ... ) {}
+
+	fitted.resize(last - first);
+	for (int i = first; i < last; ++i)
+		fitted[i - first] = pow(10., regression.y_intercept
+		        + regression.slope * centers.at(i));
+
+	return regression;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+GutenbergRichterEstimation::Job::Job() :
+		start(.0), width(.1), fitStart(.0), fitEnd(10.),
+		completeness(StartingMagnitude), bootstrapSamples(0) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+GutenbergRichterEstimation::Result::Result() :
+		fitLevel(-1.) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+GutenbergRichterEstimation::Result
+GutenbergRichterEstimation::estimate(const Job& job) {
+
+	Result result;
+	result.distribution = job.distribution;
+	if ( !result.distribution )
+		result.distribution = DistributionCPtr(new Distribution(job.magnitudes));
+
+	const Distribution& fmd = *result.distribution;
+
+	std::vector<double> centers, incremental, cumulative;
+	const int bins = (int) fmd.histogram(job.start, job.width, centers,
+	    incremental, cumulative);
+	if ( bins == 0 )
+		return result;
+
+	result.centers = QVector<double>::fromStdVector(centers);
+	result.incremental = QVector<double>::fromStdVector(incremental);
+	result.cumulative = QVector<double>::fromStdVector(cumulative);
+
+	const int first = binOf(job.fitStart, job.start, job.width, bins);
+	const int last = binOf(job.fitEnd, job.start, job.width, bins);
+	if ( first < last ) {
+		result.fitCenters = result.centers.mid(first, last - first);
+		result.incrementalRegression = fit(result.centers, result.incremental,
+		    first, last, result.incrementalFit);
+		result.cumulativeRegression = fit(result.centers, result.cumulative,
+		    first, last, result.cumulativeFit);
+	}
+
+	double mc = job.fitStart;
+	switch ( job.completeness ) {
+		case MaximumCurvature:
+			fmd.maximumCurvature(job.start, job.width, mc);
+		break;
+		case GoodnessOfFit90:
+			fmd.goodnessOfFit(job.start, job.width, 90., mc, &result.fitLevel);
+		break;
+		case GoodnessOfFit95:
+			fmd.goodnessOfFit(job.start, job.width, 95., mc, &result.fitLevel);
+		break;
+		default:
+		break;
+	}
+
+	result.bValue = fmd.maximumLikelihood(mc, job.width);
+	if ( !result.bValue.valid )
+		return result;
+
+	if ( job.bootstrapSamples > 0 )
+		result.bValue.bootstrapError = fmd.bootstrap(mc, job.width, job.bootstrapSamples);
+
+	for (int i = 0; i < bins; ++i) {
+		const double low = result.centers.at(i) - job.width / 2.;
+		if ( low < mc - Distribution::Tolerance ) continue;
+		result.likelihoodCenters.append(result.centers.at(i));
+		result.likelihoodFit.append(pow(10., result.bValue.a - result.bValue.b * low));
+	}
+
+	return result;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace Gui
+} // namespace IPGP
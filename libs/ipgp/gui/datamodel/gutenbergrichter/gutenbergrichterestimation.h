@@ -0,0 +1,120 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_GUI_DATAMODEL_GUTENBERGRICHTERESTIMATION_H__
+#define __IPGP_GUI_DATAMODEL_GUTENBERGRICHTERESTIMATION_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/core/math/math.h>
+#include <ipgp/core/math/gutenbergrichter.h>
+#include <QVector>
+#include <vector>
+
+
+namespace IPGP {
+namespace Gui {
+
+
+/**
+ * @class   GutenbergRichterEstimation
+ * @package IPGP::Gui::DataModel
+ * @brief   Frequency-magnitude statistics of a Gutenberg-Richter plot
+ *
+ * A Job gathers, on the GUI thread, the magnitudes and the plot settings;
+ * estimate() bins them, fits the least squares lines of the incremental
+ * and cumulative values, estimates the completeness magnitude and the
+ * maximum likelihood b-value with its bootstrap uncertainty. It only works
+ * on the job, so that it can run in a worker thread.
+ * The sorted distribution is handed back with the result: a job holding
+ * one skips the sort, which keeps re-estimations with other settings
+ * cheap.
+ */
+class SC_IPGP_GUI_API GutenbergRichterEstimation {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		typedef Core::Math::FrequencyMagnitudeDistribution Distribution;
+		typedef SmartPointer<const Distribution>::Impl DistributionCPtr;
+
+		//! How the completeness magnitude of the b-value is chosen, in
+		//! the order of the widget's combo box
+		enum Completeness {
+			StartingMagnitude,
+			MaximumCurvature,
+			GoodnessOfFit90,
+			GoodnessOfFit95
+		};
+
+		struct Job {
+				Job();
+				//! Magnitudes to sort, ignored if distribution is set
+				std::vector<double> magnitudes;
+				DistributionCPtr distribution;
+				//! Bins lower bound and width
+				double start;
+				double width;
+				//! Magnitudes range of the least squares fits
+				double fitStart;
+				double fitEnd;
+				Completeness completeness;
+				size_t bootstrapSamples;
+		};
+
+		struct Result {
+				Result();
+				DistributionCPtr distribution;
+				QVector<double> centers;
+				QVector<double> incremental;
+				QVector<double> cumulative;
+
+				//! Least squares fits, log10(N) = y_intercept + slope.M, and
+				//! the values they predict at fitCenters
+				Core::Math::LinearRegression incrementalRegression;
+				Core::Math::LinearRegression cumulativeRegression;
+				QVector<double> fitCenters;
+				QVector<double> incrementalFit;
+				QVector<double> cumulativeFit;
+
+				//! Maximum likelihood estimation, and the cumulative values it
+				//! predicts at the centers of the bins above mc
+				Distribution::BValue bValue;
+				//! Goodness of fit level reached, negative unless estimated
+				//! by goodness of fit
+				double fitLevel;
+				QVector<double> likelihoodCenters;
+				QVector<double> likelihoodFit;
+		};
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! Computes the statistics of a job, thread safe
+		static Result estimate(const Job&);
+};
+
+
+} // namespace Gui
+} // namespace IPGP
+
+#endif
@@ -27,8 +27,8 @@
 #include <ipgp/gui/datamodel/gutenbergrichter/ui_gutenbergrichterwidget.h>
 #include <ipgp/gui/3rd-party/qcustomplot/qcustomplot.h>
 #include <ipgp/core/math/math.h>
-#include <seiscomp3/datamodel/magnitude.h>
 #include <QtGui>
+#include <QtConcurrentRun>
 
 
 
@@ -48,6 +48,10 @@ inline bool numberIsNan(const double& x) {
 }
 
 
+//! Samples drawn to estimate the b-value uncertainty
+const size_t BootstrapSamples = 200;
+
+
 
 }
 
@@ -57,7 +61,8 @@ namespace Gui {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 GutenbergRichterWidget::
 GutenbergRichterWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
-		PlottingWidget(query, parent, f), _ui(new Ui::GutenbergRichterWidget) {
+		PlottingWidget(query, parent, f), _ui(new Ui::GutenbergRichterWidget),
+		_replotPending(false) {
 
 	_ui->setupUi(this);
 
@@ -84,6 +89,13 @@ GutenbergRichterWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 	_ui->doubleSpinBoxBEnd->setSingleStep(.1);
 	_ui->doubleSpinBoxBEnd->setRange(-5., 11.);
 
+	_ui->checkBoxMaximumLikelihood->setChecked(true);
+	_ui->comboBoxCompleteness->addItem("Starting magnitude");
+	_ui->comboBoxCompleteness->addItem("Maximum curvature");
+	_ui->comboBoxCompleteness->addItem("Goodness of fit (90%)");
+	_ui->comboBoxCompleteness->addItem("Goodness of fit (95%)");
+	_ui->labelMaximumLikelihood->clear();
+
 	_ui->listWidgetAvailable->setSelectionMode(QAbstractItemView::MultiSelection);
 	_ui->listWidgetSelected->setSelectionMode(QAbstractItemView::MultiSelection);
 
@@ -138,6 +150,22 @@ GutenbergRichterWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 
 	connect(_ui->toolButtonAddMag, SIGNAL(clicked()), this, SLOT(addMagnitude()));
 	connect(_ui->toolButtonRemoveMag, SIGNAL(clicked()), this, SLOT(removeMagnitude()));
+
+	_estimation = new QFutureWatcher<GutenbergRichterEstimation::Result>(this);
+	connect(_estimation, SIGNAL(finished()), this, SLOT(estimationFinished()));
+
+	connect(_ui->doubleSpinBoxStartMag, SIGNAL(valueChanged(double)),
+	    this, SLOT(estimationSettingsChanged()));
+	connect(_ui->doubleSpinBoxInterval, SIGNAL(valueChanged(double)),
+	    this, SLOT(estimationSettingsChanged()));
+	connect(_ui->doubleSpinBoxBStart, SIGNAL(valueChanged(double)),
+	    this, SLOT(estimationSettingsChanged()));
+	connect(_ui->doubleSpinBoxBEnd, SIGNAL(valueChanged(double)),
+	    this, SLOT(estimationSettingsChanged()));
+	connect(_ui->comboBoxCompleteness, SIGNAL(currentIndexChanged(int)),
+	    this, SLOT(estimationSettingsChanged()));
+	connect(_ui->checkBoxMaximumLikelihood, SIGNAL(toggled(bool)),
+	    this, SLOT(estimationSettingsChanged()));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -146,6 +174,7 @@ GutenbergRichterWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 GutenbergRichterWidget::~GutenbergRichterWidget() {
+	_estimation->waitForFinished();
 	delete _ui, _ui = NULL;
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
@@ -253,135 +282,111 @@ void GutenbergRichterWidget::replot() {
 		return;
 	}
 
+	if ( _estimation->isRunning() ) {
+		_replotPending = true;
+		return;
+	}
+
 	emit working();
 
-	double bStart = _ui->doubleSpinBoxBStart->value();
-	if ( bStart < _ui->doubleSpinBoxStartMag->value() )
-	    _ui->doubleSpinBoxBStart->setValue(_ui->doubleSpinBoxStartMag->value());
-	bStart = _ui->doubleSpinBoxBStart->value();
+	//! Corrected bounds must not trigger estimationSettingsChanged()
+	_ui->doubleSpinBoxBStart->blockSignals(true);
+	_ui->doubleSpinBoxBEnd->blockSignals(true);
 
-	int bStartNum = 0;
+	if ( _ui->doubleSpinBoxBStart->value() < _ui->doubleSpinBoxStartMag->value() )
+	    _ui->doubleSpinBoxBStart->setValue(_ui->doubleSpinBoxStartMag->value());
 
-	double bMax = _ui->doubleSpinBoxBEnd->value();
-	if ( bMax < bStart )
+	if ( _ui->doubleSpinBoxBEnd->value() < _ui->doubleSpinBoxBStart->value() )
 	    _ui->doubleSpinBoxBEnd->setValue(9.9);
-	bMax = _ui->doubleSpinBoxBEnd->value();
 
-	Numbers<double> mags;
-	for (OriginList::const_iterator j = _events->begin();
-	        j != _events->end(); ++j) {
+	_ui->doubleSpinBoxBStart->blockSignals(false);
+	_ui->doubleSpinBoxBEnd->blockSignals(false);
 
-		MagnitudePtr mag = Magnitude::Find(j->second->preferredMagnitudeID());
+	GutenbergRichterEstimation::Job job;
+	job.start = _ui->doubleSpinBoxStartMag->value();
+	job.width = _ui->doubleSpinBoxInterval->value();
+	job.fitStart = _ui->doubleSpinBoxBStart->value();
+	job.fitEnd = _ui->doubleSpinBoxBEnd->value();
+	job.completeness = static_cast<GutenbergRichterEstimation::Completeness>(
+	    _ui->comboBoxCompleteness->currentIndex());
+	if ( _ui->checkBoxMaximumLikelihood->isChecked() )
+	    job.bootstrapSamples = BootstrapSamples;
 
-		if ( !mag ) continue;
-		if ( !checkMagnitude(mag->type()) ) continue;
-
-		try {
-			mags.add(mag->magnitude().value());
-		} catch ( ... ) {}
+	QStringList types;
+	for (int i = 0; i < _ui->listWidgetSelected->count(); ++i)
+		types << _ui->listWidgetSelected->item(i)->text();
+	types.sort();
+
+	if ( _distribution && _distributionCatalogue == _catalogue
+	        && _distributionTypes == types )
+		job.distribution = _distribution;
+	else {
+		_distribution.clear();
+		_distributionCatalogue = _catalogue;
+		_distributionTypes = types;
+
+		const CatalogueSnapshot& cat = *_catalogue;
+		job.magnitudes.reserve(cat.size());
+		for (size_t j = 0; j < cat.size(); ++j) {
+			if ( !cat.hasMagnitude(j) ) continue;
+			if ( !checkMagnitude(cat.magnitudeTypes()[j]) ) continue;
+			job.magnitudes.push_back(cat.magnitudes()[j]);
+		}
 	}
 
-	// Count number of intervals
-	double magLow = _ui->doubleSpinBoxStartMag->value();
-	double magHigh = _ui->doubleSpinBoxStartMag->value() + _ui->doubleSpinBoxInterval->value();
-	int nbInterval = 0;
-	while ( magLow < mags.max() ) {
-		magLow = magHigh;
-		magHigh = magHigh + _ui->doubleSpinBoxInterval->value();
-		++nbInterval;
-	}
+	_estimation->setFuture(QtConcurrent::run(&GutenbergRichterEstimation::estimate, job));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	// Determine interval number for bStart and bMax
-	int count = 0;
-	int bMaxNum = nbInterval;
-	magLow = _ui->doubleSpinBoxStartMag->value();
-	magHigh = _ui->doubleSpinBoxStartMag->value() + _ui->doubleSpinBoxInterval->value();
-	while ( magLow < mags.max() ) {
 
-		if ( bStart >= magLow && bStart < magHigh )
-		    bStartNum = count;
 
-		if ( bMax >= magLow && bMax < magHigh )
-		    bMaxNum = count;
 
-		magLow = magHigh;
-		magHigh = magHigh + _ui->doubleSpinBoxInterval->value();
-		++count;
-	}
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void GutenbergRichterWidget::estimationFinished() {
 
-	Numbers<double> values;
+	const GutenbergRichterEstimation::Result result = _estimation->result();
+	_distribution = result.distribution;
 
-	// Determine incremental values yinc
-	QVector<double> yinc(nbInterval);
-	QVector<double> magVector(nbInterval);
-	magLow = _ui->doubleSpinBoxStartMag->value();
-	magHigh = _ui->doubleSpinBoxStartMag->value() + _ui->doubleSpinBoxInterval->value();
+	plot(result);
 
-	for (int i = 0; i < nbInterval; ++i) {
+	emit idling();
 
-		yinc[i] = .0;
-		magVector[i] = magLow + _ui->doubleSpinBoxInterval->value() / 2.;
+	if ( _replotPending ) {
+		_replotPending = false;
+		replot();
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-		for (size_t j = 0; j < mags.size(); ++j)
-			if ( mags.at(j) >= magLow && mags.at(j) < magHigh )
-			    yinc[i] += 1.;
 
-		values.add(yinc.at(i));
 
-		magLow = magHigh;
-		magHigh += _ui->doubleSpinBoxInterval->value();
-	}
 
-	//! Determine cumulative values
-	QVector<double> ycum(nbInterval);
-	QVector<double> lycum(nbInterval);
-	QVector<double> lyinc(nbInterval);
-	double lastInc = .0;
-	for (int i = nbInterval - 1; i > -1; --i) {
-		ycum[i] = yinc.at(i) + lastInc;
-		lycum[i] = log10(ycum.at(i));
-		lyinc[i] = log10(yinc.at(i));
-		lastInc += yinc.at(i);
-	}
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void GutenbergRichterWidget::estimationSettingsChanged() {
 
-	//! Evaluate incremental values linear regression for selected interval
-	std::vector<double> incX, incY;
-	for (int i = bStartNum; i < bMaxNum; ++i) {
-		incX.push_back(magVector.at(i));
-		incY.push_back(lyinc.at(i));
-	}
-	LinearRegression incRegression;
-	try {
-		incRegression = leastMeanSquareRegression(incX, incY);
-	} catch ( ... ) {}
-
-	//! Evaluate incremental values from a and b
-	QVector<double> yie(bMaxNum - bStartNum);
-	QVector<double> magVector_b(bMaxNum - bStartNum);
-	for (int i = 0; i < (bMaxNum - bStartNum); ++i) {
-		magVector_b[i] = magVector.at(i + bStartNum);
-		yie[i] = pow(10, incRegression.y_intercept - (-1. * incRegression.slope) * magVector_b.at(i));
-	}
+	//! Only re-estimates what has already been plotted, the magnitudes
+	//! being sorted already
+	if ( !_distribution || _ui->listWidgetSelected->count() == 0 )
+	    return;
 
+	replot();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	//! Evaluate cumulative values linear regression for selected interval
-	std::vector<double> cumY;
-	for (int i = bStartNum; i < bMaxNum; ++i)
-		cumY.push_back(lycum.at(i));
-	LinearRegression cumRegression;
-	try {
-		cumRegression = leastMeanSquareRegression(incX, cumY);
-	} catch ( ... ) {}
 
-	//! Evaluate cumulative values from a and b
-	QVector<double> yce(bMaxNum - bStartNum);
-	for (int i = 0; i < (bMaxNum - bStartNum); ++i)
-		yce[i] = pow(10, cumRegression.y_intercept - (-1. * cumRegression.slope) * magVector_b.at(i));
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void GutenbergRichterWidget::
+plot(const GutenbergRichterEstimation::Result& result) {
+
+	double maxValue = .0;
+	for (int i = 0; i < result.incremental.size(); ++i)
+		maxValue = qMax(maxValue, result.incremental.at(i));
+
 	_plot->clearPlottables();
 	_plot->xAxis->setRange(_ui->doubleSpinBoxStartMag->value(), 10);
-	_plot->yAxis->setRange(.5, (100. * values.max()));
+	_plot->yAxis->setRange(.5, (100. * maxValue));
 
 	QPen pen;
 
@@ -391,7 +396,7 @@ void GutenbergRichterWidget::replot() {
 	magHistogram->setPen(pen);
 	magHistogram->setBrush(QColor(255, 76, 76));
 	magHistogram->setWidth(_ui->doubleSpinBoxInterval->value());
-	magHistogram->setData(magVector, yinc);
+	magHistogram->setData(result.centers, result.incremental);
 	_plot->addPlottable(magHistogram);
 
 	// plot incremental values
@@ -401,7 +406,7 @@ void GutenbergRichterWidget::replot() {
 		pen.setColor(Qt::black);
 		_plot->addGraph();
 		_plot->graph()->setPen(pen);
-		_plot->graph()->setData(magVector, yinc);
+		_plot->graph()->setData(result.centers, result.incremental);
 		_plot->graph()->setName("Incremental values");
 		_plot->graph()->setLineStyle(QCPGraph::lsNone);
 		_plot->graph()->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssSquare, 6));
@@ -413,16 +418,17 @@ void GutenbergRichterWidget::replot() {
 		pen.setColor(Qt::black);
 
 		QVector<double> magV, magVCum;
-		for (int i = 0; i < magVector_b.size(); ++i) {
-			(::numberIsNan(magVector_b.at(i))) ? magV.append(1.) : magV.append(magVector_b.at(i));
-			(::numberIsNan(yie.at(i))) ? magVCum.append(1.) : magVCum.append(yie.at(i));
+		for (int i = 0; i < result.fitCenters.size(); ++i) {
+			(::numberIsNan(result.fitCenters.at(i))) ? magV.append(1.) : magV.append(result.fitCenters.at(i));
+			(::numberIsNan(result.incrementalFit.at(i))) ? magVCum.append(1.) : magVCum.append(result.incrementalFit.at(i));
 		}
 
 		_plot->addGraph();
 		_plot->graph()->setPen(pen);
 		_plot->graph()->setData(magV, magVCum);
 		_plot->graph()->setName(QString("a = %1, b = %2")
-		        .arg(incRegression.y_intercept).arg(-1. * incRegression.slope));
+		        .arg(result.incrementalRegression.y_intercept)
+		        .arg(-1. * result.incrementalRegression.slope));
 		_plot->graph()->setLineStyle(QCPGraph::lsLine);
 		_plot->graph()->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssNone, 5));
 	}
@@ -434,7 +440,7 @@ void GutenbergRichterWidget::replot() {
 		pen.setColor(QColor(86, 124, 181));
 		_plot->addGraph();
 		_plot->graph()->setPen(pen);
-		_plot->graph()->setData(magVector, ycum);
+		_plot->graph()->setData(result.centers, result.cumulative);
 		_plot->graph()->setName("Cumulative values");
 		_plot->graph()->setLineStyle(QCPGraph::lsNone);
 		_plot->graph()->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssTriangle, 8));
@@ -446,16 +452,46 @@ void GutenbergRichterWidget::replot() {
 		pen.setColor(QColor(86, 124, 181));
 		_plot->addGraph();
 		_plot->graph()->setPen(pen);
-		_plot->graph()->setData(magVector_b, yce);
+		_plot->graph()->setData(result.fitCenters, result.cumulativeFit);
 		_plot->graph()->setName(QString("a = %1, b = %2")
-		        .arg(cumRegression.y_intercept).arg(-1. * cumRegression.slope));
+		        .arg(result.cumulativeRegression.y_intercept)
+		        .arg(-1. * result.cumulativeRegression.slope));
 		_plot->graph()->setLineStyle(QCPGraph::lsLine);
 		_plot->graph()->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssNone, 5));
 	}
 
-	_plot->replot();
+	const FrequencyMagnitudeDistribution::BValue& bValue = result.bValue;
 
-	emit idling();
+	if ( _ui->checkBoxMaximumLikelihood->isChecked() && bValue.valid ) {
+
+		pen.setWidth(2.);
+		pen.setStyle(Qt::DashLine);
+		pen.setColor(QColor(46, 139, 87));
+		_plot->addGraph();
+		_plot->graph()->setPen(pen);
+		_plot->graph()->setData(result.likelihoodCenters, result.likelihoodFit);
+		_plot->graph()->setName(QString("Maximum likelihood, a = %1, b = %2")
+		        .arg(bValue.a, 0, 'f', 2).arg(bValue.b, 0, 'f', 2));
+		_plot->graph()->setLineStyle(QCPGraph::lsLine);
+		_plot->graph()->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssNone, 5));
+	}
+
+	if ( !bValue.valid )
+		_ui->labelMaximumLikelihood->setText("Not enough earthquakes above "
+			"the completeness magnitude to estimate the b-value");
+	else {
+		QString text = QString("Mc = %1, N = %2\nb = %3 +/- %4")
+		        .arg(bValue.mc, 0, 'f', 2).arg(bValue.count)
+		        .arg(bValue.b, 0, 'f', 3).arg(bValue.error, 0, 'f', 3);
+		if ( bValue.bootstrapError >= .0 )
+			text.append(QString(" (bootstrap +/- %1)").arg(bValue.bootstrapError, 0, 'f', 3));
+		text.append(QString(", a = %1").arg(bValue.a, 0, 'f', 2));
+		if ( result.fitLevel >= .0 )
+			text.append(QString("\nGoodness of fit: %1%").arg(result.fitLevel, 0, 'f', 1));
+		_ui->labelMaximumLikelihood->setText(text);
+	}
+
+	_plot->replot();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -23,6 +23,9 @@
 
 #include <ipgp/gui/api.h>
 #include <ipgp/gui/datamodel/plottingwidget.h>
+#include <ipgp/gui/datamodel/gutenbergrichter/gutenbergrichterestimation.h>
+#include <QFutureWatcher>
+#include <QStringList>
 
 class QCustomPlot;
 
@@ -65,6 +68,7 @@ class SC_IPGP_GUI_API GutenbergRichterWidget : public PlottingWidget {
 		//  Private interface
 		// ------------------------------------------------------------------
 		const bool checkMagnitude(const std::string&);
+		void plot(const GutenbergRichterEstimation::Result&);
 
 	public Q_SLOTS:
 		// ------------------------------------------------------------------
@@ -79,6 +83,8 @@ class SC_IPGP_GUI_API GutenbergRichterWidget : public PlottingWidget {
 		// ------------------------------------------------------------------
 		void addMagnitude();
 		void removeMagnitude();
+		void estimationFinished();
+		void estimationSettingsChanged();
 
 	private:
 		// ------------------------------------------------------------------
@@ -86,6 +92,17 @@ class SC_IPGP_GUI_API GutenbergRichterWidget : public PlottingWidget {
 		// ------------------------------------------------------------------
 		Ui::GutenbergRichterWidget* _ui;
 		QCustomPlot* _plot;
+
+		//! Estimation running in a worker thread, a replot requested
+		//! meanwhile being postponed until it ends
+		QFutureWatcher<GutenbergRichterEstimation::Result>* _estimation;
+		bool _replotPending;
+
+		//! Sorted magnitudes of the last estimation, reused as long as the
+		//! catalogue and the selected magnitude types don't change
+		GutenbergRichterEstimation::DistributionCPtr _distribution;
+		CatalogueSnapshotCPtr _distributionCatalogue;
+		QStringList _distributionTypes;
 };
 
 } // namespace Gui
@@ -21,10 +21,10 @@
 #include <ipgp/gui/datamodel/hypocentersdrift/hypocentersdriftwidget.h>
 #include <ipgp/gui/datamodel/hypocentersdrift/ui_hypocentersdriftwidget.h>
 #include <ipgp/gui/datamodel/squarrezoomplot.h>
+#include <ipgp/gui/datamodel/scatterplottable.h>
 #include <ipgp/gui/client/application.h>
 #include <ipgp/gui/misc/misc.h>
 #include <ipgp/core/math/math.h>
-#include <seiscomp3/datamodel/magnitude.h>
 #include <seiscomp3/math/geo.h>
 #include <QtGui>
 
@@ -156,38 +156,27 @@ void HypocentersDriftWidget::replot() {
 
 	emit working();
 
+	const CatalogueSnapshot& cat = *_catalogue;
+
 	ItemList items;
 	Core::Math::Numbers<double> mags;
-	for (OriginList::const_iterator i = _events->begin();
-	        i != _events->end(); ++i) {
-
-		OriginPtr org = i->first;
-		MagnitudePtr mag = Magnitude::Find(i->second->preferredMagnitudeID());
-
-		bool hasMag = true;
-		if ( !mag )
-		    hasMag = false;
-
-		double magnitude;
-		if ( hasMag )
-		    try {
-			    magnitude = mag->magnitude().value();
-		    } catch ( ... ) {}
+	for (size_t i = 0; i < cat.size(); ++i) {
 
 		EventItem e;
-		e.time = org->time().value();
-		e.publicID = org->publicID();
+		e.time = cat.times()[i];
+		e.publicID = cat.publicIDs()[i];
 		if ( AppInstance->scheme().distanceInKM() ) {
-			e.latitude = org->latitude();
-			e.longitude = org->longitude();
+			e.latitude = cat.latitudes()[i];
+			e.longitude = cat.longitudes()[i];
 		}
 		else {
-			e.latitude = Seiscomp::Math::Geo::km2deg(org->latitude());
-			e.longitude = Seiscomp::Math::Geo::km2deg(org->longitude());
+			e.latitude = Seiscomp::Math::Geo::km2deg(cat.latitudes()[i]);
+			e.longitude = Seiscomp::Math::Geo::km2deg(cat.longitudes()[i]);
 		}
 
-		if ( hasMag ) {
+		if ( cat.hasMagnitude(i) ) {
 
+			const double magnitude = cat.magnitudes()[i];
 			mags.add(magnitude);
 			e.magnitude = magnitude;
 			e.hasMagnitude = true;
@@ -200,27 +189,14 @@ void HypocentersDriftWidget::replot() {
 			e.hasMagnitude = false;
 		}
 
-		try {
-			if ( org->evaluationMode() == AUTOMATIC )
-				e.isAuto = true;
-			else if ( org->evaluationMode() == MANUAL )
-			    e.isAuto = false;
-		} catch ( ... ) {
-			e.isAuto = false;
-		}
-
-		try {
-			e.depth = org->depth().value();
-			e.hasDepth = true;
-		} catch ( ... ) {
-			e.hasDepth = false;
-		}
+		e.isAuto = cat.isAutomatic(i);
+		e.hasDepth = cat.hasDepth(i);
+		e.depth = cat.depths()[i];
 
 		items << e;
 	}
 
 	_plot->clearPlottables();
-	_plot->clearGraphs();
 
 	::ETypes t = ::ETypes(_ui->comboBoxType->currentIndex());
 
@@ -229,46 +205,17 @@ void HypocentersDriftWidget::replot() {
 	// Pen offset
 	double offset = 2.;
 
-	// Draw empty shapes first
-	for (ItemList::const_iterator it = items.constBegin();
-	        it != items.constEnd(); ++it) {
-
-		if ( t == ::eDepth && !(*it).hasDepth ) continue;
-
-		double itmSize = (*it).magnitudeSize + offset;
-		if ( _ui->radioButtonNormalize->isChecked() ) {
-			if ( (*it).hasMagnitude )
-			    itmSize = Core::Math::remap<double>((*it).magnitude, mags.min(), mags.max(),
-			        _ui->doubleSpinBoxMinSize->value(), _ui->doubleSpinBoxMaxSize->value()) + offset;
-		}
-
-		QCPGraph* g = _plot->addGraph();
-
-		if ( t == ::eLatitude )
-			g->addData((double) (*it).time, (*it).latitude);
-		else if ( t == ::eLongitude )
-			g->addData((double) (*it).time, (*it).longitude);
-		else if ( t == ::eDepth )
-		    g->addData((double) (*it).time, (*it).depth);
-
-		g->setName((*it).publicID.c_str());
-		g->setLineStyle(QCPGraph::lsNone);
-		g->setPen(QPen());
-		g->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssCircle, itmSize));
-		g->setTooltip(QString("%1\n%2")
-		        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
-		        .arg((*it).publicID.c_str()));
-
-		_plot->legend->removeItem(_plot->legend->itemCount() - 1);
-	}
+	//! Every object is drawn from one plottable, outlines first
+	ScatterPlottable* scatter = new ScatterPlottable(_plot->xAxis, _plot->yAxis);
+	_plot->addPlottable(scatter);
+	scatter->removeFromLegend();
+	scatter->setOutline(QPen(), offset);
+	scatter->reserve(items.size());
 
-	// Fill up shapes with colors
 	for (ItemList::const_iterator it = items.constBegin();
 	        it != items.constEnd(); ++it) {
 
-		if ( t == ::eDepth && !(*it).hasDepth )
-		    continue;
+		if ( t == ::eDepth && !(*it).hasDepth ) continue;
 
 		double itmSize = (*it).magnitudeSize;
 		if ( _ui->radioButtonNormalize->isChecked() ) {
@@ -277,27 +224,21 @@ void HypocentersDriftWidget::replot() {
 			        _ui->doubleSpinBoxMinSize->value(), _ui->doubleSpinBoxMaxSize->value());
 		}
 
-		QColor c = Misc::getDepthColoration((*it).depth);
-
-		QCPGraph* g = _plot->addGraph();
-
+		double key, value;
+		key = (double) (*it).time;
 		if ( t == ::eLatitude )
-			g->addData((double) (*it).time, (*it).latitude);
+			value = (*it).latitude;
 		else if ( t == ::eLongitude )
-			g->addData((double) (*it).time, (*it).longitude);
-		else if ( t == ::eDepth )
-		    g->addData((double) (*it).time, (*it).depth);
-
-		g->setName((*it).publicID.c_str());
-		g->setLineStyle(QCPGraph::lsNone);
-		g->setPen(c);
-		g->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssDisc, c, itmSize));
-		g->setTooltip(QString("%1\n%2")
+			value = (*it).longitude;
+		else
+			value = (*it).depth;
+
+		scatter->addPoint(key, value, itmSize, ((*it).isAuto) ?
+		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssDisc,
+		    Misc::getDepthColoration((*it).depth), (*it).publicID.c_str(),
+		    QString("%1\n%2")
 		        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
 		        .arg((*it).publicID.c_str()));
-
-		_plot->legend->removeItem(_plot->legend->itemCount() - 1);
 	}
 
 	_plot->rescaleAxes();
@@ -343,7 +284,16 @@ void HypocentersDriftWidget::print(const ToolBox::ExportConfig& ec) {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void HypocentersDriftWidget::plottableClicked(QCPAbstractPlottable* plottable,
                                               QMouseEvent* event) {
-	emit elementClicked(plottable->name());
+
+	ScatterPlottable* scatter = qobject_cast<ScatterPlottable*>(plottable);
+	if ( !scatter ) {
+		emit elementClicked(plottable->name());
+		return;
+	}
+
+	const int index = scatter->pointAt(event->pos());
+	if ( index >= 0 )
+		emit elementClicked(scatter->pointName(index));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
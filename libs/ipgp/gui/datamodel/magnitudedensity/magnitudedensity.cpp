@@ -24,7 +24,7 @@
 #include <ipgp/gui/misc/misc.h>
 #include <ipgp/core/math/math.h>
 #include <ipgp/gui/datamodel/squarrezoomplot.h>
-#include <seiscomp3/datamodel/magnitude.h>
+#include <ipgp/gui/datamodel/scatterplottable.h>
 #include <seiscomp3/math/geo.h>
 #include <QtGui>
 
@@ -176,72 +176,42 @@ void MagnitudeDensity::replot() {
 
 	emit working();
 
+	const CatalogueSnapshot& cat = *_catalogue;
+
 	ItemList items;
 	Core::Math::Numbers<double> mags;
-	for (OriginList::const_iterator i = _events->begin();
-	        i != _events->end(); ++i) {
-
-		OriginPtr org = i->first;
-		MagnitudePtr mag = Magnitude::Find(i->second->preferredMagnitudeID());
-
-		bool hasMag = true;
-		if ( !mag ) continue;
+	for (size_t i = 0; i < cat.size(); ++i) {
 
-		double magnitude;
-		if ( hasMag )
-		    try {
-			    magnitude = mag->magnitude().value();
-		    } catch ( ... ) {
-			    continue;
-		    }
+		if ( !cat.hasMagnitude(i) ) continue;
 
 		EventItem e;
-		e.time = org->time().value();
-		e.publicID = org->publicID();
+		e.time = cat.times()[i];
+		e.publicID = cat.publicIDs()[i];
 		if ( AppInstance->scheme().distanceInKM() ) {
-			e.latitude = org->latitude();
-			e.longitude = org->longitude();
+			e.latitude = cat.latitudes()[i];
+			e.longitude = cat.longitudes()[i];
 		}
 		else {
-			e.latitude = Seiscomp::Math::Geo::km2deg(org->latitude());
-			e.longitude = Seiscomp::Math::Geo::km2deg(org->longitude());
+			e.latitude = Seiscomp::Math::Geo::km2deg(cat.latitudes()[i]);
+			e.longitude = Seiscomp::Math::Geo::km2deg(cat.longitudes()[i]);
 		}
 
-		if ( hasMag ) {
+		const double magnitude = cat.magnitudes()[i];
+		mags.add(magnitude);
+		e.magnitude = magnitude;
+		e.hasMagnitude = true;
+		e.magnitudeSize = (4.9 * (magnitude - 1.2)) / 2.;
+		if ( e.magnitudeSize < 2. )
+		    e.magnitudeSize = 2.;
 
-			mags.add(magnitude);
-			e.magnitude = magnitude;
-			e.hasMagnitude = true;
-			e.magnitudeSize = (4.9 * (magnitude - 1.2)) / 2.;
-			if ( e.magnitudeSize < 2. )
-			    e.magnitudeSize = 2.;
-		}
-		else {
-			e.magnitudeSize = 2.;
-			e.hasMagnitude = false;
-		}
-
-		try {
-			if ( org->evaluationMode() == AUTOMATIC )
-				e.isAuto = true;
-			else if ( org->evaluationMode() == MANUAL )
-			    e.isAuto = false;
-		} catch ( ... ) {
-			e.isAuto = false;
-		}
-
-		try {
-			e.depth = org->depth().value();
-			e.hasDepth = true;
-		} catch ( ... ) {
-			e.hasDepth = false;
-		}
+		e.isAuto = cat.isAutomatic(i);
+		e.hasDepth = cat.hasDepth(i);
+		e.depth = cat.depths()[i];
 
 		items << e;
 	}
 
 	_plot->clearPlottables();
-	_plot->clearGraphs();
 
 	::ETypes t = ::ETypes(_ui->comboBoxType->currentIndex());
 
@@ -257,42 +227,13 @@ void MagnitudeDensity::replot() {
 	// Pen offset
 	double offset = 2.;
 
-	// Draw empty shapes first
-	for (ItemList::const_iterator it = items.constBegin();
-	        it != items.constEnd(); ++it) {
-
-		if ( t == ::eDepth && !(*it).hasDepth )
-		    continue;
-
-		double itmSize = (*it).magnitudeSize + offset;
-		if ( _ui->radioButtonNormalize->isChecked() ) {
-			if ( (*it).hasMagnitude )
-			    itmSize = Core::Math::remap<double>((*it).magnitude, mags.min(), mags.max(),
-			        _ui->doubleSpinBoxMinSize->value(), _ui->doubleSpinBoxMaxSize->value()) + offset;
-		}
-
-		QCPGraph* g = _plot->addGraph();
-
-		if ( t == ::eLatitude )
-			g->addData((*it).latitude, (*it).magnitude);
-		else if ( t == ::eLongitude )
-			g->addData((*it).longitude, (*it).magnitude);
-		else if ( t == ::eDepth )
-		    g->addData((*it).magnitude, (*it).depth);
-
-		g->setName((*it).publicID.c_str());
-		g->setLineStyle(QCPGraph::lsNone);
-		g->setPen(QPen());
-		g->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssCircle, itmSize));
-		g->setTooltip(QString("%1\n%2")
-		        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
-		        .arg((*it).publicID.c_str()));
+	//! Every object is drawn from one plottable, outlines first
+	ScatterPlottable* scatter = new ScatterPlottable(_plot->xAxis, _plot->yAxis);
+	_plot->addPlottable(scatter);
+	scatter->removeFromLegend();
+	scatter->setOutline(QPen(), offset);
+	scatter->reserve(items.size());
 
-		_plot->legend->removeItem(_plot->legend->itemCount() - 1);
-	}
-
-	// Fill up shapes with colors
 	for (ItemList::const_iterator it = items.constBegin();
 	        it != items.constEnd(); ++it) {
 
@@ -305,27 +246,26 @@ void MagnitudeDensity::replot() {
 			        _ui->doubleSpinBoxMinSize->value(), _ui->doubleSpinBoxMaxSize->value());
 		}
 
-		QColor c = Misc::getDepthColoration((*it).depth);
-
-		QCPGraph* g = _plot->addGraph();
-
-		if ( t == ::eLatitude )
-			g->addData((*it).latitude, (*it).magnitude);
-		else if ( t == ::eLongitude )
-			g->addData((*it).longitude, (*it).magnitude);
-		else if ( t == ::eDepth )
-		    g->addData((*it).magnitude, (*it).depth);
+		double key, value;
+		if ( t == ::eLatitude ) {
+			key = (*it).latitude;
+			value = (*it).magnitude;
+		}
+		else if ( t == ::eLongitude ) {
+			key = (*it).longitude;
+			value = (*it).magnitude;
+		}
+		else {
+			key = (*it).magnitude;
+			value = (*it).depth;
+		}
 
-		g->setName((*it).publicID.c_str());
-		g->setLineStyle(QCPGraph::lsNone);
-		g->setPen(c);
-		g->setScatterStyle(QCPScatterStyle(((*it).isAuto) ?
-		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssDisc, c, itmSize));
-		g->setTooltip(QString("%1\n%2")
+		scatter->addPoint(key, value, itmSize, ((*it).isAuto) ?
+		        QCPScatterStyle::ssSquare : QCPScatterStyle::ssDisc,
+		    Misc::getDepthColoration((*it).depth), (*it).publicID.c_str(),
+		    QString("%1\n%2")
 		        .arg((*it).time.toString("%Y-%m-%d %H:%M:%S").c_str())
 		        .arg((*it).publicID.c_str()));
-
-		_plot->legend->removeItem(_plot->legend->itemCount() - 1);
 	}
 
 	_plot->rescaleAxes();
@@ -341,7 +281,16 @@ void MagnitudeDensity::replot() {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void MagnitudeDensity::plottableClicked(QCPAbstractPlottable* plottable,
                                         QMouseEvent* event) {
-	emit elementClicked(plottable->name());
+
+	ScatterPlottable* scatter = qobject_cast<ScatterPlottable*>(plottable);
+	if ( !scatter ) {
+		emit elementClicked(plottable->name());
+		return;
+	}
+
+	const int index = scatter->pointAt(event->pos());
+	if ( index >= 0 )
+		emit elementClicked(scatter->pointName(index));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -20,24 +20,56 @@
 
 #include <ipgp/gui/datamodel/magnitudevariance/magnitudevariancewidget.h>
 #include <ipgp/gui/datamodel/magnitudevariance/ui_magnitudevariancewidget.h>
-#include <ipgp/core/string/string.h>
-#include <ipgp/core/math/math.h>
 #include <ipgp/gui/misc/misc.h>
 #include <ipgp/gui/datamodel/squarrezoomplot.h>
-#include <seiscomp3/datamodel/magnitude.h>
-#include <seiscomp3/core/datetime.h>
-#include <seiscomp3/datamodel/types.h>
 #include <QtGui>
 
 
 
 
 using namespace Seiscomp;
-using namespace Seiscomp::Core;
 using namespace Seiscomp::DataModel;
 
 using namespace IPGP::Core;
-using namespace IPGP::Core::String;
+
+
+namespace {
+
+using namespace IPGP::Gui;
+
+//! comboBox_style entries
+enum Style {
+	PiledBars,
+	PiledCurves,
+	Curves
+};
+
+//! comboBox_sensibility entries
+const CatalogueAggregation::Granularity Granularities[] = {
+	CatalogueAggregation::Month,
+	CatalogueAggregation::Day,
+	CatalogueAggregation::Year
+};
+
+//! Ticks labels and dates formats, by granularity
+const char* TickFormats[] = { "yyyy-MM-dd", "yyyy\nMMMM", "yyyy" };
+const char* DateFormats[] = { "yyyy-MMMM-dd", "yyyy-MMMM", "yyyy" };
+
+const char* RangeNames[] = {
+	"0 < Mag < 1", "1 < Mag < 2", "2 < Mag < 3", "3 < Mag < 4",
+	"4 < Mag < 5", "Mag > 5"
+};
+const QColor RangeColors[] = {
+	QColor(134, 134, 134), QColor(99, 173, 99), QColor(171, 219, 99),
+	QColor(255, 76, 76), QColor(251, 166, 156), QColor(173, 124, 89)
+};
+const QColor RangeOutlines[] = {
+	QColor(83, 83, 83), QColor(34, 139, 34), QColor(136, 204, 34),
+	QColor(255, 0, 0), QColor(250, 128, 114), QColor(139, 69, 19)
+};
+
+}
+
 
 namespace IPGP {
 namespace Gui {
@@ -103,6 +135,9 @@ MagnitudeVarianceWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 	connect(_ui->toolButtonAddMag, SIGNAL(clicked()), this, SLOT(addMagnitude()));
 	connect(_ui->toolButtonRemoveMag, SIGNAL(clicked()), this, SLOT(removeMagnitude()));
 	connect(_ui->comboBox_style, SIGNAL(currentIndexChanged(int)), this, SLOT(showHideNormalizeBox(int)));
+	connect(_ui->comboBox_style, SIGNAL(currentIndexChanged(int)), this, SLOT(render()));
+	connect(_ui->comboBox_sensibility, SIGNAL(currentIndexChanged(int)), this, SLOT(render()));
+	connect(_ui->checkBox_normalize, SIGNAL(clicked()), this, SLOT(render()));
 
 	_ui->checkBox_normalize->hide();
 }
@@ -123,9 +158,7 @@ MagnitudeVarianceWidget::~MagnitudeVarianceWidget() {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void MagnitudeVarianceWidget::showHideNormalizeBox(int idx) {
 
-	Q_UNUSED(idx);
-
-	if ( _ui->comboBox_style->currentText() == "Piled curves" )
+	if ( idx == ::PiledCurves )
 		_ui->checkBox_normalize->show();
 	else
 		_ui->checkBox_normalize->hide();
@@ -138,7 +171,7 @@ void MagnitudeVarianceWidget::showHideNormalizeBox(int idx) {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void MagnitudeVarianceWidget::showLegend(bool clicked) {
 	_showLegend = clicked;
-	replot();
+	render();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -231,12 +264,12 @@ void MagnitudeVarianceWidget::replot() {
 	if ( _timer )
 	    stopBlinking();
 
-	if ( _ui->comboBox_style->currentText() == "Piled bars" )
-		plotPiledBarsGraph();
-	else if ( _ui->comboBox_style->currentText() == "Piled curves" )
-		plotPiledCurvesGraph();
-	else if ( _ui->comboBox_style->currentText() == "Curves" )
-	    plotCurvesGraph();
+	QStringList types;
+	for (int i = 0; i < _ui->listWidgetSelected->count(); ++i)
+		types << _ui->listWidgetSelected->item(i)->text();
+
+	_aggregation.synchronize(_catalogue, types);
+	render();
 
 	emit idling();
 }
@@ -246,14 +279,33 @@ void MagnitudeVarianceWidget::replot() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-const bool MagnitudeVarianceWidget::
-checkMagnitude(const std::string& magtype) {
+void MagnitudeVarianceWidget::render() {
 
-	for (int i = 0; i < _ui->listWidgetSelected->count(); ++i)
-		if ( _ui->listWidgetSelected->item(i)->text() == magtype.c_str() )
-		    return true;
+	//! Curves of the previous list mustn't stay on screen
+	if ( _aggregation.count() == 0 ) {
+		_plot->clearPlottables();
+		_plot->replot();
+		emit plottingError("no event with the selected magnitude(s), nothing plotted");
+		return;
+	}
 
-	return false;
+	const CatalogueAggregation::Granularity g =
+	    ::Granularities[_ui->comboBox_sensibility->currentIndex()];
+	const CatalogueAggregation::Series series = _aggregation.series(g);
+
+	switch ( _ui->comboBox_style->currentIndex() ) {
+		case ::PiledBars:
+			plotPiledBarsGraph(series, g);
+		break;
+		case ::PiledCurves:
+			plotPiledCurvesGraph(series, g);
+		break;
+		case ::Curves:
+			plotCurvesGraph(series, g);
+		break;
+		default:
+		break;
+	}
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -261,259 +313,49 @@ checkMagnitude(const std::string& magtype) {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void MagnitudeVarianceWidget::plotPiledBarsGraph() {
-
-	_plot->clearPlottables();
-
-	QMap<Time, float> range0to1;
-	QMap<Time, float> range1to2;
-	QMap<Time, float> range2to3;
-	QMap<Time, float> range3to4;
-	QMap<Time, float> range4to5;
-	QMap<Time, float> rangeAbove5;
-	QMap<Time, float> count;
-
-	for (OriginList::const_iterator j = _events->begin(); j != _events->end();
-	        ++j) {
-
-		OriginPtr org = j->first;
-		MagnitudePtr mag = Magnitude::Find(j->second->preferredMagnitudeID());
-
-		if ( !mag ) continue;
-
-		if ( !checkMagnitude(mag->type()) ) continue;
-
-		float magnitude = -1.;
-		try {
-			magnitude = mag->magnitude().value();
-		}
-		catch ( ... ) {}
-
-		if ( magnitude == -1. || magnitude == .0 ) continue;
-
-		Time t;
-		if ( _ui->comboBox_sensibility->currentText() == "Months" )
-			t.set(stringToInt(org->time().value().toString("%Y")),
-			    stringToInt(org->time().value().toString("%m")), 1, 0, 0, 0, 0);
-		else if ( _ui->comboBox_sensibility->currentText() == "Days" )
-		    t.set(stringToInt(org->time().value().toString("%Y")),
-		        stringToInt(org->time().value().toString("%m")),
-		        stringToInt(org->time().value().toString("%d")), 0, 0, 0, 0);
-
-		if ( count[t] )
-			count[t] += 1.;
-		else
-			count.insert(t, 1.);
-
-		if ( magnitude > .0 && magnitude < 1. ) {
-			if ( range0to1.value(t) )
-				range0to1[t] += 1.;
-			else
-				range0to1.insert(t, 1.);
-		}
-
-		if ( 1. < magnitude && magnitude < 2. ) {
-			if ( range1to2.value(t) )
-				range1to2[t] += 1.;
-			else
-				range1to2.insert(t, 1.);
-		}
-
-		if ( 2. < magnitude && magnitude < 3. ) {
-			if ( range2to3.value(t) )
-				range2to3[t] += 1.;
-			else
-				range2to3.insert(t, 1.);
-		}
-
-		if ( 3. < magnitude && magnitude < 4. ) {
-			if ( range3to4.value(t) )
-				range3to4[t] += 1.;
-			else
-				range3to4.insert(t, 1.);
-		}
-
-		if ( 4. < magnitude && magnitude < 5. ) {
-			if ( range4to5.value(t) )
-				range4to5[t] += 1.;
-			else
-				range4to5.insert(t, 1.);
-		}
-
-		if ( magnitude > 5. ) {
-			if ( rangeAbove5.value(t) )
-				rangeAbove5[t] += 1.;
-			else
-				rangeAbove5.insert(t, 1.);
-		}
-	}
-
-	QPen pen;
-	pen.setStyle(Qt::SolidLine);
-
-	QCPBars* above0 = new QCPBars(_plot->xAxis, _plot->yAxis);
-	QCPBars* above1 = new QCPBars(_plot->xAxis, _plot->yAxis);
-	QCPBars* above2 = new QCPBars(_plot->xAxis, _plot->yAxis);
-	QCPBars* above3 = new QCPBars(_plot->xAxis, _plot->yAxis);
-	QCPBars* above4 = new QCPBars(_plot->xAxis, _plot->yAxis);
-	QCPBars* above5 = new QCPBars(_plot->xAxis, _plot->yAxis);
-
-	_plot->addPlottable(above0);
-	_plot->addPlottable(above1);
-	_plot->addPlottable(above2);
-	_plot->addPlottable(above3);
-	_plot->addPlottable(above4);
-	_plot->addPlottable(above5);
-
-	above0->setName("0 < Mag < 1");
-	above0->setPen(pen);
-	above0->setBrush(QColor(134, 134, 134));
-
-	above1->setName("1 < Mag < 2");
-	above1->setPen(pen);
-	above1->setBrush(QColor(99, 173, 99));
-
-	above2->setName("2 < Mag < 3");
-	above2->setPen(pen);
-	above2->setBrush(QColor(171, 219, 99));
-
-	above3->setName("3 < Mag < 4");
-	above3->setPen(pen);
-	above3->setBrush(QColor(255, 76, 76));
-
-	above4->setName("4 < Mag < 5");
-	above4->setPen(pen);
-	above4->setBrush(QColor(251, 166, 156));
-
-	above5->setName("5 < Mag");
-	above5->setPen(pen);
-	above5->setBrush(QColor(173, 124, 89));
-
-	above1->moveAbove(above0);
-	above2->moveAbove(above1);
-	above3->moveAbove(above2);
-	above4->moveAbove(above3);
-	above5->moveAbove(above4);
-
-	double minX = .0, maxX = .0, maxY = .0;
-	bool firstIt = true;
-	QVector<double> ticks(count.size());
-	QVector<QString> labels(count.size());
-	QString maxYDate;
-
-	QMap<Time, float>::iterator it = count.begin();
-	while ( it != count.end() ) {
-
-		if ( firstIt ) {
-			minX = maxX = it.key().seconds();
-			firstIt = false;
-		}
-
-		if ( minX > it.key().seconds() )
-		    minX = it.key().seconds();
-
-		if ( maxX < it.key().seconds() )
-		    maxX = it.key().seconds();
-
-		if ( it == count.begin() )
-		    minX = it.key().seconds(), maxX = it.key().seconds();
-
-		if ( it.key().seconds() < minX )
-		    minX = it.key().seconds();
-
-		if ( it.key().seconds() > maxX )
-		    maxX = it.key().seconds();
-
-		ticks << it.key().seconds();
-
-		if ( _ui->comboBox_sensibility->currentText() == "Months" ) {
-			labels << QDateTime().fromMSecsSinceEpoch(it.key().seconds() * 1000)
-			    .toString("yyyy\nMMMM");
-			if ( it.value() > maxY )
-			    maxY = it.value(), maxYDate = QDateTime().fromMSecsSinceEpoch(
-			        it.key().seconds() * 1000).toString("yyyy-MMMM");
-		}
-		else if ( _ui->comboBox_sensibility->currentText() == "Days" ) {
-			labels << it.key().toString("%Y-%m-%d").c_str();
+void MagnitudeVarianceWidget::
+setTimeTicks(const CatalogueAggregation::Series& series,
+             const CatalogueAggregation::Granularity& g,
+             const QVector<double>& totals) {
 
-			if ( it.value() > maxY )
-			    maxY = it.value(), maxYDate = QDateTime().fromMSecsSinceEpoch(
-			        it.key().seconds() * 1000).toString("yyyy-MMMM-dd");
-		}
+	QVector<double> ticks;
+	QVector<QString> labels;
+	ticks.reserve(series.keys.size());
+	labels.reserve(series.keys.size());
 
-		++it;
-	}
+	double maxValue = .0;
+	double maxKey = .0;
+	for (int i = 0; i < series.keys.size(); ++i) {
 
-	QMap<Time, float>::iterator it0 = range0to1.begin();
-	while ( it0 != range0to1.end() ) {
-		above0->addData(it0.key().seconds(), it0.value());
-		++it0;
-	}
+		if ( totals.at(i) == .0 ) continue;
 
-	QMap<Time, float>::iterator it1 = range1to2.begin();
-	while ( it1 != range1to2.end() ) {
-		above1->addData(it1.key().seconds(), it1.value());
-		++it1;
-	}
+		const QDateTime date = QDateTime::fromMSecsSinceEpoch(
+		    (qint64) series.keys.at(i) * 1000).toUTC();
 
-	QMap<Time, float>::iterator it2 = range2to3.begin();
-	while ( it2 != range2to3.end() ) {
-		above2->addData(it2.key().seconds(), it2.value());
-		++it2;
-	}
+		ticks << series.keys.at(i);
+		labels << date.toString(::TickFormats[g]);
 
-	QMap<Time, float>::iterator it3 = range3to4.begin();
-	while ( it3 != range3to4.end() ) {
-		above3->addData(it3.key().seconds(), it3.value());
-		++it3;
+		if ( totals.at(i) > maxValue )
+		    maxValue = totals.at(i), maxKey = series.keys.at(i);
 	}
 
-	QMap<Time, float>::iterator it4 = range4to5.begin();
-	while ( it4 != range4to5.end() ) {
-		above4->addData(it4.key().seconds(), it4.value());
-		++it4;
-	}
-
-	QMap<Time, float>::iterator it5 = rangeAbove5.begin();
-	while ( it5 != rangeAbove5.end() ) {
-		above5->addData(it5.key().seconds(), it5.value());
-		++it5;
-	}
-
-	_plot->legend->setVisible(_showLegend);
-	_plot->xAxis2->setTicks(false);
-	_plot->xAxis2->setTickLabels(false);
-	_plot->yAxis->setRange(.0, maxY + 2.);
+	_plot->xAxis->setAutoTicks(false);
+	_plot->xAxis->setAutoTickLabels(false);
 	_plot->xAxis->setTickVector(ticks);
 	_plot->xAxis->setTickVectorLabels(labels);
 	_plot->xAxis->setSubTickCount(0);
 
-	_ui->label_mEvent->setText(maxYDate);
-
-	if ( _ui->comboBox_sensibility->currentText() == "Months" ) {
-		above0->setWidth(3600 * 24 * 30);
-		above1->setWidth(3600 * 24 * 30);
-		above2->setWidth(3600 * 24 * 30);
-		above3->setWidth(3600 * 24 * 30);
-		above4->setWidth(3600 * 24 * 30);
-		above5->setWidth(3600 * 24 * 30);
-		_plot->xAxis->setRange(minX - 2628000., maxX + 2628000.);
+	if ( g == CatalogueAggregation::Day ) {
+		_plot->xAxis->setTickLabelRotation(90);
+		_plot->xAxis->setLabelPadding(15);
+	}
+	else {
 		_plot->xAxis->setTickLabelRotation(0);
 		_plot->xAxis->setLabelPadding(0);
 	}
 
-	else if ( _ui->comboBox_sensibility->currentText() == "Days" ) {
-		above0->setWidth(3600 * 24);
-		above1->setWidth(3600 * 24);
-		above2->setWidth(3600 * 24);
-		above3->setWidth(3600 * 24);
-		above4->setWidth(3600 * 24);
-		above5->setWidth(3600 * 24);
-		_plot->xAxis->setRange(minX - 86400., maxX + 86400.);
-		_plot->xAxis->setTickLabelRotation(90);
-		_plot->xAxis->setLabelPadding(15);
-	}
-	_plot->replot();
+	_ui->label_mEvent->setText(QDateTime::fromMSecsSinceEpoch(
+	    (qint64) maxKey * 1000).toUTC().toString(::DateFormats[g]));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -521,326 +363,106 @@ void MagnitudeVarianceWidget::plotPiledBarsGraph() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void MagnitudeVarianceWidget::plotPiledCurvesGraph() {
+void MagnitudeVarianceWidget::
+plotPiledBarsGraph(const CatalogueAggregation::Series& series,
+                   const CatalogueAggregation::Granularity& g) {
 
 	_plot->clearPlottables();
 
-	QMap<Time, float> range0to1;
-	QMap<Time, float> range1to2;
-	QMap<Time, float> range2to3;
-	QMap<Time, float> range3to4;
-	QMap<Time, float> range4to5;
-	QMap<Time, float> rangeAbove5;
-	QMap<Time, float> count;
-
-	for (OriginList::const_iterator j = _events->begin(); j != _events->end();
-	        ++j) {
-
-		OriginPtr org = j->first;
-		MagnitudePtr mag = Magnitude::Find(j->second->preferredMagnitudeID());
-
-		if ( !mag ) continue;
-
-		if ( !checkMagnitude(mag->type()) ) continue;
-
-		float magnitude = -1.;
-		try {
-			magnitude = mag->magnitude().value();
-		} catch ( ... ) {}
-
-		if ( magnitude == -1. || magnitude == .0 )
-		    continue;
-
-		Time t;
-		if ( _ui->comboBox_sensibility->currentText() == "Months" )
-			t.set(stringToInt(org->time().value().toString("%Y")),
-			    stringToInt(org->time().value().toString("%m")), 1, 0, 0, 0, 0);
-		else if ( _ui->comboBox_sensibility->currentText() == "Days" )
-		    t.set(stringToInt(org->time().value().toString("%Y")),
-		        stringToInt(org->time().value().toString("%m")),
-		        stringToInt(org->time().value().toString("%d")), 0, 0, 0, 0);
-
-		if ( count[t] )
-			count[t] += 1.;
-		else
-			count.insert(t, 1.);
-
-		if ( magnitude > .0 && magnitude < 1. ) {
-			if ( range0to1.value(t) )
-				range0to1[t] += 1.;
-			else
-				range0to1.insert(t, 1.);
-		}
-
-		if ( 1. < magnitude && magnitude < 2. ) {
-			if ( range1to2.value(t) )
-				range1to2[t] += 1.;
-			else
-				range1to2.insert(t, 1.);
-		}
-
-		if ( 2. < magnitude && magnitude < 3. ) {
-			if ( range2to3.value(t) )
-				range2to3[t] += 1.;
-			else
-				range2to3.insert(t, 1.);
-		}
-
-		if ( 3. < magnitude && magnitude < 4. ) {
-			if ( range3to4.value(t) )
-				range3to4[t] += 1.;
-			else
-				range3to4.insert(t, 1.);
-		}
-
-		if ( 4. < magnitude && magnitude < 5. ) {
-			if ( range4to5.value(t) )
-				range4to5[t] += 1.;
-			else
-				range4to5.insert(t, 1.);
-		}
-
-		if ( magnitude > 5. ) {
-			if ( rangeAbove5.value(t) )
-				rangeAbove5[t] += 1.;
-			else
-				rangeAbove5.insert(t, 1.);
-		}
-	}
-
 	QPen pen;
 	pen.setStyle(Qt::SolidLine);
 
-	pen.setColor(QColor(83, 83, 83));
-	QCPGraph* aboveZero = _plot->addGraph();
-	aboveZero->setSelectable(true);
-	aboveZero->setName(tr("0 < Mag < 1"));
-	aboveZero->setPen(pen);
-	aboveZero->setBrush(QColor(134, 134, 134));
-	aboveZero->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(34, 139, 34));
-	QCPGraph* aboveOne = _plot->addGraph();
-	aboveOne->setSelectable(false);
-	aboveOne->setName(tr("1 < Mag < 2"));
-	aboveOne->setPen(pen);
-	aboveOne->setBrush(QColor(99, 173, 99));
-	aboveOne->setChannelFillGraph(aboveZero);
-	aboveOne->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(136, 204, 34));
-	QCPGraph* aboveTwo = _plot->addGraph();
-	aboveTwo->setSelectable(false);
-	aboveTwo->setName(tr("2 < Mag < 3"));
-	aboveTwo->setPen(pen);
-	aboveTwo->setBrush(QColor(171, 219, 99));
-	aboveTwo->setChannelFillGraph(aboveOne);
-	aboveTwo->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(255, 0, 0));
-	QCPGraph* aboveThree = _plot->addGraph();
-	aboveThree->setSelectable(false);
-	aboveThree->setName(tr("3 < Mag < 4"));
-	aboveThree->setPen(pen);
-	aboveThree->setBrush(QColor(255, 76, 76));
-	aboveThree->setChannelFillGraph(aboveTwo);
-	aboveThree->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(250, 128, 114));
-	QCPGraph* aboveFour = _plot->addGraph();
-	aboveFour->setSelectable(false);
-	aboveFour->setName(tr("4 < Mag < 5"));
-	aboveFour->setPen(pen);
-	aboveFour->setBrush(QColor(251, 166, 156));
-	aboveFour->setChannelFillGraph(aboveThree);
-	aboveFour->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(139, 69, 19));
-	QCPGraph* aboveFive = _plot->addGraph();
-	aboveFive->setSelectable(false);
-	aboveFive->setName(tr("Mag > 5"));
-	aboveFive->setPen(pen);
-	aboveFive->setBrush(QColor(173, 124, 89));
-	aboveFive->setChannelFillGraph(aboveFour);
-	aboveFive->setLineStyle(QCPGraph::lsLine);
-
-	float maxValue = .0;
-	QMap<Time, float> plotValue;
-	QVector<double> ticks(count.size());
-	QVector<QString> labels(count.size());
-	Time rt;
-
-	QMap<Time, float>::iterator it = count.begin();
-	while ( it != count.end() ) {
-
-		if ( maxValue < it.value() )
-		    maxValue = it.value(), rt = it.key();
-
-		ticks << it.key().seconds();
-
-		if ( _ui->comboBox_sensibility->currentText() == "Months" )
-			labels << QDateTime().fromMSecsSinceEpoch(it.key().seconds() * 1000)
-			    .toString("yyyy\nMMMM");
-		else if ( _ui->comboBox_sensibility->currentText() == "Days" )
-		    labels << it.key().toString("%Y-%m-%d").c_str();
-
-		plotValue.insert(it.key(), .0);
-
-		++it;
-	}
+	const double width = CatalogueAggregation::bucketLength(g);
 
-	QMap<Time, float>::iterator it0 = range0to1.begin();
-	while ( it0 != range0to1.end() ) {
+	QCPBars* below = NULL;
+	for (int r = 0; r < CatalogueAggregation::RangeCount; ++r) {
 
-		if ( _ui->checkBox_normalize->isChecked() ) {
-			float v = (100. * it0.value()) / count[it0.key()];
-			aboveZero->addData(it0.key().seconds(), v);
-			plotValue[it0.key()] = v;
-		}
-		else {
-			plotValue[it0.key()] += it0.value();
-			aboveZero->addData(it0.key().seconds(), plotValue[it0.key()]);
-		}
+		QCPBars* bars = new QCPBars(_plot->xAxis, _plot->yAxis);
+		_plot->addPlottable(bars);
+		bars->setName(::RangeNames[r]);
+		bars->setPen(pen);
+		bars->setBrush(::RangeColors[r]);
+		bars->setWidth(width);
+		bars->setData(series.keys, series.ranges[r]);
 
-		++it0;
+		if ( below )
+		    bars->moveAbove(below);
+		below = bars;
 	}
 
-	// Fill data holes with curve last it value
-	QMap<Time, float>::iterator itf1 = count.begin();
-	while ( itf1 != count.end() ) {
-		if ( !range0to1[itf1.key()] )
-		    aboveZero->addData(itf1.key().seconds(), plotValue[itf1.key()]);
-		++itf1;
-	}
+	QVector<double> totals(series.keys.size(), .0);
+	for (int r = 0; r < CatalogueAggregation::RangeCount; ++r)
+		for (int i = 0; i < totals.size(); ++i)
+			totals[i] += series.ranges[r].at(i);
 
+	double maxY = .0;
+	for (int i = 0; i < totals.size(); ++i)
+		maxY = qMax(maxY, totals.at(i));
 
-	QMap<Time, float>::iterator it1 = range1to2.begin();
-	while ( it1 != range1to2.end() ) {
+	setTimeTicks(series, g, totals);
 
-		if ( _ui->checkBox_normalize->isChecked() ) {
-			float v = (100. * it1.value()) / count[it1.key()];
-			v += plotValue[it1.key()];
-			plotValue[it1.key()] = v;
-			aboveOne->addData(it1.key().seconds(), v);
-		}
-		else {
-			plotValue[it1.key()] += it1.value();
-			aboveOne->addData(it1.key().seconds(), plotValue[it1.key()]);
-		}
-		++it1;
-	}
-
-	// Fill data holes with curve last it value
-	QMap<Time, float>::iterator itf2 = count.begin();
-	while ( itf2 != count.end() ) {
-		if ( !range1to2[itf2.key()] )
-		    aboveOne->addData(itf2.key().seconds(), plotValue[itf2.key()]);
-		++itf2;
-	}
-
-
-	QMap<Time, float>::iterator it2 = range2to3.begin();
-	while ( it2 != range2to3.end() ) {
+	_plot->legend->setVisible(_showLegend);
+	_plot->xAxis2->setTicks(false);
+	_plot->xAxis2->setTickLabels(false);
+	_plot->yAxis->setAutoTicks(true);
+	_plot->yAxis->setAutoTickLabels(true);
+	_plot->yAxis->setRange(.0, maxY + 2.);
+	_plot->xAxis->setRange(series.keys.first() - width, series.keys.last() + width);
 
-		if ( _ui->checkBox_normalize->isChecked() ) {
-			float v = (100. * it2.value()) / count[it2.key()];
-			v += plotValue[it2.key()];
-			plotValue[it2.key()] = v;
-			aboveTwo->addData(it2.key().seconds(), v);
-		}
-		else {
-			plotValue[it2.key()] += it2.value();
-			aboveTwo->addData(it2.key().seconds(), plotValue[it2.key()]);
-		}
-		++it2;
-	}
+	_plot->replot();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	// Fill data holes with curve last it value
-	QMap<Time, float>::iterator itf3 = count.begin();
-	while ( itf3 != count.end() ) {
-		if ( !range2to3[itf3.key()] )
-		    aboveTwo->addData(itf3.key().seconds(), plotValue[itf3.key()]);
-		++itf3;
-	}
 
-	QMap<Time, float>::iterator it3 = range3to4.begin();
-	while ( it3 != range3to4.end() ) {
 
-		if ( _ui->checkBox_normalize->isChecked() ) {
-			float v = (100. * it3.value()) / count[it3.key()];
-			v += plotValue[it3.key()];
-			plotValue[it3.key()] = v;
-			aboveThree->addData(it3.key().seconds(), v);
-		}
-		else {
-			plotValue[it3.key()] += it3.value();
-			aboveThree->addData(it3.key().seconds(), plotValue[it3.key()]);
-		}
-		++it3;
-	}
 
-	// Fill data holes with curve last it value
-	QMap<Time, float>::iterator itf4 = count.begin();
-	while ( itf4 != count.end() ) {
-		if ( !range3to4[itf4.key()] )
-		    aboveThree->addData(itf4.key().seconds(), plotValue[itf4.key()]);
-		++itf4;
-	}
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void MagnitudeVarianceWidget::
+plotPiledCurvesGraph(const CatalogueAggregation::Series& series,
+                     const CatalogueAggregation::Granularity& g) {
 
-	QMap<Time, float>::iterator it4 = range4to5.begin();
-	while ( it4 != range4to5.end() ) {
+	_plot->clearPlottables();
 
-		if ( _ui->checkBox_normalize->isChecked() ) {
-			float v = (100. * it4.value()) / count[it4.key()];
-			v += plotValue[it4.key()];
-			plotValue[it4.key()] = v;
-			aboveFour->addData(it4.key().seconds(), v);
-		}
-		else {
-			plotValue[it4.key()] += it4.value();
-			aboveFour->addData(it4.key().seconds(), plotValue[it4.key()]);
-		}
+	const bool normalize = _ui->checkBox_normalize->isChecked();
 
-		++it4;
-	}
+	QVector<double> totals(series.keys.size(), .0);
+	for (int r = 0; r < CatalogueAggregation::RangeCount; ++r)
+		for (int i = 0; i < totals.size(); ++i)
+			totals[i] += series.ranges[r].at(i);
 
-	// Fill data holes with curve last it value
-	QMap<Time, float>::iterator itf5 = count.begin();
-	while ( itf5 != count.end() ) {
-		if ( !range4to5[itf5.key()] )
-		    aboveFour->addData(itf5.key().seconds(), plotValue[itf5.key()]);
-		++itf5;
-	}
+	QPen pen;
+	pen.setStyle(Qt::SolidLine);
 
-	QMap<Time, float>::iterator it5 = rangeAbove5.begin();
-	while ( it5 != rangeAbove5.end() ) {
+	//! Each curve is stacked over the previous one, buckets without
+	//! events of its range keeping the level reached below
+	QVector<double> piled(series.keys.size(), .0);
+	QCPGraph* below = NULL;
+	for (int r = 0; r < CatalogueAggregation::RangeCount; ++r) {
 
-		if ( _ui->checkBox_normalize->isChecked() ) {
-			float v = (100. * it5.value()) / count[it5.key()];
-			v += plotValue[it5.key()];
-			plotValue[it5.key()] = v;
-			aboveFive->addData(it5.key().seconds(), v);
-		}
-		else {
-			plotValue[it5.key()] += it5.value();
-			aboveFive->addData(it5.key().seconds(), plotValue[it5.key()]);
+		for (int i = 0; i < piled.size(); ++i) {
+			if ( normalize )
+				piled[i] += (totals.at(i) > .0) ?
+				        (100. * series.ranges[r].at(i)) / totals.at(i) : .0;
+			else
+				piled[i] += series.ranges[r].at(i);
 		}
-		++it5;
-	}
 
-	// Fill data holes with curve last it value
-	QMap<Time, float>::iterator itf6 = count.begin();
-	while ( itf6 != count.end() ) {
-		if ( !rangeAbove5[itf6.key()] )
-		    aboveFive->addData(itf6.key().seconds(), plotValue[itf6.key()]);
-		++itf6;
+		pen.setColor(::RangeOutlines[r]);
+		QCPGraph* graph = _plot->addGraph();
+		graph->setSelectable(r == 0);
+		graph->setName(::RangeNames[r]);
+		graph->setPen(pen);
+		graph->setBrush(::RangeColors[r]);
+		graph->setLineStyle(QCPGraph::lsLine);
+		graph->setData(series.keys, piled);
+
+		if ( below )
+		    graph->setChannelFillGraph(below);
+		below = graph;
 	}
 
 	_plot->legend->setVisible(_showLegend);
-	_plot->xAxis->setAutoTicks(false);
-	_plot->xAxis->setAutoTickLabels(false);
-	_plot->xAxis->setDateTimeFormat("MMMM\nyyyy");
-	if ( _ui->checkBox_normalize->isChecked() ) {
+	if ( normalize ) {
 		_plot->yAxis->setAutoTicks(false);
 		_plot->yAxis->setAutoTickLabels(false);
 		_plot->yAxis->setTickVector(QVector<double>() << .0 << 25. << 50. << 75. << 100.);
@@ -853,24 +475,8 @@ void MagnitudeVarianceWidget::plotPiledCurvesGraph() {
 		_plot->yAxis->rescale(true);
 	}
 	_plot->xAxis->rescale(true);
-	_plot->xAxis->setTickVector(ticks);
-	_plot->xAxis->setTickVectorLabels(labels);
-	_plot->xAxis->setSubTickCount(0);
 
-
-	if ( _ui->comboBox_sensibility->currentText() == "Months" ) {
-		_plot->xAxis->setTickLabelRotation(0);
-		_plot->xAxis->setLabelPadding(0);
-		_ui->label_mEvent->setText(QDateTime().fromMSecsSinceEpoch(
-		    rt.seconds() * 1000).toString("yyyy-MMMM"));
-	}
-
-	else if ( _ui->comboBox_sensibility->currentText() == "Days" ) {
-		_plot->xAxis->setTickLabelRotation(90);
-		_plot->xAxis->setLabelPadding(15);
-		_ui->label_mEvent->setText(QDateTime().fromMSecsSinceEpoch(
-		    rt.seconds() * 1000).toString("yyyy-MMMM-dd"));
-	}
+	setTimeTicks(series, g, totals);
 
 	_plot->replot();
 }
@@ -880,242 +486,39 @@ void MagnitudeVarianceWidget::plotPiledCurvesGraph() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void MagnitudeVarianceWidget::plotCurvesGraph() {
+void MagnitudeVarianceWidget::
+plotCurvesGraph(const CatalogueAggregation::Series& series,
+                const CatalogueAggregation::Granularity& g) {
 
 	_plot->clearPlottables();
 
-	QMap<Time, float> range0to1;
-	QMap<Time, float> range1to2;
-	QMap<Time, float> range2to3;
-	QMap<Time, float> range3to4;
-	QMap<Time, float> range4to5;
-	QMap<Time, float> rangeAbove5;
-	QMap<Time, float> count;
-
-	for (OriginList::const_iterator j = _events->begin(); j != _events->end();
-	        ++j) {
-
-		OriginPtr org = j->first;
-		MagnitudePtr mag = Magnitude::Find(j->second->preferredMagnitudeID());
-
-		if ( !mag ) continue;
-
-		if ( !checkMagnitude(mag->type()) ) continue;
-
-		float magnitude = -1.;
-		try {
-			magnitude = mag->magnitude().value();
-		} catch ( ... ) {}
-
-		if ( magnitude == -1. || magnitude == .0 )
-		    continue;
-
-		Time t;
-		if ( _ui->comboBox_sensibility->currentText() == "Months" )
-			t.set(stringToInt(org->time().value().toString("%Y")),
-			    stringToInt(org->time().value().toString("%m")), 1, 0, 0, 0, 0);
-		else if ( _ui->comboBox_sensibility->currentText() == "Days" )
-		    t.set(stringToInt(org->time().value().toString("%Y")),
-		        stringToInt(org->time().value().toString("%m")),
-		        stringToInt(org->time().value().toString("%d")), 0, 0, 0, 0);
-
-		if ( count[t] )
-			count[t] += 1.;
-		else
-			count.insert(t, 1.);
-
-		if ( magnitude > .0 && magnitude < 1. ) {
-			if ( range0to1.value(t) )
-				range0to1[t] += 1.;
-			else
-				range0to1.insert(t, 1.);
-		}
-
-		if ( 1. < magnitude && magnitude < 2. ) {
-			if ( range1to2.value(t) )
-				range1to2[t] += 1.;
-			else
-				range1to2.insert(t, 1.);
-		}
-
-		if ( 2. < magnitude && magnitude < 3. ) {
-			if ( range2to3.value(t) )
-				range2to3[t] += 1.;
-			else
-				range2to3.insert(t, 1.);
-		}
-
-		if ( 3. < magnitude && magnitude < 4. ) {
-			if ( range3to4.value(t) )
-				range3to4[t] += 1.;
-			else
-				range3to4.insert(t, 1.);
-		}
-
-		if ( 4. < magnitude && magnitude < 5. ) {
-			if ( range4to5.value(t) )
-				range4to5[t] += 1.;
-			else
-				range4to5.insert(t, 1.);
-		}
-
-		if ( magnitude > 5. ) {
-			if ( rangeAbove5.value(t) )
-				rangeAbove5[t] += 1.;
-			else
-				rangeAbove5.insert(t, 1.);
-		}
-	}
-
 	QPen pen;
 	pen.setStyle(Qt::SolidLine);
 	pen.setWidthF(2.);
 
-	pen.setColor(QColor(134, 134, 134));
-	QCPGraph* aboveZero = _plot->addGraph();
-	aboveZero->setSelectable(true);
-	aboveZero->setName(tr("0 < Mag < 1"));
-	aboveZero->setPen(pen);
-	aboveZero->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(99, 173, 99));
-	QCPGraph* aboveOne = _plot->addGraph();
-	aboveOne->setSelectable(false);
-	aboveOne->setName(tr("1 < Mag < 2"));
-	aboveOne->setPen(pen);
-	aboveOne->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(171, 219, 99));
-	QCPGraph* aboveTwo = _plot->addGraph();
-	aboveTwo->setSelectable(false);
-	aboveTwo->setName(tr("2 < Mag < 3"));
-	aboveTwo->setPen(pen);
-	aboveTwo->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(255, 76, 76));
-	QCPGraph* aboveThree = _plot->addGraph();
-	aboveThree->setSelectable(false);
-	aboveThree->setName(tr("3 < Mag < 4"));
-	aboveThree->setPen(pen);
-	aboveThree->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(251, 166, 156));
-	QCPGraph* aboveFour = _plot->addGraph();
-	aboveFour->setSelectable(false);
-	aboveFour->setName(tr("4 < Mag < 5"));
-	aboveFour->setPen(pen);
-	aboveFour->setLineStyle(QCPGraph::lsLine);
-
-	pen.setColor(QColor(173, 124, 89));
-	QCPGraph* aboveFive = _plot->addGraph();
-	aboveFive->setSelectable(false);
-	aboveFive->setName(tr("Mag > 5"));
-	aboveFive->setPen(pen);
-	aboveFive->setLineStyle(QCPGraph::lsLine);
-
-
-	Time rt;
-
-	QMap<Time, float>::iterator it0 = range0to1.begin();
-	while ( it0 != range0to1.end() ) {
-		aboveZero->addData(it0.key().seconds(), it0.value());
-		++it0;
-	}
-
-	QMap<Time, float>::iterator it1 = range1to2.begin();
-	while ( it1 != range1to2.end() ) {
-		aboveOne->addData(it1.key().seconds(), it1.value());
-		++it1;
+	for (int r = 0; r < CatalogueAggregation::RangeCount; ++r) {
+		pen.setColor(::RangeColors[r]);
+		QCPGraph* graph = _plot->addGraph();
+		graph->setSelectable(r == 0);
+		graph->setName(::RangeNames[r]);
+		graph->setPen(pen);
+		graph->setLineStyle(QCPGraph::lsLine);
+		graph->setData(series.keys, series.ranges[r]);
 	}
 
-	QMap<Time, float>::iterator it2 = range2to3.begin();
-	while ( it2 != range2to3.end() ) {
-		aboveTwo->addData(it2.key().seconds(), it2.value());
-		++it2;
-	}
-
-	QMap<Time, float>::iterator it3 = range3to4.begin();
-	while ( it3 != range3to4.end() ) {
-		aboveThree->addData(it3.key().seconds(), it3.value());
-		++it3;
-	}
-
-	QMap<Time, float>::iterator it4 = range4to5.begin();
-	while ( it4 != range4to5.end() ) {
-		aboveFour->addData(it4.key().seconds(), it4.value());
-		++it4;
-	}
-
-	QMap<Time, float>::iterator it5 = rangeAbove5.begin();
-	while ( it5 != rangeAbove5.end() ) {
-		aboveFive->addData(it5.key().seconds(), it5.value());
-		++it5;
-	}
-
-	QVector<double> ticks(count.size());
-	QVector<QString> labels(count.size());
-	float maxValue = .0;
-
-	QMap<Time, float>::iterator it6 = count.begin();
-	while ( it6 != count.end() ) {
-
-		ticks << it6.key().seconds();
-
-		if ( maxValue < it6.value() )
-		    maxValue = it6.value(), rt = it6.key();
-
-		if ( _ui->comboBox_sensibility->currentText() == "Months" )
-			labels << QDateTime().fromMSecsSinceEpoch(it6.key().seconds() * 1000)
-			    .toString("yyyy\nMMMM");
-		else if ( _ui->comboBox_sensibility->currentText() == "Days" )
-		    labels << it6.key().toString("%Y-%m-%d").c_str();
-
-		if ( !range0to1[it6.key()] )
-		    aboveZero->addData(it6.key().seconds(), .0);
-
-		if ( !range1to2[it6.key()] )
-		    aboveOne->addData(it6.key().seconds(), .0);
-
-		if ( !range2to3[it6.key()] )
-		    aboveTwo->addData(it6.key().seconds(), .0);
-
-		if ( !range3to4[it6.key()] )
-		    aboveThree->addData(it6.key().seconds(), .0);
-
-		if ( !range4to5[it6.key()] )
-		    aboveFour->addData(it6.key().seconds(), .0);
-
-		if ( !rangeAbove5[it6.key()] )
-		    aboveFive->addData(it6.key().seconds(), .0);
-
-		++it6;
-	}
+	QVector<double> totals(series.keys.size(), .0);
+	for (int r = 0; r < CatalogueAggregation::RangeCount; ++r)
+		for (int i = 0; i < totals.size(); ++i)
+			totals[i] += series.ranges[r].at(i);
 
 	_plot->legend->setVisible(_showLegend);
 	_plot->legend->setSelectableParts(QCPLegend::spItems);
-	_plot->xAxis->setAutoTicks(false);
-	_plot->xAxis->setAutoTickLabels(false);
-	_plot->xAxis->setDateTimeFormat("MMMM\nyyyy");
+	_plot->yAxis->setAutoTicks(true);
+	_plot->yAxis->setAutoTickLabels(true);
 	_plot->xAxis->rescale(true);
 	_plot->yAxis->rescale(true);
-	_plot->xAxis->setTickVector(ticks);
-	_plot->xAxis->setTickVectorLabels(labels);
-	_plot->xAxis->setSubTickCount(0);
-
 
-	if ( _ui->comboBox_sensibility->currentText() == "Months" ) {
-		_plot->xAxis->setTickLabelRotation(0);
-		_plot->xAxis->setLabelPadding(0);
-		_ui->label_mEvent->setText(QDateTime().fromMSecsSinceEpoch(
-		    rt.seconds() * 1000).toString("yyyy-MMMM"));
-	}
-
-	else if ( _ui->comboBox_sensibility->currentText() == "Days" ) {
-		_plot->xAxis->setTickLabelRotation(90);
-		_plot->xAxis->setLabelPadding(15);
-		_ui->label_mEvent->setText(QDateTime().fromMSecsSinceEpoch(
-		    rt.seconds() * 1000).toString("yyyy-MMMM-dd"));
-	}
+	setTimeTicks(series, g, totals);
 
 	_plot->replot();
 }
@@ -23,6 +23,7 @@
 
 #include <ipgp/gui/api.h>
 #include <ipgp/gui/datamodel/plottingwidget.h>
+#include <ipgp/gui/datamodel/catalogueaggregation.h>
 
 
 namespace Ui {
@@ -39,6 +40,11 @@ class SquarreZoomPlot;
  * @class   MagnitudeVarianceWidget
  * @package IPGP::Gui::Widgets
  * @brief   A magnitude variation plotter
+ *
+ * Events are counted by day, month or year and by magnitude range through
+ * a CatalogueAggregation, only updated when the catalogue or the selected
+ * magnitude types change. The style, sensibility and normalization options
+ * redraw the aggregated buckets.
  */
 class SC_IPGP_GUI_API MagnitudeVarianceWidget : public PlottingWidget {
 
@@ -70,11 +76,17 @@ class SC_IPGP_GUI_API MagnitudeVarianceWidget : public PlottingWidget {
 		// ------------------------------------------------------------------
 		//  Private interface
 		// ------------------------------------------------------------------
-		void plotPiledBarsGraph();
-		void plotPiledCurvesGraph();
-		void plotCurvesGraph();
-
-		const bool checkMagnitude(const std::string&);
+		void plotPiledBarsGraph(const CatalogueAggregation::Series&,
+		                        const CatalogueAggregation::Granularity&);
+		void plotPiledCurvesGraph(const CatalogueAggregation::Series&,
+		                          const CatalogueAggregation::Granularity&);
+		void plotCurvesGraph(const CatalogueAggregation::Series&,
+		                     const CatalogueAggregation::Granularity&);
+
+		//! Sets the time ticks of the buckets and the date of the largest
+		void setTimeTicks(const CatalogueAggregation::Series&,
+		                  const CatalogueAggregation::Granularity&,
+		                  const QVector<double>& totals);
 
 	public Q_SLOTS:
 		// ------------------------------------------------------------------
@@ -89,6 +101,8 @@ class SC_IPGP_GUI_API MagnitudeVarianceWidget : public PlottingWidget {
 		// ------------------------------------------------------------------
 		void showLegend(bool);
 		void showHideNormalizeBox(int);
+		//! Draws the aggregated buckets with the current options
+		void render();
 
 		void addMagnitude();
 		void removeMagnitude();
@@ -100,6 +114,7 @@ class SC_IPGP_GUI_API MagnitudeVarianceWidget : public PlottingWidget {
 		Ui::MagnitudeVarianceWidget* _ui;
 		SquarreZoomPlot* _plot;
 		bool _showLegend;
+		CatalogueAggregation _aggregation;
 };
 
 } // namespace Gui
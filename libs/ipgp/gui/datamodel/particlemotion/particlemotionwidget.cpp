@@ -23,6 +23,8 @@
 #include <ipgp/gui/datamodel/particlemotion/particlemotionwidget.h>
 #include <ipgp/gui/datamodel/particlemotion/ui_particlemotionwidget.h>
 #include <ipgp/gui/datamodel/particlemotion/ui_particlemotionsettings.h>
+#include <ipgp/gui/datamodel/particlemotion/threecomponentdata.h>
+#include <ipgp/gui/datamodel/particlemotion/stationpreparation.h>
 #include <ipgp/gui/datamodel/originrecordviewer/originrecordviewer.h>
 #include <ipgp/gui/datamodel/frequencyviewer.h>
 #include <ipgp/gui/datamodel/colormapviewer.h>
@@ -50,6 +52,7 @@
 
 #include <QtGui>
 #include <QtConcurrentRun>
+#include <QtConcurrentMap>
 
 #include <fstream>
 #include <iomanip>
@@ -75,6 +78,14 @@ namespace Gui {
 
 const QString appName = "ParticleMotion";
 
+//! Sliding polarization windows of the selected region, in seconds
+const double polarizationWindow = 1.;
+const double polarizationStep = .25;
+
+//! Region analyzed after the P pick to estimate back-azimuths, in seconds,
+//! shortened when the S pick comes earlier
+const double backAzimuthWindow = 2.;
+
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
@@ -228,6 +239,12 @@ ParticleMotionWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 
 	_ui->setupUi(this);
 
+	_preparation = new QFutureWatcher<StationPreparation::Result>(this);
+	connect(_preparation, SIGNAL(finished()), this, SLOT(stationDataPrepared()));
+
+	_bulkPolarization = new QFutureWatcher<StationPreparation::Result>(this);
+	connect(_bulkPolarization, SIGNAL(finished()), this, SLOT(backAzimuthsEstimated()));
+
 	KeyboardFilter* filter = new KeyboardFilter(this, this);
 	this->installEventFilter(filter);
 
@@ -310,6 +327,44 @@ ParticleMotionWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 	lfreqew->addWidget(_freqEW);
 	lfreqew->setMargin(0);
 
+	//! Setup the polarization viewer: ratios on the left axis, angles on
+	//! the right one
+	_polarizationPlot = new QCustomPlot(this);
+	_polarizationPlot->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+	_polarizationPlot->setBackground(Qt::transparent);
+	_polarizationPlot->axisRect()->setBackground(Qt::white);
+	_polarizationPlot->axisRect()->setRangeDrag(Qt::Horizontal);
+	_polarizationPlot->axisRect()->setRangeZoom(Qt::Horizontal);
+	_polarizationPlot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+	_polarizationPlot->xAxis->setLabel("Time from region start [s]");
+	_polarizationPlot->yAxis->setLabel("Rectilinearity, planarity");
+	_polarizationPlot->yAxis->setRange(.0, 1.);
+	_polarizationPlot->yAxis2->setVisible(true);
+	_polarizationPlot->yAxis2->setLabel("Back-azimuth, incidence [deg]");
+	_polarizationPlot->yAxis2->setRange(.0, 360.);
+	_polarizationPlot->legend->setVisible(true);
+
+	const QString polarizationNames[] = { "Rectilinearity", "Planarity", "Back-azimuth", "Incidence" };
+	const QColor polarizationColors[] = { Qt::darkBlue, Qt::darkGreen, Qt::darkRed, Qt::darkYellow };
+	for (int i = 0; i < 4; ++i) {
+		QCPGraph* g = _polarizationPlot->addGraph(_polarizationPlot->xAxis,
+		    (i < 2) ? _polarizationPlot->yAxis : _polarizationPlot->yAxis2);
+		g->setName(polarizationNames[i]);
+		g->setPen(QPen(polarizationColors[i]));
+		//! Angles wrap around, they are drawn as dots
+		if ( i >= 2 ) {
+			g->setLineStyle(QCPGraph::lsNone);
+			g->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssDisc, 4));
+		}
+	}
+
+	QWidget* polarizationTab = new QWidget(_ui->tabWidget);
+	QBoxLayout* lpolarization = new QVBoxLayout(polarizationTab);
+	polarizationTab->setLayout(lpolarization);
+	lpolarization->addWidget(_polarizationPlot);
+	lpolarization->setMargin(0);
+	_ui->tabWidget->addTab(polarizationTab, "Polarization");
+
 	//! Setup the spectrogram viewer
 //	_zSpectro = new ColorMapViewerPlot(Spectrogram, this);
 
@@ -320,6 +375,19 @@ ParticleMotionWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 	_ui->tabWidgetStationData->removeTab(2);
 //	_ui->spectrumsTab->setVisible(false);
 
+	//! Setup the back-azimuths table
+	_polarizationTable = new QTableWidget(_ui->tabWidgetStationData);
+	_polarizationTable->setColumnCount(5);
+	_polarizationTable->setHorizontalHeaderLabels(
+	    QStringList() << "Station" << "Back-azimuth" << "Incidence"
+	                  << "Rectilinearity" << "Planarity");
+	_polarizationTable->verticalHeader()->setVisible(false);
+	_polarizationTable->horizontalHeader()->setResizeMode(QHeaderView::Stretch);
+	_polarizationTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	_polarizationTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+	_polarizationTable->setAlternatingRowColors(true);
+	_ui->tabWidgetStationData->addTab(_polarizationTable, "Back-azimuths");
+
 	//! Setup the OriginRecordViewer
 	_orv = new OriginRecordViewer(_query, &_cache, OriginRecordViewer::Raw, this);
 	_orv->installEventFilter(filter);
@@ -411,6 +479,10 @@ ParticleMotionWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 	_autoRescaleValueAxes->setCheckable(true);
 	_autoRescaleValueAxes->setChecked(true);
 
+	_playMotion = new QAction("Play motion", this);
+	_playMotion->setToolTip("Play the 3D particle motion back");
+	_playMotion->connect(_playMotion, SIGNAL(triggered()), _pmgl, SLOT(play()));
+
 	_startWavePick = new QAction(this);
 	_startWavePick->setToolTip("Pick wave start");
 	_startWavePick->setIcon(QIcon(QPixmap(":images/filled-flag2.png")));
@@ -436,9 +508,14 @@ ParticleMotionWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 	_applyButton->setToolTip("Click here to apply changes");
 	_applyButton->connect(_applyButton, SIGNAL(triggered(bool)), this, SLOT(prepareData(const bool&)));
 
+	_estimateBackAzimuths = new QAction("Back-azimuths", this);
+	_estimateBackAzimuths->setToolTip("Estimate the P wave back-azimuth of every station from its polarization");
+	_estimateBackAzimuths->connect(_estimateBackAzimuths, SIGNAL(triggered()), this, SLOT(estimateBackAzimuths()));
+
 	_ui->mainToolBar->addAction(_autoReplot);
 	_ui->mainToolBar->addAction(_autoRescaleKeyAxes);
 	_ui->mainToolBar->addAction(_autoRescaleValueAxes);
+	_ui->mainToolBar->addAction(_playMotion);
 
 	QToolBar* t1 = this->addToolBar("Picker");
 	t1->setObjectName("PickerToolBar");
@@ -452,6 +529,7 @@ ParticleMotionWidget(DatabaseQuery* query, QWidget* parent, Qt::WFlags f) :
 	QToolBar* t4 = this->addToolBar("Validation");
 	t4->setObjectName("ValidationToolBar");
 	t4->addAction(_applyButton);
+	t4->addAction(_estimateBackAzimuths);
 
 	_ui->actionSaveData->setIcon(QIcon(":images/document-save.png"));
 
@@ -491,6 +569,9 @@ ParticleMotionWidget::~ParticleMotionWidget() {
 
 	closeStream();
 
+	_bulkPolarization->cancel();
+	_bulkPolarization->waitForFinished();
+
 	if ( _stopWatch ) delete _stopWatch;
 	_stopWatch = NULL;
 
@@ -865,33 +946,15 @@ void ParticleMotionWidget::checkStreamsGaps(const QString& code,
 		        .arg(_activeStreams.at(i).locationCode)
 		        .arg(_activeStreams.at(i).channelCode);
 
-		std::vector<RecordPtr> recV = _cache.getRecords(s.toStdString());
-		TimeWindowBuffer* twb = new TimeWindowBuffer(_tw);
+		const StreamsGapsList gaps = StationPreparation::findGaps(s,
+		    _cache.getRecords(s.toStdString()), _tw);
 
-		for (size_t v = 0; v < recV.size(); ++v) {
-
-			RecordPtr rec = recV.at(v);
-			if ( !rec ) continue;
-
-			twb->feed(Record::ConstCast(rec));
-		}
-
-		if ( twb->gaps().size() > 0 ) {
-			gapCount += twb->gaps().size();
+		if ( gaps.size() > 0 ) {
+			gapCount += gaps.size();
 			log(Client::LM_WARNING, QString("Gap(s) found in %1 records sequence: %2")
-			        .arg(s).arg(twb->gaps().size()));
-
-			for (size_t g = 0; g < twb->gaps().size(); ++g) {
-				StreamGap sg;
-				sg.streamID = s;
-				sg.start = twb->gaps().at(g).startTime();
-				sg.start = twb->gaps().at(g).endTime();
-				_streamsGaps.push_back(sg);
-			}
+			        .arg(s).arg(gaps.size()));
+			_streamsGaps << gaps;
 		}
-
-		delete twb;
-		twb = NULL;
 	}
 
 	for (int i = 0; i < _ui->tableWidget_stations->rowCount(); ++i) {
@@ -1657,14 +1720,18 @@ void ParticleMotionWidget::prepareData(const bool& checkStation) {
 	if ( _state.isSet(Client::AppIdling) )
 	    showWaitingWidget();
 
+	//! Every exit below that doesn't start a preparation hides the waiting
+	//! widget, stationDataPrepared() does otherwise
 	QStringList it = _currentStationPicking.split(".");
 
-	if ( it.size() == 0 ) {
+	if ( it.size() < 2 ) {
 		log(Client::LM_ERROR, "No selected station to prepare data from");
+		hideWaitingWidget();
 		return;
 	}
 
-	QStringList streams;
+	StationPreparation::Job job;
+	job.station = _currentStationPicking;
 	for (int i = 0; i < _activeStreams.size(); ++i) {
 
 		if ( _activeStreams.at(i).networkCode != it.at(0)
@@ -1674,244 +1741,97 @@ void ParticleMotionWidget::prepareData(const bool& checkStation) {
 		if ( _activeStreams.at(i).channelCode.left(2) != _ui->comboBox_component->currentText().left(2) )
 		    continue;
 
-		streams << QString("%1.%2.%3.%4").arg(_activeStreams.at(i).networkCode)
-		        .arg(_activeStreams.at(i).stationCode)
-		        .arg(_activeStreams.at(i).locationCode)
-		        .arg(_activeStreams.at(i).channelCode);
+		//! The component is resolved once per stream
+		StationPreparation::Stream stream;
+		stream.component = ThreeComponentData::component(_activeStreams.at(i).channelCode);
+		if ( stream.component < 0 ) continue;
+
+		stream.networkCode = _activeStreams.at(i).networkCode;
+		stream.stationCode = _activeStreams.at(i).stationCode;
+		stream.locationCode = _activeStreams.at(i).locationCode;
+		stream.channelCode = _activeStreams.at(i).channelCode;
+		stream.records = _cache.getRecords(stream.id().toStdString());
+		job.streams << stream;
 	}
 
-	if ( streams.size() == 0 )
-	    return;
-
+	if ( job.streams.size() == 0 ) {
+		log(Client::LM_WARNING, QString("No %1 stream of %2 to prepare data from")
+		        .arg(_ui->comboBox_component->currentText()).arg(_currentStationPicking));
+		hideWaitingWidget();
+		return;
+	}
 
-	double regionStart = -1., regionEnd = -1.;
 	if ( _pPick && _sPick && _ui->checkBox_useSminusP->isChecked() ) {
-		regionStart = (double) _pPick->time().value();
-		regionEnd = (double) _sPick->time().value();
+		job.regionStart = (double) _pPick->time().value();
+		job.regionEnd = (double) _sPick->time().value();
 	}
 	else if ( _orv->hasPick("Start") && _orv->hasPick("End") ) {
-		regionStart = _orv->pick("Start").time();
-		regionEnd = _orv->pick("End").time();
+		job.regionStart = _orv->pick("Start").time();
+		job.regionEnd = _orv->pick("End").time();
 	}
 
-	ComponentData tmpZ;
-	ComponentData tmpNS;
-	ComponentData tmpEW;
-	QStringList log;
-
-	DoubleArray* fftdataZ = new DoubleArray;
-	DoubleArray* fftdataNS = new DoubleArray;
-	DoubleArray* fftdataEW = new DoubleArray;
-	double fsamp = -1.;
-	bool fsetup = false;
-//	ColorMapViewerPlot::Stream zcstream;
-
-	for (int i = 0; i < streams.size(); ++i) {
-
-		std::vector<RecordPtr> recV = _cache.getRecords(streams.at(i).toStdString());
-		for (size_t v = 0; v < recV.size(); ++v) {
-
-			RecordPtr rec = recV.at(v);
-
-			if ( !rec ) continue;
-
-			double stime = rec->startTime();
-			double delta = 1. / rec->samplingFrequency();
-
-			ArrayPtr tmp_ar;
-			const DoubleArray* data = DoubleArray::ConstCast(rec->data());
-			if ( !data ) {
-				tmp_ar = rec->data()->copy(Array::DOUBLE);
-				data = DoubleArray::ConstCast(tmp_ar);
-				if ( !data ) continue;
-			}
-
-			DoubleArray* data2 = DoubleArray::Cast(data->clone());
-			if ( _filter ) {
-				_filter->setStartTime(rec->startTime());
-				_filter->setSamplingFrequency(rec->samplingFrequency());
-				_filter->setStreamID(_activeStreams.at(i).networkCode.toStdString(),
-				    _activeStreams.at(i).stationCode.toStdString(),
-				    _activeStreams.at(i).locationCode.toStdString(),
-				    _activeStreams.at(i).channelCode.toStdString());
-				try {
-					_filter->apply(*data2);
-				}
-				catch ( std::exception& e ) {
-					log << e.what();
-				}
-			}
-
-			for (int j = 0; j < data2->size(); ++j) {
+	if ( _filter )
+	    job.filter = StationPreparation::FilterPtr(_filter->clone());
 
-				if ( streams.at(i).right(1) == "Z" or streams.at(i).right(1) == "A" )
-				    tmpZ.insert(stime, data2->get(j));
+	job.polarizationWindow = polarizationWindow;
+	job.polarizationStep = polarizationStep;
 
-				if ( streams.at(i).right(1) == "N" or streams.at(i).right(1) == "B"
-				        or streams.at(i).right(1) == "1" )
-				    tmpNS.insert(stime, data2->get(j));
-
-				if ( streams.at(i).right(1) == "E" or streams.at(i).right(1) == "C"
-				        or streams.at(i).right(1) == "2" )
-				    tmpEW.insert(stime, data2->get(j));
-
-				stime += TimeSpan(delta);
-			}
-
-			//! Compute frequency spectrum
-			if ( (double) rec->startTime() > regionStart && ((double) rec->startTime() + delta) < regionEnd ) {
-
-				if ( !fsetup ) {
-					fsamp = rec->samplingFrequency();
-					fsetup = true;
-				}
-
-//				ColorMapViewerPlot::RecordData r;
-//				r.fsamp = rec->samplingFrequency();
-//				r.stack = *data2;
-//				r.time = rec->startTime();
-
-				if ( streams.at(i).right(1) == "Z" or streams.at(i).right(1) == "A" ) {
-
-					_zChannel.fsamp = rec->samplingFrequency();
-					_zChannel.streamID = streams.at(i);
-					fftdataZ->append(data2);
-
-//					zcstream.data.append(r);
-				}
-				else if ( streams.at(i).right(1) == "N" or streams.at(i).right(1) == "B"
-				        or streams.at(i).right(1) == "1" ) {
-					_nsChannel.fsamp = rec->samplingFrequency();
-					_nsChannel.streamID = streams.at(i);
-					fftdataNS->append(data2);
-				}
-				else if ( streams.at(i).right(1) == "E" or streams.at(i).right(1) == "C"
-				        or streams.at(i).right(1) == "2" ) {
-					_ewChannel.fsamp = rec->samplingFrequency();
-					_ewChannel.streamID = streams.at(i);
-					fftdataEW->append(data2);
-				}
-			}
-		}
-	}
-
-
-	FrequencyViewerPlot::Stream streamZ;
-	streamZ.fsamp = fsamp;
-	streamZ.data = *fftdataZ;
-	streamZ.id = _zChannel.streamID;
-
-	FrequencyViewerPlot::Stream streamNS;
-	streamNS.fsamp = fsamp;
-	streamNS.data = *fftdataNS;
-	streamNS.id = _nsChannel.streamID;
-
-	FrequencyViewerPlot::Stream streamEW;
-	streamEW.fsamp = fsamp;
-	streamEW.data = *fftdataEW;
-	streamEW.id = _ewChannel.streamID;
-
-	_freqZ->reset();
-	_freqZ->addStream(streamZ);
-	_freqZ->redraw();
-
-	_freqNS->reset();
-	_freqNS->addStream(streamNS);
-	_freqNS->redraw();
-
-	_freqEW->reset();
-	_freqEW->addStream(streamEW);
-	_freqEW->redraw();
-
-
-//	zcstream.id = _zChannel.streamID;
-//	_zSpectro->reset();
-//	_zSpectro->addStream(zcstream);
-//	_zSpectro->redraw();
+	//! Records are filtered and aligned by a worker thread, the result is
+	//! handed over to stationDataPrepared(). Restarting the watcher drops
+	//! the result of a preparation still running.
+	_preparation->setFuture(QtConcurrent::run(&StationPreparation::prepare, job));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
 
-	delete fftdataZ;
-	fftdataZ = NULL;
 
-	delete fftdataNS;
-	fftdataNS = NULL;
 
-	delete fftdataEW;
-	fftdataEW = NULL;
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionWidget::stationDataPrepared() {
 
+	const StationPreparation::Result result = _preparation->result();
 
-	_zData.clear();
-	_ewData.clear();
-	_nsData.clear();
+	//! The station may have been changed in the meantime
+	if ( result.station != _currentStationPicking )
+	    return;
 
-	// Cutting thru selection start and end time, making sure all collected
-	// samples are perfectly in range by taking the Z component as reference.
-	double start = tmpZ.begin().key();
-	if ( start < tmpNS.begin().key() )
-	    start = tmpNS.begin().key();
-	if ( start < tmpEW.begin().key() )
-	    start = tmpEW.begin().key();
+	if ( !result.log.isEmpty() )
+	    log(Client::LM_WARNING, result.log.join("\n"));
 
-	double endZ = .0;
-	ComponentData::iterator it0 = tmpZ.begin();
-	while ( it0 != tmpZ.end() ) {
-		endZ = it0.key();
-		++it0;
-	}
+	FrequencyViewerPlot* plots[ThreeComponentData::ComponentCount] = { _freqZ, _freqNS, _freqEW };
+	FFTProperty* properties[ThreeComponentData::ComponentCount] = { &_zChannel, &_nsChannel, &_ewChannel };
 
-	double endNS = .0;
-	ComponentData::iterator it1 = tmpNS.begin();
-	while ( it1 != tmpNS.end() ) {
-		if ( endNS < it1.key() )
-		    endNS = it1.key();
-		++it1;
+	//! The first record lying in the region sets the spectra sampling rate
+	double fsamp = -1.;
+	for (int c = 0; c < ThreeComponentData::ComponentCount; ++c) {
+		const StationPreparation::Channel& channel = result.channels[c];
+		if ( !channel.samples.empty() && fsamp < .0 )
+		    fsamp = channel.samplingFrequency;
 	}
 
-	double endEW = .0;
-	ComponentData::iterator it2 = tmpEW.begin();
-	while ( it2 != tmpEW.end() ) {
-		if ( endEW < it2.key() )
-		    endEW = it2.key();
-		++it2;
-	}
+	for (int c = 0; c < ThreeComponentData::ComponentCount; ++c) {
 
-	double end = endZ;
-	if ( end > endNS )
-	    end = endNS;
-	if ( end > endEW )
-	    end = endEW;
-
-	ComponentData::iterator itZ = tmpZ.begin();
-	while ( itZ != tmpZ.end() ) {
-		if ( itZ.key() >= start && itZ.key() <= end ) {
-			if ( (regionStart != -1.) && (regionEnd != -1.)
-			        && (itZ.key() > regionStart) && (itZ.key() < regionEnd) )
-			    _zData.insert(itZ.key(), itZ.value());
+		const StationPreparation::Channel& channel = result.channels[c];
+		if ( !channel.samples.empty() ) {
+			properties[c]->fsamp = channel.samplingFrequency;
+			properties[c]->streamID = channel.streamID;
 		}
-		++itZ;
-	}
 
-	ComponentData::iterator itNS = tmpNS.begin();
-	while ( itNS != tmpNS.end() ) {
-		if ( itNS.key() >= start && itNS.key() <= end ) {
-			if ( (regionStart != -1.) && (regionEnd != -1.)
-			        && (itNS.key() > regionStart) && (itNS.key() < regionEnd) )
-			    _nsData.insert(itNS.key(), itNS.value());
-		}
-		++itNS;
-	}
+		FrequencyViewerPlot::Stream stream;
+		stream.fsamp = fsamp;
+		if ( !channel.samples.empty() )
+		    stream.data = DoubleArray(channel.samples.size(), &channel.samples[0]);
+		stream.id = properties[c]->streamID;
 
-	ComponentData::iterator itEW = tmpEW.begin();
-	while ( itEW != tmpEW.end() ) {
-		if ( itEW.key() >= start && itEW.key() <= end ) {
-			if ( (regionStart != -1.) && (regionEnd != -1.)
-			        && (itEW.key() > regionStart) && (itEW.key() < regionEnd) )
-			    _ewData.insert(itEW.key(), itEW.value());
-		}
-		++itEW;
+		plots[c]->reset();
+		plots[c]->addStream(stream);
+		plots[c]->redraw();
 	}
 
+	_data = result.data;
+
 	plotData();
+	plotPolarization(result);
 
 	hideWaitingWidget();
 }
@@ -1923,40 +1843,23 @@ void ParticleMotionWidget::prepareData(const bool& checkStation) {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void ParticleMotionWidget::plotData() {
 
-	QVector<RecordItem> items;
+	const QVector<qreal>& zVector = _data.values(ThreeComponentData::Vertical);
+	const QVector<qreal>& nsVector = _data.values(ThreeComponentData::NorthSouth);
+	const QVector<qreal>& ewVector = _data.values(ThreeComponentData::EastWest);
+	const int gaps = _data.gapCount();
 
-	QVector<qreal> zVector;
-	ComponentData::iterator itZ = _zData.begin();
-	while ( itZ != _zData.end() ) {
-		zVector.append(itZ.value());
-		items.append(RecordItem(itZ.key(), itZ.value(), .0, .0));
-		++itZ;
-	}
-
-	QVector<qreal> nsVector;
-	ComponentData::iterator itNS = _nsData.begin();
-	while ( itNS != _nsData.end() ) {
-		nsVector.append(itNS.value());
-		++itNS;
-	}
-
-	QVector<qreal> ewVector;
-	ComponentData::iterator itEW = _ewData.begin();
-	while ( itEW != _ewData.end() ) {
-		ewVector.append(itEW.value());
-		++itEW;
-	}
+	QVector<RecordItem> items;
+	items.reserve(_data.size());
+	for (int i = 0; i < _data.size(); ++i)
+		items.append(RecordItem(_data.time(i), zVector.at(i), nsVector.at(i), ewVector.at(i)));
 
 	for (int i = 0; i < _ui->tableWidget_data->rowCount(); ++i)
 		_ui->tableWidget_data->removeRow(i);
 
-	if ( zVector.size() == nsVector.size() && ewVector.size() == nsVector.size() ) {
-		_ui->tableWidget_data->setRowCount(zVector.size());
+	if ( gaps == 0 ) {
+		_ui->tableWidget_data->setRowCount(items.size());
 
-		for (int i = 0; i < zVector.size(); ++i) {
-
-			items[i].nsValue = nsVector.at(i);
-			items[i].ewValue = ewVector.at(i);
+		for (int i = 0; i < items.size(); ++i) {
 
 			QDateTime t = QDateTime::fromMSecsSinceEpoch(items.at(i).time * 1000);
 			_ui->tableWidget_data->setItem(i, 0, new QTableWidgetItem(t.toString("hh:mm:ss.zzz")));
@@ -2015,7 +1918,7 @@ void ParticleMotionWidget::plotData() {
 	bool p1error = false;
 	bool p2error = false;
 
-	if ( nsVector.size() == zVector.size() ) {
+	if ( gaps == 0 ) {
 
 		for (int i = 0; i < nsVector.size() - 1; ++i) {
 
@@ -2061,10 +1964,10 @@ void ParticleMotionWidget::plotData() {
 		_pznsPlot->replot();
 	}
 	else
-		p1error = true, log.append("Z component data count differs from NS one.\n");
+		p1error = true, log.append(QString("%1 sample(s) lack at least one component.\n").arg(gaps));
 
 	_pewnsPlot->clearItems();
-	if ( nsVector.size() == ewVector.size() ) {
+	if ( gaps == 0 ) {
 
 		for (int i = 0; i < ewVector.size() - 1; ++i) {
 
@@ -2110,16 +2013,15 @@ void ParticleMotionWidget::plotData() {
 		_pewnsPlot->replot();
 	}
 	else
-		p2error = true, log.append("EW component data count differs from NS one.\n");
+		p2error = true;
 
-	if ( zVector.size() == nsVector.size() && nsVector.size() == ewVector.size()
-	        && zVector.size() != 0 )
+	if ( gaps == 0 && !_data.isEmpty() )
 		_pmgl->feed(ewVector, nsVector, zVector, _ui->checkBox_colorsGradient->isChecked());
 	else {
 
 		QString msg = QString("Data range error");
 
-		if ( zVector.size() == 0 or nsVector.size() == 0 or ewVector.size() == 0 )
+		if ( _data.isEmpty() )
 		    msg = QString("No data range defined");
 
 		if ( p1error ) {
@@ -2164,6 +2066,222 @@ void ParticleMotionWidget::plotData() {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionWidget::plotPolarization(const StationPreparation::Result& result) {
+
+	QVector<double> time, rectilinearity, planarity, backAzimuth, incidence;
+	const double fs = result.data.samplingFrequency();
+
+	for (size_t i = 0; i < result.polarizations.size(); ++i) {
+		const Core::Math::Polarization& p = result.polarizations[i];
+		time << (p.first + p.count / 2.) / fs;
+		rectilinearity << p.rectilinearity;
+		planarity << p.planarity;
+		backAzimuth << p.backAzimuth();
+		incidence << p.incidence;
+	}
+
+	_polarizationPlot->graph(0)->setData(time, rectilinearity);
+	_polarizationPlot->graph(1)->setData(time, planarity);
+	_polarizationPlot->graph(2)->setData(time, backAzimuth);
+	_polarizationPlot->graph(3)->setData(time, incidence);
+
+	if ( !time.isEmpty() )
+	    _polarizationPlot->xAxis->setRange(.0, result.data.size() / fs);
+
+	_polarizationPlot->replot();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionWidget::estimateBackAzimuths() {
+
+	if ( !_origin || _cache.isEmpty() ) {
+		statusBar()->showMessage("No records to estimate back-azimuths from",
+		    _settings.messagesDurationMS);
+		return;
+	}
+
+	if ( _bulkPolarization->isRunning() )
+	    return;
+
+	//! Picks which aren't registered are all fetched in one query
+	QHash<QString, PickPtr> picks;
+	bool missing = false;
+	for (size_t i = 0; i < _origin->arrivalCount(); ++i) {
+		PickPtr pick = Pick::Find(_origin->arrival(i)->pickID());
+		if ( pick )
+			picks.insert(pick->publicID().c_str(), pick);
+		else
+			missing = true;
+	}
+
+	if ( missing && _query ) {
+		DatabaseIterator dbit = _query->getPicks(_origin->publicID());
+		for (; *dbit; ++dbit) {
+			PickPtr pick = Pick::Cast(*dbit);
+			if ( pick && !picks.contains(pick->publicID().c_str()) )
+			    picks.insert(pick->publicID().c_str(), pick);
+		}
+	}
+
+	//! Arrivals are listed by time, the last P and S picks of a station
+	//! are the ones of interest
+	QMap<QString, PickPtr> pPicks;
+	QMap<QString, PickPtr> sPicks;
+	for (size_t i = 0; i < _origin->arrivalCount(); ++i) {
+
+		ArrivalPtr ar = _origin->arrival(i);
+		PickPtr pick = picks.value(ar->pickID().c_str());
+
+		if ( !pick )
+		    continue;
+
+		const QString code = QString("%1.%2")
+		        .arg(pick->waveformID().networkCode().c_str())
+		        .arg(pick->waveformID().stationCode().c_str());
+
+		if ( ar->phase().code() == "P" )
+		    pPicks.insert(code, pick);
+
+		if ( ar->phase().code() == "S" )
+		    sPicks.insert(code, pick);
+	}
+
+	QList<StationPreparation::Job> jobs;
+	for (StationStreamStatusList::const_iterator it = _fetchedStationsStatus.constBegin();
+	        it != _fetchedStationsStatus.constEnd(); ++it) {
+
+		if ( it.value() != sssOK && it.value() != sssMissingChunks )
+		    continue;
+
+		if ( !pPicks.contains(it.key()) )
+		    continue;
+
+		const QStringList code = it.key().split(".");
+		if ( code.size() < 2 )
+		    continue;
+
+		//! The first band and instrument having records is analyzed
+		StationPreparation::Job job;
+		job.station = it.key();
+		QString prefix;
+		for (int i = 0; i < _activeStreams.size(); ++i) {
+
+			if ( _activeStreams.at(i).networkCode != code.at(0)
+			        or _activeStreams.at(i).stationCode != code.at(1) )
+			    continue;
+
+			if ( !prefix.isEmpty() && _activeStreams.at(i).channelCode.left(2) != prefix )
+			    continue;
+
+			StationPreparation::Stream stream;
+			stream.component = ThreeComponentData::component(_activeStreams.at(i).channelCode);
+			if ( stream.component < 0 ) continue;
+
+			stream.networkCode = _activeStreams.at(i).networkCode;
+			stream.stationCode = _activeStreams.at(i).stationCode;
+			stream.locationCode = _activeStreams.at(i).locationCode;
+			stream.channelCode = _activeStreams.at(i).channelCode;
+			stream.records = _cache.getRecords(stream.id().toStdString());
+			if ( stream.records.empty() ) continue;
+
+			prefix = stream.channelCode.left(2);
+			job.streams << stream;
+		}
+
+		if ( job.streams.size() == 0 )
+		    continue;
+
+		job.regionStart = (double) pPicks.value(it.key())->time().value();
+		job.regionEnd = job.regionStart + backAzimuthWindow;
+		if ( sPicks.contains(it.key()) ) {
+			const double s = (double) sPicks.value(it.key())->time().value();
+			if ( s > job.regionStart && s < job.regionEnd )
+			    job.regionEnd = s;
+		}
+
+		if ( _filter )
+		    job.filter = StationPreparation::FilterPtr(_filter->clone());
+
+		jobs << job;
+	}
+
+	if ( jobs.isEmpty() ) {
+		statusBar()->showMessage("No picked station with records to estimate back-azimuths from",
+		    _settings.messagesDurationMS);
+		return;
+	}
+
+	_estimateBackAzimuths->setEnabled(false);
+	showWaitingWidget();
+
+	//! Stations are prepared and analyzed by the worker threads pool
+	_bulkPolarization->setFuture(QtConcurrent::mapped(jobs, &StationPreparation::prepare));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionWidget::backAzimuthsEstimated() {
+
+	_estimateBackAzimuths->setEnabled(true);
+	hideWaitingWidget();
+
+	if ( _bulkPolarization->isCanceled() )
+	    return;
+
+	const QList<StationPreparation::Result> results = _bulkPolarization->future().results();
+
+	_polarizationTable->setSortingEnabled(false);
+	_polarizationTable->setRowCount(0);
+
+	int estimated = 0;
+	for (int i = 0; i < results.size(); ++i) {
+
+		const StationPreparation::Result& result = results.at(i);
+
+		if ( !result.log.isEmpty() )
+		    log(Client::LM_WARNING, result.log.join("\n"));
+
+		const int row = _polarizationTable->rowCount();
+		_polarizationTable->insertRow(row);
+		_polarizationTable->setItem(row, 0, new QTableWidgetItem(result.station));
+
+		if ( !result.hasPolarization ) {
+			for (int c = 1; c < 5; ++c)
+				_polarizationTable->setItem(row, c, new QTableWidgetItem("-"));
+			continue;
+		}
+
+		const Core::Math::Polarization& p = result.polarization;
+		const double values[] = { p.backAzimuth(), p.incidence, p.rectilinearity, p.planarity };
+		const int decimals[] = { 1, 1, 3, 3 };
+		for (int c = 0; c < 4; ++c) {
+			QTableWidgetItem* item = new QTableWidgetItem;
+			item->setData(Qt::DisplayRole, QString::number(values[c], 'f', decimals[c]).toDouble());
+			_polarizationTable->setItem(row, c + 1, item);
+		}
+
+		++estimated;
+	}
+
+	_polarizationTable->setSortingEnabled(true);
+	_ui->tabWidgetStationData->setCurrentWidget(_polarizationTable);
+
+	log(Client::LM_INFO, QString("Back-azimuth estimated at %1 station(s) out of %2")
+	        .arg(estimated).arg(results.size()));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void ParticleMotionWidget::saveCollectedData() {
 
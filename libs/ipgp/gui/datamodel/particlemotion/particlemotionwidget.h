@@ -24,6 +24,8 @@
 #include <ipgp/gui/api.h>
 #include <ipgp/gui/defs.h>
 #include <ipgp/gui/datamodel/misc.h>
+#include <ipgp/gui/datamodel/particlemotion/threecomponentdata.h>
+#include <ipgp/gui/datamodel/particlemotion/stationpreparation.h>
 #include <ipgp/core/datamodel/recordcache.h>
 #include <ipgp/core/datamodel/flags.h>
 #include <ipgp/gui/client/misc.h>
@@ -36,6 +38,7 @@
 #include <seiscomp3/math/filter.h>
 #include <seiscomp3/utils/timer.h>
 #include <QMainWindow>
+#include <QFutureWatcher>
 
 class QCustomPlot;
 class QCPColorMap;
@@ -56,6 +59,7 @@ class DatabaseQuery;
 
 QT_FORWARD_DECLARE_CLASS(QListWidgetItem);
 QT_FORWARD_DECLARE_CLASS(QTableWidgetItem);
+QT_FORWARD_DECLARE_CLASS(QTableWidget);
 QT_FORWARD_DECLARE_CLASS(QComboBox);
 QT_FORWARD_DECLARE_CLASS(QSpinBox);
 
@@ -225,6 +229,9 @@ class SC_IPGP_GUI_API ParticleMotionWidget : public QMainWindow {
 
 		void log(Client::LogMessage, const QString&);
 
+		//! Plots the sliding polarization attributes of the prepared region
+		void plotPolarization(const StationPreparation::Result&);
+
 	private Q_SLOTS:
 		// ------------------------------------------------------------------
 		//  Private Qt interface
@@ -244,8 +251,11 @@ class SC_IPGP_GUI_API ParticleMotionWidget : public QMainWindow {
 		 * @param bool indicates if a check on the station has to be performed
 		 *        in order to make the difference between a new click (station
 		 *        click) and a refresh request from user
+		 * @note  The records are prepared by a worker thread, graphics are
+		 *        plotted once stationDataPrepared() receives the result.
 		 */
 		void prepareData(const bool& stationCheck = true);
+		void stationDataPrepared();
 
 		/**
 		 * @brief Plots the graphics with data ranging from the selected
@@ -253,6 +263,16 @@ class SC_IPGP_GUI_API ParticleMotionWidget : public QMainWindow {
 		 */
 		void plotData();
 
+		/**
+		 * @brief Estimates the back-azimuth and incidence of the P wave at
+		 *        every station whose records are available, out of the
+		 *        polarization of the region starting at its P pick. Stations
+		 *        are prepared in parallel, backAzimuthsEstimated() fills the
+		 *        polarization table once all of them are done.
+		 */
+		void estimateBackAzimuths();
+		void backAzimuthsEstimated();
+
 		/**
 		 * @brief Checks the data stream, see if any gap(s) is/are present
 		 * @param code The station name (noted as "networkCode.stationCode")
@@ -353,9 +373,12 @@ class SC_IPGP_GUI_API ParticleMotionWidget : public QMainWindow {
 
 		StreamDelegate* _delegate;
 
-		ComponentData _zData;
-		ComponentData _nsData;
-		ComponentData _ewData;
+		//! Samples of the selected region, aligned on the same time base
+		ThreeComponentData _data;
+		QFutureWatcher<StationPreparation::Result>* _preparation;
+		QFutureWatcher<StationPreparation::Result>* _bulkPolarization;
+		QCustomPlot* _polarizationPlot;
+		QTableWidget* _polarizationTable;
 
 		std::string _recordStreamUrl;
 		Seiscomp::Record::Hint _recordInputHint;
@@ -415,10 +438,12 @@ class SC_IPGP_GUI_API ParticleMotionWidget : public QMainWindow {
 		QAction* _endWavePick;
 		QAction* _autoRescaleKeyAxes;
 		QAction* _autoRescaleValueAxes;
+		QAction* _playMotion;
 		QSpinBox* _unpickedStationsDistance;
 		QAction* _addUnpickedStations;
 		QAction* _hideUnpickedStations;
 		QAction* _applyButton;
+		QAction* _estimateBackAzimuths;
 
 		Ui::ParticleMotionSettings* _configDialogUi;
 		QDialog* _configDialog;
@@ -0,0 +1,247 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/datamodel/particlemotion/stationpreparation.h>
+#include <seiscomp3/core/typedarray.h>
+#include <algorithm>
+#include <math.h>
+
+
+using namespace Seiscomp;
+using namespace Seiscomp::Core;
+
+
+namespace {
+
+
+typedef std::vector<const Record*> RecordList;
+
+
+bool byStartTime(const Record* a, const Record* b) {
+	return a->startTime() < b->startTime();
+}
+
+
+//! @return the records sorted by start time, NULL ones being dropped
+RecordList sorted(const std::vector<RecordPtr>& records) {
+
+	RecordList list;
+	list.reserve(records.size());
+	for (size_t i = 0; i < records.size(); ++i)
+		if ( records[i] )
+		    list.push_back(records[i].get());
+
+	std::sort(list.begin(), list.end(), byStartTime);
+
+	return list;
+}
+
+
+//! @return true if b starts less than half a sample after a ends
+bool contiguous(const Record* a, const Record* b) {
+	const double tolerance = .5 / a->samplingFrequency();
+	return a->samplingFrequency() == b->samplingFrequency()
+	        && fabs((double) (b->startTime() - a->endTime())) < tolerance;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QString StationPreparation::Stream::id() const {
+	return QString("%1.%2.%3.%4").arg(networkCode).arg(stationCode)
+	        .arg(locationCode).arg(channelCode);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+StationPreparation::Result StationPreparation::prepare(const Job& job) {
+
+	Result result;
+	result.station = job.station;
+
+	QList<RecordList> records;
+	for (int i = 0; i < job.streams.size(); ++i)
+		records << sorted(job.streams.at(i).records);
+
+	//! Span of the records, the first one setting the sampling rate
+	double windowStart = .0, windowEnd = .0;
+	for (int i = 0; i < records.size(); ++i) {
+		for (size_t v = 0; v < records.at(i).size(); ++v) {
+
+			const Record* rec = records.at(i).at(v);
+
+			if ( result.samplingFrequency < .0 ) {
+				result.samplingFrequency = rec->samplingFrequency();
+				windowStart = (double) rec->startTime();
+				windowEnd = (double) rec->endTime();
+			}
+			windowStart = qMin(windowStart, (double) rec->startTime());
+			windowEnd = qMax(windowEnd, (double) rec->endTime());
+		}
+	}
+
+	result.data.reset(windowStart, windowEnd, result.samplingFrequency);
+
+	for (int i = 0; i < job.streams.size(); ++i) {
+
+		const Stream& stream = job.streams.at(i);
+		const QString id = stream.id();
+		Filter* filter = NULL;
+		const Record* previous = NULL;
+
+		for (size_t v = 0; v < records.at(i).size(); ++v) {
+
+			const Record* rec = records.at(i).at(v);
+
+			if ( rec->samplingFrequency() != result.samplingFrequency ) {
+				result.log << QString("%1: sampling frequency %2 Hz differs from %3 Hz, "
+					"record skipped").arg(id).arg(rec->samplingFrequency())
+				        .arg(result.samplingFrequency);
+				continue;
+			}
+
+			ArrayPtr tmp;
+			const DoubleArray* data = DoubleArray::ConstCast(rec->data());
+			if ( !data ) {
+				if ( !rec->data() ) continue;
+				tmp = rec->data()->copy(Array::DOUBLE);
+				data = DoubleArray::ConstCast(tmp);
+				if ( !data ) continue;
+			}
+
+			DoubleArrayPtr samples = DoubleArray::Cast(data->clone());
+
+			//! The filter keeps running over contiguous records, it starts
+			//! over after a gap or an overlap
+			if ( job.filter ) {
+				if ( !filter || !previous || !contiguous(previous, rec) ) {
+					delete filter;
+					filter = job.filter->clone();
+					filter->setStartTime(rec->startTime());
+					filter->setSamplingFrequency(rec->samplingFrequency());
+					filter->setStreamID(stream.networkCode.toStdString(),
+					    stream.stationCode.toStdString(),
+					    stream.locationCode.toStdString(),
+					    stream.channelCode.toStdString());
+				}
+				try {
+					filter->apply(*samples);
+				}
+				catch ( std::exception& e ) {
+					result.log << QString("%1: %2").arg(id).arg(e.what());
+				}
+			}
+			previous = rec;
+
+			result.data.add(stream.component, (double) rec->startTime(),
+			    samples->typedData(), samples->size());
+
+			//! Records lying in the region feed the frequency spectrum
+			const double start = (double) rec->startTime();
+			if ( start > job.regionStart
+			        && start + 1. / rec->samplingFrequency() < job.regionEnd ) {
+				Channel& channel = result.channels[stream.component];
+				channel.streamID = id;
+				channel.samplingFrequency = rec->samplingFrequency();
+				channel.samples.insert(channel.samples.end(), samples->typedData(),
+				    samples->typedData() + samples->size());
+			}
+		}
+
+		delete filter;
+	}
+
+	if ( job.regionStart != -1. && job.regionEnd != -1. )
+		result.data.crop(job.regionStart, job.regionEnd);
+	else
+		result.data.clear();
+
+	if ( result.data.isEmpty() )
+		return result;
+
+	const QVector<qreal> z = result.data.values(ThreeComponentData::Vertical);
+	const QVector<qreal> ns = result.data.values(ThreeComponentData::NorthSouth);
+	const QVector<qreal> ew = result.data.values(ThreeComponentData::EastWest);
+	const size_t count = result.data.size();
+
+	result.hasPolarization = Core::Math::polarization(z.constData(),
+	    ns.constData(), ew.constData(), count, result.polarization);
+
+	if ( job.polarizationWindow > .0 ) {
+		const double fs = result.data.samplingFrequency();
+		const size_t window = std::max<size_t>(2, (size_t) (job.polarizationWindow * fs + .5));
+		const size_t step = std::max<size_t>(1, (size_t) (job.polarizationStep * fs + .5));
+		Core::Math::polarization(z.constData(), ns.constData(), ew.constData(),
+		    count, window, step, result.polarizations);
+	}
+
+	return result;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+StreamsGapsList StationPreparation::findGaps(const QString& streamID,
+                                             const std::vector<RecordPtr>& records,
+                                             const TimeWindow& tw) {
+
+	StreamsGapsList gaps;
+	const RecordList list = sorted(records);
+
+	const Record* previous = NULL;
+	for (size_t i = 0; i < list.size(); ++i) {
+
+		const Record* rec = list.at(i);
+		if ( rec->endTime() <= tw.startTime() || rec->startTime() >= tw.endTime() )
+		    continue;
+
+		if ( previous && rec->startTime() > previous->endTime()
+		        && !contiguous(previous, rec) ) {
+			StreamGap gap;
+			gap.streamID = streamID;
+			gap.start = previous->endTime();
+			gap.end = rec->startTime();
+			gaps << gap;
+		}
+
+		if ( !previous || rec->endTime() > previous->endTime() )
+		    previous = rec;
+	}
+
+	return gaps;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+} // namespace Gui
+} // namespace IPGP
@@ -0,0 +1,150 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_GUI_DATAMODEL_STATIONPREPARATION_H__
+#define __IPGP_GUI_DATAMODEL_STATIONPREPARATION_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/datamodel/misc.h>
+#include <ipgp/gui/datamodel/particlemotion/threecomponentdata.h>
+#include <ipgp/core/math/polarization.h>
+#include <seiscomp3/core/record.h>
+#include <seiscomp3/core/timewindow.h>
+#include <seiscomp3/math/filter.h>
+#include <QList>
+#include <QStringList>
+#include <vector>
+
+
+namespace IPGP {
+namespace Gui {
+
+
+/**
+ * @class   StationPreparation
+ * @package IPGP::Gui::DataModel
+ * @brief   Filtering and alignment of the records of a station
+ *
+ * A Job gathers, on the GUI thread, everything needed to prepare a station:
+ * its streams records, a prototype of the filter and the analysed region.
+ * prepare() only works on the job, so that it can run in worker threads
+ * (e.g. QtConcurrent::run() or QtConcurrent::mapped() over many stations)
+ * and hand finished arrays back to the GUI.
+ * Each stream gets its own clone of the filter, fed record after record:
+ * the filter state carries over contiguous records and is only reset at
+ * gaps and overlaps.
+ * The polarization of the region is analyzed as well, over the whole
+ * region and over sliding windows when the job defines them.
+ */
+class SC_IPGP_GUI_API StationPreparation {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		typedef Seiscomp::Math::Filtering::InPlaceFilter<double> Filter;
+		typedef SmartPointer<Filter>::Impl FilterPtr;
+
+		struct Stream {
+				Stream() :
+						component(-1) {}
+				QString networkCode;
+				QString stationCode;
+				QString locationCode;
+				QString channelCode;
+				//! ThreeComponentData::Component, resolved once
+				int component;
+				std::vector<Seiscomp::RecordPtr> records;
+
+				QString id() const;
+		};
+		typedef QList<Stream> StreamList;
+
+		struct Job {
+				Job() :
+						regionStart(-1.), regionEnd(-1.),
+						polarizationWindow(.0), polarizationStep(.0) {}
+				//! Station name, noted as "networkCode.stationCode"
+				QString station;
+				StreamList streams;
+				//! Filter prototype, never applied itself, may be NULL
+				FilterPtr filter;
+				//! Analysed region, -1 if not set
+				double regionStart;
+				double regionEnd;
+				//! Sliding polarization windows length and step in
+				//! seconds, 0 to only analyze the whole region
+				double polarizationWindow;
+				double polarizationStep;
+		};
+
+		struct Channel {
+				Channel() :
+						samplingFrequency(.0) {}
+				QString streamID;
+				double samplingFrequency;
+				//! Filtered samples of the records lying in the region
+				std::vector<double> samples;
+		};
+
+		struct Result {
+				Result() :
+						samplingFrequency(-1.), hasPolarization(false) {}
+				QString station;
+				//! Samples of the region, empty if no region is set
+				ThreeComponentData data;
+				Channel channels[ThreeComponentData::ComponentCount];
+				double samplingFrequency;
+				//! Polarization of the whole region, if hasPolarization
+				Core::Math::Polarization polarization;
+				bool hasPolarization;
+				//! Polarization of the sliding windows, their first sample
+				//! and count referring to data
+				Core::Math::PolarizationList polarizations;
+				QStringList log;
+		};
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! Filters and aligns the streams of a job, thread safe
+		static Result prepare(const Job&);
+
+		/**
+		 * @brief  Lists the gaps of a stream within a time window, from the
+		 *         records times only.
+		 * @param  streamID the stream the records belong to
+		 * @param  records the records, in any order
+		 * @param  tw the time window checked
+		 * @return the gaps, two records being contiguous when the second
+		 *         one starts less than half a sample after the first one
+		 */
+		static StreamsGapsList findGaps(const QString& streamID,
+		                                const std::vector<Seiscomp::RecordPtr>& records,
+		                                const Seiscomp::Core::TimeWindow& tw);
+};
+
+
+} // namespace Gui
+} // namespace IPGP
+
+#endif
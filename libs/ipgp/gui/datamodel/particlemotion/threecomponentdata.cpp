@@ -0,0 +1,207 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/datamodel/particlemotion/threecomponentdata.h>
+#include <math.h>
+#include <limits>
+
+
+namespace {
+
+
+const qreal Missing = std::numeric_limits<qreal>::quiet_NaN();
+
+
+inline bool isMissing(const qreal& v) {
+	return v != v;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+ThreeComponentData::ThreeComponentData() :
+		_startTime(.0), _samplingFrequency(1.), _size(0) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+ThreeComponentData::~ThreeComponentData() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int ThreeComponentData::component(const QString& channel) {
+
+	if ( channel.isEmpty() )
+	    return -1;
+
+	switch ( channel.at(channel.size() - 1).toAscii() ) {
+		case 'Z':
+		case 'A':
+			return Vertical;
+		case 'N':
+		case 'B':
+		case '1':
+			return NorthSouth;
+		case 'E':
+		case 'C':
+		case '2':
+			return EastWest;
+		default:
+			return -1;
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ThreeComponentData::reset(const double& start, const double& end,
+                               const double& samplingFrequency) {
+
+	_startTime = start;
+	_samplingFrequency = (samplingFrequency > .0) ? samplingFrequency : 1.;
+	_size = (end > start) ? (int) ceil((end - start) * _samplingFrequency) : 0;
+
+	for (int c = 0; c < ComponentCount; ++c)
+		_values[c].fill(Missing, _size);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ThreeComponentData::clear() {
+
+	for (int c = 0; c < ComponentCount; ++c)
+		_values[c].clear();
+
+	_startTime = .0;
+	_samplingFrequency = 1.;
+	_size = 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int ThreeComponentData::add(const int& component, const double& startTime,
+                            const double* samples, const int& count) {
+
+	if ( component < 0 || component >= ComponentCount || !samples )
+	    return 0;
+
+	//! Records start times jitter by a fraction of the sampling interval,
+	//! the nearest slot is the sample's one
+	const int offset = (int) floor((startTime - _startTime) * _samplingFrequency + .5);
+	const int first = qMax(0, -offset);
+	const int last = qMin(count, _size - offset);
+	if ( first >= last )
+	    return 0;
+
+	qreal* dest = _values[component].data();
+	for (int i = first; i < last; ++i)
+		dest[offset + i] = samples[i];
+
+	return last - first;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int ThreeComponentData::crop(const double& from, const double& to) {
+
+	int first = qMax(0, (int) floor((from - _startTime) * _samplingFrequency) + 1);
+	int last = qMin(_size - 1, (int) ceil((to - _startTime) * _samplingFrequency) - 1);
+
+	//! Leading and trailing samples not covered by every component are
+	//! dropped, holes in between are gaps
+	while ( first <= last && !isComplete(first) )
+		++first;
+	while ( last >= first && !isComplete(last) )
+		--last;
+
+	if ( first > last ) {
+		const double fs = _samplingFrequency;
+		clear();
+		_samplingFrequency = fs;
+		return 0;
+	}
+
+	const int size = last - first + 1;
+	for (int c = 0; c < ComponentCount; ++c)
+		_values[c] = _values[c].mid(first, size);
+
+	_startTime += first / _samplingFrequency;
+	_size = size;
+
+	return _size;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool ThreeComponentData::isComplete(const int& index) const {
+
+	for (int c = 0; c < ComponentCount; ++c)
+		if ( isMissing(_values[c].at(index)) )
+		    return false;
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int ThreeComponentData::gapCount() const {
+
+	int count = 0;
+	for (int i = 0; i < _size; ++i)
+		if ( !isComplete(i) )
+		    ++count;
+
+	return count;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+} // namespace Gui
+} // namespace IPGP
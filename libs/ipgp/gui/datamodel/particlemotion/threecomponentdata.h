@@ -0,0 +1,149 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_GUI_DATAMODEL_THREECOMPONENTDATA_H__
+#define __IPGP_GUI_DATAMODEL_THREECOMPONENTDATA_H__
+
+#include <ipgp/gui/api.h>
+#include <QString>
+#include <QVector>
+
+
+namespace IPGP {
+namespace Gui {
+
+
+/**
+ * @class   ThreeComponentData
+ * @package IPGP::Gui::DataModel
+ * @brief   Aligned samples of the three components of a station
+ *
+ * The vertical and horizontal traces are written into contiguous arrays
+ * sharing the same time base: sample i of every component is located at
+ * time(i). Samples are placed by their offset from the start of the window
+ * instead of being keyed by their own floating point time, so that records
+ * of different components line up even when their start times differ by a
+ * fraction of the sampling interval.
+ * Missing samples are NaN: gapCount() tells how many time indices lack at
+ * least one component.
+ */
+class SC_IPGP_GUI_API ThreeComponentData {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		enum Component {
+			Vertical = 0,
+			NorthSouth = 1,
+			EastWest = 2,
+			ComponentCount = 3
+		};
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		ThreeComponentData();
+		~ThreeComponentData();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief  Resolves the component a channel records, from the last
+		 *         character of its code or stream ID: Z/A are vertical,
+		 *         N/B/1 north-south and E/C/2 east-west.
+		 * @return the component, -1 if not recognized
+		 */
+		static int component(const QString& channel);
+
+		/**
+		 * @brief Allocates the window, every sample being missing.
+		 * @param start the time of the first sample (epoch seconds)
+		 * @param end the time past the last sample
+		 * @param samplingFrequency the sampling rate shared by the components
+		 */
+		void reset(const double& start, const double& end,
+		           const double& samplingFrequency);
+		void clear();
+
+		/**
+		 * @brief  Writes consecutive samples of a component.
+		 * @param  component the component written
+		 * @param  startTime the time of the first sample
+		 * @param  samples the values
+		 * @param  count the number of values
+		 * @return the number of samples written, those falling outside of
+		 *         the window are dropped
+		 */
+		int add(const int& component, const double& startTime,
+		        const double* samples, const int& count);
+
+		/**
+		 * @brief  Restricts the window to the samples strictly between two
+		 *         times which are covered by every component.
+		 * @return the number of remaining samples
+		 */
+		int crop(const double& from, const double& to);
+
+		bool isEmpty() const {
+			return _size == 0;
+		}
+		int size() const {
+			return _size;
+		}
+
+		const double& startTime() const {
+			return _startTime;
+		}
+		const double& samplingFrequency() const {
+			return _samplingFrequency;
+		}
+		double time(const int& index) const {
+			return _startTime + index / _samplingFrequency;
+		}
+
+		//! @return the contiguous samples of a component
+		const QVector<qreal>& values(const int& component) const {
+			return _values[component];
+		}
+
+		//! @return true if every component has the sample
+		bool isComplete(const int& index) const;
+		//! @return the number of samples lacking at least one component
+		int gapCount() const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		QVector<qreal> _values[ComponentCount];
+		double _startTime;
+		double _samplingFrequency;
+		int _size;
+};
+
+
+} // namespace Gui
+} // namespace IPGP
+
+#endif
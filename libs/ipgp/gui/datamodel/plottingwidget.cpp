@@ -93,6 +93,7 @@ void PlottingWidget::setEvents(OriginList* list, const bool& copy) {
 		_events = new OriginList;
 		*_events = *list;
 		_listIsACopy = true;
+		_catalogue = CatalogueSnapshot::Shared(_events);
 
 		emit eventListModified();
 
@@ -101,6 +102,7 @@ void PlottingWidget::setEvents(OriginList* list, const bool& copy) {
 
 	_events = list;
 	_listIsACopy = false;
+	_catalogue = CatalogueSnapshot::Shared(_events);
 
 	emit eventListModified();
 }
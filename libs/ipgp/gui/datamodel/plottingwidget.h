@@ -28,6 +28,7 @@
 #include <QTimer>
 #include <QList>
 #include <ipgp/gui/datamodel/toolbox/toolbox.h>
+#include <ipgp/gui/datamodel/cataloguesnapshot.h>
 #include <ipgp/core/datamodel/types.h>
 #include <seiscomp3/datamodel/event.h>
 #include <seiscomp3/datamodel/origin.h>
@@ -121,12 +122,18 @@ class SC_IPGP_GUI_API PlottingWidget : public QWidget {
 		 *        time the reference list changes.
 		 * @note  The user may reimplement this method to perform operations
 		 *        right after the event list has been setup.
+		 * @note  The catalogue snapshot of the list is updated as well.
 		 */
 		virtual void setEvents(Core::OriginList*, const bool& copy = false);
 		Core::OriginList* originList() const {
 			return _events;
 		}
 
+		//! Columnar snapshot of the list, NULL until events are set
+		CatalogueSnapshotCPtr catalogue() const {
+			return _catalogue;
+		}
+
 		/**
 		 * @brief Sets the cache engine by reference or by copy
 		 * @param ObjectCache the cache
@@ -208,6 +215,8 @@ class SC_IPGP_GUI_API PlottingWidget : public QWidget {
 		// not be deleted by any methods of this class whatsoever
 		Seiscomp::DataModel::DatabaseQuery* _query;
 		Core::OriginList* _events;
+		//! Snapshot of _events, shared with the other widgets of the list
+		CatalogueSnapshotCPtr _catalogue;
 		Core::ObjectCache* _cache;
 		ToolBox* _toolBox;
 		Core::MagnitudeTypes _magnitudes;
@@ -0,0 +1,425 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/datamodel/scatterplottable.h>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <math.h>
+
+
+namespace {
+
+//! Average number of points per cell of the hit-testing grid
+const double PointsPerCell = 4.;
+const int MaxCellsPerSide = 1024;
+
+
+//! Shapes drawn by the outlines pass, filled shapes aren't filled there
+QCPScatterStyle::ScatterShape outlineShape(const QCPScatterStyle::ScatterShape& s) {
+	if ( s == QCPScatterStyle::ssDisc )
+		return QCPScatterStyle::ssCircle;
+	if ( s == QCPScatterStyle::ssFilledSquare )
+		return QCPScatterStyle::ssSquare;
+	return s;
+}
+
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+ScatterPlottable::ScatterPlottable(QCPAxis* keyAxis, QCPAxis* valueAxis) :
+		QCPAbstractPlottable(keyAxis, valueAxis), _maxSize(.0),
+		_outlinePen(Qt::NoPen), _outlineOffset(.0), _indexDirty(true),
+		_columns(0), _rows(0), _keyMin(.0), _keyCell(1.), _valueMin(.0),
+		_valueCell(1.) {
+
+	if ( parentPlot() )
+		parentPlot()->installEventFilter(this);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+ScatterPlottable::~ScatterPlottable() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ScatterPlottable::reserve(const int& count) {
+	_keys.reserve(count);
+	_values.reserve(count);
+	_sizes.reserve(count);
+	_shapes.reserve(count);
+	_colors.reserve(count);
+	_names.reserve(count);
+	_tooltips.reserve(count);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int ScatterPlottable::addPoint(const double& key, const double& value,
+                               const double& size,
+                               const QCPScatterStyle::ScatterShape& shape,
+                               const QColor& color, const QString& name,
+                               const QString& tooltip) {
+
+	_keys.append(key);
+	_values.append(value);
+	_sizes.append(size);
+	_shapes.append(static_cast<quint8>(shape));
+	_colors.append(color.rgba());
+	_names.append(name);
+	_tooltips.append(tooltip);
+
+	if ( size > _maxSize )
+		_maxSize = size;
+
+	_indexDirty = true;
+
+	return _keys.size() - 1;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ScatterPlottable::setOutline(const QPen& pen, const double& offset) {
+	_outlinePen = pen;
+	_outlineOffset = offset;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ScatterPlottable::clearData() {
+
+	_keys.clear();
+	_values.clear();
+	_sizes.clear();
+	_shapes.clear();
+	_colors.clear();
+	_names.clear();
+	_tooltips.clear();
+	_maxSize = .0;
+
+	_indexDirty = true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int ScatterPlottable::pointAt(const QPointF& pos, double* distance) const {
+
+	if ( _keys.isEmpty() || !mKeyAxis || !mValueAxis || !parentPlot() )
+		return -1;
+
+	if ( _indexDirty )
+		buildIndex();
+
+	const double tolerance = parentPlot()->selectionTolerance();
+	const double outline = (_outlinePen.style() == Qt::NoPen) ? .0 : _outlineOffset;
+	const double reach = tolerance + (_maxSize + outline) / 2.;
+
+	//! Data rectangle around the position, axes may be reversed
+	double k1, v1, k2, v2;
+	pixelsToCoords(pos.x() - reach, pos.y() - reach, k1, v1);
+	pixelsToCoords(pos.x() + reach, pos.y() + reach, k2, v2);
+
+	const int c1 = qBound(0, (int) floor((qMin(k1, k2) - _keyMin) / _keyCell), _columns - 1);
+	const int c2 = qBound(0, (int) floor((qMax(k1, k2) - _keyMin) / _keyCell), _columns - 1);
+	const int r1 = qBound(0, (int) floor((qMin(v1, v2) - _valueMin) / _valueCell), _rows - 1);
+	const int r2 = qBound(0, (int) floor((qMax(v1, v2) - _valueMin) / _valueCell), _rows - 1);
+
+	int found = -1;
+	double best = tolerance;
+	for (int r = r1; r <= r2; ++r) {
+		for (int c = c1; c <= c2; ++c) {
+
+			const int cell = r * _columns + c;
+			for (int k = _cellStart[cell]; k < _cellStart[cell + 1]; ++k) {
+
+				const int i = _cellPoints[k];
+				const QPointF p = coordsToPixels(_keys[i], _values[i]);
+				const double dx = p.x() - pos.x();
+				const double dy = p.y() - pos.y();
+				const double d = qMax(.0, sqrt(dx * dx + dy * dy)
+				        - (_sizes[i] + outline) / 2.);
+
+				//! The last point drawn is on top
+				if ( d < best || (d == best && i > found) ) {
+					best = d;
+					found = i;
+				}
+			}
+		}
+	}
+
+	if ( found >= 0 && distance )
+		*distance = best;
+
+	return found;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+double ScatterPlottable::selectTest(const QPointF& pos, bool onlySelectable,
+                                    QVariant* details) const {
+
+	if ( (onlySelectable && !mSelectable) || _keys.isEmpty() )
+		return -1;
+
+	if ( !mKeyAxis || !mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()) )
+		return -1;
+
+	double distance;
+	const int index = pointAt(pos, &distance);
+	if ( index < 0 )
+		return -1;
+
+	if ( details )
+		details->setValue(index);
+
+	return distance;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ScatterPlottable::draw(QCPPainter* painter) {
+
+	if ( _keys.isEmpty() || !mKeyAxis || !mValueAxis )
+		return;
+
+	//! Points whose shape can't reach the axis rect are skipped
+	const QRectF visible = QRectF(clipRect()).adjusted(-_maxSize - _outlineOffset,
+	    -_maxSize - _outlineOffset, _maxSize + _outlineOffset, _maxSize + _outlineOffset);
+
+	QVector<QPointF> pixels(_keys.size());
+	QVector<bool> shown(_keys.size());
+	for (int i = 0; i < _keys.size(); ++i) {
+		pixels[i] = coordsToPixels(_keys[i], _values[i]);
+		shown[i] = visible.contains(pixels[i]);
+	}
+
+	applyScattersAntialiasingHint(painter);
+
+	QCPScatterStyle style;
+
+	if ( _outlinePen.style() != Qt::NoPen ) {
+		painter->setPen(mSelected ? mSelectedPen : _outlinePen);
+		painter->setBrush(Qt::NoBrush);
+		for (int i = 0; i < _keys.size(); ++i) {
+			if ( !shown[i] ) continue;
+			style.setShape(outlineShape(static_cast<QCPScatterStyle::ScatterShape>(_shapes[i])));
+			style.setSize(_sizes[i] + _outlineOffset);
+			style.drawShape(painter, pixels[i]);
+		}
+	}
+
+	//! Filled shapes take the pen color, the pen only changes along with
+	//! the points color
+	QRgb current = _colors.first();
+	painter->setPen(QPen(QColor::fromRgba(current)));
+	painter->setBrush(Qt::NoBrush);
+	for (int i = 0; i < _keys.size(); ++i) {
+
+		if ( !shown[i] ) continue;
+
+		if ( _colors[i] != current ) {
+			current = _colors[i];
+			painter->setPen(QPen(QColor::fromRgba(current)));
+		}
+
+		style.setShape(static_cast<QCPScatterStyle::ScatterShape>(_shapes[i]));
+		style.setSize(_sizes[i]);
+		style.drawShape(painter, pixels[i]);
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ScatterPlottable::drawLegendIcon(QCPPainter* painter,
+                                      const QRectF& rect) const {
+
+	applyDefaultAntialiasingHint(painter);
+
+	const QColor color = _colors.isEmpty() ? mainPen().color()
+	        : QColor::fromRgba(_colors.first());
+	QCPScatterStyle style(QCPScatterStyle::ssDisc, color,
+	    qMin(rect.width(), rect.height()) * .6);
+	style.applyTo(painter, mainPen());
+	style.drawShape(painter, rect.center());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QCPRange ScatterPlottable::getKeyRange(bool& foundRange,
+                                       SignDomain inSignDomain) const {
+	return getRange(_keys, foundRange, inSignDomain);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QCPRange ScatterPlottable::getValueRange(bool& foundRange,
+                                         SignDomain inSignDomain) const {
+	return getRange(_values, foundRange, inSignDomain);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool ScatterPlottable::eventFilter(QObject* object, QEvent* event) {
+
+	if ( event->type() != QEvent::ToolTip || object != parentPlot() )
+		return false;
+
+	QHelpEvent* helpEvent = static_cast<QHelpEvent*>(event);
+	if ( !mKeyAxis || !mKeyAxis.data()->axisRect()->rect().contains(helpEvent->pos()) )
+		return false;
+
+	const int index = pointAt(helpEvent->pos());
+	if ( index < 0 || _tooltips.at(index).isEmpty() )
+		return false;
+
+	QToolTip::showText(helpEvent->globalPos(), _tooltips.at(index));
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QCPRange ScatterPlottable::getRange(const QVector<double>& data,
+                                    bool& foundRange,
+                                    const SignDomain& domain) const {
+
+	QCPRange range;
+	foundRange = false;
+
+	for (int i = 0; i < data.size(); ++i) {
+
+		const double v = data[i];
+		if ( (domain == sdNegative && v >= 0) || (domain == sdPositive && v <= 0) )
+			continue;
+
+		if ( !foundRange ) {
+			range.lower = range.upper = v;
+			foundRange = true;
+		}
+		else if ( v < range.lower )
+			range.lower = v;
+		else if ( v > range.upper )
+			range.upper = v;
+	}
+
+	return range;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ScatterPlottable::buildIndex() const {
+
+	_indexDirty = false;
+
+	const int count = _keys.size();
+	if ( count == 0 ) {
+		_columns = _rows = 0;
+		_cellStart.clear();
+		_cellPoints.clear();
+		return;
+	}
+
+	double keyMax = _keys.first(), valueMax = _values.first();
+	_keyMin = keyMax;
+	_valueMin = valueMax;
+	for (int i = 1; i < count; ++i) {
+		_keyMin = qMin(_keyMin, _keys[i]);
+		keyMax = qMax(keyMax, _keys[i]);
+		_valueMin = qMin(_valueMin, _values[i]);
+		valueMax = qMax(valueMax, _values[i]);
+	}
+
+	const int side = qBound(1, (int) sqrt(count / PointsPerCell), MaxCellsPerSide);
+	_columns = (keyMax > _keyMin) ? side : 1;
+	_rows = (valueMax > _valueMin) ? side : 1;
+	_keyCell = (keyMax > _keyMin) ? (keyMax - _keyMin) / _columns : 1.;
+	_valueCell = (valueMax > _valueMin) ? (valueMax - _valueMin) / _rows : 1.;
+
+	//! Counting sort of the points by cell
+	QVector<int> cells(count);
+	_cellStart.fill(0, _columns * _rows + 1);
+	for (int i = 0; i < count; ++i) {
+		const int c = qMin((int) ((_keys[i] - _keyMin) / _keyCell), _columns - 1);
+		const int r = qMin((int) ((_values[i] - _valueMin) / _valueCell), _rows - 1);
+		cells[i] = r * _columns + c;
+		++_cellStart[cells[i] + 1];
+	}
+
+	for (int c = 0; c < _columns * _rows; ++c)
+		_cellStart[c + 1] += _cellStart[c];
+
+	QVector<int> next(_cellStart);
+	_cellPoints.resize(count);
+	for (int i = 0; i < count; ++i)
+		_cellPoints[next[cells[i]]++] = i;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace Gui
+} // namespace IPGP
@@ -0,0 +1,180 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_GUI_DATAMODEL_SCATTERPLOTTABLE_H__
+#define __IPGP_GUI_DATAMODEL_SCATTERPLOTTABLE_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/3rd-party/qcustomplot/qcustomplot.h>
+#include <QVector>
+#include <QColor>
+
+
+namespace IPGP {
+namespace Gui {
+
+
+/**
+ * @class   ScatterPlottable
+ * @package IPGP::Gui::DataModel
+ * @brief   A single plottable drawing many scatter points
+ *
+ * Catalogue plots used to create one QCPGraph per event to give it its own
+ * size, shape, color and tooltip. This plottable stores every point in
+ * columns (keys, values, sizes, shapes, colors, names and tooltips) and
+ * draws them all in one pass, optionally preceded by a pass drawing their
+ * outlines, so that the points of an event don't hide its neighbours'
+ * outlines.
+ * Points are hit-tested through a regular grid of the data extent, built
+ * on the first query following a change: selectTest(), pointAt() and the
+ * tooltips only look at the points of the cells around the mouse.
+ * Tooltips are shown by filtering the ToolTip events of the parent plot.
+ */
+class SC_IPGP_GUI_API ScatterPlottable : public QCPAbstractPlottable {
+
+	Q_OBJECT
+
+	Q_CLASSINFO( "Author", "IPGP" )
+	Q_CLASSINFO( "Version", "1.0.0" )
+	Q_CLASSINFO( "URL", "www.ipgp.fr" )
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		ScatterPlottable(QCPAxis* keyAxis, QCPAxis* valueAxis);
+		~ScatterPlottable();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		void reserve(const int& count);
+
+		/**
+		 * @brief Appends a point.
+		 * @param key the key coordinate
+		 * @param value the value coordinate
+		 * @param size the shape size in pixels
+		 * @param shape the shape, discs and filled squares being filled
+		 *        with the point color
+		 * @param color the point color
+		 * @param name the point name, e.g. the event publicID
+		 * @param tooltip the text shown when hovering the point
+		 * @return the index of the point
+		 */
+		int addPoint(const double& key, const double& value,
+		             const double& size,
+		             const QCPScatterStyle::ScatterShape& shape,
+		             const QColor& color, const QString& name = QString(),
+		             const QString& tooltip = QString());
+
+		int pointCount() const {
+			return _keys.size();
+		}
+		double pointKey(const int& index) const {
+			return _keys.at(index);
+		}
+		double pointValue(const int& index) const {
+			return _values.at(index);
+		}
+		const QString& pointName(const int& index) const {
+			return _names.at(index);
+		}
+		const QString& pointTooltip(const int& index) const {
+			return _tooltips.at(index);
+		}
+
+		/**
+		 * @brief Draws the outline of every point before the points
+		 *        themselves.
+		 * @param pen the outlines pen, Qt::NoPen disables the outlines
+		 * @param offset the outlines size increment in pixels
+		 */
+		void setOutline(const QPen& pen, const double& offset);
+
+		/**
+		 * @brief  Looks for the point under a pixel position.
+		 * @param  pos the position in pixels
+		 * @param  distance optional output of the distance in pixels
+		 *         between the position and the point shape
+		 * @return the index of the nearest point within the selection
+		 *         tolerance of the plot, -1 if none
+		 */
+		int pointAt(const QPointF& pos, double* distance = NULL) const;
+
+		void clearData();
+		double selectTest(const QPointF& pos, bool onlySelectable,
+		                  QVariant* details = 0) const;
+
+	protected:
+		// ------------------------------------------------------------------
+		//  Protected interface
+		// ------------------------------------------------------------------
+		void draw(QCPPainter*);
+		void drawLegendIcon(QCPPainter*, const QRectF&) const;
+		QCPRange getKeyRange(bool& foundRange, SignDomain inSignDomain = sdBoth) const;
+		QCPRange getValueRange(bool& foundRange, SignDomain inSignDomain = sdBoth) const;
+
+		bool eventFilter(QObject*, QEvent*);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		QCPRange getRange(const QVector<double>&, bool& foundRange,
+		                  const SignDomain&) const;
+		void buildIndex() const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		QVector<double> _keys;
+		QVector<double> _values;
+		QVector<double> _sizes;
+		QVector<quint8> _shapes;
+		QVector<QRgb> _colors;
+		QVector<QString> _names;
+		QVector<QString> _tooltips;
+		double _maxSize;
+
+		QPen _outlinePen;
+		double _outlineOffset;
+
+		//! Grid of the data extent: the points of cell c are the indices
+		//! _cellPoints[_cellStart[c]] to _cellPoints[_cellStart[c + 1] - 1]
+		mutable bool _indexDirty;
+		mutable int _columns;
+		mutable int _rows;
+		mutable double _keyMin;
+		mutable double _keyCell;
+		mutable double _valueMin;
+		mutable double _valueCell;
+		mutable QVector<int> _cellStart;
+		mutable QVector<int> _cellPoints;
+};
+
+
+} // namespace Gui
+} // namespace IPGP
+
+#endif
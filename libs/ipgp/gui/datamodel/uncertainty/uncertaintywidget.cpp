@@ -23,7 +23,6 @@
 #include <ipgp/core/string/string.h>
 #include <ipgp/gui/misc/misc.h>
 #include <ipgp/gui/3rd-party/qcustomplot/qcustomplot.h>
-#include <seiscomp3/datamodel/magnitude.h>
 #include <seiscomp3/core/datetime.h>
 #include <ipgp/core/math/math.h>
 #include <seiscomp3/datamodel/databasequery.h>
@@ -479,18 +478,9 @@ void UncertaintyWidget::replot() {
 
 		} catch ( ... ) {}
 
-		MagnitudePtr mag = Magnitude::Find(j->second->preferredMagnitudeID());
+		if ( !_catalogue->hasMagnitude(idx) ) continue;
 
-		if ( !mag ) continue;
-
-		bool hasMag = false;
-		float magErrKM;
-		try {
-			magErrKM = mag->magnitude().value();
-			hasMag = true;
-		} catch ( ... ) {}
-
-		if ( !hasMag ) continue;
+		const float magErrKM = _catalogue->magnitudes()[idx];
 
 		if ( magErrKM < .1 )
 			magErr01++;
@@ -171,25 +171,18 @@ ForegroundCanvas::containsGeometry(const QString& publicID) const {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void ForegroundCanvas::addCities(const std::vector<Seiscomp::Math::Geo::CityD>& list) {
 
-	QList<QString> types;
-
+	//! The city layer only paints the most populated cities which labels
+	//! don't overlap, the whole list can therefore be handed out.
 	for (size_t i = 0; i < list.size(); ++i) {
-
-		if ( !types.contains(list.at(i).category().c_str()) )
-			types.append(list.at(i).category().c_str());
-
-//		if ( list.at(i).category() == "B" ) {
-//			City* city = new City();
-//			city->setName(QString::fromUtf8(list.at(i).name().c_str()));
-//			city->setPopulation(list.at(i).population());
-//			city->setGeoPosition(QPointF(list.at(i).longitude(), list.at(i).latitude()));
-//			city->setSize(QSizeF(6.,6.));
-//			_cityLayer.addCity(city);
-//		}
+		City* city = new City(list.at(i).population());
+		city->setName(QString::fromUtf8(list.at(i).name().c_str()));
+		city->setGeoPosition(QPointF(list.at(i).longitude(), list.at(i).latitude()));
+		city->setSize(QSizeF(6., 6.));
+		city->setPaintName(true);
+		_cityLayer.addCity(city);
 	}
 
-	for (int i = 0; i < types.size(); i++)
-		qDebug() << "Type " << types.at(i);
+	emit updateRequested();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
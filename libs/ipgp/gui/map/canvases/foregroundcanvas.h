@@ -116,6 +116,10 @@ class SC_IPGP_GUI_API ForegroundCanvas : public Canvas {
 			return _geometryLayer.geometries();
 		}
 
+		CityLayer& cityLayer() {
+			return _cityLayer;
+		}
+
 	private Q_SLOTS:
 		// ------------------------------------------------------------------
 		//  Private Qt interface
@@ -24,8 +24,10 @@
 #include <ipgp/gui/map/config.h>
 #include <ipgp/gui/map/util.h>
 #include <ipgp/gui/math/math.h>
+#include <QImage>
 #include <QDebug>
 #include <QPointF>
+#include <QRectF>
 #include <QPen>
 #include <QSizeF>
 #include <math.h>
@@ -98,36 +100,26 @@ void City::draw(QPainter& painter, const QPointF& startTile,
 			                                   QPoint(size().width() / 2, 1)
 			};
 
-			QPixmap pix = QPixmap(size().width() + 1, size().height() + 1);
-			pix.fill(Qt::transparent);
+			QImage pix(size().width() + 1, size().height() + 1, QImage::Format_ARGB32_Premultiplied);
+			pix.fill(0);
 
 			QPainter tmp(&pix);
 			tmp.setBrush(brush());
 			tmp.setOpacity(1);
 			tmp.setPen(pen());
 			tmp.drawPolygon(tpoints, 4, Qt::WindingFill);
+			tmp.end();
 
-			painter.drawPixmap(coords.x() - (size().width() / 2),
+			painter.drawImage(QRectF(coords.x() - (size().width() / 2),
 			    coords.y() - (size().height() / 2),
-			    size().width(), size().height(), pix);
+			    size().width(), size().height()), pix);
 		}
 		break;
 	}
 
 	QFont font;
 	QFontMetrics fm(font);
-	int width = fm.width(name());
-	int height = fm.height();
-
-	QRect r;
-	switch ( _position ) {
-		case MiddleLeft:
-			r = QRect(coords.x() + 8 - width, coords.y(), width, height);
-		break;
-		default:
-			r = QRect(coords.x() + 8, coords.y(), width, height);
-		break;
-	}
+	const QRect r = labelRect(coords);
 
 	QString elidedText = fm.elidedText(name(), Qt::ElideRight, r.width());
 
@@ -222,6 +214,47 @@ void City::linkToParent(Epicenter* parent) {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QRect City::indicatorRect(const QPointF& coords) const {
+
+	//! Same shapes as draw(): ellipses use size() as radii around coords,
+	//! rectangles hang from coords and triangles are centered on them
+	switch ( _shape ) {
+		case City::is_ellipse:
+			return QRectF(coords.x() - size().width(), coords.y() - size().height(),
+			    2 * size().width(), 2 * size().height()).toAlignedRect();
+		case City::is_rectangle:
+			return QRectF(coords, size()).toAlignedRect();
+		default:
+			return QRectF(coords.x() - size().width() / 2, coords.y() - size().height() / 2,
+			    size().width(), size().height()).toAlignedRect();
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QRect City::labelRect(const QPointF& coords) const {
+
+	QFont font;
+	QFontMetrics fm(font);
+	const int width = fm.width(name());
+	const int height = fm.height();
+
+	switch ( _position ) {
+		case MiddleLeft:
+			return QRect(coords.x() + 8 - width, coords.y(), width, height);
+		default:
+			return QRect(coords.x() + 8, coords.y(), width, height);
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 }
 }
 }
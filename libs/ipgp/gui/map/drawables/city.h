@@ -26,6 +26,7 @@
 #include <ipgp/gui/api.h>
 #include <ipgp/gui/map/geometry.h>
 #include <ipgp/gui/map/config.h>
+#include <QRect>
 #include <QSizeF>
 
 class QPointF;
@@ -88,6 +89,11 @@ class SC_IPGP_GUI_API City : public Geometry {
 
 		void linkToParent(Epicenter*);
 
+		//! Screen area covered by the indicator drawn at coords
+		QRect indicatorRect(const QPointF& coords) const;
+		//! Screen area covered by the name label drawn at coords
+		QRect labelRect(const QPointF& coords) const;
+
 	private:
 		// ------------------------------------------------------------------
 		//  Members
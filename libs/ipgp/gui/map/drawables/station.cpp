@@ -25,6 +25,7 @@
 #include <ipgp/gui/misc/misc.h>
 #include <ipgp/gui/map/config.h>
 #include <ipgp/gui/math/math.h>
+#include <QImage>
 #include <QDebug>
 #include <QPointF>
 #include <QPen>
@@ -90,18 +91,19 @@ void Station::draw(QPainter& painter, const QPointF& startTile,
 			                                   QPoint(size().width() / 2, 1)
 			};
 
-			QPixmap pix = QPixmap(size().width() + 1, size().height() + 1);
-			pix.fill(Qt::transparent);
+			QImage pix(size().width() + 1, size().height() + 1, QImage::Format_ARGB32_Premultiplied);
+			pix.fill(0);
 
 			QPainter tmp(&pix);
 			tmp.setBrush(brush());
 			tmp.setOpacity(1);
 			tmp.setPen(pen());
 			tmp.drawPolygon(tpoints, 4, Qt::WindingFill);
+			tmp.end();
 
-			painter.drawPixmap(coords.x() - (size().width() / 2),
+			painter.drawImage(QRectF(coords.x() - (size().width() / 2),
 			    coords.y() - (size().height() / 2),
-			    size().width(), size().height(), pix);
+			    size().width(), size().height()), pix);
 		}
 		break;
 	}
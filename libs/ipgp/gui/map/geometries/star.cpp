@@ -23,6 +23,7 @@
 #include <ipgp/gui/map/util.h>
 
 
+#include <QImage>
 #include <QPainter>
 #include <QRect>
 #include <QPointF>
@@ -87,18 +88,19 @@ void Star::draw(QPainter& painter, const QPointF& startTile,
 	                                  QPoint(width / 2., 0.) // A
 	};
 
-	QPixmap pix = QPixmap(size().width() + 1, size().height() + 1);
-	pix.fill(Qt::transparent);
+	QImage pix(size().width() + 1, size().height() + 1, QImage::Format_ARGB32_Premultiplied);
+	pix.fill(0);
 
 	QPainter tmp(&pix);
 	tmp.setBrush(brush());
 	tmp.setPen(pen());
 	tmp.setOpacity(opacity());
 	tmp.drawPolygon(star, 11, Qt::WindingFill);
+	tmp.end();
 
-	painter.drawPixmap(coords.x() - (size().width() / 2),
+	painter.drawImage(QRectF(coords.x() - (size().width() / 2),
 	    coords.y() - (size().height() / 2),
-	    size().width(), size().height(), pix);
+	    size().width(), size().height()), pix);
 
 	painter.restore();
 }
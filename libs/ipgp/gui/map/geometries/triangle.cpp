@@ -23,6 +23,7 @@
 #include <ipgp/gui/map/util.h>
 
 
+#include <QImage>
 #include <QPainter>
 #include <QRect>
 #include <QPointF>
@@ -77,18 +78,19 @@ void Triangle::draw(QPainter& painter, const QPointF& startTile,
 	                                   QPoint(size().width() / 2, 1)
 	};
 
-	QPixmap pix = QPixmap(size().width() + 1, size().height() + 1);
-	pix.fill(Qt::transparent);
+	QImage pix(size().width() + 1, size().height() + 1, QImage::Format_ARGB32_Premultiplied);
+	pix.fill(0);
 
 	QPainter tmp(&pix);
 	tmp.setBrush(brush());
 	tmp.setPen(pen());
 	tmp.setOpacity(opacity());
 	tmp.drawPolygon(tpoints, 4, Qt::WindingFill);
+	tmp.end();
 
-	painter.drawPixmap(coords.x() - (size().width() / 2),
+	painter.drawImage(QRectF(coords.x() - (size().width() / 2),
 	    coords.y() - (size().height() / 2),
-	    size().width(), size().height(), pix);
+	    size().width(), size().height()), pix);
 
 	painter.restore();
 }
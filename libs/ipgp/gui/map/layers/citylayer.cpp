@@ -21,29 +21,62 @@
 #include <ipgp/gui/map/layers/citylayer.h>
 #include <ipgp/gui/map/drawables/city.h>
 #include <ipgp/gui/map/config.h>
+#include <ipgp/gui/map/util.h>
 #include <QPixmap>
 #include <QRect>
 #include <QPainter>
 #include <QPointF>
 #include <QString>
 #include <QDebug>
+#include <QSet>
+#include <algorithm>
+#include <cmath>
 
 namespace IPGP {
 namespace Gui {
 namespace Map {
 
+namespace {
+
+//! Cities are bucketed on a 64x64 grid (tiles of zoom level 6)
+const int INDEX_SIZE = 64;
+
+
+bool morePopulated(const City* a, const City* b) {
+	return a->population() > b->population();
+}
+
+
+inline int wrap(const int& value, const int& size) {
+	return ((value % size) + size) % size;
+}
+
+
+//! Size in pixels of the buckets of placed labels
+const int LABEL_BUCKET = 128;
+
+inline qint64 bucketKey(const int& x, const int& y) {
+	return (static_cast<qint64>(x) << 32) | static_cast<quint32>(y);
+}
+
+}
+
+
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 CityLayer::CityLayer(const QString& name, const QString& desc,
                      const bool& visible) :
-		Layer(Layer::Layer_Drawable, name, desc, visible, false) {}
+		Layer(Layer::Layer_Drawable, name, desc, visible, false),
+		_citiesPerCell(1), _cellSize(TILE_SIZE / 4) {}
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
 
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-CityLayer::~CityLayer() {}
+CityLayer::~CityLayer() {
+	removeCities();
+}
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
 
@@ -56,9 +89,28 @@ void CityLayer::draw(QPainter& painter, const QPointF& startTile,
 	if ( !isVisible() )
 		return;
 
-	for (int i = 0; i < _cities.count(); i++)
-		if ( _cities.at(i)->isVisible() )
-			_cities.at(i)->draw(painter, startTile, viewport, zoom);
+	const CityIndex& placed = layout(zoom);
+	if ( placed.isEmpty() )
+		return;
+
+	const qreal worldTiles = pow2[zoom];
+
+	//! Index cells covered by the viewport, the map wraps horizontally
+	QSet<int> cells;
+	const int cx0 = static_cast<int>(std::floor(startTile.x() / worldTiles * INDEX_SIZE));
+	const int cx1 = static_cast<int>(std::floor((startTile.x() + qreal(viewport.width()) / TILE_SIZE) / worldTiles * INDEX_SIZE));
+	const int cy0 = static_cast<int>(std::floor(startTile.y() / worldTiles * INDEX_SIZE));
+	const int cy1 = static_cast<int>(std::floor((startTile.y() + qreal(viewport.height()) / TILE_SIZE) / worldTiles * INDEX_SIZE));
+	for (int cx = cx0; cx <= qMin(cx1, cx0 + INDEX_SIZE - 1); ++cx)
+		for (int cy = cy0; cy <= qMin(cy1, cy0 + INDEX_SIZE - 1); ++cy)
+			cells.insert(wrap(cx, INDEX_SIZE) * INDEX_SIZE + wrap(cy, INDEX_SIZE));
+
+	for (QSet<int>::const_iterator it = cells.constBegin(); it != cells.constEnd(); ++it) {
+		CityIndex::const_iterator cell = placed.constFind(*it);
+		if ( cell == placed.constEnd() ) continue;
+		for (int i = 0; i < cell.value().size(); ++i)
+			cell.value().at(i)->draw(painter, startTile, viewport, zoom);
+	}
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -68,8 +120,25 @@ void CityLayer::draw(QPainter& painter, const QPointF& startTile,
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void CityLayer::addCity(City* city) {
 
-	if ( !_cities.contains(city) )
-		_cities.append(city);
+	if ( !city || _cities.contains(city) )
+		return;
+
+	qreal x, y;
+	if ( !coord2tile(city->geoPosition().y(), city->geoPosition().x(), 0, x, y) ) {
+		qDebug() << Q_FUNC_INFO << "invalid city coordinates:" << city->name();
+		return;
+	}
+
+	CityEntry entry;
+	entry.x = x;
+	entry.y = y;
+	entry.cell = qBound(0, static_cast<int>(x * INDEX_SIZE), INDEX_SIZE - 1) * INDEX_SIZE
+	        + qBound(0, static_cast<int>(y * INDEX_SIZE), INDEX_SIZE - 1);
+
+	_cities.insert(city, entry);
+	_names.insert(city->name(), city);
+
+	_layouts.clear();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -79,10 +148,9 @@ void CityLayer::addCity(City* city) {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void CityLayer::removeCity(const QString& name) {
 
-	int c = _cities.size();
-	for (int i = c - 1; i >= 0; --i)
-		if ( _cities.at(i)->name() == name )
-			removeCity(_cities.at(i));
+	const QList<City*> cities = _names.values(name);
+	for (int i = 0; i < cities.size(); ++i)
+		removeCity(cities.at(i));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -92,13 +160,135 @@ void CityLayer::removeCity(const QString& name) {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void CityLayer::removeCity(City* city) {
 
-	if ( !_cities.contains(city) ) {
+	CityEntries::iterator it = _cities.find(city);
+	if ( it == _cities.end() ) {
 		qDebug() << Q_FUNC_INFO << "city not in list:" << reinterpret_cast<quintptr>(city);
 		return;
 	}
 
+	_names.remove(city->name(), city);
+	_cities.erase(it);
+	_layouts.clear();
+
 	delete city;
-	_cities.removeOne(city);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CityLayer::removeCities() {
+
+	for (CityEntries::iterator it = _cities.begin(); it != _cities.end(); ++it)
+		delete it.key();
+
+	_cities.clear();
+	_names.clear();
+	_layouts.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CityLayer::setCitiesPerCell(const int& count) {
+	_citiesPerCell = qMax(1, count);
+	_layouts.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CityLayer::setCellSize(const int& size) {
+	_cellSize = qMax(1, size);
+	_layouts.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void CityLayer::invalidate() {
+	_layouts.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const CityLayer::CityIndex& CityLayer::layout(const int& zoom) {
+
+	QHash<int, CityIndex>::const_iterator cached = _layouts.constFind(zoom);
+	if ( cached != _layouts.constEnd() )
+		return cached.value();
+
+	CityIndex& placed = _layouts[zoom];
+	if ( _cities.isEmpty() )
+		return placed;
+
+	const qreal worldPixels = pow2[zoom] * TILE_SIZE;
+
+	QList<City*> candidates = _cities.keys();
+	std::stable_sort(candidates.begin(), candidates.end(), morePopulated);
+
+	//! Placed footprints are bucketed in a grid of LABEL_BUCKET pixels, a
+	//! footprint is only tested against the ones of the buckets it covers
+	QHash<qint64, QList<QRect> > buckets;
+	QHash<qint64, int> screenCells;
+
+	for (int i = 0; i < candidates.size(); ++i) {
+
+		City* city = candidates.at(i);
+		if ( !city->isVisible() )
+			continue;
+
+		const CityEntry& entry = _cities[city];
+		const QPointF coords(entry.x * worldPixels, entry.y * worldPixels);
+
+		const qint64 screenCell = (static_cast<qint64>(coords.x() / _cellSize) << 32)
+		        | static_cast<quint32>(coords.y() / _cellSize);
+		int& used = screenCells[screenCell];
+		if ( used >= _citiesPerCell )
+			continue;
+
+		QRect footprint = city->indicatorRect(coords);
+		if ( city->isPaintName() )
+			footprint = footprint.united(city->labelRect(coords));
+
+		const int bx0 = static_cast<int>(std::floor(qreal(footprint.left()) / LABEL_BUCKET));
+		const int bx1 = static_cast<int>(std::floor(qreal(footprint.right()) / LABEL_BUCKET));
+		const int by0 = static_cast<int>(std::floor(qreal(footprint.top()) / LABEL_BUCKET));
+		const int by1 = static_cast<int>(std::floor(qreal(footprint.bottom()) / LABEL_BUCKET));
+
+		bool collides = false;
+		for (int bx = bx0; bx <= bx1 && !collides; ++bx) {
+			for (int by = by0; by <= by1 && !collides; ++by) {
+				QHash<qint64, QList<QRect> >::const_iterator b =
+				    buckets.constFind(bucketKey(bx, by));
+				if ( b == buckets.constEnd() ) continue;
+				for (int j = 0; j < b.value().size() && !collides; ++j)
+					collides = b.value().at(j).intersects(footprint);
+			}
+		}
+
+		if ( collides )
+			continue;
+
+		++used;
+		for (int bx = bx0; bx <= bx1; ++bx)
+			for (int by = by0; by <= by1; ++by)
+				buckets[bucketKey(bx, by)].append(footprint);
+
+		placed[entry.cell].append(city);
+	}
+
+	return placed;
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -27,6 +27,10 @@
 #include <ipgp/gui/map/drawables/city.h>
 #include <vector>
 #include <QList>
+#include <QHash>
+#include <QMultiHash>
+#include <QRect>
+#include <QPointF>
 
 class QString;
 class QPainter;
@@ -40,6 +44,14 @@ namespace Map {
 /**
  * @class CityLayer
  * @brief Provides a layer in which cities can be painted.
+ * @note  Cities are stored with their normalized mercator position and the
+ *        cell of a 64x64 grid they fall in. Labels are placed once per zoom
+ *        level over the whole map: cities are greedily placed by population,
+ *        only the most populated ones of each cell of cellSize() pixels are
+ *        kept and a city whose label would overlap an already placed one is
+ *        culled, overlaps being looked for in a grid of the placed labels.
+ *        Layouts are cached by zoom level until the cities change, panning
+ *        only queries the visible grid cells of the layout.
  */
 class SC_IPGP_GUI_API CityLayer : public Layer {
 
@@ -65,18 +77,62 @@ class SC_IPGP_GUI_API CityLayer : public Layer {
 
 		void addCity(City*);
 		void removeCity(const QString&);
+		void removeCities();
+
+		int count() const {
+			return _cities.size();
+		}
+
+		//! Number of cities allowed in each screen cell
+		void setCitiesPerCell(const int&);
+		const int& citiesPerCell() const {
+			return _citiesPerCell;
+		}
+
+		//! Screen cell size in pixels
+		void setCellSize(const int&);
+		const int& cellSize() const {
+			return _cellSize;
+		}
+
+		//! Forces the layout to be computed again on next paint
+		void invalidate();
+
+	private:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		//! Normalized mercator position (zoom level 0) and index cell
+		struct CityEntry {
+				qreal x;
+				qreal y;
+				int cell;
+		};
+
+		typedef QHash<City*, CityEntry> CityEntries;
+		//! Cities by grid cell
+		typedef QHash<int, QList<City*> > CityIndex;
 
 	private:
 		// ------------------------------------------------------------------
 		//  Private interface
 		// ------------------------------------------------------------------
 		void removeCity(City* city);
+		//! @return the cities placed at a zoom level, by index cell
+		const CityIndex& layout(const int& zoom);
 
 	private:
 		// ------------------------------------------------------------------
 		//  Members
 		// ------------------------------------------------------------------
-		QList<City*> _cities;
+		CityEntries _cities;
+		QMultiHash<QString, City*> _names;
+
+		int _citiesPerCell;
+		int _cellSize;
+
+		//! Layouts by zoom level
+		QHash<int, CityIndex> _layouts;
 };
 
 } // namespace Map
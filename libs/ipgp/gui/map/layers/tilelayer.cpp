@@ -21,7 +21,7 @@
 #include <ipgp/gui/map/layers/tilelayer.h>
 #include <ipgp/gui/map/tile.h>
 #include <ipgp/gui/map/config.h>
-#include <QPixmap>
+#include <QImage>
 #include <QRect>
 #include <QPainter>
 #include <QPointF>
@@ -57,6 +57,8 @@ void TileLayer::draw(QPainter& painter, const QPointF& startTile,
 	if ( !isVisible() )
 		return;
 
+	updateArchive();
+
 	painter.save();
 
 	const int tilesHoriz = viewport.width() / TILE_SIZE + 2;
@@ -72,10 +74,10 @@ void TileLayer::draw(QPainter& painter, const QPointF& startTile,
 			    (static_cast<int>(startTile.y()) + j) % pow2[zoom],
 			    zoom, mapSettings().tilePath, mapSettings().tilePattern);
 
-			QPixmap tempImage;
-			if ( !tempImage.load(tile.path()) && mapSettings().paintDefaultBackground ) {
+			QImage tempImage;
+			if ( !loadTile(tempImage, tile) && mapSettings().paintDefaultBackground ) {
 
-				tempImage = QPixmap(TILE_SIZE, TILE_SIZE);
+				tempImage = QImage(TILE_SIZE, TILE_SIZE, QImage::Format_ARGB32_Premultiplied);
 				QPainter dummyPainter;
 				dummyPainter.begin(&tempImage);
 				dummyPainter.fillRect(0, 0, tempImage.width(), tempImage.height(),
@@ -93,7 +95,7 @@ void TileLayer::draw(QPainter& painter, const QPointF& startTile,
 
 			}
 
-			painter.drawPixmap(x, y, TILE_SIZE, TILE_SIZE, tempImage);
+			painter.drawImage(QRect(x, y, TILE_SIZE, TILE_SIZE), tempImage);
 
 			if ( mapSettings().showTileset ) {
 				painter.setPen(Qt::black);
@@ -117,6 +119,52 @@ void TileLayer::draw(QPainter& painter, const QPointF& startTile,
 
 
 
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TileLayer::updateArchive() {
+
+	//! Only probe the tile path when it changes, the archive stays mapped
+	//! for as long as the user doesn't switch to another map
+	if ( _archiveCheckedPath == mapSettings().tilePath )
+	    return;
+
+	_archiveCheckedPath = mapSettings().tilePath;
+
+	//! MapWidget appends a trailing slash to every map path
+	QString filename = _archiveCheckedPath;
+	while ( filename.endsWith('/') )
+		filename.chop(1);
+
+	if ( TileArchive::isArchive(filename) ) {
+		if ( !_archive.open(filename) )
+		    qDebug() << "Failed to open tile archive" << filename;
+	}
+	else
+		_archive.close();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TileLayer::loadTile(QImage& image, const Tile& tile) {
+
+	if ( !_archive.isOpen() )
+	    return image.load(tile.path());
+
+	const QByteArray data = _archive.tile(tile.z(), tile.x(), tile.y());
+	if ( data.isEmpty() )
+	    return false;
+
+	return image.loadFromData(reinterpret_cast<const uchar*>(data.constData()),
+	    data.size());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
 }// namespace Map
 } // namespace Gui
 } // namespace IPGP
@@ -24,9 +24,11 @@
 #include <ipgp/gui/defs.h>
 #include <ipgp/gui/api.h>
 #include <ipgp/gui/map/layer.h>
+#include <ipgp/gui/map/tilearchive.h>
 #include <QCache>
 
 class QString;
+class QImage;
 class QPainter;
 class QPointF;
 class QRect;
@@ -35,12 +37,19 @@ namespace IPGP {
 namespace Gui {
 namespace Map {
 
+class Tile;
+
 /**
  * @class TileLayer
  * @brief Provides a layer in which tiles can be painted.
  * @note  Tiles format has to be either '.jpg' or '.png' and a pattern string
  *        may be defined : %1 represents the zoomLevel, %2 the tile column and %3
  *        the tile line.
+ *        If the tile path points to a packed tile archive file (see
+ *        TileArchive) instead of a directory, tiles are read straight from
+ *        the memory-mapped archive.
+ *        Tiles are decoded into QImage so that the layer may also be painted
+ *        outside of the GUI thread (see SnapshotRenderer).
  */
 class SC_IPGP_GUI_API TileLayer : public Layer {
 
@@ -63,6 +72,24 @@ class SC_IPGP_GUI_API TileLayer : public Layer {
 		//  Public interface
 		// ------------------------------------------------------------------
 		virtual void draw(QPainter&, const QPointF&, const QRect&, const int&);
+
+		const TileArchive& archive() const {
+			return _archive;
+		}
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		void updateArchive();
+		bool loadTile(QImage&, const Tile&);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		TileArchive _archive;
+		QString _archiveCheckedPath;
 };
 
 } // namespace Map
@@ -0,0 +1,201 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <ipgp/gui/map/snapshotrenderer.h>
+#include <ipgp/gui/map/geometry.h>
+#include <ipgp/gui/map/util.h>
+#include <QPainter>
+#include <QRect>
+
+
+namespace IPGP {
+namespace Gui {
+namespace Map {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+SnapshotRenderer::SnapshotRenderer(const MapSettings& settings) {
+	setMapSettings(settings);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+SnapshotRenderer::~SnapshotRenderer() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SnapshotRenderer::setMapSettings(const MapSettings& settings) {
+
+	_settings = settings;
+	if ( _settings.tilePattern.isEmpty() )
+		_settings.tilePattern = _settings.defaultTilePattern;
+
+	_backgroundCanvas.setMapSettings(_settings);
+	_backgroundCanvas.updateSettings();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const MapSettings& SnapshotRenderer::mapSettings() const {
+	return _settings;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool SnapshotRenderer::addGeometry(Geometry* geometry) {
+	return _foregroundCanvas.addGeometry(geometry);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SnapshotRenderer::clearGeometries() {
+	_foregroundCanvas.clearGeometries();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QImage SnapshotRenderer::render(const QPointF& center, const int& zoom,
+                                const QSize& size) {
+
+	const int z = qBound(MIN_ZOOM, zoom, MAX_ZOOM);
+
+	qreal x, y;
+	if ( !coord2tile(center.y(), center.x(), z, x, y) || size.isEmpty() )
+		return QImage();
+
+	//! Same computation as MapWidget::centerOnTile(): the start tile is the
+	//! one lying in the top left corner of the viewport
+	x -= static_cast<qreal>(size.width()) / (TILE_SIZE * 2);
+	y -= static_cast<qreal>(size.height()) / (TILE_SIZE * 2);
+
+	if ( x > pow2[z] )
+		x -= pow2[z];
+	else if ( x < .0 )
+		x += pow2[z];
+
+	if ( y > pow2[z] )
+		y -= pow2[z];
+	else if ( y < .0 )
+		y += pow2[z];
+
+	const QPointF startTile(x, y);
+	const QRect viewport(QPoint(0, 0), size);
+
+	QImage image(size, QImage::Format_ARGB32_Premultiplied);
+	image.fill(_settings.defaultBackground.isValid() ?
+	        _settings.defaultBackground.rgba() : qRgba(255, 255, 255, 255));
+
+	QPainter painter(&image);
+	_backgroundCanvas.draw(painter, startTile, viewport, z);
+	_foregroundCanvas.draw(painter, startTile, viewport, z);
+	painter.end();
+
+	return image;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool SnapshotRenderer::renderToFile(const QPointF& center, const int& zoom,
+                                    const QSize& size, const QString& filepath) {
+
+	const QImage image = render(center, zoom, size);
+	if ( image.isNull() )
+		return false;
+
+	return image.save(filepath);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+SnapshotTask::SnapshotTask(const MapSettings& settings, const QPointF& center,
+                           const int& zoom, const QSize& size,
+                           const QString& filepath) :
+		_settings(settings), _center(center), _zoom(zoom), _size(size),
+		_filepath(filepath), _rendered(false) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+SnapshotTask::~SnapshotTask() {
+	qDeleteAll(_geometries);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SnapshotTask::addGeometry(Geometry* geometry) {
+	if ( geometry && !_geometries.contains(geometry) )
+		_geometries.append(geometry);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SnapshotTask::run() {
+
+	//! The renderer and its canvases belong to the worker thread
+	SnapshotRenderer renderer(_settings);
+
+	//! Rejected geometries are not owned by the canvas, release them here
+	for (int i = 0; i < _geometries.size(); ++i)
+		if ( !renderer.addGeometry(_geometries.at(i)) )
+		    delete _geometries.at(i);
+	_geometries.clear();
+
+	_rendered = renderer.renderToFile(_center, _zoom, _size, _filepath);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+} // namespace Map
+} // namespace Gui
+} // namespace IPGP
@@ -0,0 +1,166 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef __IPGP_GUI_MAP_SNAPSHOTRENDERER_H__
+#define __IPGP_GUI_MAP_SNAPSHOTRENDERER_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/map/config.h>
+#include <ipgp/gui/map/canvases/backgroundcanvas.h>
+#include <ipgp/gui/map/canvases/foregroundcanvas.h>
+#include <QImage>
+#include <QList>
+#include <QPointF>
+#include <QRunnable>
+#include <QSize>
+#include <QString>
+
+
+namespace IPGP {
+namespace Gui {
+namespace Map {
+
+class Geometry;
+
+/**
+ * @class   SnapshotRenderer
+ * @package IPGP::Gui::Map
+ * @brief   Headless map renderer.
+ *
+ * This class paints the same BackgroundCanvas (tiles, plates) and
+ * ForegroundCanvas (geometries) a MapWidget does, but into a QImage and
+ * without any widget. Tiles and markers are painted with QImage only, so
+ * a renderer may live and be used in any thread, as long as each thread
+ * uses its own instance.
+ * @note  MapWidget decorators (grid, scale...) are not painted. Pin,
+ *        Indicator and CrossSection drawables still rely on QPixmap and
+ *        should only be rendered from the GUI thread.
+ */
+class SC_IPGP_GUI_API SnapshotRenderer {
+
+	Q_CLASSINFO( "Author", "IPGP" )
+	Q_CLASSINFO( "Version", "1.0.0" )
+	Q_CLASSINFO( "URL", "www.ipgp.fr" )
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		explicit SnapshotRenderer(const MapSettings& settings = MapSettings());
+		~SnapshotRenderer();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		void setMapSettings(const MapSettings&);
+		const MapSettings& mapSettings() const;
+
+		/**
+		 * @brief Adds a geometry to the foreground canvas.
+		 * @note  The renderer takes ownership of the geometry.
+		 */
+		bool addGeometry(Geometry*);
+		void clearGeometries();
+
+		BackgroundCanvas& backgroundCanvas() {
+			return _backgroundCanvas;
+		}
+		ForegroundCanvas& foregroundCanvas() {
+			return _foregroundCanvas;
+		}
+
+		/**
+		 * @brief Renders the map into an image.
+		 * @param center the (longitude, latitude) point to center the map on
+		 * @param zoom the zoom level
+		 * @param size the image size
+		 * @return the rendered image, a null image if center is invalid
+		 */
+		QImage render(const QPointF& center, const int& zoom, const QSize& size);
+
+		bool renderToFile(const QPointF& center, const int& zoom,
+		                  const QSize& size, const QString& filepath);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		BackgroundCanvas _backgroundCanvas;
+		ForegroundCanvas _foregroundCanvas;
+		MapSettings _settings;
+};
+
+
+
+/**
+ * @class   SnapshotTask
+ * @package IPGP::Gui::Map
+ * @brief   Renders a map snapshot into a file from a QThreadPool worker.
+ *
+ * The task owns its geometries, which are handed to the SnapshotRenderer it
+ * creates inside the worker thread. Tasks may be started by hundreds on
+ * QThreadPool::globalInstance() to produce event maps in parallel.
+ */
+class SC_IPGP_GUI_API SnapshotTask : public QRunnable {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		SnapshotTask(const MapSettings& settings, const QPointF& center,
+		             const int& zoom, const QSize& size,
+		             const QString& filepath);
+		~SnapshotTask();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! The task takes ownership of the geometry
+		void addGeometry(Geometry*);
+
+		void run();
+
+		//! Whether run() managed to write the snapshot file
+		bool isRendered() const {
+			return _rendered;
+		}
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		MapSettings _settings;
+		QPointF _center;
+		int _zoom;
+		QSize _size;
+		QString _filepath;
+		QList<Geometry*> _geometries;
+		bool _rendered;
+};
+
+
+} // namespace Map
+} // namespace Gui
+} // namespace IPGP
+
+#endif
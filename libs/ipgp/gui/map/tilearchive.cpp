@@ -0,0 +1,522 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+#include <ipgp/gui/map/tilearchive.h>
+#include <QBuffer>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImage>
+#include <QMap>
+#include <QPainter>
+#include <QRegExp>
+#include <QSet>
+#include <QtEndian>
+#include <QVector>
+#include <cstring>
+
+
+namespace IPGP {
+namespace Gui {
+namespace Map {
+
+namespace {
+
+const char TILE_ARCHIVE_MAGIC[8] = { 'I', 'P', 'G', 'P', 'T', 'I', 'L', 'E' };
+const quint32 TILE_ARCHIVE_VERSION = 1;
+
+
+struct TileSource {
+		TileSource() :
+				format(TileArchive::PNG) {}
+		QString path;
+		QByteArray data;
+		quint32 format;
+};
+
+typedef QMap<quint64, TileSource> TileSources;
+
+
+inline quint64 tileKey(const quint64& z, const quint64& x, const quint64& y) {
+	return (z << 56) | (x << 28) | y;
+}
+
+inline quint32 keyZ(const quint64& key) {
+	return static_cast<quint32>(key >> 56);
+}
+
+inline quint32 keyX(const quint64& key) {
+	return static_cast<quint32>((key >> 28) & 0xFFFFFFF);
+}
+
+inline quint32 keyY(const quint64& key) {
+	return static_cast<quint32>(key & 0xFFFFFFF);
+}
+
+
+/**
+ * @brief Builds a regular expression matching tiles relative file paths
+ *        from a tile pattern, and stores the capture index of the zoom
+ *        level, column, line and file extension.
+ */
+QRegExp patternToRegExp(const QString& pattern, int captures[4]) {
+
+	captures[0] = captures[1] = captures[2] = captures[3] = -1;
+
+	QString rx;
+	int capture = 0;
+	for (int i = 0; i < pattern.size(); ++i) {
+		if ( pattern.at(i) == '%' && i + 1 < pattern.size()
+		        && pattern.at(i + 1) >= '1' && pattern.at(i + 1) <= '3' ) {
+			const int arg = pattern.at(i + 1).digitValue() - 1;
+			++capture;
+			if ( captures[arg] == -1 ) captures[arg] = capture;
+			rx += "(\\d+)";
+			++i;
+		}
+		else
+			rx += QRegExp::escape(pattern.at(i));
+	}
+	rx += "\\.(png|jpg)";
+	captures[3] = capture + 1;
+
+	return QRegExp(rx, Qt::CaseInsensitive);
+}
+
+
+QImage loadSource(const TileSource& source) {
+
+	QImage image;
+	if ( !source.data.isEmpty() )
+		image.loadFromData(source.data);
+	else
+		image.load(source.path);
+
+	return image;
+}
+
+
+//! @return false unless the whole buffer has been written
+bool writeAll(QFile& file, const char* data, const qint64& size) {
+
+	qint64 written = 0;
+	while ( written < size ) {
+		const qint64 n = file.write(data + written, size - written);
+		if ( n <= 0 )
+		    return false;
+		written += n;
+	}
+
+	return true;
+}
+
+}
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+TileArchive::TileArchive() :
+		_data(NULL), _size(0), _header(NULL), _entries(NULL) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+TileArchive::~TileArchive() {
+	close();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TileArchive::open(const QString& filename) {
+
+	close();
+
+	_file.setFileName(filename);
+	if ( !_file.open(QIODevice::ReadOnly) )
+	    return false;
+
+	_size = _file.size();
+	if ( _size < static_cast<qint64>(sizeof(Header)) ) {
+		close();
+		return false;
+	}
+
+	_data = _file.map(0, _size);
+	if ( !_data ) {
+		close();
+		return false;
+	}
+
+	_header = reinterpret_cast<const Header*>(_data);
+	if ( std::memcmp(_header->magic, TILE_ARCHIVE_MAGIC, sizeof(TILE_ARCHIVE_MAGIC)) != 0
+	        || qFromLittleEndian(_header->version) != TILE_ARCHIVE_VERSION ) {
+		close();
+		return false;
+	}
+
+	const qint64 indexSize = static_cast<qint64>(count()) * sizeof(Entry);
+	if ( static_cast<qint64>(sizeof(Header)) + indexSize > _size ) {
+		close();
+		return false;
+	}
+
+	_entries = reinterpret_cast<const Entry*>(_data + sizeof(Header));
+	_filename = filename;
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TileArchive::close() {
+
+	if ( _data )
+	    _file.unmap(_data);
+
+	if ( _file.isOpen() )
+	    _file.close();
+
+	_data = NULL;
+	_size = 0;
+	_header = NULL;
+	_entries = NULL;
+	_filename.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TileArchive::isOpen() const {
+	return _header != NULL;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const QString& TileArchive::filename() const {
+	return _filename;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+quint32 TileArchive::count() const {
+	return _header ? qFromLittleEndian(_header->count) : 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TileArchive::minZoom() const {
+	return _header ? static_cast<int>(qFromLittleEndian(_header->minZoom)) : MIN_ZOOM;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TileArchive::maxZoom() const {
+	return _header ? static_cast<int>(qFromLittleEndian(_header->maxZoom)) : MAX_ZOOM;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const TileArchive::Entry*
+TileArchive::find(const int& z, const int& x, const int& y) const {
+
+	if ( !_entries || z < 0 || x < 0 || y < 0 )
+	    return NULL;
+
+	const quint64 key = tileKey(z, x, y);
+
+	//! Entries are sorted by key, binary search it
+	quint32 low = 0;
+	quint32 high = count();
+	while ( low < high ) {
+
+		const quint32 mid = low + (high - low) / 2;
+		const Entry& e = _entries[mid];
+		const quint64 k = tileKey(qFromLittleEndian(e.z),
+		    qFromLittleEndian(e.x), qFromLittleEndian(e.y));
+
+		if ( k == key )
+		    return &e;
+		else if ( k < key )
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return NULL;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QByteArray TileArchive::tile(const int& z, const int& x, const int& y) const {
+
+	const Entry* e = find(z, x, y);
+	if ( !e )
+	    return QByteArray();
+
+	const quint64 offset = qFromLittleEndian(e->offset);
+	const quint64 length = qFromLittleEndian(e->length);
+	if ( offset + length > static_cast<quint64>(_size) )
+	    return QByteArray();
+
+	return QByteArray::fromRawData(reinterpret_cast<const char*>(_data + offset),
+	    static_cast<int>(length));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TileArchive::contains(const int& z, const int& x, const int& y) const {
+	return find(z, x, y) != NULL;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TileArchive::isArchive(const QString& filename) {
+
+	QFileInfo info(filename);
+	if ( !info.isFile() )
+	    return false;
+
+	QFile file(filename);
+	if ( !file.open(QIODevice::ReadOnly) )
+	    return false;
+
+	const QByteArray magic = file.read(sizeof(TILE_ARCHIVE_MAGIC));
+	return magic.size() == sizeof(TILE_ARCHIVE_MAGIC)
+	    && std::memcmp(magic.constData(), TILE_ARCHIVE_MAGIC, sizeof(TILE_ARCHIVE_MAGIC)) == 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TileArchive::pack(const QString& tileDir, const QString& pattern,
+                      const QString& filename, const int& minZoom,
+                      const int& maxZoom, const bool& generateMissing,
+                      QString* error) {
+
+	QDir dir(tileDir);
+	if ( !dir.exists() ) {
+		if ( error ) *error = QString("Tile directory %1 doesn't exist").arg(tileDir);
+		return -1;
+	}
+
+	int captures[4];
+	QRegExp rx = patternToRegExp(pattern.isEmpty() ?
+	        QString(DEFAULT_TILE_PATTERN.c_str()) : pattern, captures);
+	if ( captures[0] == -1 || captures[1] == -1 || captures[2] == -1 ) {
+		if ( error ) *error = QString("Invalid tile pattern %1").arg(pattern);
+		return -1;
+	}
+
+	//! Collect existing tiles
+	TileSources sources;
+	QDirIterator it(dir.absolutePath(), QDir::Files, QDirIterator::Subdirectories);
+	while ( it.hasNext() ) {
+
+		const QString path = it.next();
+		if ( !rx.exactMatch(dir.relativeFilePath(path)) )
+		    continue;
+
+		const int z = rx.cap(captures[0]).toInt();
+		const int x = rx.cap(captures[1]).toInt();
+		const int y = rx.cap(captures[2]).toInt();
+
+		if ( z < minZoom || z > maxZoom || z > MAX_ZOOM || x > TMXY[z] || y > TMXY[z] )
+		    continue;
+
+		TileSource src;
+		src.path = path;
+		src.format = (rx.cap(captures[3]).toLower() == "jpg") ? JPG : PNG;
+		sources.insert(tileKey(z, x, y), src);
+	}
+
+	if ( sources.isEmpty() ) {
+		if ( error ) *error = QString("No tile found in %1").arg(tileDir);
+		return -1;
+	}
+
+	//! Downsample missing lower zoom levels from their children, deepest
+	//! level first so that generated tiles can feed the next level.
+	if ( generateMissing ) {
+
+		for (int z = maxZoom - 1; z >= minZoom; --z) {
+
+			QSet<quint64> parents;
+			for (TileSources::const_iterator i = sources.lowerBound(tileKey(z + 1, 0, 0));
+			        i != sources.end() && keyZ(i.key()) == static_cast<quint32>(z + 1); ++i) {
+				const quint64 parent = tileKey(z, keyX(i.key()) / 2, keyY(i.key()) / 2);
+				if ( !sources.contains(parent) )
+				    parents.insert(parent);
+			}
+
+			for (QSet<quint64>::const_iterator p = parents.constBegin();
+			        p != parents.constEnd(); ++p) {
+
+				const quint32 px = keyX(*p);
+				const quint32 py = keyY(*p);
+
+				QImage canvas(TILE_SIZE * 2, TILE_SIZE * 2, QImage::Format_ARGB32_Premultiplied);
+				canvas.fill(0);
+
+				QPainter painter(&canvas);
+				for (int dx = 0; dx < 2; ++dx) {
+					for (int dy = 0; dy < 2; ++dy) {
+						TileSources::const_iterator c =
+						    sources.constFind(tileKey(z + 1, px * 2 + dx, py * 2 + dy));
+						if ( c == sources.constEnd() )
+						    continue;
+						painter.drawImage(dx * TILE_SIZE, dy * TILE_SIZE, loadSource(c.value()));
+					}
+				}
+				painter.end();
+
+				TileSource src;
+				QBuffer buffer(&src.data);
+				buffer.open(QIODevice::WriteOnly);
+				canvas.scaled(TILE_SIZE, TILE_SIZE, Qt::IgnoreAspectRatio,
+				    Qt::SmoothTransformation).save(&buffer, "PNG");
+				src.format = PNG;
+				sources.insert(*p, src);
+			}
+		}
+	}
+
+	//! Compute the index, tiles data are appended after it
+	QVector<Entry> index;
+	index.reserve(sources.size());
+	quint64 offset = sizeof(Header) + static_cast<quint64>(sources.size()) * sizeof(Entry);
+	quint32 lowestZoom = MAX_ZOOM, highestZoom = MIN_ZOOM;
+	for (TileSources::const_iterator i = sources.constBegin(); i != sources.constEnd(); ++i) {
+
+		const quint64 length = i.value().data.isEmpty() ?
+		        QFileInfo(i.value().path).size() : i.value().data.size();
+
+		Entry e;
+		e.z = qToLittleEndian(keyZ(i.key()));
+		e.x = qToLittleEndian(keyX(i.key()));
+		e.y = qToLittleEndian(keyY(i.key()));
+		e.format = qToLittleEndian(i.value().format);
+		e.offset = qToLittleEndian(offset);
+		e.length = qToLittleEndian(length);
+		index.append(e);
+
+		lowestZoom = qMin(lowestZoom, keyZ(i.key()));
+		highestZoom = qMax(highestZoom, keyZ(i.key()));
+		offset += length;
+	}
+
+	QFile file(filename);
+	if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+		if ( error ) *error = QString("Failed to open %1 for writing").arg(filename);
+		return -1;
+	}
+
+	Header header;
+	std::memcpy(header.magic, TILE_ARCHIVE_MAGIC, sizeof(TILE_ARCHIVE_MAGIC));
+	header.version = qToLittleEndian(TILE_ARCHIVE_VERSION);
+	header.count = qToLittleEndian(static_cast<quint32>(index.size()));
+	header.minZoom = qToLittleEndian(lowestZoom);
+	header.maxZoom = qToLittleEndian(highestZoom);
+
+	bool written = writeAll(file, reinterpret_cast<const char*>(&header), sizeof(Header))
+	        && writeAll(file, reinterpret_cast<const char*>(index.constData()),
+	            index.size() * sizeof(Entry));
+
+	for (TileSources::const_iterator i = sources.constBegin();
+	        written && i != sources.constEnd(); ++i) {
+
+		if ( !i.value().data.isEmpty() ) {
+			written = writeAll(file, i.value().data.constData(), i.value().data.size());
+			continue;
+		}
+
+		QFile tile(i.value().path);
+		if ( !tile.open(QIODevice::ReadOnly) ) {
+			if ( error ) *error = QString("Failed to read tile %1").arg(i.value().path);
+			file.close();
+			file.remove();
+			return -1;
+		}
+
+		//! The index already holds the tile length
+		const QByteArray data = tile.readAll();
+		written = (data.size() == QFileInfo(i.value().path).size())
+		        && writeAll(file, data.constData(), data.size());
+	}
+
+	if ( written )
+	    written = file.flush();
+
+	if ( !written ) {
+		if ( error ) *error = QString("Failed to write %1: %2").arg(filename)
+		        .arg(file.errorString());
+		file.close();
+		file.remove();
+		return -1;
+	}
+
+	file.close();
+
+	return index.size();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+} // namespace Map
+} // namespace Gui
+} // namespace IPGP
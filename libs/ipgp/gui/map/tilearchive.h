@@ -0,0 +1,164 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+
+#ifndef __IPGP_GUI_MAP_TILEARCHIVE_H__
+#define __IPGP_GUI_MAP_TILEARCHIVE_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/map/config.h>
+#include <QByteArray>
+#include <QString>
+#include <QFile>
+
+
+namespace IPGP {
+namespace Gui {
+namespace Map {
+
+
+/**
+ * @class TileArchive
+ * @brief This class provides a read-only access to a packed tile archive.
+ *        A packed archive stores every tile of a tile directory inside a
+ *        single file, which avoids hundreds of thousands of tiny files on
+ *        network mounted map directories.
+ * @note  The archive layout is the following (little-endian):
+ *        - header   : magic 'IPGPTILE', version, tile count, min/max zoom
+ *        - index    : one entry per tile {z, x, y, format, offset, length},
+ *                     sorted by zoom level, column and line
+ *        - payload  : the raw PNG/JPG tile images
+ *        The file is memory-mapped and tiles are handed out as QByteArray
+ *        referencing the mapped region (no copy).
+ */
+class SC_IPGP_GUI_API TileArchive {
+
+	Q_CLASSINFO( "Author", "IPGP" )
+	Q_CLASSINFO( "Version", "1.0.0" )
+	Q_CLASSINFO( "URL", "www.ipgp.fr" )
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		enum Format {
+			PNG = 0,
+			JPG = 1
+		};
+
+		struct Header {
+				char magic[8];
+				quint32 version;
+				quint32 count;
+				quint32 minZoom;
+				quint32 maxZoom;
+		};
+
+		struct Entry {
+				quint32 z;
+				quint32 x;
+				quint32 y;
+				quint32 format;
+				quint64 offset;
+				quint64 length;
+		};
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		TileArchive();
+		~TileArchive();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief Maps the archive file in memory and validates its header.
+		 * @param filename the archive file path
+		 * @return true on success, false otherwise
+		 */
+		bool open(const QString& filename);
+		void close();
+
+		bool isOpen() const;
+		const QString& filename() const;
+
+		quint32 count() const;
+		int minZoom() const;
+		int maxZoom() const;
+
+		/**
+		 * @brief Fetches a tile image data from the mapped archive.
+		 * @param z the zoom level
+		 * @param x the tile's column
+		 * @param y the tile's line
+		 * @return a QByteArray referencing the mapped data, or an empty array
+		 *         if the tile isn't in the archive.
+		 * @note  The returned array is only valid while the archive is open.
+		 */
+		QByteArray tile(const int& z, const int& x, const int& y) const;
+		bool contains(const int& z, const int& x, const int& y) const;
+
+		/**
+		 * @brief Packs a tile directory into a single archive file.
+		 * @param tileDir the tile directory
+		 * @param pattern the tile pattern (e.g. DEFAULT_TILE_PATTERN)
+		 * @param filename the archive file to write
+		 * @param minZoom the lowest zoom level to keep/generate
+		 * @param maxZoom the highest zoom level to keep
+		 * @param generateMissing downsample missing lower zoom levels tiles
+		 *        from their four children
+		 * @param error optional error message output
+		 * @return the number of packed tiles, -1 on failure
+		 */
+		static int pack(const QString& tileDir, const QString& pattern,
+		                const QString& filename, const int& minZoom = MIN_ZOOM,
+		                const int& maxZoom = MAX_ZOOM,
+		                const bool& generateMissing = true,
+		                QString* error = NULL);
+
+		static bool isArchive(const QString& filename);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		const Entry* find(const int& z, const int& x, const int& y) const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		QFile _file;
+		uchar* _data;
+		qint64 _size;
+		const Header* _header;
+		const Entry* _entries;
+		QString _filename;
+};
+
+
+} // namespace Map
+} // namespace Gui
+} // namespace IPGP
+
+#endif
@@ -0,0 +1,255 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/opengl/boundingvolumehierarchy.h>
+#include <algorithm>
+
+
+namespace {
+
+//! Orders primitives by the coordinate of their center along an axis
+struct CenterLess {
+		CenterLess(const GLfloat* c, const int& a) :
+				centers(c), axis(a) {}
+		bool operator()(const int& a, const int& b) const {
+			return centers[a * 3 + axis] < centers[b * 3 + axis];
+		}
+		const GLfloat* centers;
+		int axis;
+};
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BoundingVolumeHierarchy::BoundingVolumeHierarchy() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BoundingVolumeHierarchy::build(const BoxList& boxes) {
+
+	clear();
+
+	const int count = boxes.size();
+	if ( count == 0 )
+		return;
+
+	_primitives.resize(count);
+	_centers.resize(count * 3);
+	for (int i = 0; i < count; ++i) {
+		_primitives[i] = i;
+		for (int k = 0; k < 3; ++k)
+			_centers[i * 3 + k] = (boxes[i].min[k] + boxes[i].max[k]) * .5f;
+	}
+
+	//! A median split tree holds less than 2n / MaxLeafSize nodes
+	_nodes.reserve(2 * count / MaxLeafSize + 1);
+	buildNode(boxes, 0, count);
+
+	_centers.clear();
+	_nodes.squeeze();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void BoundingVolumeHierarchy::clear() {
+	_nodes.clear();
+	_primitives.clear();
+	_centers.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int BoundingVolumeHierarchy::buildNode(const BoxList& boxes, const int& first,
+                                       const int& count) {
+
+	const int index = _nodes.size();
+	_nodes.append(Node());
+
+	Box box = boxes[_primitives[first]];
+	GLfloat cmin[3], cmax[3];
+	for (int k = 0; k < 3; ++k)
+		cmin[k] = cmax[k] = _centers[_primitives[first] * 3 + k];
+
+	for (int i = first + 1; i < first + count; ++i) {
+		const Box& b = boxes[_primitives[i]];
+		const GLfloat* c = _centers.constData() + _primitives[i] * 3;
+		for (int k = 0; k < 3; ++k) {
+			box.min[k] = qMin(box.min[k], b.min[k]);
+			box.max[k] = qMax(box.max[k], b.max[k]);
+			cmin[k] = qMin(cmin[k], c[k]);
+			cmax[k] = qMax(cmax[k], c[k]);
+		}
+	}
+
+	_nodes[index].box = box;
+
+	int axis = 0;
+	for (int k = 1; k < 3; ++k)
+		if ( cmax[k] - cmin[k] > cmax[axis] - cmin[axis] )
+			axis = k;
+
+	//! Primitives sharing the same center can't be told apart
+	if ( count <= MaxLeafSize || cmax[axis] == cmin[axis] ) {
+		_nodes[index].right = -1;
+		_nodes[index].first = first;
+		_nodes[index].count = count;
+		return index;
+	}
+
+	const int half = count / 2;
+	int* primitives = _primitives.data();
+	std::nth_element(primitives + first, primitives + first + half,
+	    primitives + first + count, CenterLess(_centers.constData(), axis));
+
+	buildNode(boxes, first, half);
+	const int right = buildNode(boxes, first + half, count - half);
+
+	_nodes[index].right = right;
+	_nodes[index].first = first;
+	_nodes[index].count = 0;
+
+	return index;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int BoundingVolumeHierarchy::intersect(const Ray& ray, Visitor& visitor,
+                                       GLfloat& distance) const {
+
+	if ( _nodes.isEmpty() )
+		return -1;
+
+	GLfloat entry;
+	if ( !intersects(_nodes[0].box, ray, distance, entry) )
+		return -1;
+
+	int hit = -1;
+
+	//! Median splits keep the depth logarithmic, 64 levels are plenty
+	int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+
+	while ( top > 0 ) {
+
+		const Node& node = _nodes[stack[--top]];
+
+		//! The box may have been passed by a nearer hit in the meantime
+		if ( !intersects(node.box, ray, distance, entry) )
+			continue;
+
+		if ( node.isLeaf() ) {
+			for (int i = node.first; i < node.first + node.count; ++i)
+				if ( visitor.intersect(_primitives[i], ray, distance) )
+					hit = _primitives[i];
+			continue;
+		}
+
+		const int left = &node - _nodes.constData() + 1;
+		GLfloat leftEntry, rightEntry;
+		const bool hitLeft = intersects(_nodes[left].box, ray, distance, leftEntry);
+		const bool hitRight = intersects(_nodes[node.right].box, ray, distance, rightEntry);
+
+		//! Push the farthest child first so that the nearest is walked
+		//! first
+		if ( hitLeft && hitRight ) {
+			if ( leftEntry < rightEntry ) {
+				stack[top++] = node.right;
+				stack[top++] = left;
+			}
+			else {
+				stack[top++] = left;
+				stack[top++] = node.right;
+			}
+		}
+		else if ( hitLeft )
+			stack[top++] = left;
+		else if ( hitRight )
+			stack[top++] = node.right;
+	}
+
+	return hit;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool BoundingVolumeHierarchy::intersects(const Box& box, const Ray& ray,
+                                         const GLfloat& distance,
+                                         GLfloat& entry) {
+
+	GLfloat tmin = .0f;
+	GLfloat tmax = distance;
+
+	for (int k = 0; k < 3; ++k) {
+		if ( ray.direction[k] == .0f ) {
+			if ( ray.origin[k] < box.min[k] || ray.origin[k] > box.max[k] )
+				return false;
+			continue;
+		}
+
+		const GLfloat inverse = 1.f / ray.direction[k];
+		GLfloat t0 = (box.min[k] - ray.origin[k]) * inverse;
+		GLfloat t1 = (box.max[k] - ray.origin[k]) * inverse;
+		if ( t0 > t1 ) std::swap(t0, t1);
+
+		if ( t0 > tmin ) tmin = t0;
+		if ( t1 < tmax ) tmax = t1;
+		if ( tmin > tmax )
+			return false;
+	}
+
+	entry = tmin;
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
@@ -0,0 +1,159 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_OPENGL_DATAMODEL_BOUNDINGVOLUMEHIERARCHY_H__
+#define __IPGP_OPENGL_DATAMODEL_BOUNDINGVOLUMEHIERARCHY_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/opengl/gl.h>
+#include <ipgp/gui/opengl/camera.h>
+#include <QVector>
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+DEFINE_IPGP_SMARTPOINTER(BoundingVolumeHierarchy);
+/**
+ * @class   BoundingVolumeHierarchy
+ * @package IPGP::Gui::OpenGL
+ * @brief   Binary tree of axis aligned boxes for ray casting
+ *
+ * Primitives are only known by their index and bounding box: the tree is
+ * built by splitting them at the median of their centers along the widest
+ * axis until a handful remain per leaf. Ray casts walk the boxes front to
+ * back and hand the primitives whose box is hit to a Visitor, which does
+ * the exact test (triangles, spheres, ...), so that only a logarithmic
+ * fraction of the scene is ever looked at.
+ */
+class SC_IPGP_GUI_API BoundingVolumeHierarchy {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		struct Box {
+				GLfloat min[3];
+				GLfloat max[3];
+		};
+		typedef QVector<Box> BoxList;
+
+		struct Node {
+				Box box;
+				//! Index of the second child, the first one follows its parent
+				int right;
+				//! Range of the leaf's primitives, count is 0 for inner nodes
+				int first;
+				int count;
+
+				bool isLeaf() const {
+					return count > 0;
+				}
+		};
+		typedef QVector<Node> NodeList;
+
+		/**
+		 * @brief Exact intersection test of the primitives whose box the ray
+		 *        goes through.
+		 */
+		class Visitor {
+			public:
+				virtual ~Visitor() {}
+				/**
+				 * @param primitive the primitive index
+				 * @param ray the ray
+				 * @param distance the nearest hit so far, to be lowered
+				 * @return true if the primitive is hit nearer than distance
+				 */
+				virtual bool intersect(const int& primitive, const Ray& ray,
+				                       GLfloat& distance) = 0;
+		};
+
+		static const int MaxLeafSize = 4;
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		BoundingVolumeHierarchy();
+		~BoundingVolumeHierarchy();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! Builds the tree over the boxes, primitive i being boxes[i]
+		void build(const BoxList& boxes);
+		void clear();
+
+		bool isEmpty() const {
+			return _nodes.isEmpty();
+		}
+		const NodeList& nodes() const {
+			return _nodes;
+		}
+
+		/**
+		 * @brief Casts a ray through the tree.
+		 * @param ray the ray
+		 * @param visitor the exact test of the primitives
+		 * @param distance the farthest distance considered, set to the
+		 *        distance of the nearest hit
+		 * @return the nearest primitive hit, -1 if none
+		 */
+		int intersect(const Ray& ray, Visitor& visitor, GLfloat& distance) const;
+
+		/**
+		 * @brief Slab test of a box.
+		 * @param box the box
+		 * @param ray the ray
+		 * @param distance the farthest distance considered
+		 * @param entry the distance at which the ray enters the box
+		 * @return true if the box is hit before distance
+		 */
+		static bool intersects(const Box& box, const Ray& ray,
+		                       const GLfloat& distance, GLfloat& entry);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		int buildNode(const BoxList& boxes, const int& first, const int& count);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		NodeList _nodes;
+		//! Primitives indices, leaves reference ranges of it
+		QVector<int> _primitives;
+		//! Centers of the primitives boxes, while building
+		QVector<GLfloat> _centers;
+};
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
+
+#endif
@@ -35,6 +35,80 @@
 #define POW2(a)		((a)*(a))
 
 
+namespace {
+
+/**
+ * @brief Inverts a column major 4x4 matrix by cofactors.
+ * @return false if the matrix is singular
+ */
+bool invertMatrix(const GLfloat m[16], GLfloat out[16]) {
+
+	double inv[16];
+
+	inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15]
+	        + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+	inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15]
+	        - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+	inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15]
+	        + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+	inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14]
+	        - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+	inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15]
+	        - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+	inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15]
+	        + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+	inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15]
+	        - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+	inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14]
+	        + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+	inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15]
+	        + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+	inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15]
+	        - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+	inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15]
+	        + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+	inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14]
+	        - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+	inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11]
+	        - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+	inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11]
+	        + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+	inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11]
+	        - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+	inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10]
+	        + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+	const double det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+	if ( det == .0 )
+		return false;
+
+	for (int i = 0; i < 16; ++i)
+		out[i] = static_cast<GLfloat>(inv[i] / det);
+
+	return true;
+}
+
+
+//! Transforms a point by a column major matrix, with perspective division
+bool transformPoint(const GLfloat m[16], const GLfloat in[4], GLfloat out[3]) {
+
+	GLfloat r[4];
+	for (int row = 0; row < 4; ++row)
+		r[row] = m[row] * in[0] + m[4 + row] * in[1] + m[8 + row] * in[2]
+		        + m[12 + row] * in[3];
+
+	if ( r[3] == .0 )
+		return false;
+
+	for (int i = 0; i < 3; ++i)
+		out[i] = r[i] / r[3];
+
+	return true;
+}
+
+}
+
+
 namespace IPGP {
 namespace Gui {
 namespace OpenGL {
@@ -623,6 +697,127 @@ bool Camera::getRun() const {
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+Frustum::Frustum() :
+		_invertible(false), _pixelScale(1.) {
+	for (int i = 0; i < 4; ++i)
+		_viewport[i] = 0;
+	for (int i = 0; i < 16; ++i)
+		_inverse[i] = .0;
+	for (int i = 0; i < 6; ++i)
+		for (int j = 0; j < 4; ++j)
+			_planes[i][j] = .0;
+	_eye[0] = _eye[1] = _eye[2] = .0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+Frustum::~Frustum() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void Frustum::update() {
+
+	//! OpenGL matrices are column major: m[col * 4 + row]
+	GLfloat p[16], m[16], c[16];
+	glGetFloatv(GL_PROJECTION_MATRIX, p);
+	glGetFloatv(GL_MODELVIEW_MATRIX, m);
+	glGetIntegerv(GL_VIEWPORT, _viewport);
+
+	for (int col = 0; col < 4; ++col)
+		for (int row = 0; row < 4; ++row) {
+			c[col * 4 + row] = .0;
+			for (int k = 0; k < 4; ++k)
+				c[col * 4 + row] += p[k * 4 + row] * m[col * 4 + k];
+		}
+
+	//! Gribb & Hartmann: planes are sums/differences of the 4th row and
+	//! the other ones (left, right, bottom, top, near, far)
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 4; ++j) {
+			_planes[i * 2][j] = c[j * 4 + 3] + c[j * 4 + i];
+			_planes[i * 2 + 1][j] = c[j * 4 + 3] - c[j * 4 + i];
+		}
+
+	for (int i = 0; i < 6; ++i) {
+		const GLfloat l = sqrt(POW2(_planes[i][0]) + POW2(_planes[i][1]) + POW2(_planes[i][2]));
+		if ( l > .0 )
+			for (int j = 0; j < 4; ++j)
+				_planes[i][j] /= l;
+	}
+
+	//! The eye is the inverse translation through the (orthonormal)
+	//! rotation part of the modelview matrix: -R^t.t
+	for (int i = 0; i < 3; ++i)
+		_eye[i] = -(m[i * 4] * m[12] + m[i * 4 + 1] * m[13] + m[i * 4 + 2] * m[14]);
+
+	//! p[5] is cot(fov / 2) for perspective projections
+	_pixelScale = _viewport[3] * p[5] / 2.;
+
+	_invertible = invertMatrix(c, _inverse);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool Frustum::intersects(const GLfloat min[3], const GLfloat max[3]) const {
+
+	for (int i = 0; i < 6; ++i) {
+		//! Test the box corner lying the furthest along the plane normal
+		const GLfloat x = (_planes[i][0] >= 0) ? max[0] : min[0];
+		const GLfloat y = (_planes[i][1] >= 0) ? max[1] : min[1];
+		const GLfloat z = (_planes[i][2] >= 0) ? max[2] : min[2];
+		if ( _planes[i][0] * x + _planes[i][1] * y + _planes[i][2] * z + _planes[i][3] < 0 )
+			return false;
+	}
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool Frustum::ray(const GLfloat& x, const GLfloat& y, Ray& ray) const {
+
+	if ( !_invertible || _viewport[2] <= 0 || _viewport[3] <= 0 )
+		return false;
+
+	//! Widget rows go downward, the viewport's ones upward
+	const GLfloat nx = 2. * (x - _viewport[0]) / _viewport[2] - 1.;
+	const GLfloat ny = 1. - 2. * (y - _viewport[1]) / _viewport[3];
+
+	const GLfloat nearPoint[4] = { nx, ny, -1., 1. };
+	const GLfloat farPoint[4] = { nx, ny, 1., 1. };
+	GLfloat a[3], b[3];
+	if ( !transformPoint(_inverse, nearPoint, a) || !transformPoint(_inverse, farPoint, b) )
+		return false;
+
+	const GLfloat l = sqrt(POW2(b[0] - a[0]) + POW2(b[1] - a[1]) + POW2(b[2] - a[2]));
+	if ( l == .0 )
+		return false;
+
+	for (int i = 0; i < 3; ++i) {
+		ray.origin[i] = a[i];
+		ray.direction[i] = (b[i] - a[i]) / l;
+	}
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
 }// namespace OpenGL
 } // namespace Gui
 } // namespace IPGP
@@ -38,6 +38,91 @@ namespace IPGP {
 namespace Gui {
 namespace OpenGL {
 
+/**
+ * @brief Half line cast from the eye through a point of the viewport, in
+ *        world coordinates (those of the modelview matrix).
+ */
+struct Ray {
+		GLfloat origin[3];
+		//! Unit length direction
+		GLfloat direction[3];
+
+		//! Point at the distance t from the origin
+		void at(const GLfloat& t, GLfloat point[3]) const {
+			for (int i = 0; i < 3; ++i)
+				point[i] = origin[i] + direction[i] * t;
+		}
+};
+
+
+DEFINE_IPGP_SMARTPOINTER(Frustum);
+/**
+ * @class   Frustum
+ * @package IPGP::Gui
+ * @brief   Viewing volume of the current OpenGL transformations
+ *
+ * The six clipping planes are extracted from the product of the projection
+ * and modelview matrices, as they are set when update() is called.
+ */
+class SC_IPGP_GUI_API Frustum {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		Frustum();
+		~Frustum();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! Reads back the current matrices and viewport
+		void update();
+
+		//! @return false if the axis aligned box lies outside the volume
+		bool intersects(const GLfloat min[3], const GLfloat max[3]) const;
+
+		/**
+		 * @brief Size in pixels of a world unit seen from a unit distance,
+		 *        the projected size of an object is roughly its size times
+		 *        this scale divided by its distance from the eye.
+		 */
+		const GLfloat& pixelScale() const {
+			return _pixelScale;
+		}
+
+		//! Position of the eye in world coordinates
+		const GLfloat* eye() const {
+			return _eye;
+		}
+
+		/**
+		 * @brief Unprojects a widget position through the matrices read
+		 *        by the last update(), so that mouse events received
+		 *        between two frames can be related to what is displayed.
+		 * @param x the horizontal position, from the left of the widget
+		 * @param y the vertical position, from the top of the widget
+		 * @param ray the ray going from the near plane through the point
+		 * @return false if the matrices can't be inverted (no frame yet)
+		 */
+		bool ray(const GLfloat& x, const GLfloat& y, Ray& ray) const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		//! Inverse of the projection x modelview matrix
+		GLfloat _inverse[16];
+		bool _invertible;
+		GLint _viewport[4];
+		GLfloat _planes[6][4];
+		GLfloat _eye[3];
+		GLfloat _pixelScale;
+};
+
+
+
 DEFINE_IPGP_SMARTPOINTER(Camera);
 /**
  * @class   Camera
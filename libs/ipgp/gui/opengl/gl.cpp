@@ -26,6 +26,7 @@
 #include <QDebug>
 #include <QString>
 #include <QColor>
+#include <QVector>
 #include <math.h>
 
 
@@ -43,6 +44,44 @@ namespace Gui {
 namespace OpenGL {
 namespace GL {
 
+namespace {
+
+/**
+ * @brief Sphere of radius 1 tessellated once by latitude and longitude,
+ *        in OpenGL coordinates (poles along the Y axis like vertex() does
+ *        with the Z axis).
+ */
+struct UnitSphere {
+		UnitSphere(const int& lats, const int& longs) {
+			vertices.reserve((lats + 1) * (longs + 1) * 3);
+			for (int i = 0; i <= lats; ++i) {
+				const double lat = PI * (-.5 + (double) i / lats);
+				for (int j = 0; j <= longs; ++j) {
+					const double lng = 2 * PI * (double) j / longs;
+					vertices << cos(lng) * cos(lat) << sin(lat) << -sin(lng) * cos(lat);
+				}
+			}
+			indices.reserve(lats * longs * 6);
+			for (int i = 0; i < lats; ++i)
+				for (int j = 0; j < longs; ++j) {
+					const GLuint a = i * (longs + 1) + j;
+					const GLuint b = a + longs + 1;
+					indices << a << b << b + 1 << a << b + 1 << a + 1;
+				}
+		}
+		QVector<GLfloat> vertices;
+		QVector<GLuint> indices;
+};
+
+
+const UnitSphere& unitSphere(const bool& coarse) {
+	static const UnitSphere fine(20, 20);
+	static const UnitSphere light(8, 12);
+	return coarse ? light : fine;
+}
+
+}
+
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void normal(const GLfloat& x, const GLfloat& y, const GLfloat& z) {
@@ -101,6 +140,22 @@ void translate(const GLfloat& x, const GLfloat& y, const GLfloat& z) {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void swapAxes() {
+	//! Column-major (x,y,z) -> (x,z,-y)
+	static const GLfloat m[16] = {
+		1., .0, .0, .0,
+		.0, .0, -1., .0,
+		.0, 1., .0, .0,
+		.0, .0, .0, 1.
+	};
+	glMultMatrixf(m);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void rotate(const GLfloat& x, const GLfloat& y, const GLfloat& z) {
 	glRotatef(x, 1, 0, 0);
@@ -164,19 +219,18 @@ GLenum checkError(const QString& file, const int& line) {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void useVBO(bool enable) {
+void useVBO(bool enable, bool textured) {
 
 	if ( enable ) {
 		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
 		glEnableClientState(GL_NORMAL_ARRAY);
-		glEnableClientState(GL_INDEX_ARRAY);
+		if ( textured )
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 	}
 	else {
 		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_COLOR_ARRAY);
 		glDisableClientState(GL_NORMAL_ARRAY);
-		glDisableClientState(GL_INDEX_ARRAY);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 	}
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
@@ -255,37 +309,23 @@ void cone(const GLfloat& x, const GLfloat& y, const GLfloat& z,
 void drawSphere(GLfloat r, const GLfloat& x, const GLfloat& y, const GLfloat& z,
                 const QColor& color) {
 
-	int lats = 20;
-	int longs = 20;
 	if ( r == .0 )
 		r = .001;
 
+	const UnitSphere& sphere = unitSphere(false);
+
 	glPushMatrix();
 	translate(x, y, z);
 	glColor3f(color.redF(), color.greenF(), color.blueF());
 
-	for (int i = 0; i <= lats; ++i) {
-		double lat0 = M_PI * (-.5 + (double) (i - 1) / lats);
-		double z0 = sin(lat0);
-		double zr0 = cos(lat0);
-
-		double lat1 = M_PI * (-.5 + (double) i / lats);
-		double z1 = sin(lat1);
-		double zr1 = cos(lat1);
-
-		glBegin(GL_QUAD_STRIP);
-		for (int j = 0; j <= longs; ++j) {
-			double lng = 2 * M_PI * (double) (j - 1) / longs;
-			double xv = cos(lng);
-			double yv = sin(lng);
-
-			normal(xv * zr0, yv * zr0, z0);
-			vertex(xv * zr0 * r, yv * zr0 * r, z0 * r);
-			normal(xv * zr1, yv * zr1, z1);
-			vertex(xv * zr1 * r, yv * zr1 * r, z1 * r);
-		}
-		glEnd();
+	glBegin(GL_TRIANGLES);
+	for (int i = 0; i < sphere.indices.size(); ++i) {
+		const GLfloat* n = sphere.vertices.constData() + sphere.indices[i] * 3;
+		glNormal3fv(n);
+		glVertex3f(n[0] * r, n[1] * r, n[2] * r);
 	}
+	glEnd();
+
 	glPopMatrix();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
@@ -293,6 +333,28 @@ void drawSphere(GLfloat r, const GLfloat& x, const GLfloat& y, const GLfloat& z,
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void drawUnitSphere(const bool& coarse) {
+
+	const UnitSphere& sphere = unitSphere(coarse);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+
+	//! On a unit sphere, vertices are their own normals
+	glVertexPointer(3, GL_FLOAT, 0, sphere.vertices.constData());
+	glNormalPointer(GL_FLOAT, 0, sphere.vertices.constData());
+	glDrawElements(GL_TRIANGLES, sphere.indices.size(), GL_UNSIGNED_INT,
+	    sphere.indices.constData());
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void circle(const GLfloat& cx, const GLfloat& cy, const GLfloat& r,
             const int& num_segments) {
@@ -59,6 +59,14 @@ void vertex(const Vertex& vec);
 void vertex(const GLfloat& th2, const GLfloat& ph2);
 
 void translate(const GLfloat& x, const GLfloat& y, const GLfloat& z);
+
+/**
+ * @brief Multiplies the current matrix by the axes swap vertex(), normal()
+ *        and translate() apply, so that geometry stored as (x,y,z) arrays
+ *        (e.g. buffer objects) lands where those calls would have put it.
+ */
+void swapAxes();
+
 void rotate(const GLfloat& x, const GLfloat& y, const GLfloat& z);
 void scale(const GLfloat& x, const GLfloat& y, const GLfloat& z);
 
@@ -67,7 +75,11 @@ void color(const Vertex& vec, const GLfloat& a = 1.);
 
 GLenum checkError(const QString& file, const int& line);
 
-void useVBO(bool enable);
+/**
+ * @brief Toggles the client states used by vertex arrays/buffer objects:
+ *        vertices, normals and, optionally, texture coordinates.
+ */
+void useVBO(bool enable, bool textured = false);
 
 enum Direction {
 	UP, DOWN, LEFT, RIGHT, TOFRONT, TOBACK
@@ -88,6 +100,15 @@ void cone(const GLfloat& x, const GLfloat& y, const GLfloat& z,
 void drawSphere(GLfloat radius, const GLfloat& x, const GLfloat& y,
                 const GLfloat& z, const QColor& color = Qt::white);
 
+/**
+ * @brief Draws a sphere of radius 1 centered on the origin out of vertex
+ *        arrays tessellated once. Meant to be positioned and scaled by the
+ *        caller, with GL_NORMALIZE enabled for the lighting.
+ * @param coarse use a lighter tessellation (8x12 instead of 20x20), for
+ *        large amounts of spheres
+ */
+void drawUnitSphere(const bool& coarse = false);
+
 
 
 void circle(const GLfloat& cx, const GLfloat& cy, const GLfloat& r, const int& num_segments);
@@ -0,0 +1,319 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/opengl/mesh.h>
+#include <QHash>
+#include <math.h>
+#include <string.h>
+
+
+namespace {
+
+//! Spreads the cell coordinates over the key space, collisions are fine
+//! since candidates are compared by distance anyway
+inline quint64 cellKey(const qint64& x, const qint64& y, const qint64& z) {
+	return (static_cast<quint64>(x) * Q_UINT64_C(73856093))
+	        ^ (static_cast<quint64>(y) * Q_UINT64_C(19349663))
+	        ^ (static_cast<quint64>(z) * Q_UINT64_C(83492791));
+}
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+const float Mesh::DefaultTolerance = 1e-6f;
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+Mesh::Mesh() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+Mesh::~Mesh() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void Mesh::weld(const GLfloat* positions, const int& facets,
+                const GLfloat& tolerance) {
+
+	clear();
+
+	if ( !positions || facets <= 0 )
+		return;
+
+	//! Cells are twice as large as the tolerance so that the neighbourhood
+	//! of a vertex never spans more than two cells per axis
+	const double cellSize = 2. * qMax(tolerance, 1e-12f);
+	const double squaredTolerance = static_cast<double>(tolerance) * tolerance;
+
+	QHash<quint64, int> heads;
+	heads.reserve(facets * 3 / 2);
+
+	//! Vertices sharing a key are chained through this array
+	QVector<int> next;
+	next.reserve(facets * 3 / 2);
+	_vertices.reserve(facets * 3 / 2 * 3);
+	_indices.reserve(facets * 3);
+
+	for (int f = 0; f < facets; ++f) {
+
+		GLuint corner[3];
+		for (int c = 0; c < 3; ++c) {
+
+			const GLfloat* p = positions + f * 9 + c * 3;
+
+			qint64 lo[3], hi[3], cell[3];
+			for (int a = 0; a < 3; ++a) {
+				const double u = p[a] / cellSize;
+				cell[a] = static_cast<qint64>(floor(u));
+				const double offset = (u - cell[a]) * cellSize;
+				lo[a] = (offset < tolerance) ? cell[a] - 1 : cell[a];
+				hi[a] = (cellSize - offset < tolerance) ? cell[a] + 1 : cell[a];
+			}
+
+			int found = -1;
+			for (qint64 x = lo[0]; x <= hi[0] && found < 0; ++x)
+				for (qint64 y = lo[1]; y <= hi[1] && found < 0; ++y)
+					for (qint64 z = lo[2]; z <= hi[2] && found < 0; ++z) {
+						QHash<quint64, int>::const_iterator it = heads.constFind(cellKey(x, y, z));
+						if ( it == heads.constEnd() ) continue;
+						for (int i = it.value(); i >= 0; i = next[i]) {
+							const GLfloat* v = _vertices.constData() + i * 3;
+							const double dx = v[0] - p[0];
+							const double dy = v[1] - p[1];
+							const double dz = v[2] - p[2];
+							if ( dx * dx + dy * dy + dz * dz <= squaredTolerance ) {
+								found = i;
+								break;
+							}
+						}
+					}
+
+			if ( found < 0 ) {
+				found = vertexCount();
+				_vertices << p[0] << p[1] << p[2];
+				const quint64 key = cellKey(cell[0], cell[1], cell[2]);
+				next << heads.value(key, -1);
+				heads.insert(key, found);
+			}
+
+			corner[c] = static_cast<GLuint>(found);
+		}
+
+		if ( corner[0] == corner[1] || corner[1] == corner[2] || corner[0] == corner[2] )
+			continue;
+
+		_indices << corner[0] << corner[1] << corner[2];
+	}
+
+	_vertices.squeeze();
+	_indices.squeeze();
+
+	computeNormals();
+	computeTexCoords();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void Mesh::setPoints(const GLfloat* positions, const int& count) {
+
+	clear();
+
+	if ( !positions || count <= 0 )
+		return;
+
+	_vertices.resize(count * 3);
+	memcpy(_vertices.data(), positions, count * 3 * sizeof(GLfloat));
+
+	//! Points have no surface, face them up
+	_normals.resize(count * 3);
+	GLfloat* n = _normals.data();
+	for (int i = 0; i < count; ++i, n += 3) {
+		n[0] = n[1] = .0f;
+		n[2] = 1.f;
+	}
+
+	computeTexCoords();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void Mesh::setGrid(const GLfloat* positions, const int& columns,
+                   const int& rows) {
+
+	clear();
+
+	if ( !positions || columns < 2 || rows < 2 )
+		return;
+
+	const int count = columns * rows;
+	_vertices.resize(count * 3);
+	memcpy(_vertices.data(), positions, count * 3 * sizeof(GLfloat));
+
+	//! Depending on the order of the grid, cells have to be walked one
+	//! way or the other for the facets to face up
+	const GLfloat* v = _vertices.constData();
+	const GLfloat* right = v + 3;
+	const GLfloat* below = v + columns * 3;
+	const bool flip = (right[0] - v[0]) * (below[1] - v[1])
+	        - (right[1] - v[1]) * (below[0] - v[0]) < .0f;
+
+	_indices.resize((columns - 1) * (rows - 1) * 6);
+	GLuint* index = _indices.data();
+	for (int r = 0; r < rows - 1; ++r) {
+		for (int c = 0; c < columns - 1; ++c) {
+			const GLuint a = r * columns + c;
+			const GLuint b = a + columns;
+			if ( flip ) {
+				*index++ = a; *index++ = b; *index++ = a + 1;
+				*index++ = a + 1; *index++ = b; *index++ = b + 1;
+			}
+			else {
+				*index++ = a; *index++ = a + 1; *index++ = b;
+				*index++ = a + 1; *index++ = b + 1; *index++ = b;
+			}
+		}
+	}
+
+	computeNormals();
+	computeTexCoords();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void Mesh::setData(const FloatBuffer& vertices, const FloatBuffer& normals,
+                   const FloatBuffer& texCoords, const IndexBuffer& indices) {
+	_vertices = vertices;
+	_normals = normals;
+	_texCoords = texCoords;
+	_indices = indices;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void Mesh::clear() {
+	_vertices.clear();
+	_normals.clear();
+	_texCoords.clear();
+	_indices.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void Mesh::computeNormals() {
+
+	_normals.fill(.0f, _vertices.size());
+
+	const GLfloat* v = _vertices.constData();
+	GLfloat* n = _normals.data();
+
+	for (int i = 0; i < _indices.size(); i += 3) {
+
+		const GLuint a = _indices[i] * 3;
+		const GLuint b = _indices[i + 1] * 3;
+		const GLuint c = _indices[i + 2] * 3;
+
+		const GLfloat ux = v[b] - v[a], uy = v[b + 1] - v[a + 1], uz = v[b + 2] - v[a + 2];
+		const GLfloat wx = v[c] - v[a], wy = v[c + 1] - v[a + 1], wz = v[c + 2] - v[a + 2];
+
+		//! The cross product's length is twice the facet's area
+		const GLfloat nx = uy * wz - uz * wy;
+		const GLfloat ny = uz * wx - ux * wz;
+		const GLfloat nz = ux * wy - uy * wx;
+
+		n[a] += nx; n[a + 1] += ny; n[a + 2] += nz;
+		n[b] += nx; n[b + 1] += ny; n[b + 2] += nz;
+		n[c] += nx; n[c + 1] += ny; n[c + 2] += nz;
+	}
+
+	for (int i = 0; i < _normals.size(); i += 3) {
+		const GLfloat l = sqrt(n[i] * n[i] + n[i + 1] * n[i + 1] + n[i + 2] * n[i + 2]);
+		if ( l > .0f ) {
+			n[i] /= l;
+			n[i + 1] /= l;
+			n[i + 2] /= l;
+		}
+		else {
+			n[i] = n[i + 1] = .0f;
+			n[i + 2] = 1.f;
+		}
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void Mesh::computeTexCoords() {
+
+	const int count = vertexCount();
+	_texCoords.resize(count * 2);
+	if ( count == 0 ) return;
+
+	const GLfloat* v = _vertices.constData();
+	GLfloat minX = v[0], maxX = v[0], minY = v[1], maxY = v[1];
+	for (int i = 1; i < count; ++i) {
+		minX = qMin(minX, v[i * 3]);
+		maxX = qMax(maxX, v[i * 3]);
+		minY = qMin(minY, v[i * 3 + 1]);
+		maxY = qMax(maxY, v[i * 3 + 1]);
+	}
+
+	const GLfloat dx = (maxX > minX) ? maxX - minX : 1.f;
+	const GLfloat dy = (maxY > minY) ? maxY - minY : 1.f;
+
+	GLfloat* t = _texCoords.data();
+	for (int i = 0; i < count; ++i, t += 2) {
+		t[0] = (v[i * 3] - minX) / dx;
+		t[1] = (v[i * 3 + 1] - minY) / dy;
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
@@ -0,0 +1,158 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_OPENGL_DATAMODEL_MESH_H__
+#define __IPGP_OPENGL_DATAMODEL_MESH_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/opengl/gl.h>
+#include <QVector>
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+DEFINE_IPGP_SMARTPOINTER(Mesh);
+/**
+ * @class   Mesh
+ * @package IPGP::Gui::OpenGL
+ * @brief   Indexed triangle mesh
+ *
+ * Stores unique vertices (x,y,z triplets) along with their normals and
+ * texture coordinates, and the triangles as triplets of indices in the
+ * vertices array. Every rendering mode (points, wireframe, filled) can be
+ * drawn from the same buffers.
+ *
+ * Meshes are built out of triangles soups (three vertices per facet, like
+ * STL files provide) by welding the vertices lying within a tolerance of
+ * each other. Candidates are looked up in a spatial hash, which keeps the
+ * welding linear in the number of vertices.
+ * Gridded points (like most XYZ files provide) are triangulated straight
+ * from their layout.
+ */
+class SC_IPGP_GUI_API Mesh {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		typedef QVector<GLfloat> FloatBuffer;
+		typedef QVector<GLuint> IndexBuffer;
+
+		static const float DefaultTolerance;
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		Mesh();
+		~Mesh();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief Builds the mesh out of a triangles soup.
+		 * @param positions the x,y,z triplets, three per facet
+		 * @param facets the number of facets
+		 * @param tolerance the distance under which vertices are merged
+		 * @note  Facets collapsing once welded are dropped
+		 */
+		void weld(const GLfloat* positions, const int& facets,
+		          const GLfloat& tolerance = DefaultTolerance);
+
+		/**
+		 * @brief Builds a mesh made of vertices only (points cloud).
+		 * @param positions the x,y,z triplets
+		 * @param count the number of points
+		 */
+		void setPoints(const GLfloat* positions, const int& count);
+
+		/**
+		 * @brief Builds the surface of points sampled on a regular grid
+		 *        (heightfield). Neighbours are implied by the layout, so
+		 *        the triangles are laid out row after row, two per cell,
+		 *        without any lookup.
+		 * @param positions the x,y,z triplets, columns per row, rows after
+		 *        rows
+		 * @param columns the number of points per row
+		 * @param rows the number of rows
+		 */
+		void setGrid(const GLfloat* positions, const int& columns,
+		             const int& rows);
+
+		//! Takes over already built buffers (implicitly shared)
+		void setData(const FloatBuffer& vertices, const FloatBuffer& normals,
+		             const FloatBuffer& texCoords, const IndexBuffer& indices);
+
+		void clear();
+
+		bool isEmpty() const {
+			return _vertices.isEmpty();
+		}
+		int vertexCount() const {
+			return _vertices.size() / 3;
+		}
+		int triangleCount() const {
+			return _indices.size() / 3;
+		}
+
+		const FloatBuffer& vertices() const {
+			return _vertices;
+		}
+		const FloatBuffer& normals() const {
+			return _normals;
+		}
+		//! s,t pairs mapping the texture over the mesh's x/y extent
+		const FloatBuffer& texCoords() const {
+			return _texCoords;
+		}
+		const IndexBuffer& indices() const {
+			return _indices;
+		}
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		//! Area weighted average of the normals of the adjacent facets
+		void computeNormals();
+		void computeTexCoords();
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		FloatBuffer _vertices;
+		FloatBuffer _normals;
+		FloatBuffer _texCoords;
+		IndexBuffer _indices;
+};
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
+
+#endif
@@ -0,0 +1,242 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#define SEISCOMP_COMPONENT IPGP_GL_MESHBUFFER
+
+#include <ipgp/gui/opengl/meshbuffer.h>
+#include <ipgp/gui/opengl/mesh.h>
+#include <seiscomp3/logging/log.h>
+
+
+namespace {
+
+inline const GLvoid* bufferOffset(const int& offset) {
+	return reinterpret_cast<const GLvoid*>(static_cast<size_t>(offset));
+}
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+MeshBuffer::MeshBuffer() :
+		_vertexBuffer(QGLBuffer::VertexBuffer),
+		_indexBuffer(QGLBuffer::IndexBuffer), _vertices(NULL),
+		_normals(NULL), _texCoords(NULL), _indices(NULL), _vertexCount(0),
+		_indexCount(0), _normalsOffset(0), _texCoordsOffset(0),
+		_bufferObjects(false) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+MeshBuffer::~MeshBuffer() {
+	clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool MeshBuffer::upload(const Mesh& mesh) {
+	return upload(mesh.vertices().constData(), mesh.normals().constData(),
+	    mesh.texCoords().constData(), mesh.vertexCount(),
+	    mesh.indices().constData(), mesh.indices().size());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool MeshBuffer::upload(const GLfloat* vertices, const GLfloat* normals,
+                        const GLfloat* texCoords, const int& vertexCount,
+                        const GLuint* indices, const int& indexCount) {
+
+	clear();
+
+	_vertices = vertices;
+	_normals = normals;
+	_texCoords = texCoords;
+	_indices = indices;
+	_vertexCount = vertexCount;
+	_indexCount = indices ? indexCount : 0;
+
+	if ( _vertexCount == 0 )
+		return false;
+
+	const int verticesSize = _vertexCount * 3 * sizeof(GLfloat);
+	const int normalsSize = _vertexCount * 3 * sizeof(GLfloat);
+	const int texCoordsSize = _vertexCount * 2 * sizeof(GLfloat);
+
+	if ( !_vertexBuffer.create() ) {
+		SEISCOMP_WARNING("Buffer objects are not supported, falling back on vertex arrays");
+		return false;
+	}
+
+	//! Vertices, normals and texture coordinates are stored one after
+	//! the other in the same buffer
+	_normalsOffset = verticesSize;
+	_texCoordsOffset = verticesSize + normalsSize;
+
+	_vertexBuffer.setUsagePattern(QGLBuffer::StaticDraw);
+	_vertexBuffer.bind();
+	_vertexBuffer.allocate(verticesSize + normalsSize + texCoordsSize);
+	_vertexBuffer.write(0, _vertices, verticesSize);
+	_vertexBuffer.write(_normalsOffset, _normals, normalsSize);
+	_vertexBuffer.write(_texCoordsOffset, _texCoords, texCoordsSize);
+	_vertexBuffer.release();
+
+	if ( _indexCount > 0 ) {
+		if ( !_indexBuffer.create() ) {
+			_vertexBuffer.destroy();
+			SEISCOMP_WARNING("Buffer objects are not supported, falling back on vertex arrays");
+			return false;
+		}
+		_indexBuffer.setUsagePattern(QGLBuffer::StaticDraw);
+		_indexBuffer.bind();
+		_indexBuffer.allocate(_indices, _indexCount * sizeof(GLuint));
+		_indexBuffer.release();
+	}
+
+	_bufferObjects = true;
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void MeshBuffer::clear() {
+
+	if ( _vertexBuffer.isCreated() )
+		_vertexBuffer.destroy();
+	if ( _indexBuffer.isCreated() )
+		_indexBuffer.destroy();
+
+	_vertices = _normals = _texCoords = NULL;
+	_indices = NULL;
+	_vertexCount = _indexCount = _normalsOffset = _texCoordsOffset = 0;
+	_bufferObjects = false;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void MeshBuffer::drawTriangles(const bool& textured) {
+
+	if ( _indexCount == 0 )
+		return;
+
+	beginDraw(textured);
+	drawElements(GL_TRIANGLES, 0, _indexCount);
+	endDraw();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void MeshBuffer::drawPoints() {
+
+	if ( _vertexCount == 0 )
+		return;
+
+	beginDraw(false);
+	glDrawArrays(GL_POINTS, 0, _vertexCount);
+	endDraw();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void MeshBuffer::beginDraw(const bool& textured) {
+
+	GL::useVBO(true, textured);
+
+	if ( _bufferObjects ) {
+		_vertexBuffer.bind();
+		glVertexPointer(3, GL_FLOAT, 0, bufferOffset(0));
+		glNormalPointer(GL_FLOAT, 0, bufferOffset(_normalsOffset));
+		if ( textured )
+			glTexCoordPointer(2, GL_FLOAT, 0, bufferOffset(_texCoordsOffset));
+		if ( _indexCount > 0 )
+			_indexBuffer.bind();
+	}
+	else if ( _vertices ) {
+		glVertexPointer(3, GL_FLOAT, 0, _vertices);
+		glNormalPointer(GL_FLOAT, 0, _normals);
+		if ( textured )
+			glTexCoordPointer(2, GL_FLOAT, 0, _texCoords);
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void MeshBuffer::drawElements(const GLenum& mode, const int& first, const int& count) {
+
+	if ( count <= 0 || first < 0 || first + count > _indexCount )
+		return;
+
+	if ( _bufferObjects )
+		glDrawElements(mode, count, GL_UNSIGNED_INT,
+		    bufferOffset(first * sizeof(GLuint)));
+	else
+		glDrawElements(mode, count, GL_UNSIGNED_INT,
+		    _indices + first);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void MeshBuffer::endDraw() {
+
+	if ( _bufferObjects ) {
+		if ( _indexCount > 0 )
+			_indexBuffer.release();
+		_vertexBuffer.release();
+	}
+
+	GL::useVBO(false);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
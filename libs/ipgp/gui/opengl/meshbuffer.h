@@ -0,0 +1,146 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_OPENGL_DATAMODEL_MESHBUFFER_H__
+#define __IPGP_OPENGL_DATAMODEL_MESHBUFFER_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/opengl/gl.h>
+#include <QGLBuffer>
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+DEFINE_IPGP_SMARTPOINTER(Mesh);
+
+DEFINE_IPGP_SMARTPOINTER(MeshBuffer);
+/**
+ * @class   MeshBuffer
+ * @package IPGP::Gui::OpenGL
+ * @brief   GPU side copy of a Mesh
+ *
+ * The mesh's vertices, normals and texture coordinates are uploaded once
+ * into a single vertex buffer object, and its indices into an index buffer
+ * object. Every rendering mode is then drawn from those two buffers with
+ * glDrawElements (triangles) or glDrawArrays (points), without re-sending
+ * any geometry.
+ * When buffer objects aren't supported (OpenGL < 1.5), the same calls are
+ * issued on client side arrays pointing to the uploaded data, which must
+ * then stay alive and unchanged as long as the buffer is used.
+ * @note  Every method expects the owning context to be the current one.
+ */
+class SC_IPGP_GUI_API MeshBuffer {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		MeshBuffer();
+		~MeshBuffer();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief  Uploads the mesh to the video memory.
+		 * @return true if buffer objects are used, false if it falls back
+		 *         on client side arrays
+		 */
+		bool upload(const Mesh&);
+		/**
+		 * @brief Uploads raw arrays, e.g. a memory-mapped mesh.
+		 * @param vertices x,y,z triplets
+		 * @param normals x,y,z triplets
+		 * @param texCoords s,t pairs
+		 * @param vertexCount the number of vertices
+		 * @param indices triangles corners, may be NULL
+		 * @param indexCount the number of indices
+		 */
+		bool upload(const GLfloat* vertices, const GLfloat* normals,
+		            const GLfloat* texCoords, const int& vertexCount,
+		            const GLuint* indices, const int& indexCount);
+		void clear();
+
+		bool isEmpty() const {
+			return _vertexCount == 0;
+		}
+		const int& vertexCount() const {
+			return _vertexCount;
+		}
+		const int& indexCount() const {
+			return _indexCount;
+		}
+		const bool& usesBufferObjects() const {
+			return _bufferObjects;
+		}
+		//! The uploaded arrays, still needed on the client side for picking
+		const GLfloat* vertices() const {
+			return _vertices;
+		}
+		const GLuint* indices() const {
+			return _indices;
+		}
+
+		//! Draws the triangles, lines or fills depend on the polygon mode
+		void drawTriangles(const bool& textured = false);
+		void drawPoints();
+
+		/**
+		 * @brief Binds the buffers for a sequence of drawElements() calls,
+		 *        which must be closed by endDraw().
+		 */
+		void beginDraw(const bool& textured = false);
+		/**
+		 * @brief Draws a range of the index buffer
+		 * @param mode the primitive (GL_TRIANGLES, GL_POINTS, ...)
+		 * @param first the first index of the range
+		 * @param count the number of indices
+		 */
+		void drawElements(const GLenum& mode, const int& first, const int& count);
+		void endDraw();
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		QGLBuffer _vertexBuffer;
+		QGLBuffer _indexBuffer;
+		const GLfloat* _vertices;
+		const GLfloat* _normals;
+		const GLfloat* _texCoords;
+		const GLuint* _indices;
+		int _vertexCount;
+		int _indexCount;
+		int _normalsOffset;
+		int _texCoordsOffset;
+		bool _bufferObjects;
+};
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
+
+#endif
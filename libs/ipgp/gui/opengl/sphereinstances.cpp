@@ -0,0 +1,346 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/opengl/sphereinstances.h>
+#include <math.h>
+
+
+namespace {
+
+using namespace IPGP::Gui::OpenGL;
+
+//! Instances are positioned by GL::translate(), which swaps the axes
+inline void center(const SphereInstances::Instance& i, GLfloat c[3]) {
+	c[0] = i.x;
+	c[1] = i.z;
+	c[2] = -i.y;
+}
+
+inline GLfloat radius(const SphereInstances::Instance& i) {
+	return (i.radius == .0) ? .001 : fabs(i.radius);
+}
+
+
+class SphereHit : public BoundingVolumeHierarchy::Visitor {
+
+	public:
+		SphereHit(const QVector<SphereInstances::Instance>& i,
+		          const QVector<int>& h) :
+				instances(i), handles(h) {}
+
+		bool intersect(const int& primitive, const Ray& ray, GLfloat& distance) {
+
+			const SphereInstances::Instance& i = instances.at(handles.at(primitive));
+			GLfloat c[3];
+			center(i, c);
+			const GLfloat r = radius(i);
+
+			//! Distance from the center to its projection on the ray,
+			//! computed without cancellation
+			GLfloat o[3];
+			for (int k = 0; k < 3; ++k)
+				o[k] = ray.origin[k] - c[k];
+			const GLfloat b = o[0] * ray.direction[0] + o[1] * ray.direction[1]
+			        + o[2] * ray.direction[2];
+			GLfloat d2 = .0;
+			for (int k = 0; k < 3; ++k) {
+				const GLfloat q = o[k] - ray.direction[k] * b;
+				d2 += q * q;
+			}
+			if ( d2 > r * r )
+				return false;
+
+			const GLfloat h = sqrt(r * r - d2);
+			GLfloat t = -b - h;
+			if ( t < .0 ) t = -b + h;
+			if ( t < .0 || t >= distance )
+				return false;
+
+			distance = t;
+			return true;
+		}
+
+	private:
+		const QVector<SphereInstances::Instance>& instances;
+		const QVector<int>& handles;
+};
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+SphereInstances::SphereInstances() :
+		_count(0), _coarse(false), _pickingTreeDirty(false) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+SphereInstances::~SphereInstances() {
+	clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int SphereInstances::add(const GLfloat& x, const GLfloat& y, const GLfloat& z,
+                         const GLfloat& radius, const QColor& color) {
+
+	int handle;
+	if ( !_freeSlots.isEmpty() ) {
+		handle = _freeSlots.last();
+		_freeSlots.pop_back();
+	}
+	else {
+		handle = _instances.size();
+		_instances.resize(handle + 1);
+	}
+
+	Instance& i = _instances[handle];
+	i.x = x;
+	i.y = y;
+	i.z = z;
+	i.radius = radius;
+	i.color = color.rgb();
+	i.used = true;
+
+	++_count;
+	setDirty(handle);
+
+	return handle;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool SphereInstances::update(const int& handle, const GLfloat& x,
+                             const GLfloat& y, const GLfloat& z,
+                             const GLfloat& radius, const QColor& color) {
+
+	if ( handle < 0 || handle >= _instances.size() || !_instances[handle].used )
+		return false;
+
+	Instance& i = _instances[handle];
+	if ( i.x == x && i.y == y && i.z == z && i.radius == radius
+	        && i.color == color.rgb() )
+		return true;
+
+	i.x = x;
+	i.y = y;
+	i.z = z;
+	i.radius = radius;
+	i.color = color.rgb();
+	setDirty(handle);
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool SphereInstances::remove(const int& handle) {
+
+	if ( handle < 0 || handle >= _instances.size() || !_instances[handle].used )
+		return false;
+
+	_instances[handle].used = false;
+	_freeSlots.append(handle);
+	--_count;
+	setDirty(handle);
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SphereInstances::clear() {
+
+	for (int i = 0; i < _lists.size(); ++i)
+		if ( _lists[i] != 0 )
+			glDeleteLists(_lists[i], 1);
+
+	_lists.clear();
+	_dirty.clear();
+	_instances.clear();
+	_freeSlots.clear();
+	_count = 0;
+
+	_pickingTree.clear();
+	_pickingHandles.clear();
+	_pickingTreeDirty = false;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SphereInstances::draw() {
+
+	if ( _count == 0 )
+		return;
+
+	//! Switching tessellation invalidates every chunk
+	const bool coarse = _count > CoarseThreshold;
+	if ( coarse != _coarse ) {
+		_coarse = coarse;
+		_dirty.fill(true);
+	}
+
+	//! Normals are scaled along with the unit sphere
+	glPushAttrib(GL_ENABLE_BIT);
+	glEnable(GL_NORMALIZE);
+
+	for (int c = 0; c < _lists.size(); ++c) {
+		if ( _dirty[c] )
+			compile(c, _coarse);
+		if ( _lists[c] != 0 )
+			glCallList(_lists[c]);
+	}
+
+	glPopAttrib();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int SphereInstances::pick(const Ray& ray, GLfloat& distance) {
+
+	if ( _count == 0 )
+		return -1;
+
+	if ( _pickingTreeDirty )
+		buildPickingTree();
+
+	SphereHit hit(_instances, _pickingHandles);
+	const int primitive = _pickingTree.intersect(ray, hit, distance);
+
+	return (primitive < 0) ? -1 : _pickingHandles.at(primitive);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SphereInstances::setDirty(const int& handle) {
+
+	const int chunk = handle / ChunkSize;
+	if ( chunk >= _lists.size() ) {
+		_lists.resize(chunk + 1);
+		_dirty.resize(chunk + 1);
+	}
+
+	_dirty[chunk] = true;
+	_pickingTreeDirty = true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SphereInstances::compile(const int& chunk, const bool& coarse) {
+
+	_dirty[chunk] = false;
+
+	if ( _lists[chunk] == 0 )
+		_lists[chunk] = glGenLists(1);
+	if ( _lists[chunk] == 0 )
+		return;
+
+	const int first = chunk * ChunkSize;
+	const int last = qMin(first + ChunkSize, _instances.size());
+
+	glNewList(_lists[chunk], GL_COMPILE);
+	for (int k = first; k < last; ++k) {
+
+		const Instance& i = _instances.at(k);
+		if ( !i.used ) continue;
+
+		const GLfloat r = (i.radius == .0) ? .001 : i.radius;
+
+		glPushMatrix();
+		GL::translate(i.x, i.y, i.z);
+		glScalef(r, r, r);
+		glColor3ub(qRed(i.color), qGreen(i.color), qBlue(i.color));
+		GL::drawUnitSphere(coarse);
+		glPopMatrix();
+	}
+	glEndList();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void SphereInstances::buildPickingTree() {
+
+	_pickingTreeDirty = false;
+	_pickingHandles.clear();
+	_pickingHandles.reserve(_count);
+
+	BoundingVolumeHierarchy::BoxList boxes;
+	boxes.reserve(_count);
+
+	for (int k = 0; k < _instances.size(); ++k) {
+
+		const Instance& i = _instances.at(k);
+		if ( !i.used ) continue;
+
+		GLfloat c[3];
+		center(i, c);
+		const GLfloat r = radius(i);
+
+		BoundingVolumeHierarchy::Box box;
+		for (int a = 0; a < 3; ++a) {
+			box.min[a] = c[a] - r;
+			box.max[a] = c[a] + r;
+		}
+		boxes.append(box);
+		_pickingHandles.append(k);
+	}
+
+	_pickingTree.build(boxes);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
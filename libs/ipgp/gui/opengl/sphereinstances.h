@@ -0,0 +1,144 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_OPENGL_DATAMODEL_SPHEREINSTANCES_H__
+#define __IPGP_OPENGL_DATAMODEL_SPHEREINSTANCES_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/opengl/gl.h>
+#include <ipgp/gui/opengl/boundingvolumehierarchy.h>
+#include <QVector>
+#include <QColor>
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+DEFINE_IPGP_SMARTPOINTER(SphereInstances);
+/**
+ * @class   SphereInstances
+ * @package IPGP::Gui::OpenGL
+ * @brief   Many spheres sharing the same geometry
+ *
+ * Every sphere is an instance of the unit sphere tessellated once by
+ * GL::drawUnitSphere(), with its own position, radius and color. Instances
+ * are grouped by chunks of ChunkSize slots, each compiled into its own
+ * display list: changing an instance only recompiles its chunk, and
+ * drawing costs one glCallList per chunk.
+ * Handles returned by add() stay valid until the instance is removed,
+ * freed slots are reused.
+ * Instances can be picked by ray casting, through a bounding volume
+ * hierarchy rebuilt on the first pick following a change.
+ * @note  draw() and clear() expect the owning context to be the current one.
+ */
+class SC_IPGP_GUI_API SphereInstances {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		struct Instance {
+				GLfloat x;
+				GLfloat y;
+				GLfloat z;
+				GLfloat radius;
+				QRgb color;
+				bool used;
+		};
+
+		static const int ChunkSize = 1024;
+		//! Past this number of instances, the lighter tessellation is used
+		static const int CoarseThreshold = 4096;
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		SphereInstances();
+		~SphereInstances();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! @return the handle of the new instance
+		int add(const GLfloat& x, const GLfloat& y, const GLfloat& z,
+		        const GLfloat& radius, const QColor& color);
+		/**
+		 * @brief Updates an instance, its chunk is only recompiled if
+		 *        something did change.
+		 * @return false if the handle doesn't refer to an instance
+		 */
+		bool update(const int& handle, const GLfloat& x, const GLfloat& y,
+		            const GLfloat& z, const GLfloat& radius,
+		            const QColor& color);
+		bool remove(const int& handle);
+		void clear();
+
+		int count() const {
+			return _count;
+		}
+
+		//! Compiles the chunks which changed, and calls them all
+		void draw();
+
+		/**
+		 * @brief Casts a ray through the instances.
+		 * @param ray the ray, in OpenGL coordinates
+		 * @param distance the farthest distance considered, set to the
+		 *        distance of the hit
+		 * @return the handle of the nearest instance hit, -1 if none
+		 */
+		int pick(const Ray& ray, GLfloat& distance);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		void setDirty(const int& handle);
+		void compile(const int& chunk, const bool& coarse);
+		void buildPickingTree();
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		QVector<Instance> _instances;
+		QVector<int> _freeSlots;
+		QVector<GLuint> _lists;
+		QVector<bool> _dirty;
+		int _count;
+		bool _coarse;
+
+		BoundingVolumeHierarchy _pickingTree;
+		//! Handle of each primitive of the picking tree
+		QVector<int> _pickingHandles;
+		bool _pickingTreeDirty;
+};
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
+
+#endif
@@ -0,0 +1,452 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#include <ipgp/gui/opengl/terrainquadtree.h>
+#include <ipgp/gui/opengl/camera.h>
+#include <QHash>
+#include <math.h>
+#include <string.h>
+
+
+namespace {
+
+inline quint64 edgeKey(const GLuint& a, const GLuint& b) {
+	return (a < b) ? (static_cast<quint64>(a) << 32) | b
+	               : (static_cast<quint64>(b) << 32) | a;
+}
+
+}
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+const int TerrainQuadtree::MaxLeafTriangles = 16384;
+const int TerrainQuadtree::MaxDepth = 10;
+const int TerrainQuadtree::ClusterResolution = 64;
+const float TerrainQuadtree::DefaultPixelError = 2.f;
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+TerrainQuadtree::TerrainQuadtree() {
+	_rootMin[0] = _rootMin[1] = _rootMax[0] = _rootMax[1] = .0f;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+TerrainQuadtree::~TerrainQuadtree() {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TerrainQuadtree::build(const Mesh& source) {
+
+	clear();
+
+	if ( source.triangleCount() == 0 )
+		return;
+
+	const GLfloat* v = source.vertices().constData();
+	_rootMin[0] = _rootMax[0] = v[0];
+	_rootMin[1] = _rootMax[1] = v[1];
+	for (int i = 1; i < source.vertexCount(); ++i) {
+		_rootMin[0] = qMin(_rootMin[0], v[i * 3]);
+		_rootMax[0] = qMax(_rootMax[0], v[i * 3]);
+		_rootMin[1] = qMin(_rootMin[1], v[i * 3 + 1]);
+		_rootMax[1] = qMax(_rootMax[1], v[i * 3 + 1]);
+	}
+
+	//! Every level weighs about as much as the source
+	_vertices.reserve(source.vertices().size() * 2);
+	_normals.reserve(source.normals().size() * 2);
+	_texCoords.reserve(source.texCoords().size() * 2);
+	_indices.reserve(source.indices().size() * 2);
+	_remap.fill(-1, source.vertexCount());
+
+	QVector<int> triangles(source.triangleCount());
+	for (int i = 0; i < triangles.size(); ++i)
+		triangles[i] = i;
+
+	buildNode(source, triangles, _rootMin, _rootMax, 0, .0f);
+
+	_vertices.squeeze();
+	_normals.squeeze();
+	_texCoords.squeeze();
+	_indices.squeeze();
+	_mesh.setData(_vertices, _normals, _texCoords, _indices);
+
+	_vertices.clear();
+	_normals.clear();
+	_texCoords.clear();
+	_indices.clear();
+	_remap.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TerrainQuadtree::assign(const Node* nodes, const int& count) {
+
+	clear();
+
+	if ( !nodes || count <= 0 )
+		return;
+
+	_nodes.resize(count);
+	memcpy(_nodes.data(), nodes, count * sizeof(Node));
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TerrainQuadtree::clear() {
+	_mesh.clear();
+	_nodes.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TerrainQuadtree::select(const Frustum& frustum, Selection& selection,
+                             const GLfloat& pixelError) const {
+
+	selection.clear();
+
+	if ( _nodes.isEmpty() )
+		return;
+
+	selectNode(0, frustum, selection, pixelError);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TerrainQuadtree::buildNode(const Mesh& source, QVector<int>& triangles,
+                               const GLfloat cellMin[2], const GLfloat cellMax[2],
+                               const int& depth, const GLfloat& skirtDepth) {
+
+	if ( triangles.isEmpty() )
+		return -1;
+
+	const GLfloat* v = source.vertices().constData();
+	const GLuint* idx = source.indices().constData();
+
+	Node node;
+	for (int a = 0; a < 3; ++a)
+		node.min[a] = node.max[a] = v[idx[triangles[0] * 3] * 3 + a];
+	for (int i = 0; i < triangles.size(); ++i)
+		for (int c = 0; c < 3; ++c) {
+			const GLfloat* p = v + idx[triangles[i] * 3 + c] * 3;
+			for (int a = 0; a < 3; ++a) {
+				node.min[a] = qMin(node.min[a], p[a]);
+				node.max[a] = qMax(node.max[a], p[a]);
+			}
+		}
+	for (int q = 0; q < 4; ++q)
+		node.children[q] = -1;
+
+	const bool leaf = triangles.size() <= MaxLeafTriangles || depth >= MaxDepth;
+
+	node.first = _indices.size();
+	node.error = leaf ? appendTriangles(source, triangles) : appendSimplified(source, triangles, node);
+	node.count = _indices.size() - node.first;
+
+	//! Skirts hang low enough to hide the gap to a coarser neighbour
+	const GLfloat skirt = skirtDepth + node.error;
+	if ( skirt > .0f ) {
+		appendSkirts(node.first, skirt);
+		node.min[2] -= skirt;
+	}
+	node.skirtCount = _indices.size() - node.first - node.count;
+
+	const int index = _nodes.size();
+	_nodes.append(node);
+
+	if ( leaf ) {
+		triangles.clear();
+		return index;
+	}
+
+	//! Dispatch the triangles by centroid
+	const GLfloat mid[2] = { (cellMin[0] + cellMax[0]) / 2.f, (cellMin[1] + cellMax[1]) / 2.f };
+	QVector<int> quadrants[4];
+	for (int i = 0; i < triangles.size(); ++i) {
+		const GLuint* t = idx + triangles[i] * 3;
+		const GLfloat cx = v[t[0] * 3] + v[t[1] * 3] + v[t[2] * 3];
+		const GLfloat cy = v[t[0] * 3 + 1] + v[t[1] * 3 + 1] + v[t[2] * 3 + 1];
+		const int q = ((cx >= mid[0] * 3.f) ? 1 : 0) | ((cy >= mid[1] * 3.f) ? 2 : 0);
+		quadrants[q].append(triangles[i]);
+	}
+	triangles.clear();
+
+	GLfloat error = node.error;
+	for (int q = 0; q < 4; ++q) {
+		const GLfloat childMin[2] = { (q & 1) ? mid[0] : cellMin[0], (q & 2) ? mid[1] : cellMin[1] };
+		const GLfloat childMax[2] = { (q & 1) ? cellMax[0] : mid[0], (q & 2) ? cellMax[1] : mid[1] };
+		const int child = buildNode(source, quadrants[q], childMin, childMax, depth + 1, skirt);
+		if ( child < 0 ) continue;
+		_nodes[index].children[q] = child;
+		error = qMax(error, _nodes[child].error);
+	}
+
+	//! Keep errors monotone so that refining never lowers the quality
+	_nodes[index].error = error;
+
+	return index;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+GLfloat TerrainQuadtree::appendTriangles(const Mesh& source,
+                                         const QVector<int>& triangles) {
+
+	const GLfloat* v = source.vertices().constData();
+	const GLfloat* n = source.normals().constData();
+	const GLfloat* t = source.texCoords().constData();
+	const GLuint* idx = source.indices().constData();
+
+	QVector<int> touched;
+	touched.reserve(triangles.size());
+
+	for (int i = 0; i < triangles.size(); ++i)
+		for (int c = 0; c < 3; ++c) {
+			const GLuint s = idx[triangles[i] * 3 + c];
+			if ( _remap[s] < 0 ) {
+				_remap[s] = _vertices.size() / 3;
+				_vertices << v[s * 3] << v[s * 3 + 1] << v[s * 3 + 2];
+				_normals << n[s * 3] << n[s * 3 + 1] << n[s * 3 + 2];
+				_texCoords << t[s * 2] << t[s * 2 + 1];
+				touched.append(s);
+			}
+			_indices.append(static_cast<GLuint>(_remap[s]));
+		}
+
+	for (int i = 0; i < touched.size(); ++i)
+		_remap[touched[i]] = -1;
+
+	return .0f;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+GLfloat TerrainQuadtree::appendSimplified(const Mesh& source,
+                                          const QVector<int>& triangles,
+                                          const Node& node) {
+
+	const GLfloat* v = source.vertices().constData();
+	const GLfloat* n = source.normals().constData();
+	const GLfloat* t = source.texCoords().constData();
+	const GLuint* idx = source.indices().constData();
+
+	const GLfloat sx = (node.max[0] > node.min[0]) ? (node.max[0] - node.min[0]) / ClusterResolution : 1.f;
+	const GLfloat sy = (node.max[1] > node.min[1]) ? (node.max[1] - node.min[1]) / ClusterResolution : 1.f;
+
+	//! Sums of the positions, normals and texture coordinates of the
+	//! vertices falling in each cell of the grid
+	QHash<int, int> cells;
+	QVector<GLfloat> sums;
+	QVector<int> weights;
+	QVector<int> touched;
+	touched.reserve(triangles.size());
+
+	for (int i = 0; i < triangles.size(); ++i)
+		for (int c = 0; c < 3; ++c) {
+			const GLuint s = idx[triangles[i] * 3 + c];
+			if ( _remap[s] >= 0 ) continue;
+
+			const int cx = qBound(0, static_cast<int>((v[s * 3] - node.min[0]) / sx), ClusterResolution - 1);
+			const int cy = qBound(0, static_cast<int>((v[s * 3 + 1] - node.min[1]) / sy), ClusterResolution - 1);
+			const int key = cy * ClusterResolution + cx;
+
+			QHash<int, int>::iterator it = cells.find(key);
+			if ( it == cells.end() ) {
+				it = cells.insert(key, weights.size());
+				sums.insert(sums.end(), 8, .0f);
+				weights.append(0);
+			}
+
+			const int cluster = it.value();
+			GLfloat* sum = sums.data() + cluster * 8;
+			for (int a = 0; a < 3; ++a) {
+				sum[a] += v[s * 3 + a];
+				sum[3 + a] += n[s * 3 + a];
+			}
+			sum[6] += t[s * 2];
+			sum[7] += t[s * 2 + 1];
+			++weights[cluster];
+
+			_remap[s] = cluster;
+			touched.append(s);
+		}
+
+	const int base = _vertices.size() / 3;
+	for (int k = 0; k < weights.size(); ++k) {
+		const GLfloat* sum = sums.constData() + k * 8;
+		const GLfloat w = weights[k];
+		_vertices << sum[0] / w << sum[1] / w << sum[2] / w;
+		const GLfloat l = sqrt(sum[3] * sum[3] + sum[4] * sum[4] + sum[5] * sum[5]);
+		if ( l > .0f )
+			_normals << sum[3] / l << sum[4] / l << sum[5] / l;
+		else
+			_normals << .0f << .0f << 1.f;
+		_texCoords << sum[6] / w << sum[7] / w;
+	}
+
+	//! Triangles whose corners fell in the same cell collapse
+	for (int i = 0; i < triangles.size(); ++i) {
+		const GLuint* tri = idx + triangles[i] * 3;
+		const int a = _remap[tri[0]], b = _remap[tri[1]], c = _remap[tri[2]];
+		if ( a == b || b == c || a == c ) continue;
+		_indices << static_cast<GLuint>(base + a) << static_cast<GLuint>(base + b)
+		         << static_cast<GLuint>(base + c);
+	}
+
+	GLfloat error = .0f;
+	const GLfloat* rep = _vertices.constData() + base * 3;
+	for (int i = 0; i < touched.size(); ++i) {
+		const GLuint s = touched[i];
+		//! Moving along a smooth surface doesn't show, the height does
+		error = qMax(error, static_cast<GLfloat>(fabs(v[s * 3 + 2] - rep[_remap[s] * 3 + 2])));
+		_remap[s] = -1;
+	}
+
+	return error;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TerrainQuadtree::appendSkirts(const int& first, const GLfloat& depth) {
+
+	const int last = _indices.size();
+
+	//! Border edges belong to a single triangle
+	QHash<quint64, int> edges;
+	for (int i = first; i < last; ++i) {
+		const int next = (i % 3 == 2) ? i - 2 : i + 1;
+		++edges[edgeKey(_indices[i], _indices[next])];
+	}
+
+	const GLfloat epsX = (_rootMax[0] - _rootMin[0]) * 1e-6f;
+	const GLfloat epsY = (_rootMax[1] - _rootMin[1]) * 1e-6f;
+
+	QHash<GLuint, GLuint> lowered;
+	for (int i = first; i < last; ++i) {
+
+		const GLuint a = _indices[i];
+		const GLuint b = _indices[(i % 3 == 2) ? i - 2 : i + 1];
+		if ( edges.value(edgeKey(a, b)) != 1 ) continue;
+
+		//! Nothing to hide along the terrain's outer border
+		const GLfloat ax = _vertices[a * 3], ay = _vertices[a * 3 + 1];
+		const GLfloat bx = _vertices[b * 3], by = _vertices[b * 3 + 1];
+		if ( (fabs(ax - _rootMin[0]) <= epsX && fabs(bx - _rootMin[0]) <= epsX)
+		        || (fabs(ax - _rootMax[0]) <= epsX && fabs(bx - _rootMax[0]) <= epsX)
+		        || (fabs(ay - _rootMin[1]) <= epsY && fabs(by - _rootMin[1]) <= epsY)
+		        || (fabs(ay - _rootMax[1]) <= epsY && fabs(by - _rootMax[1]) <= epsY) )
+			continue;
+
+		GLuint low[2];
+		const GLuint ends[2] = { a, b };
+		for (int e = 0; e < 2; ++e) {
+			QHash<GLuint, GLuint>::const_iterator it = lowered.constFind(ends[e]);
+			if ( it != lowered.constEnd() ) {
+				low[e] = it.value();
+				continue;
+			}
+			const GLuint s = ends[e];
+			low[e] = _vertices.size() / 3;
+			_vertices << _vertices[s * 3] << _vertices[s * 3 + 1] << _vertices[s * 3 + 2] - depth;
+			_normals << _normals[s * 3] << _normals[s * 3 + 1] << _normals[s * 3 + 2];
+			_texCoords << _texCoords[s * 2] << _texCoords[s * 2 + 1];
+			lowered.insert(s, low[e]);
+		}
+
+		//! Faces outward given counter-clockwise triangles
+		_indices << a << low[0] << low[1];
+		_indices << a << low[1] << b;
+	}
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TerrainQuadtree::selectNode(const int& index, const Frustum& frustum,
+                                 Selection& selection,
+                                 const GLfloat& pixelError) const {
+
+	const Node& node = _nodes[index];
+
+	if ( !frustum.intersects(node.min, node.max) )
+		return;
+
+	if ( node.isLeaf() ) {
+		selection.append(index);
+		return;
+	}
+
+	//! Distance from the eye to the node's box
+	const GLfloat* eye = frustum.eye();
+	GLfloat d2 = .0f;
+	for (int a = 0; a < 3; ++a) {
+		const GLfloat d = qMax(qMax(node.min[a] - eye[a], eye[a] - node.max[a]), .0f);
+		d2 += d * d;
+	}
+
+	if ( d2 > .0f && node.error * frustum.pixelScale() <= pixelError * sqrt(d2) ) {
+		selection.append(index);
+		return;
+	}
+
+	for (int q = 0; q < 4; ++q)
+		if ( node.children[q] >= 0 )
+			selectNode(node.children[q], frustum, selection, pixelError);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
@@ -0,0 +1,174 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_OPENGL_DATAMODEL_TERRAINQUADTREE_H__
+#define __IPGP_OPENGL_DATAMODEL_TERRAINQUADTREE_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/opengl/gl.h>
+#include <ipgp/gui/opengl/mesh.h>
+#include <QVector>
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+class Frustum;
+
+DEFINE_IPGP_SMARTPOINTER(TerrainQuadtree);
+/**
+ * @class   TerrainQuadtree
+ * @package IPGP::Gui::OpenGL
+ * @brief   Chunked level of detail of a terrain mesh
+ *
+ * The triangles of the mesh are split over a quadtree of the x/y extent.
+ * Leaves hold the full resolution triangles, every other node holds a
+ * simplified version of the whole area it covers, obtained by clustering
+ * its vertices on a regular grid. Each node records its geometric error
+ * (the largest elevation difference between a vertex and its simplified
+ * counterpart) and is skirted: its border edges are extruded downward by
+ * the error of its ancestors so that the cracks between neighbours drawn
+ * at different levels stay hidden.
+ *
+ * Every level is stored in the same Mesh, a node referencing a range of
+ * its indices, so that the whole tree is uploaded once and each frame
+ * only issues one glDrawElements per selected chunk.
+ */
+class SC_IPGP_GUI_API TerrainQuadtree {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		struct Node {
+				GLfloat min[3];
+				GLfloat max[3];
+				//! Geometric error, never less than the children's one
+				GLfloat error;
+				//! Range of the surface triangles in the mesh indices
+				int first;
+				int count;
+				//! Skirt triangles, stored right after the surface ones
+				int skirtCount;
+				//! Index of the children in the nodes list, -1 if empty
+				int children[4];
+
+				bool isLeaf() const {
+					return children[0] < 0 && children[1] < 0
+					        && children[2] < 0 && children[3] < 0;
+				}
+		};
+		typedef QVector<Node> NodeList;
+		typedef QVector<int> Selection;
+
+		static const int MaxLeafTriangles;
+		static const int MaxDepth;
+		static const int ClusterResolution;
+		static const float DefaultPixelError;
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		TerrainQuadtree();
+		~TerrainQuadtree();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		//! Builds the levels of detail of a triangle mesh
+		void build(const Mesh&);
+		/**
+		 * @brief Restores nodes built earlier, whose mesh is stored
+		 *        elsewhere (e.g. in a TopographyCache). mesh() is then
+		 *        left empty.
+		 */
+		void assign(const Node* nodes, const int& count);
+		void clear();
+
+		bool isEmpty() const {
+			return _nodes.isEmpty();
+		}
+
+		//! The vertices and indices of every node
+		const Mesh& mesh() const {
+			return _mesh;
+		}
+		const NodeList& nodes() const {
+			return _nodes;
+		}
+
+		/**
+		 * @brief Selects the nodes to draw: those intersecting the frustum
+		 *        and whose error, projected on screen, is below the
+		 *        threshold, or leaves.
+		 * @param frustum the viewing volume, up to date
+		 * @param selection the indices of the selected nodes
+		 * @param pixelError the tolerated screen space error in pixels
+		 */
+		void select(const Frustum& frustum, Selection& selection,
+		            const GLfloat& pixelError = DefaultPixelError) const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		int buildNode(const Mesh& source, QVector<int>& triangles,
+		              const GLfloat cellMin[2], const GLfloat cellMax[2],
+		              const int& depth, const GLfloat& skirtDepth);
+
+		//! Appends the triangles at full resolution, returns the error (0)
+		GLfloat appendTriangles(const Mesh& source, const QVector<int>& triangles);
+		//! Appends the clustered triangles, returns their error
+		GLfloat appendSimplified(const Mesh& source, const QVector<int>& triangles,
+		                         const Node& node);
+		//! Extrudes the border of the triangles appended from index first
+		void appendSkirts(const int& first, const GLfloat& depth);
+
+		void selectNode(const int& index, const Frustum& frustum,
+		                Selection& selection, const GLfloat& pixelError) const;
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		Mesh _mesh;
+		NodeList _nodes;
+		GLfloat _rootMin[2];
+		GLfloat _rootMax[2];
+
+		//! Buffers of the mesh under construction
+		Mesh::FloatBuffer _vertices;
+		Mesh::FloatBuffer _normals;
+		Mesh::FloatBuffer _texCoords;
+		Mesh::IndexBuffer _indices;
+		QVector<int> _remap;
+};
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
+
+#endif
@@ -0,0 +1,468 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#define SEISCOMP_COMPONENT IPGP_TOPOCACHE
+
+#include <ipgp/gui/opengl/topographycache.h>
+#include <ipgp/gui/opengl/mesh.h>
+#include <seiscomp3/logging/log.h>
+#include <seiscomp3/utils/timer.h>
+#include <QFileInfo>
+#include <cstring>
+
+
+using namespace Seiscomp;
+using namespace Seiscomp::Core;
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+namespace {
+
+const char TOPOGRAPHY_CACHE_MAGIC[8] = { 'I', 'P', 'G', 'P', 'T', 'O', 'P', 'O' };
+const quint32 TOPOGRAPHY_CACHE_VERSION = 2;
+
+const quint64 FNV_OFFSET_BASIS = Q_UINT64_C(14695981039346656037);
+const quint64 FNV_PRIME = Q_UINT64_C(1099511628211);
+
+const qint64 CHECKSUM_BLOCK_SIZE = 1 << 20;
+
+
+inline bool isLittleEndianHost() {
+	return Q_BYTE_ORDER == Q_LITTLE_ENDIAN;
+}
+
+
+//! Offsets of the arrays following the header
+struct Layout {
+		Layout(const quint64& vertexCount, const quint64& indexCount,
+		       const quint64& nodeCount) {
+			vertices = sizeof(TopographyCache::Header);
+			normals = vertices + vertexCount * 3 * sizeof(GLfloat);
+			texCoords = normals + vertexCount * 3 * sizeof(GLfloat);
+			indices = texCoords + vertexCount * 2 * sizeof(GLfloat);
+			nodes = indices + indexCount * sizeof(GLuint);
+			size = nodes + nodeCount * sizeof(TerrainQuadtree::Node);
+		}
+		quint64 vertices;
+		quint64 normals;
+		quint64 texCoords;
+		quint64 indices;
+		quint64 nodes;
+		quint64 size;
+};
+
+}
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+TopographyCache::TopographyCache() :
+		_data(NULL), _size(0), _header(NULL) {}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+TopographyCache::~TopographyCache() {
+	close();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyCache::open(const QString& filename,
+                           const TopographyFile::Type& type) {
+
+	close();
+
+	if ( !isLittleEndianHost() )
+	    return false;
+
+	_file.setFileName(filename);
+	if ( !_file.open(QIODevice::ReadOnly) )
+	    return false;
+
+	_size = _file.size();
+	if ( _size < static_cast<qint64>(sizeof(Header)) ) {
+		close();
+		return false;
+	}
+
+	_data = _file.map(0, _size);
+	if ( !_data ) {
+		close();
+		return false;
+	}
+
+	_header = reinterpret_cast<const Header*>(_data);
+	if ( std::memcmp(_header->magic, TOPOGRAPHY_CACHE_MAGIC, sizeof(TOPOGRAPHY_CACHE_MAGIC)) != 0
+	        || _header->version != TOPOGRAPHY_CACHE_VERSION
+	        || _header->nodeSize != sizeof(TerrainQuadtree::Node)
+	        || _header->sourceType != static_cast<quint32>(type) ) {
+		close();
+		return false;
+	}
+
+	const Layout layout(_header->vertexCount, _header->indexCount, _header->nodeCount);
+	if ( layout.size != static_cast<quint64>(_size) ) {
+		close();
+		return false;
+	}
+
+	_filename = filename;
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TopographyCache::close() {
+
+	if ( _data )
+	    _file.unmap(_data);
+
+	if ( _file.isOpen() )
+	    _file.close();
+
+	_data = NULL;
+	_size = 0;
+	_header = NULL;
+	_filename.clear();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyCache::isOpen() const {
+	return _header != NULL;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const QString& TopographyCache::filename() const {
+	return _filename;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyCache::isUpToDate(const QString& source) const {
+
+	if ( !_header )
+	    return false;
+
+	//! Sizes differ far more often than checksums collide, and are cheap
+	if ( static_cast<quint64>(QFileInfo(source).size()) != _header->sourceSize )
+	    return false;
+
+	bool ok;
+	const quint64 sum = checksum(source, &ok);
+
+	return ok && sum == _header->sourceChecksum;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TopographyCache::vertexCount() const {
+	return _header ? static_cast<int>(_header->vertexCount) : 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TopographyCache::indexCount() const {
+	return _header ? static_cast<int>(_header->indexCount) : 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TopographyCache::nodeCount() const {
+	return _header ? static_cast<int>(_header->nodeCount) : 0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const GLfloat* TopographyCache::vertices() const {
+	if ( !_header ) return NULL;
+	const Layout layout(_header->vertexCount, _header->indexCount, _header->nodeCount);
+	return reinterpret_cast<const GLfloat*>(_data + layout.vertices);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const GLfloat* TopographyCache::normals() const {
+	if ( !_header ) return NULL;
+	const Layout layout(_header->vertexCount, _header->indexCount, _header->nodeCount);
+	return reinterpret_cast<const GLfloat*>(_data + layout.normals);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const GLfloat* TopographyCache::texCoords() const {
+	if ( !_header ) return NULL;
+	const Layout layout(_header->vertexCount, _header->indexCount, _header->nodeCount);
+	return reinterpret_cast<const GLfloat*>(_data + layout.texCoords);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const GLuint* TopographyCache::indices() const {
+	if ( !_header || _header->indexCount == 0 ) return NULL;
+	const Layout layout(_header->vertexCount, _header->indexCount, _header->nodeCount);
+	return reinterpret_cast<const GLuint*>(_data + layout.indices);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+const TerrainQuadtree::Node* TopographyCache::nodes() const {
+	if ( !_header || _header->nodeCount == 0 ) return NULL;
+	const Layout layout(_header->vertexCount, _header->indexCount, _header->nodeCount);
+	return reinterpret_cast<const TerrainQuadtree::Node*>(_data + layout.nodes);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+QString TopographyCache::fileName(const QString& source) {
+	return QString("%1.%2").arg(source).arg(TOPOGRAPHY_CACHE_SUFFIX);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+quint64 TopographyCache::checksum(const QString& filename, bool* ok) {
+
+	if ( ok ) *ok = false;
+
+	QFile file(filename);
+	if ( !file.open(QIODevice::ReadOnly) )
+	    return 0;
+
+	quint64 hash = FNV_OFFSET_BASIS;
+	QByteArray block;
+	do {
+		block = file.read(CHECKSUM_BLOCK_SIZE);
+		const uchar* p = reinterpret_cast<const uchar*>(block.constData());
+		const uchar* end = p + block.size();
+		for (; p != end; ++p) {
+			hash ^= *p;
+			hash *= FNV_PRIME;
+		}
+	}
+	while ( block.size() == CHECKSUM_BLOCK_SIZE );
+
+	if ( ok ) *ok = (file.error() == QFile::NoError);
+
+	return hash;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TopographyCache::buildMesh(const TopographyFile::Data& data, Mesh& mesh,
+                                TerrainQuadtree& tree) {
+
+	Util::StopWatch sw;
+	sw.restart();
+
+	tree.clear();
+
+	if ( data.facetCount() > 0 )
+		mesh.weld(data.positions.constData(), data.facetCount());
+	else if ( data.isGrid() )
+		mesh.setGrid(data.positions.constData(), data.gridColumns, data.gridRows);
+	else
+		mesh.setPoints(data.positions.constData(), data.pointCount());
+
+	SEISCOMP_DEBUG("Indexed mesh built in %s", Time(sw.elapsed()).toString("%T.%f").c_str());
+	sw.restart();
+
+	//! Surfaces are drawn through their levels of detail, points clouds
+	//! as they are
+	tree.build(mesh);
+
+	SEISCOMP_DEBUG("Quadtree of %d nodes built in %s", tree.nodes().size(),
+	    Time(sw.elapsed()).toString("%T.%f").c_str());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyCache::write(const QString& filename, const QString& source,
+                            const TopographyFile& file, const Mesh& mesh,
+                            const TerrainQuadtree& tree, QString* error) {
+
+	if ( !isLittleEndianHost() ) {
+		if ( error ) *error = "Topography caches are only supported on little-endian hosts";
+		return false;
+	}
+
+	bool ok;
+	const quint64 sum = checksum(source, &ok);
+	if ( !ok ) {
+		if ( error ) *error = QString("Failed to read %1").arg(source);
+		return false;
+	}
+
+	const Mesh& drawn = tree.isEmpty() ? mesh : tree.mesh();
+	const TopographyFile::Data& data = file.data();
+
+	Header header;
+	std::memcpy(header.magic, TOPOGRAPHY_CACHE_MAGIC, sizeof(TOPOGRAPHY_CACHE_MAGIC));
+	header.version = TOPOGRAPHY_CACHE_VERSION;
+	header.sourceType = static_cast<quint32>(file.type());
+	header.sourceSize = static_cast<quint64>(QFileInfo(source).size());
+	header.sourceChecksum = sum;
+	header.vertexCount = static_cast<quint32>(drawn.vertexCount());
+	header.indexCount = static_cast<quint32>(drawn.indices().size());
+	header.nodeCount = static_cast<quint32>(tree.nodes().size());
+	header.nodeSize = sizeof(TerrainQuadtree::Node);
+	header.minLatitude = data.minLatitude;
+	header.maxLatitude = data.maxLatitude;
+	header.minLongitude = data.minLongitude;
+	header.maxLongitude = data.maxLongitude;
+	header.minElevation = data.minElevation;
+	header.maxElevation = data.maxElevation;
+
+	//! Write aside and swap, so that a cache is never mapped half written
+	const QString tmp = filename + ".tmp";
+	QFile out(tmp);
+	if ( !out.open(QIODevice::WriteOnly | QIODevice::Truncate) ) {
+		if ( error ) *error = QString("Failed to open %1 for writing").arg(tmp);
+		return false;
+	}
+
+	const qint64 expected = Layout(header.vertexCount, header.indexCount, header.nodeCount).size;
+	qint64 written = out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	written += out.write(reinterpret_cast<const char*>(drawn.vertices().constData()),
+	    drawn.vertices().size() * sizeof(GLfloat));
+	written += out.write(reinterpret_cast<const char*>(drawn.normals().constData()),
+	    drawn.normals().size() * sizeof(GLfloat));
+	written += out.write(reinterpret_cast<const char*>(drawn.texCoords().constData()),
+	    drawn.texCoords().size() * sizeof(GLfloat));
+	written += out.write(reinterpret_cast<const char*>(drawn.indices().constData()),
+	    drawn.indices().size() * sizeof(GLuint));
+	written += out.write(reinterpret_cast<const char*>(tree.nodes().constData()),
+	    tree.nodes().size() * sizeof(TerrainQuadtree::Node));
+	out.close();
+
+	if ( written != expected ) {
+		out.remove();
+		if ( error ) *error = QString("Failed to write %1").arg(tmp);
+		return false;
+	}
+
+	QFile::remove(filename);
+	if ( !QFile::rename(tmp, filename) ) {
+		QFile::remove(tmp);
+		if ( error ) *error = QString("Failed to rename %1 as %2").arg(tmp).arg(filename);
+		return false;
+	}
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyCache::build(const QString& source, const TopographyFile::Type& type,
+                            const QString& filename, QString* error) {
+
+	TopographyFile* file = NULL;
+	if ( type == TopographyFile::STL )
+		file = new STLFile;
+	else if ( type == TopographyFile::XYZ )
+		file = new XYZFile;
+	else {
+		if ( error ) *error = QString("Unknown topography type for %1").arg(source);
+		return false;
+	}
+
+	if ( !file->read(source) ) {
+		if ( error ) *error = QString("Failed to parse %1").arg(source);
+		delete file;
+		return false;
+	}
+
+	Mesh mesh;
+	TerrainQuadtree tree;
+	buildMesh(file->data(), mesh, tree);
+
+	const bool result = write(filename, source, *file, mesh, tree, error);
+	delete file;
+
+	return result;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
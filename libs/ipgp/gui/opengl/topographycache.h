@@ -0,0 +1,192 @@
+/************************************************************************
+ *                                                                      *
+ * Copyright (C) 2012 OVSM/IPGP                                         *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * This program is part of 'Projet TSUAREG - INTERREG IV Caraïbes'.     *
+ * It has been co-financed by the European Union and le Ministère de    *
+ * l'Ecologie, du Développement Durable, des Transports et du Logement. *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef __IPGP_OPENGL_DATAMODEL_TOPOGRAPHYCACHE_H__
+#define __IPGP_OPENGL_DATAMODEL_TOPOGRAPHYCACHE_H__
+
+#include <ipgp/gui/api.h>
+#include <ipgp/gui/defs.h>
+#include <ipgp/gui/opengl/gl.h>
+#include <ipgp/gui/opengl/topographyfile.h>
+#include <ipgp/gui/opengl/terrainquadtree.h>
+#include <QString>
+#include <QFile>
+
+
+namespace IPGP {
+namespace Gui {
+namespace OpenGL {
+
+
+class Mesh;
+
+//! Topography cache file extension, appended to the source file name
+const QString TOPOGRAPHY_CACHE_SUFFIX = "iptc";
+
+
+DEFINE_IPGP_SMARTPOINTER(TopographyCache);
+/**
+ * @class   TopographyCache
+ * @package IPGP::Gui::OpenGL
+ * @brief   Preprocessed topography file
+ *
+ * Stores what the renderer draws out of a topography source (STL or XYZ
+ * file): the welded mesh with its normals and texture coordinates, and
+ * the nodes of its level of detail quadtree, so that the source doesn't
+ * have to be parsed, welded and chunked each time the viewer starts.
+ * @note  The cache layout is the following (little-endian):
+ *        - header   : magic 'IPGPTOPO', version, source type, size and
+ *                     checksum, vertex/index/node counts and bounds
+ *        - vertices : x,y,z floats
+ *        - normals  : x,y,z floats
+ *        - texture  : s,t floats
+ *        - indices  : 32 bits unsigned integers
+ *        - nodes    : TerrainQuadtree::Node records
+ *        The file is memory-mapped and the arrays are handed out as
+ *        pointers into the mapped region (no copy). Big-endian hosts never
+ *        use cache files.
+ */
+class SC_IPGP_GUI_API TopographyCache {
+
+	public:
+		// ------------------------------------------------------------------
+		//  Nested types
+		// ------------------------------------------------------------------
+		struct Header {
+				char magic[8];
+				quint32 version;
+				quint32 sourceType;
+				quint64 sourceSize;
+				quint64 sourceChecksum;
+				quint32 vertexCount;
+				quint32 indexCount;
+				quint32 nodeCount;
+				quint32 nodeSize;
+				float minLatitude;
+				float maxLatitude;
+				float minLongitude;
+				float maxLongitude;
+				float minElevation;
+				float maxElevation;
+		};
+
+	public:
+		// ------------------------------------------------------------------
+		//  Instruction
+		// ------------------------------------------------------------------
+		TopographyCache();
+		~TopographyCache();
+
+	public:
+		// ------------------------------------------------------------------
+		//  Public interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief Maps the cache file in memory and validates its layout.
+		 * @param filename the cache file path
+		 * @param type the type of the source file the cache stands for
+		 * @return true on success, false otherwise (a cache built out of
+		 *         another type of source is rejected)
+		 */
+		bool open(const QString& filename, const TopographyFile::Type& type);
+		void close();
+
+		bool isOpen() const;
+		const QString& filename() const;
+
+		//! @return true if the cache has been built out of this very file
+		bool isUpToDate(const QString& source) const;
+
+		const Header* header() const {
+			return _header;
+		}
+
+		int vertexCount() const;
+		int indexCount() const;
+		int nodeCount() const;
+
+		const GLfloat* vertices() const;
+		const GLfloat* normals() const;
+		const GLfloat* texCoords() const;
+		//! @return the triangles corners, NULL for points clouds
+		const GLuint* indices() const;
+		const TerrainQuadtree::Node* nodes() const;
+
+		//! @return the default cache file of a source file
+		static QString fileName(const QString& source);
+
+		/**
+		 * @brief Computes a source file checksum (64 bits FNV-1a).
+		 * @param filename the file to digest
+		 * @param ok optional success output
+		 */
+		static quint64 checksum(const QString& filename, bool* ok = NULL);
+
+		/**
+		 * @brief Builds what is drawn out of parsed topography data: the
+		 *        welded mesh of STL facets or the triangulated grid of XYZ
+		 *        files and its quadtree, or the points of scattered XYZ
+		 *        files (the tree is then left empty).
+		 */
+		static void buildMesh(const TopographyFile::Data& data, Mesh& mesh,
+		                      TerrainQuadtree& tree);
+
+		/**
+		 * @brief Writes a cache file.
+		 * @param filename the cache file to write
+		 * @param source the source file path, for its size and checksum
+		 * @param file the parsed source, for its type and bounds
+		 * @param mesh the mesh drawn when the tree is empty
+		 * @param tree the quadtree, its own mesh being written
+		 * @param error optional error message output
+		 * @return true on success, false otherwise
+		 */
+		static bool write(const QString& filename, const QString& source,
+		                  const TopographyFile& file, const Mesh& mesh,
+		                  const TerrainQuadtree& tree, QString* error = NULL);
+
+		/**
+		 * @brief Parses a source file and writes its cache.
+		 * @param source the STL or XYZ file path
+		 * @param type the source file type
+		 * @param filename the cache file to write
+		 * @param error optional error message output
+		 * @return true on success, false otherwise
+		 */
+		static bool build(const QString& source, const TopographyFile::Type& type,
+		                  const QString& filename, QString* error = NULL);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Members
+		// ------------------------------------------------------------------
+		QFile _file;
+		uchar* _data;
+		qint64 _size;
+		const Header* _header;
+		QString _filename;
+};
+
+
+} // namespace OpenGL
+} // namespace Gui
+} // namespace IPGP
+
+#endif
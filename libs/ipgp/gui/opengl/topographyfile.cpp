@@ -21,29 +21,191 @@
 #define SEISCOMP_COMPONENT IPGP_TOPOFILE
 
 #include <ipgp/gui/opengl/topographyfile.h>
-#include <ipgp/gui/opengl/vertex.h>
-#include <ipgp/gui/opengl/triangle.h>
-#include <ipgp/core/math/math.h>
 #include <seiscomp3/utils/timer.h>
 #include <seiscomp3/logging/log.h>
-#include <stdio.h>
+#include <QFile>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QtEndian>
 #include <fstream>
+#include <string.h>
+#include <math.h>
 
 using namespace Seiscomp;
 
 
 namespace {
 
-template<typename T> void clearList(QList<T*>& l) {
-	qDeleteAll(l);
-	l.clear();
-}
+//! Running x (longitude), y (latitude) and z (elevation) bounds
+struct Bounds {
+		Bounds() :
+				empty(true) {}
+		void add(const float* v) {
+			if ( empty ) {
+				for (int i = 0; i < 3; ++i)
+					min[i] = max[i] = v[i];
+				empty = false;
+				return;
+			}
+			for (int i = 0; i < 3; ++i) {
+				if ( v[i] < min[i] ) min[i] = v[i];
+				if ( v[i] > max[i] ) max[i] = v[i];
+			}
+		}
+		void merge(const Bounds& other) {
+			if ( other.empty ) return;
+			add(other.min);
+			add(other.max);
+		}
+		void store(IPGP::Gui::OpenGL::TopographyFile::Data& data) const {
+			if ( empty ) return;
+			data.minLongitude = min[0];
+			data.maxLongitude = max[0];
+			data.minLatitude = min[1];
+			data.maxLatitude = max[1];
+			data.minElevation = min[2];
+			data.maxElevation = max[2];
+		}
+		float min[3];
+		float max[3];
+		bool empty;
+};
+
+
+const double powersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+	1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+/**
+ * @brief Scans a decimal floating point number ([+-]digits[.digits][e[+-]digits])
+ *        without going through the locale aware stream machinery.
+ * @param p the current position, moved past the number on success
+ * @param end the end of the buffer
+ * @param value the scanned value
+ * @return true if a number has been scanned, false otherwise
+ */
+inline bool scanFloat(const char*& p, const char* end, float& value) {
+
+	while ( p < end && (*p == ' ' || *p == '\t' || *p == ',' || *p == ';' || *p == '\r') )
+		++p;
+
+	const char* q = p;
+	bool negative = false;
+	if ( q < end && (*q == '-' || *q == '+') ) {
+		negative = (*q == '-');
+		++q;
+	}
 
-template<typename T> void clearVector(QVector<T*>& v) {
-	qDeleteAll(v);
-	v.clear();
+	double mantissa = .0;
+	int exponent = 0;
+	bool digits = false;
+	for (; q < end && *q >= '0' && *q <= '9'; ++q, digits = true)
+		mantissa = mantissa * 10. + (*q - '0');
+
+	if ( q < end && *q == '.' )
+		for (++q; q < end && *q >= '0' && *q <= '9'; ++q, digits = true) {
+			mantissa = mantissa * 10. + (*q - '0');
+			--exponent;
+		}
+
+	if ( !digits ) return false;
+
+	if ( q < end && (*q == 'e' || *q == 'E') ) {
+		const char* e = q + 1;
+		bool negativeExponent = false;
+		if ( e < end && (*e == '-' || *e == '+') ) {
+			negativeExponent = (*e == '-');
+			++e;
+		}
+		int n = 0;
+		bool exponentDigits = false;
+		for (; e < end && *e >= '0' && *e <= '9'; ++e, exponentDigits = true)
+			n = qMin(n * 10 + (*e - '0'), 1000);
+		if ( exponentDigits ) {
+			exponent += negativeExponent ? -n : n;
+			q = e;
+		}
+	}
+
+	if ( exponent > 0 )
+		mantissa *= (exponent <= 22) ? powersOf10[exponent] : pow(10., exponent);
+	else if ( exponent < 0 )
+		mantissa /= (exponent >= -22) ? powersOf10[-exponent] : pow(10., -exponent);
+
+	value = static_cast<float>(negative ? -mantissa : mantissa);
+	p = q;
+
+	return true;
 }
 
+
+/**
+ * @brief XYZ file chunk parser. The first run counts the lines of the chunk,
+ *        the second one parses them into the shared buffer, from the
+ *        output offset on.
+ */
+class XYZChunk : public QRunnable {
+
+	public:
+		XYZChunk(const char* b, const char* e) :
+				begin(b), end(e), buffer(NULL), output(0), lines(0),
+				points(0) {
+			setAutoDelete(false);
+		}
+
+		void run() {
+			if ( buffer )
+				parse();
+			else
+				count();
+		}
+
+		const char* begin;
+		const char* end;
+		float* buffer;
+		int output;
+		int lines;
+		int points;
+		Bounds bounds;
+
+	private:
+		void count() {
+			lines = 0;
+			for (const char* p = begin; p < end; ++p) {
+				p = static_cast<const char*>(memchr(p, '\n', end - p));
+				if ( !p ) {
+					++lines;
+					break;
+				}
+				++lines;
+			}
+		}
+
+		void parse() {
+			float* out = buffer + output;
+			points = 0;
+			const char* p = begin;
+			while ( p < end && points < lines ) {
+				float v[3];
+				if ( scanFloat(p, end, v[0]) && scanFloat(p, end, v[1])
+				        && scanFloat(p, end, v[2]) ) {
+					memcpy(out, v, sizeof(v));
+					out += 3;
+					++points;
+					bounds.add(v);
+				}
+
+				//! Whatever follows the third column is ignored
+				const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+				p = eol ? eol + 1 : end;
+			}
+		}
+};
+
 }
 
 
@@ -53,7 +215,8 @@ namespace OpenGL {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-TopographyFile::Data::Data() {
+TopographyFile::Data::Data() :
+		gridColumns(0), gridRows(0) {
 	minLatitude = maxLatitude = minLongitude = maxLongitude = minElevation
 	        = maxElevation = -1.;
 }
@@ -64,8 +227,10 @@ TopographyFile::Data::Data() {
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyFile::Data::clear() {
-	::clearVector(triangles);
-	::clearVector(vertices);
+	positions.clear();
+	normals.clear();
+	colors.clear();
+	gridColumns = gridRows = 0;
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -152,49 +317,92 @@ XYZFile::~XYZFile() {}
 bool XYZFile::read(const QString& file) {
 
 	_file = file;
-	std::ifstream in(file.toStdString().c_str());
-	if ( !in.good() ) return false;
-
 	_data.clear();
 
+	QFile f(file);
+	if ( !f.open(QIODevice::ReadOnly) ) {
+		SEISCOMP_ERROR("Failed to open XYZ file %s", file.toStdString().c_str());
+		return false;
+	}
+
 	Util::StopWatch sw;
 	sw.restart();
 
-	int count = 0;
-	std::string s0;
-	float n0, n1, n2;
+	const qint64 size = f.size();
+	if ( size == 0 ) return true;
 
-	while ( !in.eof() ) {
-		in >> n0 >> n1 >> n2;
+	QByteArray buffer;
+	const char* data = reinterpret_cast<const char*>(f.map(0, size));
+	if ( !data ) {
+		buffer = f.readAll();
+		data = buffer.constData();
+	}
+	const char* end = data + size;
+
+	//! Split the file in chunks ending on line boundaries
+	const int threads = qMax(1, QThread::idealThreadCount());
+	const int chunkCount = static_cast<int>(qBound<qint64>(1,
+	    size / MinChunkSize, threads * 4));
+
+	QVector<XYZChunk*> chunks;
+	const char* begin = data;
+	for (int i = 1; i <= chunkCount && begin < end; ++i) {
+		const char* stop = (i == chunkCount) ? end : data + size / chunkCount * i;
+		if ( stop < begin ) stop = begin;
+		while ( stop < end && *stop != '\n' )
+			++stop;
+		if ( stop < end ) ++stop;
+		chunks << new XYZChunk(begin, stop);
+		begin = stop;
+	}
 
-		if ( count == 0 ) {
-			_data.minLongitude = _data.maxLongitude = n0;
-			_data.minLatitude = _data.maxLatitude = n1;
-			_data.minElevation = _data.maxElevation = n2;
-		}
+	QThreadPool pool;
+	pool.setMaxThreadCount(threads);
+
+	//! First pass counts lines so that the buffer is allocated once
+	for (int i = 0; i < chunks.size(); ++i)
+		pool.start(chunks[i]);
+	pool.waitForDone();
 
-		if ( _data.minLatitude > n0 )
-		    _data.minLatitude = n0;
-		if ( _data.minLongitude > n1 )
-		    _data.minLongitude = n1;
-		if ( _data.minElevation > n2 )
-		    _data.minElevation = n2;
-
-		if ( _data.maxLatitude < n0 )
-		    _data.maxLatitude = n0;
-		if ( _data.maxLongitude < n1 )
-		    _data.maxLongitude = n1;
-		if ( _data.maxElevation < n2 )
-		    _data.maxElevation = n2;
-
-		_data.vertices << new Vertex(n0, n1, n2);
-		++count;
+	int lines = 0;
+	for (int i = 0; i < chunks.size(); ++i) {
+		chunks[i]->output = lines * 3;
+		lines += chunks[i]->lines;
 	}
-	in.close();
+	_data.positions.resize(lines * 3);
+
+	//! Second pass parses every chunk right at its place
+	for (int i = 0; i < chunks.size(); ++i) {
+		chunks[i]->buffer = _data.positions.data();
+		pool.start(chunks[i]);
+	}
+	pool.waitForDone();
+
+	//! Skipped lines leave holes behind each chunk, squeeze them out and
+	//! reduce bounds
+	Bounds bounds;
+	int points = 0;
+	float* positions = _data.positions.data();
+	for (int i = 0; i < chunks.size(); ++i) {
+		if ( chunks[i]->output != points * 3 )
+			memmove(positions + points * 3, positions + chunks[i]->output,
+			    chunks[i]->points * 3 * sizeof(float));
+		points += chunks[i]->points;
+		bounds.merge(chunks[i]->bounds);
+	}
+	qDeleteAll(chunks);
+
+	_data.positions.resize(points * 3);
+	bounds.store(_data);
+
+	detectGrid();
+
+	if ( points < lines )
+		SEISCOMP_DEBUG("Skipped %d unparsable lines", lines - points);
 
 	QStringList l = file.split('/');
-	SEISCOMP_DEBUG("Loaded XYZ file ../%s in %s", l.last().toStdString().c_str(),
-	    Seiscomp::Core::Time(sw.elapsed()).toString("%T.%f").c_str());
+	SEISCOMP_DEBUG("Loaded XYZ file ../%s (%d points) in %s", l.last().toStdString().c_str(),
+	    points, Seiscomp::Core::Time(sw.elapsed()).toString("%T.%f").c_str());
 
 	return true;
 }
@@ -203,6 +411,67 @@ bool XYZFile::read(const QString& file) {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void XYZFile::detectGrid() {
+
+	_data.gridColumns = _data.gridRows = 0;
+
+	const int count = _data.pointCount();
+	if ( count < 4 ) return;
+
+	const float* p = _data.positions.constData();
+
+	//! Along a line of the grid one coordinate changes, the other doesn't
+	int fast;
+	if ( p[1] == p[4] && p[0] != p[3] )
+		fast = 0;
+	else if ( p[0] == p[3] && p[1] != p[4] )
+		fast = 1;
+	else
+		return;
+	const int slow = 1 - fast;
+
+	int columns = 1;
+	while ( columns < count && p[columns * 3 + slow] == p[slow] )
+		++columns;
+	if ( columns < 2 || columns == count || count % columns != 0 )
+		return;
+	const int rows = count / columns;
+
+	//! Tolerances relative to the sampling steps absorb the rounding of
+	//! the text representation
+	const float fastStep = p[3 + fast] - p[fast];
+	const float slowStep = p[columns * 3 + slow] - p[slow];
+	const float fastTolerance = fabs(fastStep) * 1e-3f;
+	const float slowTolerance = fabs(slowStep) * 1e-3f;
+
+	for (int c = 1; c < columns; ++c)
+		if ( (p[c * 3 + fast] - p[(c - 1) * 3 + fast]) * fastStep <= .0f )
+			return;
+
+	for (int r = 0; r < rows; ++r) {
+		const float* row = p + r * columns * 3;
+		if ( r > 0 && (row[slow] - row[slow - columns * 3]) * slowStep <= .0f )
+			return;
+		for (int c = 0; c < columns; ++c) {
+			const float* v = row + c * 3;
+			if ( fabs(v[slow] - row[slow]) > slowTolerance
+			        || fabs(v[fast] - p[c * 3 + fast]) > fastTolerance )
+				return;
+		}
+	}
+
+	_data.gridColumns = columns;
+	_data.gridRows = rows;
+
+	SEISCOMP_DEBUG("Points form a %dx%d %s ordered grid", columns, rows,
+	    (fast == 0) ? "row" : "column");
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 STLFile::STLFile() :
 		TopographyFile(STL) {}
@@ -219,33 +488,23 @@ STLFile::~STLFile() {}
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-const bool STLFile::isBinarySTL(const QString& file) {
-
-	bool binary = false;
-	FILE* fp = fopen(file.toStdString().c_str(), "r");
-	/* Find size of file */
-	fseek(fp, 0, SEEK_END);
-//	int file_size = ftell(fp);
-	int facenum;
-	/* Check for binary or ASCII file */
-	fseek(fp, STL_LABEL_SIZE, SEEK_SET);
-	fread(&facenum, sizeof(int), 1, fp);
-//	int expected_file_size = STL_LABEL_SIZE + 4 + (sizeof(short) + sizeof(STLFacet)) * facenum;
-//	if ( file_size == expected_file_size )
-//		binary = true;
-	unsigned char tmpbuf[128];
-	fread(tmpbuf, sizeof(tmpbuf), 1, fp);
-	for (unsigned int i = 0; i < sizeof(tmpbuf); i++) {
-		if ( tmpbuf[i] > 127 ) {
-			binary = true;
-			break;
-		}
-	}
+const bool STLFile::isBinarySTL(const uchar* data, const qint64& size) {
+
+	if ( size < STL_LABEL_SIZE + 4 )
+		return false;
+
+	//! A binary file has exactly the size its header announces
+	const quint32 facets = qFromLittleEndian<quint32>(data + STL_LABEL_SIZE);
+	if ( size == STL_LABEL_SIZE + 4 + static_cast<qint64>(facets) * STL_FACET_SIZE )
+		return true;
 
-	// Now we know if the stl file is ascii or binary.
-	fclose(fp);
+	//! Otherwise look for non-ASCII characters after the header
+	const qint64 last = qMin<qint64>(size, STL_LABEL_SIZE + 4 + 128);
+	for (qint64 i = STL_LABEL_SIZE + 4; i < last; ++i)
+		if ( data[i] > 127 )
+			return true;
 
-	return binary;
+	return false;
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -253,31 +512,20 @@ const bool STLFile::isBinarySTL(const QString& file) {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-const bool STLFile::isBinarySTLColored(const QString& file, bool& magicsMode) {
+const bool STLFile::isBinarySTLColored(const uchar* data, const qint64& size,
+                                       bool& magicsMode) {
 
-	FILE* fp = fopen(file.toStdString().c_str(), "rb");
-	char buf[STL_LABEL_SIZE + 1];
-	fread(buf, sizeof(char), STL_LABEL_SIZE, fp);
-	std::string strInput(buf);
+	const std::string strInput(reinterpret_cast<const char*>(data), STL_LABEL_SIZE);
 	size_t cInd = strInput.rfind("COLOR=");
 	size_t mInd = strInput.rfind("MATERIAL=");
-	(cInd != std::string::npos && mInd != std::string::npos) ? magicsMode = true : magicsMode = false;
-	int facenum;
-	fread(&facenum, sizeof(int), 1, fp);
-
-	for (int i = 0; i < std::min(facenum, 1000); ++i) {
-
-		unsigned short attr;
-		Vertex n;
-		Vertex v[3];
-		fread(&n, sizeof(Vertex), 1, fp);
-		fread(&v, sizeof(Vertex), 3, fp);
-		fread(&attr, sizeof(unsigned short), 1, fp);
-
-		//! Check if attr is negative (for an unsigned short? what?)
-		if ( attr != 0 )
-		    if ( attr != static_cast<unsigned short>(0xffffffff) )
-		        return true;
+	magicsMode = (cInd != std::string::npos && mInd != std::string::npos);
+
+	const qint64 facets = (size - STL_LABEL_SIZE - 4) / STL_FACET_SIZE;
+	const uchar* attr = data + STL_LABEL_SIZE + 4 + STL_FACET_SIZE - 2;
+	for (qint64 i = 0; i < qMin<qint64>(facets, 1000); ++i, attr += STL_FACET_SIZE) {
+		const quint16 a = qFromLittleEndian<quint16>(attr);
+		if ( a != 0 && a != 0xffff )
+			return true;
 	}
 
 	return false;
@@ -296,105 +544,143 @@ bool STLFile::read(const QString& file) {
 	Util::StopWatch sw;
 	sw.restart();
 
-	if ( !isBinarySTL(file) ) {
-
-		std::ifstream in(file.toStdString().c_str());
-		if ( !in.good() ) return false;
-
-		char title[80];
-		std::string s0, s1;
-		float n0, n1, n2, f0, f1, f2, f3, f4, f5, f6, f7, f8;
-		in.read(title, 80);
-		while ( !in.eof() ) {
-			in >> s0;                                // facet || endsolid
-			if ( s0 == "facet" ) {
-				in >> s1 >> n0 >> n1 >> n2;            // normal x y z
-				in >> s0 >> s1;            // outer loop
-				in >> s0 >> f0 >> f1 >> f2;            // vertex x y z
-				in >> s0 >> f3 >> f4 >> f5;            // vertex x y z
-				in >> s0 >> f6 >> f7 >> f8;            // vertex x y z
-				in >> s0;            // endloop
-				in >> s0;            // endfacet
-				_data.triangles << new Triangle(Vertex(n0, n1, n2), Vertex(f0, f1, f2),
-				    Vertex(f3, f4, f5), Vertex(f6, f7, f8));
-			}
-			else if ( s0 == "endsolid" ) break;
-		}
-		in.close();
+	QFile f(file);
+	if ( !f.open(QIODevice::ReadOnly) ) {
+		SEISCOMP_ERROR("Failed to open STL file %s", file.toStdString().c_str());
+		return false;
+	}
+
+	const qint64 size = f.size();
+
+	//! Map the whole file, and fall back on a plain read if the platform
+	//! refuses to map it
+	QByteArray buffer;
+	const uchar* data = f.map(0, size);
+	if ( !data ) {
+		buffer = f.readAll();
+		data = reinterpret_cast<const uchar*>(buffer.constData());
 	}
+
+	bool result;
+	if ( isBinarySTL(data, size) )
+		result = readBinary(data, size);
 	else {
+		f.close();
+		result = readASCII(file);
+	}
 
-		//! TODO Re-write this part in pure Qt/c++
-		FILE* f = fopen(file.toStdString().c_str(), "rb");
-		if ( !f )
-		    return false;
+	if ( !result ) {
+		_data.clear();
+		return false;
+	}
 
-		bool magicsMode;
-		bool stlIsColored = isBinarySTLColored(file, magicsMode);
+	QStringList l = file.split('/');
+	SEISCOMP_DEBUG("Loaded STL file ../%s (%d facets) in %s", l.last().toStdString().c_str(),
+	    _data.facetCount(), Seiscomp::Core::Time(sw.elapsed()).toString("%T.%f").c_str());
 
-		char title[80];
-		int nFaces;
-		fread(title, 80, 1, f);
-		fread((void*) &nFaces, 4, 1, f);
-		float v[12]; // normal=3, vertices=3*3 = 12
-		// Every Face is 50 Bytes: Normal(3*float), Vertices(9*float), 2 Bytes Spacer
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-		bool isInit = false;
-		for (int i = 0; i < nFaces; ++i) {
 
-			//! Read the 4 vertices, first being the triangle normal
-			//! TODO Investigate why this method crashes
-//			Vertex vertex[4];
-//			fread((void*)&vertex, sizeof(Vertex), 4, f);
 
-			for (size_t j = 0; j < 12; ++j)
-				fread((void*) &v[j], sizeof(float), 1, f);
 
-			unsigned short attr;
-			fread(&attr, sizeof(unsigned short), 1, f);
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool STLFile::readASCII(const QString& file) {
 
-			if ( !isInit ) {
-				_data.minLongitude = _data.maxLongitude = v[3];
-				_data.minLatitude = _data.maxLatitude = v[4];
-				_data.minElevation = _data.maxElevation = v[5];
-				isInit = true;
-			}
+	std::ifstream in(file.toStdString().c_str());
+	if ( !in.good() ) return false;
 
-			Core::Math::Numbers<float> lats, lons, eles;
-			lats.add(v[4]);
-			lats.add(v[7]);
-			lats.add(v[10]);
-			lons.add(v[2]);
-			lons.add(v[6]);
-			lons.add(v[9]);
-			eles.add(v[5]);
-			eles.add(v[8]);
-			eles.add(v[11]);
-
-			Core::Math::checkIfItIsSmaller<float>(&_data.minLatitude, lats.min());
-			Core::Math::checkIfItIsSmaller<float>(&_data.minLongitude, lons.min());
-			Core::Math::checkIfItIsSmaller<float>(&_data.minElevation, eles.min());
-
-			Core::Math::checkIfItIsBigger<float>(&_data.maxLatitude, lats.max());
-			Core::Math::checkIfItIsBigger<float>(&_data.maxLongitude, lons.max());
-			Core::Math::checkIfItIsBigger<float>(&_data.maxElevation, eles.max());
-
-			//			fread((void*) &uint16, sizeof(unsigned short), 1, f); // spacer between successive faces
-
-			QColor c;
-			(stlIsColored) ? c = getColor(attr) : c = Qt::gray;
-
-			_data.triangles << new Triangle(Vertex(v[0], v[1], v[2], c),
-			    Vertex(v[3], v[4], v[5], c), Vertex(v[6], v[7], v[8], c),
-			    Vertex(v[9], v[10], v[11], c));
+	Bounds bounds;
+	char title[80];
+	std::string s0, s1;
+	float n[3], v[9];
+	in.read(title, 80);
+	while ( !in.eof() ) {
+		in >> s0;                                // facet || endsolid
+		if ( s0 == "facet" ) {
+			in >> s1 >> n[0] >> n[1] >> n[2];        // normal x y z
+			in >> s0 >> s1;                          // outer loop
+			in >> s0 >> v[0] >> v[1] >> v[2];        // vertex x y z
+			in >> s0 >> v[3] >> v[4] >> v[5];        // vertex x y z
+			in >> s0 >> v[6] >> v[7] >> v[8];        // vertex x y z
+			in >> s0;                                // endloop
+			in >> s0;                                // endfacet
+
+			for (int i = 0; i < 3; ++i)
+				_data.normals << n[i];
+			for (int i = 0; i < 9; ++i)
+				_data.positions << v[i];
+			bounds.add(v);
+			bounds.add(v + 3);
+			bounds.add(v + 6);
 		}
-		fclose(f);
+		else if ( s0 == "endsolid" ) break;
 	}
+	in.close();
 
-	QStringList l = file.split('/');
+	bounds.store(_data);
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool STLFile::readBinary(const uchar* data, const qint64& size) {
+
+	qint64 facets = qFromLittleEndian<quint32>(data + STL_LABEL_SIZE);
+	const qint64 available = (size - STL_LABEL_SIZE - 4) / STL_FACET_SIZE;
+	if ( facets > available ) {
+		SEISCOMP_WARNING("STL file %s is truncated: %lld facets announced, "
+			"%lld available", _file.toStdString().c_str(), facets, available);
+		facets = available;
+	}
+
+	bool magicsMode;
+	const bool stlIsColored = isBinarySTLColored(data, size, magicsMode);
+
+	_data.positions.resize(facets * 9);
+	_data.normals.resize(facets * 3);
+	if ( stlIsColored )
+		_data.colors.resize(facets);
+
+	float* positions = _data.positions.data();
+	float* normals = _data.normals.data();
+
+	//! Every facet is 50 bytes: normal (3 floats), vertices (9 floats) and
+	//! a 2 bytes attribute. Records aren't 4 bytes aligned, hence memcpy.
+	Bounds bounds;
+	const uchar* record = data + STL_LABEL_SIZE + 4;
+	for (qint64 i = 0; i < facets; ++i, record += STL_FACET_SIZE) {
+
+		float v[12];
+		memcpy(v, record, sizeof(v));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+		for (int j = 0; j < 12; ++j) {
+			quint32 w;
+			memcpy(&w, v + j, 4);
+			w = qFromLittleEndian<quint32>(w);
+			memcpy(v + j, &w, 4);
+		}
+#endif
+
+		memcpy(normals, v, 3 * sizeof(float));
+		memcpy(positions, v + 3, 9 * sizeof(float));
+		normals += 3;
+		positions += 9;
+
+		bounds.add(v + 3);
+		bounds.add(v + 6);
+		bounds.add(v + 9);
+
+		if ( stlIsColored )
+			_data.colors[i] = getColor(qFromLittleEndian<quint16>(record + 48)).rgb();
+	}
 
-	SEISCOMP_DEBUG("Loaded STL file ../%s in %s", l.last().toStdString().c_str(),
-	    Seiscomp::Core::Time(sw.elapsed()).toString("%T.%f").c_str());
+	bounds.store(_data);
 
 	return true;
 }
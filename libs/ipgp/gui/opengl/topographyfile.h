@@ -33,9 +33,6 @@ namespace IPGP {
 namespace Gui {
 namespace OpenGL {
 
-DEFINE_IPGP_SMARTPOINTER(Triangle);
-DEFINE_IPGP_SMARTPOINTER(Vertex);
-
 DEFINE_IPGP_SMARTPOINTER(TopographyFile);
 /**
  * @class   TopographyFile
@@ -54,13 +51,32 @@ class SC_IPGP_GUI_API TopographyFile {
 			XYZ 		//! XYZ file (points cloud)
 		};
 
-		typedef QVector<Triangle*> TriangleList;
-		typedef QVector<Vertex*> VertexList;
+		typedef QVector<float> FloatBuffer;
 		struct Data {
 				Data();
 				void clear();
-				TriangleList triangles;
-				VertexList vertices;
+				//! Number of facets stored in the flat buffers
+				int facetCount() const {
+					return normals.size() / 3;
+				}
+				int pointCount() const {
+					return positions.size() / 3;
+				}
+				//! Whether the points (XYZ) lie on a regular grid
+				bool isGrid() const {
+					return gridColumns > 1 && gridRows > 1;
+				}
+				//! Flat x,y,z triplets, three per facet (STL) or one per
+				//! point (XYZ)
+				FloatBuffer positions;
+				//! Grid layout of the points in file order: gridColumns
+				//! points per line of the grid, 0 if not gridded
+				int gridColumns;
+				int gridRows;
+				//! Flat x,y,z triplets, one per facet (STL)
+				FloatBuffer normals;
+				//! Per facet colors, only filled by colored binary STL files
+				QVector<QRgb> colors;
 				float minLatitude;
 				float maxLatitude;
 				float minLongitude;
@@ -118,7 +134,28 @@ class SC_IPGP_GUI_API XYZFile : public TopographyFile {
 		// ------------------------------------------------------------------
 		//  Public interface
 		// ------------------------------------------------------------------
+		/**
+		 * @brief Parses the file in parallel: the memory-mapped content is
+		 *        split in chunks on line boundaries which are scanned by
+		 *        a pool of threads straight into the positions buffer.
+		 *        Each line holds the longitude, latitude and elevation of
+		 *        a point, unparsable lines are skipped.
+		 *        Points sampled on a regular longitude/latitude grid (in
+		 *        either row or column order) are detected and their layout
+		 *        recorded in the data, so that they can be triangulated
+		 *        without looking for neighbours.
+		 */
 		bool read(const QString&);
+
+	private:
+		// ------------------------------------------------------------------
+		//  Private interface
+		// ------------------------------------------------------------------
+		//! Checks in one pass whether the points form a grid
+		void detectGrid();
+
+		//! Chunks are never smaller than this, in bytes
+		static const qint64 MinChunkSize = 1 << 20;
 };
 
 
@@ -136,7 +173,8 @@ class SC_IPGP_GUI_API STLFile : public TopographyFile {
 		//  Nested types
 		// ------------------------------------------------------------------
 		enum {
-			STL_LABEL_SIZE = 80
+			STL_LABEL_SIZE = 80,
+			STL_FACET_SIZE = 50
 		};
 
 		enum STLError {
@@ -162,8 +200,18 @@ class SC_IPGP_GUI_API STLFile : public TopographyFile {
 		// ------------------------------------------------------------------
 		//  Private interface
 		// ------------------------------------------------------------------
-		const bool isBinarySTL(const QString&);
-		const bool isBinarySTLColored(const QString&, bool&);
+		const bool isBinarySTL(const uchar* data, const qint64& size);
+		const bool isBinarySTLColored(const uchar* data, const qint64& size,
+		                              bool& magicsMode);
+		bool readASCII(const QString&);
+		/**
+		 * @brief Decodes a binary STL file in one pass: facets are copied
+		 *        straight into the flat buffers and bounds are computed
+		 *        along the way.
+		 * @param data the file content (usually memory-mapped)
+		 * @param size the file size
+		 */
+		bool readBinary(const uchar* data, const qint64& size);
 		QColor getColor(const unsigned short&);
 };
 
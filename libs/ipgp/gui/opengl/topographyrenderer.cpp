@@ -23,8 +23,10 @@
 #include <ipgp/gui/opengl/topographyrenderer.h>
 #include <ipgp/gui/opengl/topographyfile.h>
 #include <ipgp/gui/opengl/camera.h>
-#include <ipgp/gui/opengl/triangle.h>
 #include <ipgp/gui/opengl/gl.h>
+#include <ipgp/gui/opengl/mesh.h>
+#include <ipgp/gui/opengl/meshbuffer.h>
+#include <ipgp/gui/opengl/terrainquadtree.h>
 #include <ipgp/gui/opengl/drawables/arrival.h>
 #include <ipgp/gui/opengl/drawables/hypocenter.h>
 #include <ipgp/gui/opengl/drawables/station.h>
@@ -40,6 +42,7 @@
 #include <QtOpenGL>
 #include <QMatrix4x4>
 #include <qmath.h>
+#include <limits>
 
 
 
@@ -65,13 +68,75 @@ template<typename T> void clearList(QList<T*>& l) {
 	l.clear();
 }
 
-template<typename T> void clearVector(QVector<T*>& v) {
-//	if ( v.size() == 0 ) return;
-	qDeleteAll(v);
-	v.clear();
+QString stationKey(const QString& network, const QString& code) {
+	return QString("%1.%2").arg(network).arg(code);
 }
 
 
+using namespace IPGP::Gui::OpenGL;
+
+/**
+ * @brief Ray/triangles test of the full resolution triangles of a leaf of
+ *        the terrain quadtree (Moller-Trumbore).
+ */
+class TerrainHit : public BoundingVolumeHierarchy::Visitor {
+
+	public:
+		TerrainHit(const GLfloat* v, const GLuint* i,
+		           const TerrainQuadtree::NodeList& n, const QVector<int>& l) :
+				vertices(v), indices(i), nodes(n), leaves(l) {}
+
+		bool intersect(const int& primitive, const Ray& ray, GLfloat& distance) {
+
+			const TerrainQuadtree::Node& node = nodes.at(leaves.at(primitive));
+			const GLfloat* d = ray.direction;
+			bool hit = false;
+
+			for (int k = node.first; k < node.first + node.count; k += 3) {
+
+				const GLfloat* a = vertices + indices[k] * 3;
+				const GLfloat* b = vertices + indices[k + 1] * 3;
+				const GLfloat* c = vertices + indices[k + 2] * 3;
+
+				const GLfloat e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				const GLfloat e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				const GLfloat p[3] = { d[1] * e2[2] - d[2] * e2[1],
+				                       d[2] * e2[0] - d[0] * e2[2],
+				                       d[0] * e2[1] - d[1] * e2[0] };
+				const GLfloat det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+				if ( det == .0f ) continue;
+
+				const GLfloat inv = 1.f / det;
+				const GLfloat s[3] = { ray.origin[0] - a[0], ray.origin[1] - a[1],
+				                       ray.origin[2] - a[2] };
+				const GLfloat u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+				if ( u < .0f || u > 1.f ) continue;
+
+				const GLfloat q[3] = { s[1] * e1[2] - s[2] * e1[1],
+				                       s[2] * e1[0] - s[0] * e1[2],
+				                       s[0] * e1[1] - s[1] * e1[0] };
+				const GLfloat v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv;
+				if ( v < .0f || u + v > 1.f ) continue;
+
+				const GLfloat t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+				if ( t < .0f || t >= distance ) continue;
+
+				distance = t;
+				hit = true;
+			}
+
+			return hit;
+		}
+
+	private:
+		const GLfloat* vertices;
+		const GLuint* indices;
+		const TerrainQuadtree::NodeList& nodes;
+		const QVector<int>& leaves;
+};
+
+
+
 
 }
 
@@ -99,8 +164,7 @@ TopographyRenderer::TopographyRenderer(QWidget* parent, Qt::WFlags f) :
 	        = _maxElevation = .0;
 	_viewer = NONE;
 
-	_pointsCloud = _mesh = _filled = _filledMesh = _graticule = _oHypocenters
-	        = _oArrivals = _oStations = _oCrossSections = 0;
+	_graticule = _oArrivals = _oCrossSections = 0;
 
 	_rendering = POINTCLOUD;
 
@@ -111,24 +175,30 @@ TopographyRenderer::TopographyRenderer(QWidget* parent, Qt::WFlags f) :
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+TopographyRenderer::Pick::Pick() :
+		object(PICKED_NOTHING), hypocenter(NULL), station(NULL), distance(.0) {
+	position[0] = position[1] = position[2] = .0;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 TopographyRenderer::~TopographyRenderer() {
 
 	makeCurrent();
 
-	glDeleteLists(_pointsCloud, 1);
-	glDeleteLists(_mesh, 1);
-	glDeleteLists(_filledMesh, 1);
-	glDeleteLists(_filled, 1);
+	_terrainBuffer.clear();
+	_hypocenterSpheres.clear();
+	_stationSpheres.clear();
+
 	glDeleteLists(_graticule, 1);
 	glDeleteLists(_texture, 1);
 	glDeleteLists(_oArrivals, 1);
 	glDeleteLists(_oCrossSections, 1);
-	glDeleteLists(_oHypocenters, 1);
-	glDeleteLists(_oStations, 1);
 
-	::clearVector(_triangles);
-	::clearVector(_vertices);
 	::clearList(_stations);
 	::clearList(_arrivals);
 	::clearList(_crossSections);
@@ -146,11 +216,45 @@ TopographyRenderer::~TopographyRenderer() {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyRenderer::event(QEvent* event) {
+
+	if ( event->type() != QEvent::ToolTip )
+	    return Renderer::event(event);
+
+	QHelpEvent* help = static_cast<QHelpEvent*>(event);
+
+	Pick p;
+	QString text;
+	if ( !mouseGrabbed() && pick(help->pos(), p) ) {
+		if ( p.object == PICKED_HYPOCENTER )
+			text = QString("%1\nMagnitude: %2\nDepth: %3 km").arg(p.hypocenter->name())
+			    .arg(p.hypocenter->magnitude(), 0, 'f', 1).arg(p.hypocenter->depth(), 0, 'f', 1);
+		else if ( p.object == PICKED_STATION )
+			text = QString("%1\nNetwork: %2").arg(p.station->name()).arg(p.station->network());
+	}
+
+	if ( text.isEmpty() ) {
+		QToolTip::hideText();
+		event->ignore();
+	}
+	else
+		QToolTip::showText(help->globalPos(), text, this);
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::mousePressEvent(QMouseEvent* event) {
 
 	Renderer::mousePressEvent(event);
 
+	_pressPos = event->pos();
+
 	if ( !mouseGrabbed() )
 	    if ( event->buttons() & Qt::RightButton )
 	        _contextMenu.exec(mapToGlobal(event->pos()));
@@ -160,6 +264,31 @@ void TopographyRenderer::mousePressEvent(QMouseEvent* event) {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TopographyRenderer::mouseReleaseEvent(QMouseEvent* event) {
+
+	Renderer::mouseReleaseEvent(event);
+
+	if ( mouseGrabbed() || event->button() != Qt::LeftButton )
+	    return;
+
+	if ( (event->pos() - _pressPos).manhattanLength() >= QApplication::startDragDistance() )
+	    return;
+
+	Pick p;
+	if ( !pick(event->pos(), p) )
+	    return;
+
+	if ( p.object == PICKED_HYPOCENTER )
+		emit hypocenterClicked(p.hypocenter);
+	else if ( p.object == PICKED_STATION )
+		emit stationClicked(p.station);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::initTexture() {
 
@@ -382,16 +511,16 @@ void TopographyRenderer::drawWithLight() {
 	switch ( _rendering ) {
 		case POINTCLOUD:
 			// Do we really need light on points??
-//			glCallList(_pointsCloud);
 		break;
 		case MESH:
-			glCallList(_mesh);
+			drawTerrainMesh(Qt::white);
 		break;
 		case FILLED:
-			glCallList(_filled);
+			drawFilledTerrain();
 		break;
 		case FILLEDMESH:
-			glCallList(_filledMesh);
+			drawFilledTerrain();
+			drawTerrainMesh(Qt::black);
 		break;
 		default:
 			break;
@@ -411,11 +540,25 @@ void TopographyRenderer::drawWithLight() {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::drawWithoutLight() {
 
+	//! The modelview matrix holds the camera transformations by now, they
+	//! are kept for the culling of this frame and for picking
+	_frustum.update();
+
+	//! Terrain buffers hold raw (x,y,z) values, they are drawn, culled and
+	//! picked through the axes swap GL::vertex() applies to the rest
+	glPushMatrix();
+	GL::swapAxes();
+	_terrainFrustum.update();
+	glPopMatrix();
+
 	if ( _activeSettings.graticuleVisible() )
 	    drawGraticule();
 
-	if ( _rendering == POINTCLOUD )
-	    glCallList(_pointsCloud);
+	if ( _rendering == POINTCLOUD ) {
+		glLineWidth(1.);
+		qglColor(Qt::white);
+		drawTerrainChunks(GL_POINTS, false, false);
+	}
 
 	drawArrivals();
 	drawCrossSections();
@@ -429,7 +572,99 @@ void TopographyRenderer::drawWithoutLight() {
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::drawHypocenters() {
-	glCallList(_oHypocenters);
+	_hypocenterSpheres.draw();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyRenderer::pick(const QPoint& pos, Pick& pick) {
+
+	pick = Pick();
+
+	Ray ray;
+	if ( !_frustum.ray(pos.x(), pos.y(), ray) )
+	    return false;
+
+	GLfloat distance = std::numeric_limits<GLfloat>::max();
+
+	//! The axes swap is a rotation, distances along both rays match
+	Ray terrainRay;
+	if ( !_terrainPickingTree.isEmpty() && _terrainFrustum.ray(pos.x(), pos.y(), terrainRay) ) {
+		TerrainHit hit(_terrainBuffer.vertices(), _terrainBuffer.indices(),
+		    _terrainTree.nodes(), _terrainPickingNodes);
+		if ( _terrainPickingTree.intersect(terrainRay, hit, distance) >= 0 )
+		    pick.object = PICKED_TERRAIN;
+	}
+
+	//! Objects are tested against the nearest hit so far, so that those
+	//! hidden by the terrain aren't picked
+	int handle = _hypocenterSpheres.pick(ray, distance);
+	if ( handle >= 0 ) {
+		pick.object = PICKED_HYPOCENTER;
+		pick.hypocenter = _hypocenterObjects.value(handle, NULL);
+	}
+
+	handle = _stationSpheres.pick(ray, distance);
+	if ( handle >= 0 ) {
+		pick.object = PICKED_STATION;
+		pick.hypocenter = NULL;
+		pick.station = _stationObjects.value(handle, NULL);
+	}
+
+	if ( pick.object == PICKED_NOTHING )
+	    return false;
+
+	pick.distance = distance;
+	ray.at(distance, pick.position);
+
+	return true;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TopographyRenderer::buildTerrainPickingTree() {
+
+	_terrainPickingTree.clear();
+	_terrainPickingNodes.clear();
+
+	if ( _terrainTree.isEmpty() || !_terrainBuffer.vertices() || !_terrainBuffer.indices() )
+	    return;
+
+	Util::StopWatch sw;
+	sw.restart();
+
+	const TerrainQuadtree::NodeList& nodes = _terrainTree.nodes();
+	BoundingVolumeHierarchy::BoxList boxes;
+	for (int i = 0; i < nodes.size(); ++i) {
+		if ( !nodes.at(i).isLeaf() || nodes.at(i).count == 0 ) continue;
+		BoundingVolumeHierarchy::Box box;
+		for (int k = 0; k < 3; ++k) {
+			box.min[k] = nodes.at(i).min[k];
+			box.max[k] = nodes.at(i).max[k];
+		}
+		boxes.append(box);
+		_terrainPickingNodes.append(i);
+	}
+
+	_terrainPickingTree.build(boxes);
+
+	SEISCOMP_DEBUG("Picking tree of %d terrain chunks built in %s", boxes.size(),
+	    Time(sw.elapsed()).toString("%T.%f").c_str());
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+GLfloat TopographyRenderer::hypocenterRadius(Hypocenter* h) const {
+	return ((4.9 * (h->magnitude() - 1.2)) / 2.) * _vObjCoeff;
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -438,7 +673,7 @@ void TopographyRenderer::drawHypocenters() {
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::drawStations() {
-	glCallList(_oStations);
+	_stationSpheres.draw();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -680,27 +915,26 @@ Vertex TopographyRenderer::getPointFromVertex(const Vertex& v,
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::updateHypocenters() {
+	updateHypocenters(_hypocenters);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	makeCurrent();
-
-	if ( glIsList(_oHypocenters) )
-	    glDeleteLists(_oHypocenters, 1);
-	_oHypocenters = glGenLists(1);
-
-	if ( _oHypocenters == 0 ) return;
-
-	glNewList(_oHypocenters, GL_COMPILE);
 
 
 
-	QListIterator<Hypocenter*> itH(_hypocenters);
-	while ( itH.hasNext() ) {
-		Hypocenter* h = itH.next();
-		GL::drawSphere(((4.9 * (h->magnitude() - 1.2)) / 2.) * _vObjCoeff,
-		    h->vertex().x(), h->vertex().y(), h->vertex().z(), h->color());
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TopographyRenderer::updateHypocenters(const HypocenterList& list) {
+
+	//! Only the chunks holding hypocenters which changed get recompiled
+	for (int i = 0; i < list.size(); ++i) {
+		Hypocenter* h = list.at(i);
+		QHash<Hypocenter*, int>::const_iterator it = _hypocenterHandles.constFind(h);
+		if ( it == _hypocenterHandles.constEnd() ) continue;
+		_hypocenterSpheres.update(it.value(), h->vertex().x(), h->vertex().y(),
+		    h->vertex().z(), hypocenterRadius(h), h->color());
 	}
-	glEndList();
 
+	update();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -709,22 +943,25 @@ void TopographyRenderer::updateHypocenters() {
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::updateStations() {
+	updateStations(_stations);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	makeCurrent();
 
-	if ( glIsList(_oStations) )
-	    glDeleteLists(_oStations, 1);
-	_oStations = glGenLists(1);
 
-	if ( _oStations == 0 ) return;
 
-	glNewList(_oStations, GL_COMPILE);
-	QListIterator<Station*> itS(_stations);
-	while ( itS.hasNext() ) {
-		Station* s = itS.next();
-		GL::drawSphere(_vObjCoeff, s->vertex().x(), s->vertex().y(), s->vertex().z(), s->color());
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TopographyRenderer::updateStations(const StationList& list) {
+
+	for (int i = 0; i < list.size(); ++i) {
+		Station* s = list.at(i);
+		QHash<Station*, int>::const_iterator it = _stationHandles.constFind(s);
+		if ( it == _stationHandles.constEnd() ) continue;
+		_stationSpheres.update(it.value(), s->vertex().x(), s->vertex().y(),
+		    s->vertex().z(), _vObjCoeff, s->color());
 	}
-	glEndList();
+
+	update();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -886,32 +1123,16 @@ void TopographyRenderer::reassessObjectsPosition() {
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::loadSTL(const QString& file) {
+	loadTopography(file, TopographyFile::STL);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	if ( _file )
-	    delete _file;
-	_file = NULL;
-
-	_filename = file;
-
-	_file = new STLFile;
-	if ( _file->read(file) ) {
 
-		::clearVector(_triangles);
-		::clearVector(_vertices);
 
-		_triangles = _file->data().triangles;
-		_vertices = _file->data().vertices;
-		_minLatitude = _file->data().minLatitude;
-		_maxLatitude = _file->data().maxLatitude;
-		_minLongitude = _file->data().minLongitude;
-		_maxLongitude = _file->data().maxLongitude;
-		_minElevation = _file->data().minElevation;
-		_maxElevation = _file->data().maxElevation;
 
-		processData();
-	}
-	else
-		SEISCOMP_ERROR("Couldn't parse file %s as STL file", file.toStdString().c_str());
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TopographyRenderer::loadXYZ(const QString& file) {
+	loadTopography(file, TopographyFile::XYZ);
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -919,33 +1140,70 @@ void TopographyRenderer::loadSTL(const QString& file) {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void TopographyRenderer::loadXYZ(const QString& file) {
+void TopographyRenderer::loadTopography(const QString& file,
+                                        const TopographyFile::Type& type) {
 
 	if ( _file )
 	    delete _file;
 	_file = NULL;
 
+	//! Client side arrays may point into the mapped cache, the buffer has
+	//! to let go of them before it gets unmapped
+	makeCurrent();
+	_terrainBuffer.clear();
+
+	_cache.close();
+	_terrain.clear();
+	_terrainTree.clear();
+	_terrainPickingTree.clear();
+	_terrainPickingNodes.clear();
+
 	_filename = file;
 
-	_file = new XYZFile;
-	if ( _file->read(file) ) {
+	const QString cacheFile = TopographyCache::fileName(file);
+	if ( _cache.open(cacheFile, type) && _cache.isUpToDate(file) ) {
 
-		::clearVector(_triangles);
-		::clearVector(_vertices);
+		SEISCOMP_DEBUG("Loading topography from cache %s", cacheFile.toStdString().c_str());
 
-		_triangles = _file->data().triangles;
-		_vertices = _file->data().vertices;
-		_minLatitude = _file->data().minLatitude;
-		_maxLatitude = _file->data().maxLatitude;
-		_minLongitude = _file->data().minLongitude;
-		_maxLongitude = _file->data().maxLongitude;
-		_minElevation = _file->data().minElevation;
-		_maxElevation = _file->data().maxElevation;
+		const TopographyCache::Header* header = _cache.header();
+		_minLatitude = header->minLatitude;
+		_maxLatitude = header->maxLatitude;
+		_minLongitude = header->minLongitude;
+		_maxLongitude = header->maxLongitude;
+		_minElevation = header->minElevation;
+		_maxElevation = header->maxElevation;
 
 		processData();
+		return;
 	}
+	_cache.close();
+
+	if ( type == TopographyFile::STL )
+		_file = new STLFile;
 	else
-		SEISCOMP_ERROR("Couldn't parse file %s as XYZ file", file.toStdString().c_str());
+		_file = new XYZFile;
+
+	if ( !_file->read(file) ) {
+		SEISCOMP_ERROR("Couldn't parse file %s as %s file", file.toStdString().c_str(),
+		    (type == TopographyFile::STL) ? "STL" : "XYZ");
+		return;
+	}
+
+	_minLatitude = _file->data().minLatitude;
+	_maxLatitude = _file->data().maxLatitude;
+	_minLongitude = _file->data().minLongitude;
+	_maxLongitude = _file->data().maxLongitude;
+	_minElevation = _file->data().minElevation;
+	_maxElevation = _file->data().maxElevation;
+
+	TopographyCache::buildMesh(_file->data(), _terrain, _terrainTree);
+
+	//! A read-only topography directory only costs the rebuild next time
+	QString error;
+	if ( !TopographyCache::write(cacheFile, file, *_file, _terrain, _terrainTree, &error) )
+		SEISCOMP_WARNING("Topography cache not written: %s", error.toStdString().c_str());
+
+	processData();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1013,161 +1271,25 @@ void TopographyRenderer::setAvailableSettings(const SettingsList& l) {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::processData() {
 
-	//! Pre-store vertices in video memory
-	makeCurrent();
-
-	if ( glIsList(_mesh) )
-	    glDeleteLists(_mesh, 1);
-	_mesh = glGenLists(1);
-
-	if ( glIsList(_filled) )
-	    glDeleteLists(_filled, 1);
-	_filled = glGenLists(1);
-
-	if ( glIsList(_filledMesh) )
-	    glDeleteLists(_filledMesh, 1);
-	_filledMesh = glGenLists(1);
-
-	if ( glIsList(_pointsCloud) )
-	    glDeleteLists(_pointsCloud, 1);
-	_pointsCloud = glGenLists(1);
-
-	if ( _mesh == 0 && _filledMesh == 0 && _filled == 0 && _pointsCloud == 0 ) {
-		SEISCOMP_ERROR("Failed to generate rendering buffers");
-		return;
-	}
-
 	Util::StopWatch sw;
 	sw.restart();
 
-
-	//! STL file
-	if ( _triangles.size() > 0 ) {
-
-		::clearVector(_vertices);
-
-		//! Mesh
-		glNewList(_mesh, GL_COMPILE);
-		glLineWidth(1.);
-		qglColor(Qt::white);
-		for (TriangleList::const_iterator it = _triangles.constBegin();
-		        it != _triangles.constEnd(); ++it) {
-			glBegin(GL_LINES);
-			GL::normal((*it)->normal());
-			GL::vertex((*it)->vertexA());
-			GL::vertex((*it)->vertexB());
-			GL::vertex((*it)->vertexC());
-			glEnd();
-		}
-		glEndList();
-
-
-		//! Filled polygons + mesh
-		glNewList(_filledMesh, GL_COMPILE);
-
-		if ( _activeSettings.textureVisible() ) {
-			glEnable(GL_TEXTURE_2D);
-			glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-		}
-
-		glLineWidth(1.);
-		qglColor(Qt::white);
-		for (TriangleList::const_iterator it = _triangles.constBegin();
-		        it != _triangles.constEnd(); ++it) {
-			glBegin(GL_TRIANGLE_STRIP);
-			//					qglColor((*it)->vertexA().color());
-			GL::normal((*it)->normal());
-			if ( _activeSettings.textureVisible() )
-			    glTexCoord2f(0, 0);
-			GL::vertex((*it)->vertexA());
-			if ( _activeSettings.textureVisible() )
-			    glTexCoord2f(1, 0);
-			GL::vertex((*it)->vertexB());
-			if ( _activeSettings.textureVisible() )
-			    glTexCoord2f(0, 1);
-			GL::vertex((*it)->vertexC());
-			glEnd();
-		}
-		if ( _activeSettings.textureVisible() )
-		    glDisable(GL_TEXTURE_2D);
-
-		qglColor(Qt::black);
-		for (TriangleList::const_iterator it = _triangles.constBegin();
-		        it != _triangles.constEnd(); ++it) {
-			glBegin(GL_LINES);
-			GL::normal((*it)->normal());
-			GL::vertex((*it)->vertexA());
-			GL::vertex((*it)->vertexB());
-			GL::vertex((*it)->vertexC());
-			glEnd();
-		}
-		glEndList();
-
-		//! Filled polygons
-		glNewList(_filled, GL_COMPILE);
-
-		if ( _activeSettings.textureVisible() ) {
-			glEnable(GL_TEXTURE_2D);
-			glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-		}
-
-		glLineWidth(1.);
-		qglColor(Qt::white);
-		for (TriangleList::const_iterator it = _triangles.constBegin();
-		        it != _triangles.constEnd(); ++it) {
-			glBegin(GL_TRIANGLE_STRIP);
-			GL::normal((*it)->normal());
-			if ( _activeSettings.textureVisible() )
-			    glTexCoord2f(0, 0);
-			GL::vertex((*it)->vertexA());
-			if ( _activeSettings.textureVisible() )
-			    glTexCoord2f(1, 0);
-			GL::vertex((*it)->vertexB());
-			if ( _activeSettings.textureVisible() )
-			    glTexCoord2f(0, 1);
-			GL::vertex((*it)->vertexC());
-			glEnd();
-		}
-
-		if ( _activeSettings.textureVisible() )
-		    glDisable(GL_TEXTURE_2D);
-
-		glEndList();
-
-
-		//! Points cloud
-		glNewList(_pointsCloud, GL_COMPILE);
-		glLineWidth(1.);
-		qglColor(Qt::white);
-		glBegin(GL_POINTS);
-		for (TriangleList::const_iterator it = _triangles.constBegin();
-		        it != _triangles.constEnd(); ++it) {
-			GL::normal((*it)->normal());
-			GL::vertex((*it)->vertexA());
-			GL::vertex((*it)->vertexB());
-			GL::vertex((*it)->vertexC());
-		}
-		glEnd();
-		glEndList();
+	//! Upload the terrain once, every rendering mode is drawn from the
+	//! same buffers
+	makeCurrent();
+	bool bufferObjects;
+	if ( _cache.isOpen() ) {
+		_terrainTree.assign(_cache.nodes(), _cache.nodeCount());
+		bufferObjects = _terrainBuffer.upload(_cache.vertices(), _cache.normals(),
+		    _cache.texCoords(), _cache.vertexCount(), _cache.indices(), _cache.indexCount());
 	}
+	else
+		bufferObjects = _terrainBuffer.upload(_terrainTree.isEmpty() ? _terrain : _terrainTree.mesh());
 
-	//! XYZ file
-	else if ( _vertices.size() > 0 ) {
+	if ( !bufferObjects && !_terrainBuffer.isEmpty() )
+		SEISCOMP_DEBUG("Terrain is drawn from client side vertex arrays");
 
-		::clearVector(_triangles);
-		//! Points cloud
-		glNewList(_pointsCloud, GL_COMPILE);
-		glLineWidth(1.);
-		qglColor(Qt::white);
-		glBegin(GL_POINTS);
-		for (VertexList::const_iterator it = _vertices.constBegin();
-		        it != _vertices.constEnd(); ++it) {
-			GL::normal((*it)->x(), (*it)->y(), (*it)->z());
-			GL::vertex((*it)->x(), (*it)->y(), (*it)->z());
-		}
-		glEnd();
-		glEndList();
-	}
+	buildTerrainPickingTree();
 
 	setBoundingBox(_minLongitude, _maxLongitude, _minLatitude, _maxLatitude, _minElevation, _maxElevation);
 	makeGraticule();
@@ -1195,8 +1317,8 @@ void TopographyRenderer::processData() {
 	SEISCOMP_DEBUG("Longitudes: [%f;%f] [%f;%f]", minLon, maxLon, _minLongitude, _maxLongitude);
 	SEISCOMP_DEBUG("Latitudes : [%f;%f] [%f;%f]", minLat, maxLat, _minLatitude, _maxLatitude);
 	SEISCOMP_DEBUG("Elevation : [%f;%f] [%f;%f]", minEleB, maxEleA, _minElevation, _maxElevation);
-	SEISCOMP_DEBUG("Vertices  : %d", _vertices.size());
-	SEISCOMP_DEBUG("Triangles : %d", _triangles.size());
+	SEISCOMP_DEBUG("Vertices  : %d", _terrainBuffer.vertexCount());
+	SEISCOMP_DEBUG("Triangles : %d", _terrainBuffer.indexCount() / 3);
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1204,109 +1326,35 @@ void TopographyRenderer::processData() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void TopographyRenderer::updateTexturedData() {
-
-	//! Pre-store vertices in video memory
-	makeCurrent();
-
-	if ( glIsList(_filled) )
-	    glDeleteLists(_filled, 1);
-	_filled = glGenLists(1);
-
-	if ( glIsList(_filledMesh) )
-	    glDeleteLists(_filledMesh, 1);
-	_filledMesh = glGenLists(1);
-
-	if ( _filledMesh == 0 && _filled == 0 ) {
-		SEISCOMP_ERROR("Failed to generate rendering buffers");
-		return;
-	}
-
-	//! STL file
-	if ( _triangles.size() == 0 ) {
-		SEISCOMP_ERROR("There is no data to fill the polygons buffers");
-		return;
-	}
-
-	Util::StopWatch sw;
-	sw.restart();
+void TopographyRenderer::drawFilledTerrain() {
 
-	//! Filled polygons + mesh
-	glNewList(_filledMesh, GL_COMPILE);
+	const bool textured = _activeSettings.textureVisible();
 
-	if ( _activeSettings.textureVisible() ) {
+	if ( textured ) {
 		glEnable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, _texture);
 		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 	}
 
-	glLineWidth(1.);
 	qglColor(Qt::white);
-	for (TriangleList::const_iterator it = _triangles.constBegin();
-	        it != _triangles.constEnd(); ++it) {
-		glBegin(GL_TRIANGLE_STRIP);
-		//					qglColor((*it)->vertexA().color());
-		GL::normal((*it)->normal());
-		if ( _activeSettings.textureVisible() )
-		    glTexCoord2f(0, 0);
-		GL::vertex((*it)->vertexA());
-		if ( _activeSettings.textureVisible() )
-		    glTexCoord2f(1, 0);
-		GL::vertex((*it)->vertexB());
-		if ( _activeSettings.textureVisible() )
-		    glTexCoord2f(0, 1);
-		GL::vertex((*it)->vertexC());
-		glEnd();
-	}
-	if ( _activeSettings.textureVisible() )
+	drawTerrainChunks(GL_TRIANGLES, textured, true);
+
+	if ( textured )
 	    glDisable(GL_TEXTURE_2D);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	qglColor(Qt::black);
-	for (TriangleList::const_iterator it = _triangles.constBegin();
-	        it != _triangles.constEnd(); ++it) {
-		glBegin(GL_LINES);
-		GL::normal((*it)->normal());
-		GL::vertex((*it)->vertexA());
-		GL::vertex((*it)->vertexB());
-		GL::vertex((*it)->vertexC());
-		glEnd();
-	}
-	glEndList();
 
 
-	//! Filled polygons
-	glNewList(_filled, GL_COMPILE);
 
-	if ( _activeSettings.textureVisible() ) {
-		glEnable(GL_TEXTURE_2D);
-		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-	}
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void TopographyRenderer::drawTerrainMesh(const QColor& color) {
 
 	glLineWidth(1.);
-	qglColor(Qt::white);
-	for (TriangleList::const_iterator it = _triangles.constBegin();
-	        it != _triangles.constEnd(); ++it) {
-		glBegin(GL_TRIANGLE_STRIP);
-		//					qglColor((*it)->vertexA().color());
-		GL::normal((*it)->normal());
-		if ( _activeSettings.textureVisible() )
-		    glTexCoord2f(0, 0);
-		GL::vertex((*it)->vertexA());
-		if ( _activeSettings.textureVisible() )
-		    glTexCoord2f(1, 0);
-		GL::vertex((*it)->vertexB());
-		if ( _activeSettings.textureVisible() )
-		    glTexCoord2f(0, 1);
-		GL::vertex((*it)->vertexC());
-		glEnd();
-	}
-
-	if ( _activeSettings.textureVisible() )
-	    glDisable(GL_TEXTURE_2D);
-
-	glEndList();
-
-	SEISCOMP_DEBUG("Re-generated and populated polygons buffers in %s",
-	    Time(sw.elapsed()).toString("%T.%f").c_str());
+	qglColor(color);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	drawTerrainChunks(GL_TRIANGLES, false, false);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1314,15 +1362,34 @@ void TopographyRenderer::updateTexturedData() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-bool TopographyRenderer::appendVertex(const Vertex& v) {
+void TopographyRenderer::drawTerrainChunks(const GLenum& mode,
+                                           const bool& textured,
+                                           const bool& skirts) {
+
+	glPushMatrix();
+	GL::swapAxes();
+
+	if ( _terrainTree.isEmpty() ) {
+		if ( mode == GL_POINTS )
+			_terrainBuffer.drawPoints();
+		else
+			_terrainBuffer.drawTriangles(textured);
+		glPopMatrix();
+		return;
+	}
 
-	for (VertexList::const_iterator it = _vertices.constBegin();
-	        it != _vertices.constEnd(); ++it)
-		if ( (*it)->x() == v.x() && (*it)->y() == v.y() && (*it)->z() == v.z() )
-		    return false;
+	TerrainQuadtree::Selection selection;
+	_terrainTree.select(_terrainFrustum, selection);
 
-	_vertices << new Vertex(v.x(), v.y(), v.z());
-	return true;
+	_terrainBuffer.beginDraw(textured);
+	for (int i = 0; i < selection.size(); ++i) {
+		const TerrainQuadtree::Node& node = _terrainTree.nodes().at(selection.at(i));
+		_terrainBuffer.drawElements(mode, node.first,
+		    skirts ? node.count + node.skirtCount : node.count);
+	}
+	_terrainBuffer.endDraw();
+
+	glPopMatrix();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1346,10 +1413,8 @@ void TopographyRenderer::setTextureVisible(const bool& visible) {
 	    return;
 
 	_activeSettings.setTextureVisible(visible);
-	if ( _rendering == FILLED || _rendering == FILLEDMESH ) {
-		updateTexturedData();
-		update();
-	}
+	if ( _rendering == FILLED || _rendering == FILLEDMESH )
+	    update();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1392,8 +1457,16 @@ bool TopographyRenderer::addHypocenter(Hypocenter* h) {
 		return false;
 	}
 
-	if ( !_hypocenters.contains(h) )
-	    _hypocenters.append(h);
+	if ( _hypocenterHandles.contains(h) )
+	    return true;
+
+	_hypocenters.append(h);
+	if ( !_hypocenterIndex.contains(h->name()) )
+	    _hypocenterIndex.insert(h->name(), h);
+	const int handle = _hypocenterSpheres.add(h->vertex().x(), h->vertex().y(),
+	    h->vertex().z(), hypocenterRadius(h), h->color());
+	_hypocenterHandles.insert(h, handle);
+	_hypocenterObjects.insert(handle, h);
 
 	return true;
 }
@@ -1402,17 +1475,95 @@ bool TopographyRenderer::addHypocenter(Hypocenter* h) {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TopographyRenderer::addHypocenters(const HypocenterList& list) {
+
+	_hypocenters.reserve(_hypocenters.size() + list.size());
+	_hypocenterHandles.reserve(_hypocenterHandles.size() + list.size());
+	_hypocenterIndex.reserve(_hypocenterIndex.size() + list.size());
+
+	int count = 0;
+	for (int i = 0; i < list.size(); ++i)
+		if ( list.at(i) && !_hypocenterHandles.contains(list.at(i)) ) {
+			addHypocenter(list.at(i));
+			++count;
+		}
+
+	return count;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 Hypocenter* TopographyRenderer::getHypocenter(const QString& name) {
+	return _hypocenterIndex.value(name, NULL);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	QListIterator<Hypocenter*> itH(_hypocenters);
-	while ( itH.hasNext() ) {
-		Hypocenter* h = itH.next();
-		if ( h->name() == name )
-		    return h;
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyRenderer::removeHypocenter(Hypocenter* h) {
+	return removeHypocenters(HypocenterList() << h) == 1;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TopographyRenderer::removeHypocenters(const HypocenterList& list) {
+
+	QSet<Hypocenter*> removed;
+	for (int i = 0; i < list.size(); ++i) {
+		Hypocenter* h = list.at(i);
+		QHash<Hypocenter*, int>::iterator it = _hypocenterHandles.find(h);
+		if ( it == _hypocenterHandles.end() ) continue;
+
+		_hypocenterSpheres.remove(it.value());
+		_hypocenterObjects.remove(it.value());
+		_hypocenterHandles.erase(it);
+		removed.insert(h);
 	}
 
-	return NULL;
+	if ( removed.isEmpty() )
+	    return 0;
+
+	//! One pass over the list whatever the number of hypocenters removed,
+	//! the index is rebuilt along so that a name shared by a removed
+	//! hypocenter falls back on the first remaining one
+	HypocenterList hypocenters;
+	hypocenters.reserve(_hypocenters.size() - removed.size());
+	_hypocenterIndex.clear();
+	for (int i = 0; i < _hypocenters.size(); ++i) {
+		Hypocenter* h = _hypocenters.at(i);
+		if ( removed.contains(h) ) continue;
+		hypocenters.append(h);
+		if ( !_hypocenterIndex.contains(h->name()) )
+		    _hypocenterIndex.insert(h->name(), h);
+	}
+	_hypocenters = hypocenters;
+
+	ArrivalList arrivals;
+	for (int i = 0; i < _arrivals.size(); ++i) {
+		if ( removed.contains(_arrivals.at(i)->hypocenter()) )
+			delete _arrivals.at(i);
+		else
+			arrivals.append(_arrivals.at(i));
+	}
+	const bool arrivalsChanged = arrivals.size() != _arrivals.size();
+	_arrivals = arrivals;
+
+	qDeleteAll(removed);
+
+	if ( arrivalsChanged )
+	    updateArrivals();
+	update();
+
+	return removed.size();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1422,7 +1573,11 @@ Hypocenter* TopographyRenderer::getHypocenter(const QString& name) {
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::clearHypocenters() {
 	::clearList(_hypocenters);
-	updateHypocenters();
+	_hypocenterIndex.clear();
+	_hypocenterHandles.clear();
+	_hypocenterObjects.clear();
+	makeCurrent();
+	_hypocenterSpheres.clear();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1483,8 +1638,18 @@ bool TopographyRenderer::addStation(Station* station) {
 		return false;
 	}
 
-	if ( !_stations.contains(station) )
-	    _stations.append(station);
+	if ( _stationHandles.contains(station) )
+	    return true;
+
+	const QString key = stationKey(station->network(), station->name());
+
+	_stations.append(station);
+	if ( !_stationIndex.contains(key) )
+	    _stationIndex.insert(key, station);
+	const int handle = _stationSpheres.add(station->vertex().x(),
+	    station->vertex().y(), station->vertex().z(), _vObjCoeff, station->color());
+	_stationHandles.insert(station, handle);
+	_stationObjects.insert(handle, station);
 
 	return true;
 }
@@ -1493,18 +1658,94 @@ bool TopographyRenderer::addStation(Station* station) {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TopographyRenderer::addStations(const StationList& list) {
+
+	_stations.reserve(_stations.size() + list.size());
+	_stationHandles.reserve(_stationHandles.size() + list.size());
+	_stationIndex.reserve(_stationIndex.size() + list.size());
+
+	int count = 0;
+	for (int i = 0; i < list.size(); ++i)
+		if ( list.at(i) && !_stationHandles.contains(list.at(i)) ) {
+			addStation(list.at(i));
+			++count;
+		}
+
+	return count;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 Station* TopographyRenderer::getStation(const QString& network,
                                         const QString& code) {
+	return _stationIndex.value(stationKey(network, code), NULL);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
-	QListIterator<Station*> itS(_stations);
-	while ( itS.hasNext() ) {
-		Station* s = itS.next();
-		if ( s->name() == code && s->network() == network )
-		    return s;
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool TopographyRenderer::removeStation(Station* station) {
+	return removeStations(StationList() << station) == 1;
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int TopographyRenderer::removeStations(const StationList& list) {
+
+	QSet<Station*> removed;
+	for (int i = 0; i < list.size(); ++i) {
+		Station* s = list.at(i);
+		QHash<Station*, int>::iterator it = _stationHandles.find(s);
+		if ( it == _stationHandles.end() ) continue;
+
+		_stationSpheres.remove(it.value());
+		_stationObjects.remove(it.value());
+		_stationHandles.erase(it);
+		removed.insert(s);
 	}
 
-	return NULL;
+	if ( removed.isEmpty() )
+	    return 0;
+
+	StationList stations;
+	stations.reserve(_stations.size() - removed.size());
+	_stationIndex.clear();
+	for (int i = 0; i < _stations.size(); ++i) {
+		Station* s = _stations.at(i);
+		if ( removed.contains(s) ) continue;
+		stations.append(s);
+		const QString key = stationKey(s->network(), s->name());
+		if ( !_stationIndex.contains(key) )
+		    _stationIndex.insert(key, s);
+	}
+	_stations = stations;
+
+	ArrivalList arrivals;
+	for (int i = 0; i < _arrivals.size(); ++i) {
+		if ( removed.contains(_arrivals.at(i)->station()) )
+			delete _arrivals.at(i);
+		else
+			arrivals.append(_arrivals.at(i));
+	}
+	const bool arrivalsChanged = arrivals.size() != _arrivals.size();
+	_arrivals = arrivals;
+
+	qDeleteAll(removed);
+
+	if ( arrivalsChanged )
+	    updateArrivals();
+	update();
+
+	return removed.size();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -1514,7 +1755,11 @@ Station* TopographyRenderer::getStation(const QString& network,
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void TopographyRenderer::clearStations() {
 	::clearList(_stations);
-	updateStations();
+	_stationIndex.clear();
+	_stationHandles.clear();
+	_stationObjects.clear();
+	makeCurrent();
+	_stationSpheres.clear();
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
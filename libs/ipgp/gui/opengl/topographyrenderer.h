@@ -23,6 +23,13 @@
 
 #include <ipgp/gui/opengl/renderer.h>
 #include <ipgp/gui/opengl/vertex.h>
+#include <ipgp/gui/opengl/mesh.h>
+#include <ipgp/gui/opengl/meshbuffer.h>
+#include <ipgp/gui/opengl/boundingvolumehierarchy.h>
+#include <ipgp/gui/opengl/camera.h>
+#include <ipgp/gui/opengl/sphereinstances.h>
+#include <ipgp/gui/opengl/terrainquadtree.h>
+#include <ipgp/gui/opengl/topographycache.h>
 #include <ipgp/gui/opengl/topographyrenderersettings.h>
 
 #include <QObject>
@@ -77,7 +84,25 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 			FILLED = 3
 		};
 
-		typedef QVector<Triangle*> TriangleList;
+		enum PickedObject {
+			PICKED_NOTHING = 0,
+			PICKED_TERRAIN = 1,
+			PICKED_HYPOCENTER = 2,
+			PICKED_STATION = 3
+		};
+
+		//! What lies under a point of the widget
+		struct Pick {
+				Pick();
+				PickedObject object;
+				Hypocenter* hypocenter;
+				Station* station;
+				//! Hit point, in OpenGL coordinates
+				GLfloat position[3];
+				//! Distance from the near plane along the ray
+				GLfloat distance;
+		};
+
 		typedef QList<Hypocenter*> HypocenterList;
 		typedef QList<Station*> StationList;
 		typedef QList<Arrival*> ArrivalList;
@@ -95,7 +120,11 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 		// ------------------------------------------------------------------
 		//  Protected interface
 		// ------------------------------------------------------------------
+		//! Shows the tooltip of the hypocenter or station hovered
+		bool event(QEvent*);
 		void mousePressEvent(QMouseEvent*);
+		//! A click which didn't move the camera selects what is under it
+		void mouseReleaseEvent(QMouseEvent*);
 
 		//! Initializes the texture buffer
 		void initTexture();
@@ -149,6 +178,13 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 		//! Updates objects without recalculating their position
 		void updateHypocenters();
 		void updateStations();
+		/**
+		 * @brief Updates the rendering of some objects only, e.g. those
+		 *        whose magnitude or color changed since they were added.
+		 *        Objects which aren't registered are skipped.
+		 */
+		void updateHypocenters(const HypocenterList&);
+		void updateStations(const StationList&);
 		void updateArrivals();
 		void updateCrossSections();
 		void updateEverything() {
@@ -160,6 +196,17 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 
 		void reassessObjectsPosition();
 
+		/**
+		 * @brief Casts a ray from the camera through a point of the widget,
+		 *        as it was displayed by the last frame. Terrain chunks and
+		 *        objects are looked up in bounding volume hierarchies, the
+		 *        nearest hit wins.
+		 * @param pos the point, in widget coordinates
+		 * @param pick what has been hit
+		 * @return false if nothing has been hit
+		 */
+		bool pick(const QPoint& pos, Pick& pick);
+
 		void loadSTL(const QString&);
 		void loadXYZ(const QString&);
 
@@ -177,8 +224,25 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 			return _availableSettings;
 		}
 
+		/**
+		 * @brief Registers hypocenters, the renderer takes their ownership.
+		 *        Each one is indexed by its name and keeps the same sphere
+		 *        instance until it is removed, so that loading or updating
+		 *        a catalogue only costs a hash lookup per event.
+		 * @note  Only the first hypocenter registered under a given name
+		 *        is returned by getHypocenter().
+		 */
 		bool addHypocenter(Hypocenter*);
+		//! @return the number of hypocenters actually added
+		int addHypocenters(const HypocenterList&);
 		Hypocenter* getHypocenter(const QString&);
+		/**
+		 * @brief Unregisters and deletes hypocenters, along with the
+		 *        arrivals pointing to them.
+		 * @return the number of hypocenters actually removed
+		 */
+		bool removeHypocenter(Hypocenter*);
+		int removeHypocenters(const HypocenterList&);
 		void clearHypocenters();
 
 		/**
@@ -198,7 +262,17 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 		 *        arrival list (false)
 		 */
 		bool addStation(Station*);
+		//! @return the number of stations actually added
+		int addStations(const StationList&);
+		//! Looks a station up by its network and name
 		Station* getStation(const QString&, const QString&);
+		/**
+		 * @brief Unregisters and deletes stations, along with the arrivals
+		 *        pointing to them.
+		 * @return the number of stations actually removed
+		 */
+		bool removeStation(Station*);
+		int removeStations(const StationList&);
 		void clearStations();
 
 
@@ -210,9 +284,27 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 		// ------------------------------------------------------------------
 		//  Private interface
 		// ------------------------------------------------------------------
+		/**
+		 * @brief Opens the topography cache of the file when it's still in
+		 *        sync with it, otherwise parses the file, builds its mesh
+		 *        and writes the cache for the next time.
+		 */
+		void loadTopography(const QString&, const TopographyFile::Type&);
 		void processData();
-		void updateTexturedData();
-		bool appendVertex(const Vertex&);
+		void drawFilledTerrain();
+		void drawTerrainMesh(const QColor&);
+		/**
+		 * @brief Draws the chunks of the terrain selected for the current
+		 *        point of view, or the whole mesh when it has no tree.
+		 * @param mode the primitive (GL_TRIANGLES or GL_POINTS)
+		 * @param textured whether texture coordinates are sent
+		 * @param skirts whether the chunks' skirts are drawn too
+		 */
+		void drawTerrainChunks(const GLenum& mode, const bool& textured,
+		                       const bool& skirts);
+		GLfloat hypocenterRadius(Hypocenter*) const;
+		//! Indexes the leaves of the terrain quadtree for picking
+		void buildTerrainPickingTree();
 
 	public Q_SLOTS:
 		// ------------------------------------------------------------------
@@ -227,6 +319,8 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 		//  Qt signals
 		// ------------------------------------------------------------------
 		void currentSettingsChanged();
+		void hypocenterClicked(Hypocenter*);
+		void stationClicked(Station*);
 
 	private:
 		// ------------------------------------------------------------------
@@ -234,22 +328,36 @@ class SC_IPGP_GUI_API TopographyRenderer : public Renderer {
 		// ------------------------------------------------------------------
 		static TopographyRenderer* _instance;
 		TopographyFile* _file;
-		TriangleList _triangles;
-		VertexList _vertices;
+		TopographyCache _cache;
+		Mesh _terrain;
+		TerrainQuadtree _terrainTree;
+		MeshBuffer _terrainBuffer;
+		//! Camera transformations of the last frame
+		Frustum _frustum;
+		//! Same transformations in the (x,y,z) axes the terrain is stored in
+		Frustum _terrainFrustum;
+		BoundingVolumeHierarchy _terrainPickingTree;
+		//! Quadtree node of each primitive of the picking tree
+		QVector<int> _terrainPickingNodes;
+		QPoint _pressPos;
 
 		HypocenterList _hypocenters;
 		ArrivalList _arrivals;
 		StationList _stations;
 		CrossSectionList _crossSections;
 
-		GLuint _pointsCloud;
-		GLuint _mesh;
-		GLuint _filled;
-		GLuint _filledMesh;
+		//! Registries: lookup by name and drawn instance of each object
+		QHash<QString, Hypocenter*> _hypocenterIndex;
+		QHash<Hypocenter*, int> _hypocenterHandles;
+		QHash<int, Hypocenter*> _hypocenterObjects;
+		SphereInstances _hypocenterSpheres;
+		QHash<QString, Station*> _stationIndex;
+		QHash<Station*, int> _stationHandles;
+		QHash<int, Station*> _stationObjects;
+		SphereInstances _stationSpheres;
+
 		GLuint _graticule;
 		GLuint _texture;
-		GLuint _oHypocenters;
-		GLuint _oStations;
 		GLuint _oArrivals;
 		GLuint _oCrossSections;
 
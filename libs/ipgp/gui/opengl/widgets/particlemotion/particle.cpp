@@ -47,6 +47,8 @@ static GLfloat pointTime[MAX_POINTS];
 static GLfloat pointVelocity[MAX_POINTS][2];
 static GLfloat pointDirection[MAX_POINTS][2];
 static int colorList[MAX_POINTS];
+static GLfloat pointColor[MAX_POINTS][4];
+static GLuint aliveList[MAX_POINTS];
 static int animate = 1, motion = 0;
 
 static GLfloat colorSet[][4] = {
@@ -80,6 +82,20 @@ static float float_rand(void) {
 /* Modeling units of ground extent in each X and Z direction. */
 #define EDGE 12
 
+/* The floor quad, drawn from vertex arrays. */
+static GLfloat floorVertices[4][3] = {
+                                       { -EDGE, -0.05, -EDGE },
+                                       { EDGE, -0.05, -EDGE },
+                                       { EDGE, -0.05, EDGE },
+                                       { -EDGE, -0.05, EDGE },
+};
+static GLfloat floorTexCoords[4][2] = {
+                                        { 0.0, 0.0 },
+                                        { 20.0, 0.0 },
+                                        { 20.0, 20.0 },
+                                        { 0.0, 20.0 },
+};
+
 void
 makePointList(void)
               {
@@ -100,6 +116,7 @@ makePointList(void)
 		pointVelocity[i][0] = velocity * cos(angle);
 		pointVelocity[i][1] = velocity * sin(angle);
 		colorList[i] = rand() % NUM_COLORS;
+		memcpy(pointColor[i], colorSet[colorList[i]], sizeof(pointColor[i]));
 	}
 	time = 0.0;
 }
@@ -184,7 +201,7 @@ recalcModelView(void)
 void
 redraw(void)
        {
-	int i;
+	int i, alive;
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	if ( newModel )
@@ -192,33 +209,36 @@ redraw(void)
 
 	glDepthMask(GL_FALSE);
 
+	glEnableClientState(GL_VERTEX_ARRAY);
+
 	/* Draw the floor. */
 	glEnable(GL_TEXTURE_2D);
 	glColor3f(0.5, 1.0, 0.5);
-	glBegin(GL_QUADS);
-	glTexCoord2f(0.0, 0.0);
-	glVertex3f(-EDGE, -0.05, -EDGE);
-	glTexCoord2f(20.0, 0.0);
-	glVertex3f(EDGE, -0.05, -EDGE);
-	glTexCoord2f(20.0, 20.0);
-	glVertex3f(EDGE, -0.05, EDGE);
-	glTexCoord2f(0.0, 20.0);
-	glVertex3f(-EDGE, -0.05, EDGE);
-	glEnd();
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, floorVertices);
+	glTexCoordPointer(2, GL_FLOAT, 0, floorTexCoords);
+	glDrawArrays(GL_QUADS, 0, 4);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 
 	/* Allow particles to blend with each other. */
 	glDepthMask(GL_TRUE);
 
 	glDisable(GL_TEXTURE_2D);
-	glBegin(GL_POINTS);
-	for (i = 0; i < numPoints; i++) {
-		/* Draw alive particles. */
-		if ( colorList[i] != DEAD ) {
-			glColor4fv(colorSet[colorList[i]]);
-			glVertex3fv(pointList[i]);
-		}
-	}
-	glEnd();
+
+	/* Draw alive particles, in one call. Particles which stopped moving
+	 are marked with NUM_COLORS by updatePointList(). */
+	alive = 0;
+	for (i = 0; i < numPoints; i++)
+		if ( colorList[i] < (int) NUM_COLORS )
+			aliveList[alive++] = i;
+
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, pointList);
+	glColorPointer(4, GL_FLOAT, 0, pointColor);
+	glDrawElements(GL_POINTS, alive, GL_UNSIGNED_INT, aliveList);
+	glDisableClientState(GL_COLOR_ARRAY);
+
+	glDisableClientState(GL_VERTEX_ARRAY);
 
 	glutSwapBuffers();
 }
@@ -24,13 +24,26 @@
 #include <ipgp/gui/math/math.h>
 
 
+namespace {
+
+//! Playback refresh period in milliseconds
+const int PlaybackPeriod = 40;
+
+inline const GLvoid* bufferOffset(const int& offset) {
+	return reinterpret_cast<const GLvoid*>(static_cast<size_t>(offset));
+}
+
+}
+
+
 namespace IPGP {
 namespace Gui {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 ParticleMotionGLWidget::ParticleMotionGLWidget(QWidget* parent) :
-		Canvas(parent), _dm(dm_None) {
+		Canvas(parent), _buffer(QGLBuffer::VertexBuffer), _bufferDirty(false),
+		_cursorFirst(0), _cursorCount(-1), _playbackDuration(.0), _dm(dm_None) {
 
 	setXAxisName("EW");
 	setYAxisName("NS");
@@ -40,6 +53,10 @@ ParticleMotionGLWidget::ParticleMotionGLWidget(QWidget* parent) :
 	setZRange(0, 10);
 //	setScalingValue(.09f);
 	setRendererInfoVisible(false);
+
+	_playbackTimer = new QTimer(this);
+	_playbackTimer->setInterval(PlaybackPeriod);
+	connect(_playbackTimer, SIGNAL(timeout()), this, SLOT(advancePlayback()));
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -47,7 +64,12 @@ ParticleMotionGLWidget::ParticleMotionGLWidget(QWidget* parent) :
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-ParticleMotionGLWidget::~ParticleMotionGLWidget() {}
+ParticleMotionGLWidget::~ParticleMotionGLWidget() {
+
+	makeCurrent();
+	if ( _buffer.isCreated() )
+		_buffer.destroy();
+}
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
 
@@ -59,10 +81,12 @@ void ParticleMotionGLWidget::feed(const QVector<qreal>& xdata,
                                   const QVector<qreal>& zdata,
                                   const bool& autoGradient) {
 
-	if ( xdata.size() != ydata.size() && ydata.size() != zdata.size() )
+	if ( xdata.size() != ydata.size() || ydata.size() != zdata.size() )
 		return;
 
-	_data.clear();
+	stop();
+	_vertices.clear();
+	_colors.clear();
 
 	if ( autoGradient )
 		_dm = dm_UseAutoGradient;
@@ -74,9 +98,19 @@ void ParticleMotionGLWidget::feed(const QVector<qreal>& xdata,
 	_range_z_min = Math::getMin(zdata);
 	_range_z_max = Math::getMax(zdata);
 
-	for (int i = 0; i < xdata.size(); ++i)
-		_data.append(ParticleData(QVector3D(xdata.at(i), ydata.at(i),
-		    zdata.at(i)), Qt::red));
+	_vertices.reserve(xdata.size() * 3);
+	_colors.reserve(xdata.size() * 3);
+	for (int i = 0; i < xdata.size(); ++i) {
+		QColor color(Qt::red);
+		if ( _dm == dm_UseAutoGradient )
+			color = QColor(sin(i * 0.3) * 100 + 100, sin(i * 0.6 + 0.7) * 100 + 100,
+			    sin(i * 0.4 + 0.6) * 100 + 100);
+		append(xdata.at(i), ydata.at(i), zdata.at(i), color);
+	}
+
+	_bufferDirty = true;
+	_cursorFirst = 0;
+	_cursorCount = -1;
 
 //	_scaling = .0002;
 
@@ -92,10 +126,12 @@ void ParticleMotionGLWidget::feed(const QVector<Particle>& xdata,
                                   const QVector<Particle>& ydata,
                                   const QVector<Particle>& zdata) {
 
-	if ( xdata.size() != ydata.size() && ydata.size() != zdata.size() )
+	if ( xdata.size() != ydata.size() || ydata.size() != zdata.size() )
 		return;
 
-	_data.clear();
+	stop();
+	_vertices.clear();
+	_colors.clear();
 	_dm = dm_UseCustomGradient;
 
 	_range_x_min = getMinParticleValue(xdata);
@@ -105,9 +141,15 @@ void ParticleMotionGLWidget::feed(const QVector<Particle>& xdata,
 	_range_z_min = getMinParticleValue(zdata);
 	_range_z_max = getMaxParticleValue(zdata);
 
+	_vertices.reserve(xdata.size() * 3);
+	_colors.reserve(xdata.size() * 3);
 	for (int i = 0; i < xdata.size(); ++i)
-		_data.append(ParticleData(QVector3D(xdata.at(i).value(), ydata.at(i).value(),
-		    zdata.at(i).value()), xdata.at(i).color()));
+		append(xdata.at(i).value(), ydata.at(i).value(), zdata.at(i).value(),
+		    xdata.at(i).color());
+
+	_bufferDirty = true;
+	_cursorFirst = 0;
+	_cursorCount = -1;
 
 //	_scaling = .0002;
 
@@ -121,7 +163,12 @@ void ParticleMotionGLWidget::feed(const QVector<Particle>& xdata,
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void ParticleMotionGLWidget::clear(const bool& refresh) {
 
-	_data.clear();
+	stop();
+	_vertices.clear();
+	_colors.clear();
+	_bufferDirty = true;
+	_cursorFirst = 0;
+	_cursorCount = -1;
 
 	if ( refresh )
 		updateGL();
@@ -136,26 +183,37 @@ void ParticleMotionGLWidget::draw() {
 
 	Canvas::draw();
 
-	glBegin(GL_LINES);
-	for (int i = 0; i < _data.size() - 1; ++i) {
-
-		switch ( _dm ) {
-			case dm_UseAutoGradient:
-				qglColor(QColor(sin(i * 0.3) * 100 + 100, sin(i * 0.6 + 0.7) * 100 + 100,
-				    sin(i * 0.4 + 0.6) * 100 + 100));
-			break;
-			case dm_UseCustomGradient:
-				qglColor(_data.at(i).second);
-			break;
-			default:
-				qglColor(QColor(Qt::red));
-			break;
-		}
-		glVertex3d(_data.at(i).first.x(), _data.at(i).first.y(), _data.at(i).first.z());
-		glVertex3d(_data.at(i + 1).first.x(), _data.at(i + 1).first.y(), _data.at(i + 1).first.z());
+	if ( _bufferDirty )
+		upload();
+
+	const int samples = sampleCount();
+	const int first = qBound(0, _cursorFirst, samples);
+	const int count = (_cursorCount < 0) ? samples - first : qMin(_cursorCount, samples - first);
+	if ( count < 2 )
+		return;
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+
+	//! Colors are stored right after the vertices
+	if ( _buffer.isCreated() ) {
+		_buffer.bind();
+		glVertexPointer(3, GL_FLOAT, 0, bufferOffset(0));
+		glColorPointer(3, GL_UNSIGNED_BYTE, 0,
+		    bufferOffset(_vertices.size() * sizeof(GLfloat)));
+	}
+	else {
+		glVertexPointer(3, GL_FLOAT, 0, _vertices.constData());
+		glColorPointer(3, GL_UNSIGNED_BYTE, 0, _colors.constData());
 	}
-	glEnd();
 
+	glDrawArrays(GL_LINE_STRIP, first, count);
+
+	if ( _buffer.isCreated() )
+		_buffer.release();
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -189,6 +247,128 @@ void ParticleMotionGLWidget::redraw() {
 
 
 
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionGLWidget::setTimeCursor(const int& first, const int& count) {
+
+	if ( first == _cursorFirst && count == _cursorCount )
+		return;
+
+	_cursorFirst = qMax(0, first);
+	_cursorCount = count;
+
+	updateGL();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionGLWidget::resetTimeCursor() {
+	stop();
+	setTimeCursor(0, -1);
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionGLWidget::play(const qreal& duration) {
+
+	if ( sampleCount() < 2 )
+		return;
+
+	_playbackDuration = (duration > .0) ? duration : 5.;
+	_playbackClock.start();
+	_cursorFirst = 0;
+	_cursorCount = 2;
+	_playbackTimer->start();
+
+	updateGL();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionGLWidget::stop() {
+	_playbackTimer->stop();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+bool ParticleMotionGLWidget::isPlaying() const {
+	return _playbackTimer->isActive();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionGLWidget::advancePlayback() {
+
+	//! The cursor follows the clock rather than the frames count, a slow
+	//! renderer skips samples instead of slowing the motion down
+	const qreal progress = _playbackClock.elapsed() / (1000. * _playbackDuration);
+	const int samples = sampleCount();
+
+	if ( progress >= 1. ) {
+		stop();
+		_cursorCount = -1;
+	}
+	else
+		_cursorCount = qMax(2, (int) (progress * samples));
+
+	updateGL();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionGLWidget::append(const qreal& x, const qreal& y,
+                                    const qreal& z, const QColor& color) {
+	_vertices << x << y << z;
+	_colors << color.red() << color.green() << color.blue();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
+// >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void ParticleMotionGLWidget::upload() {
+
+	_bufferDirty = false;
+
+	if ( _vertices.isEmpty() )
+		return;
+
+	if ( !_buffer.isCreated() && !_buffer.create() )
+		return;
+
+	const int verticesSize = _vertices.size() * sizeof(GLfloat);
+	const int colorsSize = _colors.size() * sizeof(GLubyte);
+
+	_buffer.setUsagePattern(QGLBuffer::StaticDraw);
+	_buffer.bind();
+	_buffer.allocate(verticesSize + colorsSize);
+	_buffer.write(0, _vertices.constData(), verticesSize);
+	_buffer.write(verticesSize, _colors.constData(), colorsSize);
+	_buffer.release();
+}
+// <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+
+
+
+
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 const qreal ParticleMotionGLWidget::
 getMinParticleValue(const QVector<Particle>& vector) const {
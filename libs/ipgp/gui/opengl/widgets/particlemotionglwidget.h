@@ -23,9 +23,13 @@
 
 
 #include <ipgp/gui/opengl/canvas.h>
+#include <QGLBuffer>
 #include <QVector3D>
 #include <QVector>
 #include <QColor>
+#include <QTime>
+
+QT_FORWARD_DECLARE_CLASS(QTimer);
 
 namespace IPGP {
 namespace Gui {
@@ -65,6 +69,18 @@ class SC_IPGP_GUI_API Particle {
 };
 
 
+/**
+ * @class   ParticleMotionGLWidget
+ * @package IPGP::Gui
+ * @brief   Three-dimensional hodogram
+ *
+ * The trajectory and its colors are uploaded once into a vertex buffer
+ * object when fed, and drawn as a single line strip. The time cursor
+ * restricts the drawn samples to a range of the buffer, so that rotating
+ * the view or playing the motion back only issues one glDrawArrays per
+ * frame, whatever the number of samples. When buffer objects aren't
+ * supported, the same call is issued on client side arrays.
+ */
 class SC_IPGP_GUI_API ParticleMotionGLWidget : public Canvas {
 
 	Q_OBJECT
@@ -77,9 +93,6 @@ class SC_IPGP_GUI_API ParticleMotionGLWidget : public Canvas {
 		// ------------------------------------------------------------------
 		//  Nested types
 		// ------------------------------------------------------------------
-		typedef QPair<QVector3D, QColor> ParticleData;
-		typedef QVector<ParticleData> DataSet;
-
 		enum DrawingMethod {
 			dm_UseAutoGradient,
 			dm_UseCustomGradient,
@@ -121,6 +134,29 @@ class SC_IPGP_GUI_API ParticleMotionGLWidget : public Canvas {
 		//! Redraws the scene without altering the current view settings
 		void redraw();
 
+		//! @return the number of samples of the trajectory
+		int sampleCount() const {
+			return _vertices.size() / 3;
+		}
+
+		/**
+		 * @brief Restricts the drawn trajectory to a range of samples.
+		 * @param first the first sample drawn
+		 * @param count the number of samples drawn, -1 up to the last one
+		 */
+		void setTimeCursor(const int& first, const int& count = -1);
+		//! Draws the whole trajectory again
+		void resetTimeCursor();
+
+		const int& timeCursorFirst() const {
+			return _cursorFirst;
+		}
+		const int& timeCursorCount() const {
+			return _cursorCount;
+		}
+
+		bool isPlaying() const;
+
 //		const bool& paintUsingGradient() const {
 //			return _paintUsingGradient;
 //		}
@@ -135,7 +171,27 @@ class SC_IPGP_GUI_API ParticleMotionGLWidget : public Canvas {
 			return _dm;
 		}
 
+	public Q_SLOTS:
+		// ------------------------------------------------------------------
+		//  Public Qt interface
+		// ------------------------------------------------------------------
+		/**
+		 * @brief Plays the motion back: the trajectory grows from its first
+		 *        sample to its last one. Samples are skipped as the frame
+		 *        rate requires, so that the playback lasts as long whatever
+		 *        the renderer.
+		 * @param duration the playback duration in seconds
+		 */
+		void play(const qreal& duration = 5.);
+		void stop();
+
 	private:
+		//! Appends a sample to the client side arrays
+		void append(const qreal& x, const qreal& y, const qreal& z,
+		            const QColor& color);
+		//! Sends the client side arrays to the buffer object
+		void upload();
+
 		const qreal getMinParticleValue(const QVector<Particle>&) const;
 		const qreal getMaxParticleValue(const QVector<Particle>&) const;
 
@@ -145,11 +201,28 @@ class SC_IPGP_GUI_API ParticleMotionGLWidget : public Canvas {
 		// ------------------------------------------------------------------
 		void draw();
 
+	private Q_SLOTS:
+		// ------------------------------------------------------------------
+		//  Private Qt interface
+		// ------------------------------------------------------------------
+		void advancePlayback();
+
 	private:
 		// ------------------------------------------------------------------
 		//  Members
 		// ------------------------------------------------------------------
-		DataSet _data;
+		//! x,y,z triplets and r,g,b triplets of the samples
+		QVector<GLfloat> _vertices;
+		QVector<GLubyte> _colors;
+		QGLBuffer _buffer;
+		bool _bufferDirty;
+
+		int _cursorFirst;
+		int _cursorCount;
+
+		QTimer* _playbackTimer;
+		QTime _playbackClock;
+		qreal _playbackDuration;
 		//		bool _paintUsingGradient;
 		DrawingMethod _dm;
 };
@@ -43,9 +43,10 @@
 #include <seiscomp3/datamodel/magnitude.h>
 #include <seiscomp3/datamodel/station.h>
 #include <seiscomp3/datamodel/event.h>
-#include <seiscomp3/datamodel/inventory.h>
+#include <ipgp/core/datamodel/inventorysnapshot.h>
 
 #include <QtGui>
+#include <map>
 
 
 
@@ -53,6 +54,43 @@ using namespace Seiscomp;
 using namespace Seiscomp::Core;
 
 
+namespace {
+
+
+typedef std::map<std::string, Seiscomp::DataModel::PickPtr> PickMap;
+
+
+/**
+ * @brief Fetches the picks referenced by the arrivals of an origin. Those
+ *        which aren't registered yet are all loaded in a single query.
+ */
+void loadPicks(Seiscomp::DataModel::DatabaseQuery* query,
+               Seiscomp::DataModel::Origin* org, PickMap& picks) {
+
+	bool missing = false;
+	for (size_t i = 0; i < org->arrivalCount(); ++i) {
+		const std::string& pickID = org->arrival(i)->pickID();
+		Seiscomp::DataModel::PickPtr pick = Seiscomp::DataModel::Pick::Find(pickID);
+		if ( pick )
+			picks[pickID] = pick;
+		else
+			missing = true;
+	}
+
+	if ( !missing || !query ) return;
+
+	Seiscomp::DataModel::DatabaseIterator it = query->getPicks(org->publicID());
+	for (; *it; ++it) {
+		Seiscomp::DataModel::PickPtr pick = Seiscomp::DataModel::Pick::Cast(*it);
+		if ( pick && picks.find(pick->publicID()) == picks.end() )
+		    picks[pick->publicID()] = pick;
+	}
+}
+
+
+}
+
+
 namespace IPGP {
 namespace Gui {
 namespace OpenGL {
@@ -300,8 +338,10 @@ void TopographyMap::updateInterface() {
 
 
 // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-void TopographyMap::setDatabase(DataModel::DatabaseQuery* query) {
+void TopographyMap::setDatabase(DataModel::DatabaseQuery* query,
+                                const std::string& databaseURI) {
 	_query = query;
+	_databaseURI = databaseURI;
 }
 // <<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
 
@@ -409,6 +449,12 @@ void TopographyMap::setOrigin(DataModel::Origin* org) {
 
 	if ( !hypocenter ) return;
 
+	//! Picks come in one query, station coordinates from the inventory
+	//! snapshot, loaded once for every origin
+	PickMap picks;
+	loadPicks(_query.get(), org, picks);
+	Core::InventorySnapshot* inventory = Core::InventorySnapshot::Shared(_databaseURI, _query.get());
+
 	for (size_t i = 0; i < org->arrivalCount(); ++i) {
 
 		DataModel::ArrivalPtr ar = org->arrival(i);
@@ -422,32 +468,31 @@ void TopographyMap::setOrigin(DataModel::Origin* org) {
 			hasResiduals = true;
 		} catch ( ... ) {}
 
-		DataModel::PickPtr pick = DataModel::Pick::Find(ar->pickID());
-		if ( !pick ) {
-			pick = DataModel::Pick::Cast(_query->getObject(DataModel::Pick::TypeInfo(), ar->pickID()));
-			if ( !pick ) continue;
-		}
+		PickMap::const_iterator pick = picks.find(ar->pickID());
+		if ( pick == picks.end() ) continue;
 
-		DataModel::StationPtr station = _query->getStation(pick->waveformID().networkCode(),
-		    pick->waveformID().stationCode(), Time::GMT());
+		const std::string& networkCode = pick->second->waveformID().networkCode();
+		const Core::InventorySnapshot::Station* station = (inventory) ?
+		        inventory->station(networkCode, pick->second->waveformID().stationCode(),
+		            org->time().value()) : NULL;
 
 		if ( !station ) continue;
-		if ( station->latitude() < _renderer->activeSettings().latitude().min )
+		if ( station->latitude < _renderer->activeSettings().latitude().min )
 		    continue;
-		if ( station->latitude() > _renderer->activeSettings().latitude().max )
+		if ( station->latitude > _renderer->activeSettings().latitude().max )
 		    continue;
-		if ( station->longitude() < _renderer->activeSettings().longitude().min )
+		if ( station->longitude < _renderer->activeSettings().longitude().min )
 		    continue;
-		if ( station->longitude() > _renderer->activeSettings().longitude().max )
+		if ( station->longitude > _renderer->activeSettings().longitude().max )
 		    continue;
 
-		if ( !_renderer->getStation(pick->waveformID().networkCode().c_str(), station->code().c_str()) ) {
+		if ( !_renderer->getStation(networkCode.c_str(), station->code.c_str()) ) {
 
 			Station* stationGeometry = new Station;
-			stationGeometry->setName(station->code().c_str());
+			stationGeometry->setName(station->code.c_str());
 			stationGeometry->setRendererSettings(_renderer->activeSettings());
-			stationGeometry->setNetwork(pick->waveformID().networkCode().c_str());
-			stationGeometry->setGeoPosition(station->latitude(), station->longitude(), station->elevation());
+			stationGeometry->setNetwork(networkCode.c_str());
+			stationGeometry->setGeoPosition(station->latitude, station->longitude, station->elevation);
 			if ( hasResiduals )
 			    stationGeometry->setColor(Misc::getResidualsColoration(ares));
 
@@ -457,8 +502,7 @@ void TopographyMap::setOrigin(DataModel::Origin* org) {
 			}
 		}
 
-		Station* parent = _renderer->getStation(pick->waveformID().networkCode().c_str(),
-		    station->code().c_str());
+		Station* parent = _renderer->getStation(networkCode.c_str(), station->code.c_str());
 
 		if ( parent ) {
 			if ( !_renderer->getArrival(parent->name(), ar->phase().code().c_str()) ) {
@@ -740,53 +784,42 @@ void TopographyMap::setInventoryVisible(const bool& v) {
 
 	if ( !_inventoryVisible ) return;
 
-	DataModel::DatabaseReaderPtr reader = new DataModel::DatabaseReader(_query->driver());
-	DataModel::InventoryPtr inv = new DataModel::Inventory();
-	reader->loadNetworks(inv.get());
-
-	for (size_t i = 0; i < inv->networkCount(); ++i) {
-		DataModel::NetworkPtr network = inv->network(i);
-		reader->load(network.get());
-
-		for (size_t j = 0; j < network->stationCount(); ++j) {
-			DataModel::StationPtr station = network->station(j);
-
-			if ( !station ) continue;
-			if ( station->latitude() < _renderer->activeSettings().latitude().min )
-			    continue;
-			if ( station->latitude() > _renderer->activeSettings().latitude().max )
-			    continue;
-			if ( station->longitude() < _renderer->activeSettings().longitude().min )
-			    continue;
-			if ( station->longitude() > _renderer->activeSettings().longitude().max )
-			    continue;
-
-//			if ( station->elevation() > _renderer->activeSettings().elevation().max )
-//				continue;
-//
-//			if ( station->elevation() < _renderer->activeSettings().elevation().min )
-//				continue;
-
-			if ( !_renderer->getStation(station->network()->code().c_str(), station->code().c_str()) ) {
-
-				Station* stationGeometry = new Station;
-				stationGeometry->setName(QString("%1.%2").arg(station->network()->code().c_str()).arg(station->code().c_str()));
-				stationGeometry->setRendererSettings(_renderer->activeSettings());
-				stationGeometry->setNetwork(station->network()->code().c_str());
-				stationGeometry->setGeoPosition(station->latitude(), station->longitude(), station->elevation());
-				stationGeometry->setColor(Qt::red);
-
-				if ( !_renderer->addStation(stationGeometry) ) {
-					delete stationGeometry;
-					stationGeometry = NULL;
-				}
-			}
-		}
+	Core::InventorySnapshot* inventory = Core::InventorySnapshot::Shared(_databaseURI, _query.get());
+	if ( !inventory || !inventory->isLoaded() ) {
+		SEISCOMP_ERROR("No inventory available");
+		return;
+	}
+
+	TopographyRenderer::StationList stations;
+	const Core::InventorySnapshot::StationMap& map = inventory->stations();
+	for (Core::InventorySnapshot::StationMap::const_iterator it = map.begin();
+	        it != map.end(); ++it) {
 
-		emit loadingPercentage(Core::Math::percentageOfSomething<size_t>(inv->networkCount(), i),
-		    objectName(), "Painting inventory object...");
+		if ( it->second.empty() ) continue;
+
+		//! Latest epoch of the station
+		const Core::InventorySnapshot::Station& station = it->second.back();
+
+		if ( station.latitude < _renderer->activeSettings().latitude().min )
+		    continue;
+		if ( station.latitude > _renderer->activeSettings().latitude().max )
+		    continue;
+		if ( station.longitude < _renderer->activeSettings().longitude().min )
+		    continue;
+		if ( station.longitude > _renderer->activeSettings().longitude().max )
+		    continue;
+
+		Station* stationGeometry = new Station;
+		stationGeometry->setName(it->first.c_str());
+		stationGeometry->setRendererSettings(_renderer->activeSettings());
+		stationGeometry->setNetwork(station.networkCode.c_str());
+		stationGeometry->setGeoPosition(station.latitude, station.longitude, station.elevation);
+		stationGeometry->setColor(Qt::red);
+		stations << stationGeometry;
 	}
 
+	_renderer->addStations(stations);
+
 	emit loadingPercentage(98, _renderer->objectName(), "Updating stations...");
 
 	_renderer->updateStations();
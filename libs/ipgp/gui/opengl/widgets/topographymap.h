@@ -121,7 +121,9 @@ class SC_IPGP_GUI_API TopographyMap : public QMainWindow {
 		}
 		void updateInterface();
 
-		void setDatabase(Seiscomp::DataModel::DatabaseQuery*);
+		//! The URI keys the inventory snapshot shared with other widgets
+		void setDatabase(Seiscomp::DataModel::DatabaseQuery*,
+		                 const std::string& databaseURI);
 		void setOrigin(Seiscomp::DataModel::Origin*);
 		void setOrigins(Core::OriginList*);
 
@@ -184,6 +186,7 @@ class SC_IPGP_GUI_API TopographyMap : public QMainWindow {
 		Ui::TopographyMapDialog* _dialogUi;
 
 		Seiscomp::DataModel::DatabaseQueryPtr _query;
+		std::string _databaseURI;
 		Seiscomp::DataModel::OriginPtr _origin;
 
 		//! General actions